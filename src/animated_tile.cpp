@@ -16,14 +16,33 @@
 #include "framerate_type.h"
 #include "date_func.h"
 #include "3rdparty/cpp-btree/btree_map.h"
+#include "3rdparty/cpp-btree/btree_set.h"
 
-#include INCLUDE_FOR_PREFETCH_NTA
+#include <algorithm>
+#include <array>
+#include <vector>
 
 #include "safeguards.h"
 
 /** The table/list with animated tiles. */
 btree::btree_map<TileIndex, AnimatedTileInfo> _animated_tiles;
 
+/** Animated tiles which are animated at all, in buckets by their speed, in tile order. */
+static std::array<btree::btree_set<TileIndex>, MAX_ANIMATED_TILE_SPEED + 1> _animated_tile_speed_buckets;
+
+/** Incremented whenever an animated tile is added, removed, or changes speed. */
+static uint32_t _animated_tiles_change_count = 0;
+
+static void AddAnimatedTileToSpeedBucket(TileIndex tile, uint8_t speed)
+{
+	if (speed <= MAX_ANIMATED_TILE_SPEED) _animated_tile_speed_buckets[speed].insert(tile);
+}
+
+static void RemoveAnimatedTileFromSpeedBucket(TileIndex tile, uint8_t speed)
+{
+	if (speed <= MAX_ANIMATED_TILE_SPEED) _animated_tile_speed_buckets[speed].erase(tile);
+}
+
 /**
  * Removes the given tile from the animated tile table.
  * @param tile the tile to remove
@@ -31,8 +50,10 @@ btree::btree_map<TileIndex, AnimatedTileInfo> _animated_tiles;
 void DeleteAnimatedTile(TileIndex tile)
 {
 	auto to_remove = _animated_tiles.find(tile);
-	if (to_remove != _animated_tiles.end() && !to_remove->second.pending_deletion) {
-		to_remove->second.pending_deletion = true;
+	if (to_remove != _animated_tiles.end()) {
+		RemoveAnimatedTileFromSpeedBucket(tile, to_remove->second.speed);
+		_animated_tiles.erase(to_remove);
+		_animated_tiles_change_count++;
 		MarkTileDirtyByTile(tile, VMDF_NOT_MAP_MODE);
 	}
 }
@@ -75,15 +96,21 @@ static void UpdateAnimatedTileSpeed(TileIndex tile, AnimatedTileInfo &info)
 void AddAnimatedTile(TileIndex tile, bool mark_dirty)
 {
 	if (mark_dirty) MarkTileDirtyByTile(tile, VMDF_NOT_MAP_MODE);
-	AnimatedTileInfo &info = _animated_tiles[tile];
+	auto res = _animated_tiles.insert({ tile, AnimatedTileInfo{} });
+	AnimatedTileInfo &info = res.first->second;
+	const uint8_t old_speed = info.speed;
 	UpdateAnimatedTileSpeed(tile, info);
-	info.pending_deletion = false;
+	if (res.second || info.speed != old_speed) {
+		if (!res.second) RemoveAnimatedTileFromSpeedBucket(tile, old_speed);
+		AddAnimatedTileToSpeedBucket(tile, info.speed);
+		_animated_tiles_change_count++;
+	}
 }
 
 int GetAnimatedTileSpeed(TileIndex tile)
 {
 	const auto iter = _animated_tiles.find(tile);
-	if (iter != _animated_tiles.end() && !iter->second.pending_deletion) {
+	if (iter != _animated_tiles.end()) {
 		return iter->second.speed;
 	}
 	return -1;
@@ -100,61 +127,74 @@ void AnimateAnimatedTiles()
 	extern void AnimateTile_Object(TileIndex tile);
 
 	PerformanceAccumulator framerate(PFE_GL_LANDSCAPE);
+	PerformanceZoneMeasurer framerate_zone(PFZ_ANIMATED_TILES);
 
 	const uint32_t ticks = (uint) _scaled_tick_counter;
-	const uint8_t max_speed = (ticks == 0) ? 32 : FindFirstBit(ticks);
-
-	auto iter = _animated_tiles.begin();
-	while (iter != _animated_tiles.end()) {
-		if (iter->second.pending_deletion) {
-			iter = _animated_tiles.erase(iter);
-			continue;
-		}
+	const uint8_t max_speed = (ticks == 0) ? MAX_ANIMATED_TILE_SPEED : FindFirstBit(ticks);
+
+	/* Collect the tiles which are due this tick, from the buckets of speeds up to max_speed, in tile order.
+	 * Animating a tile may add or remove other animated tiles, so work from a copy. */
+	static std::vector<TileIndex> due_tiles;
+	due_tiles.clear();
+	for (uint speed = 0; speed <= max_speed; speed++) {
+		const btree::btree_set<TileIndex> &bucket = _animated_tile_speed_buckets[speed];
+		if (bucket.empty()) continue;
+		const size_t merge_point = due_tiles.size();
+		due_tiles.insert(due_tiles.end(), bucket.begin(), bucket.end());
+		if (merge_point != 0) std::inplace_merge(due_tiles.begin(), due_tiles.begin() + merge_point, due_tiles.end());
+	}
 
-		auto next = iter;
-		++next;
-		if (next != _animated_tiles.end()) {
-			PREFETCH_NTA(&(next->second));
+	const uint32_t change_count = _animated_tiles_change_count;
+	for (const TileIndex curr : due_tiles) {
+		if (_animated_tiles_change_count != change_count) {
+			/* An earlier tile changed the animated tile table, skip tiles which are no longer due */
+			auto iter = _animated_tiles.find(curr);
+			if (iter == _animated_tiles.end() || iter->second.speed > max_speed) continue;
 		}
 
-		if (iter->second.speed <= max_speed) {
-			const TileIndex curr = iter->first;
-			switch (GetTileType(curr)) {
-				case MP_HOUSE:
-					AnimateTile_Town(curr);
-					break;
+		switch (GetTileType(curr)) {
+			case MP_HOUSE:
+				AnimateTile_Town(curr);
+				break;
 
-				case MP_STATION:
-					AnimateTile_Station(curr);
-					break;
+			case MP_STATION:
+				AnimateTile_Station(curr);
+				break;
 
-				case MP_INDUSTRY:
-					AnimateTile_Industry(curr);
-					break;
+			case MP_INDUSTRY:
+				AnimateTile_Industry(curr);
+				break;
 
-				case MP_OBJECT:
-					AnimateTile_Object(curr);
-					break;
+			case MP_OBJECT:
+				AnimateTile_Object(curr);
+				break;
 
-				default:
-					NOT_REACHED();
-			}
+			default:
+				NOT_REACHED();
 		}
-		iter = next;
 	}
 }
 
+/**
+ * Rebuild the speed buckets of the animated tile table, after the table has been changed directly.
+ */
+void RebuildAnimatedTileSpeedBuckets()
+{
+	for (btree::btree_set<TileIndex> &bucket : _animated_tile_speed_buckets) {
+		bucket.clear();
+	}
+	for (const auto &it : _animated_tiles) {
+		AddAnimatedTileToSpeedBucket(it.first, it.second.speed);
+	}
+	_animated_tiles_change_count++;
+}
+
 void UpdateAllAnimatedTileSpeeds()
 {
-	auto iter = _animated_tiles.begin();
-	while (iter != _animated_tiles.end()) {
-		if (iter->second.pending_deletion) {
-			iter = _animated_tiles.erase(iter);
-			continue;
-		}
-		UpdateAnimatedTileSpeed(iter->first, iter->second);
-		++iter;
+	for (auto &it : _animated_tiles) {
+		UpdateAnimatedTileSpeed(it.first, it.second);
 	}
+	RebuildAnimatedTileSpeedBuckets();
 }
 
 /**
@@ -163,4 +203,5 @@ void UpdateAllAnimatedTileSpeeds()
 void InitializeAnimatedTiles()
 {
 	_animated_tiles.clear();
+	RebuildAnimatedTileSpeedBuckets();
 }
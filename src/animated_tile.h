@@ -13,9 +13,11 @@
 #include "tile_type.h"
 #include "3rdparty/cpp-btree/btree_map.h"
 
+/** Animated tiles with a higher speed are never animated, see AnimateAnimatedTiles. */
+static const uint8_t MAX_ANIMATED_TILE_SPEED = 32;
+
 struct AnimatedTileInfo {
 	uint8_t speed = 0;
-	bool pending_deletion = false;
 };
 
 extern btree::btree_map<TileIndex, AnimatedTileInfo> _animated_tiles;
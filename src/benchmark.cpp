@@ -0,0 +1,313 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file benchmark.cpp Headless benchmark of the game loop. */
+
+#include "stdafx.h"
+#include "benchmark.h"
+#include "command_func.h"
+#include "company_base.h"
+#include "company_func.h"
+#include "core/backup_type.hpp"
+#include "core/checksum_func.hpp"
+#include "core/format.hpp"
+#include "core/random_func.hpp"
+#include "date_func.h"
+#include "debug.h"
+#include "fileio_func.h"
+#include "framerate_type.h"
+#include "gfx_func.h"
+#include "openttd.h"
+#include "survey.h"
+#include "window_func.h"
+#include "sl/saveload.h"
+
+#include <algorithm>
+#include <chrono>
+#include <optional>
+#include <tuple>
+
+#if defined(_WIN32)
+# include <windows.h>
+# include <psapi.h>
+#elif defined(UNIX)
+# include <sys/resource.h>
+#endif
+
+#include "safeguards.h"
+
+bool _benchmark_running; ///< Is a benchmark running, so the state checksum must be kept even when not networking?
+
+/** Keys of the performance elements in the benchmark results. */
+static const char * const PERFORMANCE_ELEMENT_KEYS[PFE_AI0] = {
+	"gameloop",
+	"gl_economy",
+	"gl_trains",
+	"gl_roadvehs",
+	"gl_ships",
+	"gl_aircraft",
+	"gl_landscape",
+	"gl_linkgraph",
+	"drawing",
+	"drawworld",
+	"video",
+	"sound",
+	"allscripts",
+	"gamescript",
+};
+
+/** Keys of the performance zones in the benchmark results. */
+static const char * const PERFORMANCE_ZONE_KEYS[PFZ_MAX] = {
+	"load_unload",
+	"train_pathfinder",
+	"roadveh_pathfinder",
+	"ship_pathfinder",
+	"animated_tiles",
+	"tile_loop",
+	"towns",
+	"station_ratings",
+	"industries",
+};
+
+/**
+ * Replays the commands of a desync log, as written by "-d desync=1", at the game dates at which they were originally executed.
+ * Sync states in the log, as written by a server with "-d desync=2", are checked against the replayed game.
+ */
+class CommandLogReplay {
+	/** Date at which a log entry is due. */
+	using LogDate = std::tuple<uint, uint, uint>;
+
+	FILE *f;                         ///< The log file.
+	bool pending = false;            ///< Has an entry been read which is not yet due?
+	bool pending_sync = false;       ///< Is the pending entry a sync state instead of a command?
+	LogDate pending_date;            ///< Date at which the pending entry is due.
+	CommandLogLine pending_line;     ///< The pending command or sync state.
+
+	bool ReadEntry();
+
+public:
+	uint commands = 0;        ///< Number of replayed commands.
+	uint script_commands = 0; ///< Number of commands of AIs and game scripts, which are not replayed as the scripts are run.
+	uint sync_checks = 0;     ///< Number of checked sync states.
+	uint sync_mismatches = 0; ///< Number of sync states which did not match.
+
+	CommandLogReplay(FILE *f) : f(f) {}
+	~CommandLogReplay() { fclose(this->f); }
+
+	void Replay();
+};
+
+/**
+ * Read the next command or sync state from the log.
+ * @return False when the end of the log has been reached.
+ */
+bool CommandLogReplay::ReadEntry()
+{
+	static char buff[65536];
+	while (fgets(buff, lengthof(buff), this->f) != nullptr) {
+		switch (ParseCommandLogLine(buff, this->pending_line)) {
+			case CLLT_COMMAND:
+				this->pending_line.cmd.cmd &= ~CMD_FLAGS_MASK;
+				this->pending_sync = false;
+				break;
+
+			case CLLT_SYNC:
+				this->pending_sync = true;
+				break;
+
+			case CLLT_INVALID:
+				DEBUG(misc, 0, "Benchmark: cannot parse command log line: %s", buff);
+				continue;
+
+			default:
+				/* Failed commands, messages, joins and so on are not replayed */
+				continue;
+		}
+
+		this->pending_date = { this->pending_line.date, this->pending_line.date_fract, this->pending_line.tick_skip_counter };
+		return true;
+	}
+	return false;
+}
+
+/**
+ * Execute the commands and check the sync states which are due at the current date.
+ * Commands which are due at an earlier date, because the log starts before the savegame, are executed immediately.
+ */
+void CommandLogReplay::Replay()
+{
+	const LogDate now{ static_cast<uint>(EconTime::CurDate().base()), EconTime::CurDateFract(), TickSkipCounter() };
+	for (;;) {
+		if (!this->pending) {
+			if (!this->ReadEntry()) return;
+			this->pending = true;
+		}
+		if (this->pending_date > now) return;
+		this->pending = false;
+
+		if (this->pending_sync) {
+			if (this->pending_date < now) continue;
+			this->sync_checks++;
+			if (this->pending_line.sync_state[0] != _random.state[0] || this->pending_line.sync_state[1] != _random.state[1]) {
+				this->sync_mismatches++;
+				DEBUG(misc, 0, "Benchmark: sync check: %s; mismatch expected {%08x, %08x}, got {%08x, %08x}",
+						debug_date_dumper().HexDate(), this->pending_line.sync_state[0], this->pending_line.sync_state[1], _random.state[0], _random.state[1]);
+			}
+			continue;
+		}
+
+		if (Company::IsValidAiID(this->pending_line.company) || this->pending_line.company == OWNER_DEITY) {
+			this->script_commands++;
+			continue;
+		}
+
+		Backup<CompanyID> cur_company(_current_company, this->pending_line.company, FILE_LINE);
+		DoCommandP(&this->pending_line.cmd, false);
+		cur_company.Restore();
+		this->commands++;
+	}
+}
+
+/**
+ * Get the peak resident set size of the process.
+ * @return The peak resident set size in bytes, if it is known.
+ */
+static std::optional<uint64_t> GetPeakResidentSetSize()
+{
+#if defined(_WIN32)
+	PROCESS_MEMORY_COUNTERS pmc;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) return pmc.PeakWorkingSetSize;
+#elif defined(UNIX)
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#	if defined(__APPLE__)
+		return static_cast<uint64_t>(usage.ru_maxrss);
+#	else
+		return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#	endif
+	}
+#endif
+	return std::nullopt;
+}
+
+/**
+ * Convert the measurements of a performance element to JSON.
+ * @param samples The durations of the measurements in microseconds, this is sorted.
+ * @return The JSON object.
+ */
+static nlohmann::json PerformanceElementToJson(std::vector<TimingMeasurement> &samples)
+{
+	std::sort(samples.begin(), samples.end());
+
+	uint64_t total = 0;
+	for (TimingMeasurement sample : samples) total += sample;
+
+	/* Nearest rank percentile */
+	auto percentile = [&](uint p) -> TimingMeasurement {
+		size_t rank = (samples.size() * p + 99) / 100;
+		return samples[std::max<size_t>(rank, 1) - 1];
+	};
+
+	nlohmann::json json;
+	json["samples"] = samples.size();
+	json["total_us"] = total;
+	json["mean_us"] = static_cast<double>(total) / samples.size();
+	json["p50_us"] = percentile(50);
+	json["p90_us"] = percentile(90);
+	json["p99_us"] = percentile(99);
+	json["max_us"] = samples.back();
+	return json;
+}
+
+/**
+ * Run a benchmark of the game loop, without any pacing, and write the results to a file.
+ * The game to benchmark must be loaded by the first iteration of the game loop, which is not measured.
+ * That iteration also runs the first tick of the game, so the state checksum is updated from the start,
+ * whether or not it is a network server which updates it anyway.
+ * @param ticks Number of game loop iterations to measure.
+ * @param output_file Name of the file to write the results to, as JSON.
+ * @param command_log Name of a desync log of which to replay the commands, or empty.
+ */
+void RunBenchmark(int ticks, const std::string &output_file, const std::string &command_log)
+{
+	/* Load the game */
+	_benchmark_running = true;
+	::GameLoop();
+	::InputLoop();
+	::UpdateWindows();
+	if (_game_mode != GM_NORMAL) usererror("Benchmark: no game loaded, use -g to load a savegame");
+
+	std::unique_ptr<CommandLogReplay> replay;
+	if (!command_log.empty()) {
+		FILE *f = FioFOpenFile(command_log, "rb", NO_DIRECTORY);
+		if (f == nullptr) usererror("Benchmark: cannot open command log %s", command_log.c_str());
+		replay = std::make_unique<CommandLogReplay>(f);
+	}
+
+	DEBUG(misc, 1, "Benchmark: running %d ticks", ticks);
+	const uint64_t start_tick_counter = _tick_counter;
+	StartPerformanceRecording();
+	const auto start_time = std::chrono::steady_clock::now();
+
+	int run = 0;
+	for (; run < ticks && !_exit_game; run++) {
+		if (replay != nullptr) replay->Replay();
+		::GameLoop();
+		::InputLoop();
+		::UpdateWindows();
+	}
+
+	const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time);
+	PerformanceRecording recording = StopPerformanceRecording();
+	_benchmark_running = false;
+
+	nlohmann::json json;
+	SurveyOpenTTD(json["openttd"]);
+	json["savegame"] = _file_to_saveload.name;
+	json["ticks"] = run;
+	json["game_ticks"] = _tick_counter - start_tick_counter;
+	json["wall_time_us"] = elapsed.count();
+	json["date"] = debug_date_dumper().HexDate();
+	json["random_state"] = fmt::format("{:08x}{:08x}", _random.state[0], _random.state[1]);
+	json["state_checksum"] = fmt::format("{:016x}", _state_checksum.state);
+	if (auto rss = GetPeakResidentSetSize(); rss.has_value()) {
+		json["peak_rss_bytes"] = *rss;
+	} else {
+		json["peak_rss_bytes"] = nullptr;
+	}
+	if (replay != nullptr) {
+		json["command_log"]["commands"] = replay->commands;
+		json["command_log"]["script_commands"] = replay->script_commands;
+		json["command_log"]["sync_checks"] = replay->sync_checks;
+		json["command_log"]["sync_mismatches"] = replay->sync_mismatches;
+	}
+
+	nlohmann::json &elements = json["elements"];
+	elements = nlohmann::json::object();
+	for (PerformanceElement e = PFE_FIRST; e < PFE_MAX; e++) {
+		if (recording.elements[e].empty()) continue;
+		std::string key = e < PFE_AI0 ? PERFORMANCE_ELEMENT_KEYS[e] : fmt::format("ai{}", e - PFE_AI0 + 1);
+		elements[key] = PerformanceElementToJson(recording.elements[e]);
+	}
+
+	nlohmann::json &zones = json["zones"];
+	zones = nlohmann::json::object();
+	for (PerformanceZone z = PFZ_FIRST; z < PFZ_MAX; z++) {
+		if (recording.zones[z].empty()) continue;
+		zones[PERFORMANCE_ZONE_KEYS[z]] = PerformanceElementToJson(recording.zones[z]);
+	}
+
+	FILE *f = FioFOpenFile(output_file, "w", NO_DIRECTORY);
+	if (f == nullptr) usererror("Benchmark: cannot write results to %s", output_file.c_str());
+	std::string result = json.dump(4);
+	result += '\n';
+	bool ok = fwrite(result.data(), 1, result.size(), f) == result.size();
+	ok &= fclose(f) == 0;
+	if (!ok) usererror("Benchmark: cannot write results to %s", output_file.c_str());
+
+	DEBUG(misc, 1, "Benchmark: %d ticks in %.3f s, results written to %s", run, elapsed.count() / 1000000.0, output_file.c_str());
+}
@@ -0,0 +1,17 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file benchmark.h Headless benchmark of the game loop. */
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <string>
+
+void RunBenchmark(int ticks, const std::string &output_file, const std::string &command_log);
+
+#endif /* BENCHMARK_H */
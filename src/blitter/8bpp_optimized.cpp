@@ -148,7 +148,7 @@ Sprite *Blitter_8bppOptimized::Encode(const SpriteLoader::SpriteCollection &spri
 	/* Don't allocate memory each time, but just keep some
 	 * memory around as this function is called quite often
 	 * and the memory usage is quite low. */
-	static ReusableBuffer<uint8_t> temp_buffer;
+	static thread_local ReusableBuffer<uint8_t> temp_buffer;
 	SpriteData *temp_dst = (SpriteData *)temp_buffer.Allocate(memory);
 	memset(temp_dst, 0, sizeof(*temp_dst));
 	uint8_t *dst = temp_dst->data;
@@ -381,6 +381,28 @@ static void TileLoop_Clear(TileIndex tile)
 	MarkTileDirtyByTile(tile, VMDF_NOT_MAP_MODE_NON_VEG);
 }
 
+/** @see TileLoopQuiescentProc */
+static bool IsTileLoopQuiescent_Clear(TileIndex tile)
+{
+	switch (_settings_game.game_creation.landscape) {
+		case LT_TROPIC:
+			/* TileLoopClearDesert only checks the neighbours of desert zone tiles */
+			if (GetTropicZone(tile) == TROPICZONE_DESERT || IsClearGround(tile, CLEAR_DESERT)) return false;
+			break;
+
+		case LT_ARCTIC:
+			/* TileLoopClearAlps only checks the corner heights of tiles near the snow line */
+			if ((int)TileHeight(tile) >= GetSnowLine() - 1 || IsSnowTile(tile)) return false;
+			break;
+	}
+
+	switch (GetClearGround(tile)) {
+		case CLEAR_GRASS:  return GetClearDensity(tile) == 3;
+		case CLEAR_FIELDS: return false;
+		default:           return true;
+	}
+}
+
 void GenerateClearTile()
 {
 	uint i, gi;
@@ -474,4 +496,5 @@ extern const TileTypeProcs _tile_type_clear_procs = {
 	nullptr,                     ///< vehicle_enter_tile_proc
 	GetFoundation_Clear,      ///< get_foundation_proc
 	TerraformTile_Clear,      ///< terraform_tile_proc
+	IsTileLoopQuiescent_Clear, ///< tile_loop_quiescent_proc
 };
@@ -38,6 +38,7 @@
 #include "core/checksum_func.hpp"
 #include "3rdparty/nlohmann/json.hpp"
 #include <array>
+#include <charconv>
 
 #include "table/strings.h"
 
@@ -1292,6 +1293,84 @@ CommandCost DoCommandPInternal(TileIndex tile, uint32_t p1, uint32_t p2, uint64_
 }
 #undef return_dcpi
 
+/**
+ * Parse a line of a desync command log, as written by DoCommandPInternal and the network server with "-d desync=1" or higher.
+ * @param line The line, with or without the "[date time] " prefix of the debug output.
+ * @param[out] parsed The contents of the line, depending on its type.
+ * @return The type of the line.
+ */
+CommandLogLineType ParseCommandLogLine(const char *line, CommandLogLine &parsed)
+{
+	const char *p = line;
+	/* Ignore the "[date time] " part of the message */
+	if (*p == '[') {
+		p = strchr(p, ']');
+		if (p == nullptr) return CLLT_INVALID;
+		p += 2;
+	}
+
+	const bool failed = strncmp(p, "cmdf: ", 6) == 0;
+	if (failed || strncmp(p, "cmd: ", 5) == 0) {
+		p += failed ? 6 : 5;
+		int company;
+		int offset;
+		CommandContainer &cmd = parsed.cmd;
+		int ret = sscanf(p, "date{%x; %x; %x}; company: %x; tile: %x (%*u x %*u); p1: %x; p2: %x; p3: " OTTD_PRINTFHEX64 "; cmd: %x; %n\"",
+				&parsed.date, &parsed.date_fract, &parsed.tick_skip_counter, &company, &cmd.tile, &cmd.p1, &cmd.p2, &cmd.p3, &cmd.cmd, &offset);
+		if (ret != 9) return CLLT_INVALID;
+		parsed.company = (CompanyID)company;
+		cmd.callback = nullptr;
+
+		const char *text_start = p + offset;
+		const char *text_end = text_start + 1;
+		while (*text_end != 0) {
+			char current = *text_end;
+			text_end++;
+			if (current == '"') break;
+			if (current == '\\' && *text_end != 0) {
+				text_end++;
+			}
+		}
+		auto json = nlohmann::json::parse(text_start, text_end, nullptr, false);
+		cmd.text = json.is_string() ? json.get<std::string>() : std::string{};
+
+		const char *aux_str = text_end;
+		while (*aux_str != 0 && *aux_str != '<') aux_str++;
+
+		if (aux_str[0] == '<' && aux_str[1] != '>') {
+			auto aux = std::make_unique<CommandAuxiliarySerialised>();
+			for (const char *data = aux_str + 1; data[0] != 0 && data[1] != 0 && data[0] != '>'; data += 2) {
+				uint8_t e = 0;
+				std::from_chars(data, data + 2, e, 16);
+				aux->serialised_data.emplace_back(e);
+			}
+			cmd.aux_data = std::move(aux);
+		} else {
+			cmd.aux_data = nullptr;
+		}
+		return failed ? CLLT_FAILED_COMMAND : CLLT_COMMAND;
+	}
+
+	if (strncmp(p, "join: ", 6) == 0) {
+		int ret = sscanf(p + 6, "date{%x; %x; %x}", &parsed.date, &parsed.date_fract, &parsed.tick_skip_counter);
+		return ret == 3 ? CLLT_JOIN : CLLT_INVALID;
+	}
+
+	if (strncmp(p, "sync: ", 6) == 0) {
+		int ret = sscanf(p + 6, "date{%x; %x; %x}; %x; %x", &parsed.date, &parsed.date_fract, &parsed.tick_skip_counter, &parsed.sync_state[0], &parsed.sync_state[1]);
+		return ret == 5 ? CLLT_SYNC : CLLT_INVALID;
+	}
+
+	if (strncmp(p, "msg: ", 5) == 0 || strncmp(p, "client: ", 8) == 0 ||
+			strncmp(p, "load: ", 6) == 0 || strncmp(p, "save: ", 6) == 0 ||
+			strncmp(p, "new_company: ", 13) == 0 || strncmp(p, "new_company_ai: ", 16) == 0 ||
+			strncmp(p, "buy_company: ", 13) == 0 || strncmp(p, "delete_company: ", 16) == 0) {
+		return CLLT_OTHER;
+	}
+
+	return CLLT_INVALID;
+}
+
 CommandCost::CommandCost(const CommandCost &other)
 {
 	*this = other;
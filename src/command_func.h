@@ -85,6 +85,28 @@ void ExecuteCommandQueue();
 void ClearCommandQueue();
 void EnqueueDoCommandP(CommandContainer cmd);
 
+/** Type of a line of a desync command log, see #ParseCommandLogLine. */
+enum CommandLogLineType {
+	CLLT_COMMAND,        ///< An executed command.
+	CLLT_FAILED_COMMAND, ///< A command which failed.
+	CLLT_JOIN,           ///< A client joined.
+	CLLT_SYNC,           ///< The random state of the server.
+	CLLT_OTHER,          ///< Another message, which is not needed to replay the log.
+	CLLT_INVALID,        ///< A line which cannot be parsed.
+};
+
+/** Contents of a line of a desync command log, which fields are set depends on the type of the line. */
+struct CommandLogLine {
+	uint date;              ///< Date of a command, join or sync state.
+	uint date_fract;        ///< Date fraction of a command, join or sync state.
+	uint tick_skip_counter; ///< Tick skip counter of a command, join or sync state.
+	CompanyID company;      ///< Company executing a command.
+	CommandContainer cmd{}; ///< A command.
+	uint32_t sync_state[2]; ///< The random state of a sync state.
+};
+
+CommandLogLineType ParseCommandLogLine(const char *line, CommandLogLine &parsed);
+
 /*** All command callbacks that exist ***/
 
 /* ai/ai_instance.cpp */
@@ -29,6 +29,7 @@
 #include "screenshot.h"
 #include "genworld.h"
 #include "strings_func.h"
+#include "vehicle_func.h"
 #include "viewport_func.h"
 #include "window_func.h"
 #include "date_func.h"
@@ -54,6 +55,10 @@
 #include "industry.h"
 #include "string_func_extra.h"
 #include "linkgraph/linkgraphjob.h"
+#include "linkgraph/linkgraph_export.h"
+#include "pathfinder/yapf/yapf_cache.h"
+#include "pathfinder/yapf/yapf.h"
+#include "train.h"
 #include "base_media_base.h"
 #include "debug_settings.h"
 #include "walltime_func.h"
@@ -64,8 +69,10 @@
 #include "object_base.h"
 #include "newgrf_newsignals.h"
 #include "roadstop_base.h"
+#include "framerate_type.h"
 #include "3rdparty/fmt/chrono.h"
 #include <time.h>
+#include <chrono>
 
 #include "3rdparty/cpp-btree/btree_set.h"
 
@@ -1310,7 +1317,6 @@ DEF_CONSOLE_CMD(ConReturn)
 extern bool CloseConsoleLogIfActive();
 extern const std::vector<GRFFile *> &GetAllGRFFiles();
 extern void ConPrintFramerate(); // framerate_gui.cpp
-extern void ShowFramerateWindow();
 
 DEF_CONSOLE_CMD(ConScript)
 {
@@ -2875,6 +2881,148 @@ DEF_CONSOLE_CMD(ConDumpLinkgraphJobs)
 	return true;
 }
 
+DEF_CONSOLE_CMD(ConExportLinkgraphs)
+{
+	if (argc == 0) {
+		IConsolePrint(CC_HELP, "Export all link graphs to a file in the save directory, for use with the MCF benchmark. Usage: 'export_linkgraphs <filename>'.");
+		return true;
+	}
+
+	if (argc != 2) return false;
+
+	std::string_view name = argv[1];
+	if (name.empty() || name.find_first_of("/\\:") != std::string_view::npos || name.starts_with('.')) {
+		IConsolePrint(CC_ERROR, "The link graph export file name must not be a path.");
+		return true;
+	}
+
+	std::string filename = FioFindDirectory(SAVE_DIR);
+	filename += name;
+	FILE *f = fopen(filename.c_str(), "w");
+	if (f == nullptr) {
+		IConsolePrint(CC_ERROR, "Could not open link graph export file '{}'.", filename);
+		return true;
+	}
+	bool ok = ExportLinkGraphs(f);
+	ok &= fclose(f) == 0;
+	if (ok) {
+		IConsolePrint(CC_INFO, "Exported {} link graphs to '{}'.", LinkGraph::GetNumItems(), filename);
+	} else {
+		IConsolePrint(CC_ERROR, "Failed to write link graph export file '{}'.", filename);
+	}
+	return true;
+}
+
+DEF_CONSOLE_CMD(ConYapfCacheStats)
+{
+	if (argc == 0) {
+		IConsolePrint(CC_HELP, "Show statistics of the YAPF rail and road segment cost caches. Usage: 'yapf_cache_stats [reset]'.");
+		return true;
+	}
+
+	if (argc > 2) return false;
+
+	if (argc == 2) {
+		if (!StrEqualsIgnoreCase(argv[1], "reset")) return false;
+		YapfResetSegmentCostCacheStats();
+		IConsolePrint(CC_INFO, "YAPF segment cost cache statistics reset.");
+		return true;
+	}
+
+	const YapfSegmentCostCacheStats &stats = YapfGetSegmentCostCacheStats();
+	auto print_hits = [](const char *type, uint64_t hits, uint64_t misses) {
+		const uint64_t lookups = hits + misses;
+		IConsolePrint(CC_DEFAULT, "{} hits: {}, misses: {}, hit rate: {:.1f}%", type, hits, misses, lookups > 0 ? (100.0 * hits) / lookups : 0.0);
+	};
+	IConsolePrint(CC_DEFAULT, "Cached segments: {}", YapfGetSegmentCostCacheSize());
+	print_hits("Rail", stats.rail_hits, stats.rail_misses);
+	print_hits("Road", stats.road_hits, stats.road_misses);
+	IConsolePrint(CC_DEFAULT, "Region invalidations: {}, segments invalidated: {}", stats.region_invalidations, stats.segments_invalidated);
+	IConsolePrint(CC_DEFAULT, "Full flushes: {}", stats.flushes);
+	return true;
+}
+
+DEF_CONSOLE_CMD(ConYapfRailCorridorBenchmark)
+{
+	if (argc == 0) {
+		IConsolePrint(CC_HELP, "Compare the YAPF train pathfinder with and without the rail region corridor, for every train heading for a station, waypoint or depot. Usage: 'yapf_rail_corridor_benchmark [iterations]'.");
+		return true;
+	}
+
+	if (argc > 2) return false;
+
+	uint iterations = 1;
+	if (argc == 2 && !GetArgumentInteger(&iterations, argv[1])) return false;
+	iterations = std::max<uint>(iterations, 1);
+
+	std::vector<const Train *> trains;
+	for (const Train *v : Train::IterateFrontOnly()) {
+		if (v->vehstatus & VS_CRASHED || v->IsChainInDepot()) continue;
+		if (!v->current_order.IsType(OT_GOTO_STATION) && !v->current_order.IsType(OT_GOTO_WAYPOINT) && !v->current_order.IsType(OT_GOTO_DEPOT)) continue;
+		trains.push_back(v);
+	}
+
+	struct Totals {
+		std::chrono::steady_clock::duration time{};
+		uint64_t expanded_nodes = 0;
+		uint paths_found = 0;
+		uint region_corridors_used = 0;
+	};
+	Totals totals[2];
+	uint different_choices = 0;
+	for (uint i = 0; i < iterations; i++) {
+		for (const Train *v : trains) {
+			Trackdir choice[2];
+			for (uint mode = 0; mode < 2; mode++) {
+				auto start = std::chrono::steady_clock::now();
+				YapfTrainBenchmarkResult result = YapfTrainBenchmarkChooseTrack(v, mode == 1);
+				totals[mode].time += std::chrono::steady_clock::now() - start;
+				totals[mode].expanded_nodes += result.expanded_nodes;
+				if (result.path_found) totals[mode].paths_found++;
+				if (result.region_corridor_used) totals[mode].region_corridors_used++;
+				choice[mode] = result.trackdir;
+			}
+			if (i == 0 && choice[0] != choice[1]) different_choices++;
+		}
+	}
+
+	IConsolePrint(CC_DEFAULT, "Trains: {}, iterations: {}", trains.size(), iterations);
+	auto print_totals = [&](const char *name, const Totals &t) {
+		IConsolePrint(CC_DEFAULT, "{}: {:.3f} ms, {} expanded nodes, {} paths found (per iteration)", name,
+				std::chrono::duration<double, std::milli>(t.time).count() / iterations, t.expanded_nodes / iterations, t.paths_found / iterations);
+	};
+	print_totals("Full search", totals[0]);
+	print_totals("Corridor search", totals[1]);
+	IConsolePrint(CC_DEFAULT, "Corridors used: {}, different first track choices: {}", totals[1].region_corridors_used / iterations, different_choices);
+	return true;
+}
+
+DEF_CONSOLE_CMD(ConVehicleTileHashBenchmark)
+{
+	if (argc == 0) {
+		IConsolePrint(CC_HELP, "Compare lookups of every map tile in the vehicle tile grid and in an equivalent hash map. Usage: 'vehicle_tile_hash_benchmark [iterations]'.");
+		return true;
+	}
+
+	if (argc > 2) return false;
+
+	uint iterations = 1;
+	if (argc == 2 && !GetArgumentInteger(&iterations, argv[1])) return false;
+	iterations = std::max<uint>(iterations, 1);
+
+	VehicleTileHashBenchmarkResult result = BenchmarkVehicleTileHash(iterations);
+
+	IConsolePrint(CC_DEFAULT, "Occupied tiles: {}, lookups: {}", result.occupied_tiles, result.lookups);
+	auto print_time = [&](const char *name, std::chrono::steady_clock::duration time) {
+		IConsolePrint(CC_DEFAULT, "{}: {:.3f} ms, {:.2f} ns per lookup", name,
+				std::chrono::duration<double, std::milli>(time).count(), std::chrono::duration<double, std::nano>(time).count() / std::max<uint64_t>(result.lookups, 1));
+	};
+	print_time("Tile grid", result.grid_time);
+	print_time("Hash map", result.hash_time);
+	if (result.mismatch) IConsolePrint(CC_ERROR, "Tile grid and hash map contents differ");
+	return true;
+}
+
 DEF_CONSOLE_CMD(ConDumpRoadTypes)
 {
 	if (argc == 0) {
@@ -3877,6 +4025,50 @@ DEF_CONSOLE_CMD(ConFramerateWindow)
 	return true;
 }
 
+DEF_CONSOLE_CMD(ConFramerateTrace)
+{
+	if (argc < 2) {
+		IConsolePrint(CC_HELP, "Capture a trace of the game loop performance elements and zones, which can be viewed in Perfetto or chrome://tracing. Sub-commands can be abbreviated.");
+		IConsolePrint(CC_HELP, "Usage: 'fps_trace start [<num-ticks>]':");
+		IConsolePrint(CC_HELP, "  Begin capturing a trace. If a number of ticks is provided, the trace is written after that many game ticks.");
+		IConsolePrint(CC_HELP, "Usage: 'fps_trace stop':");
+		IConsolePrint(CC_HELP, "  End capturing and write the trace to a JSON file in the screenshot directory.");
+		IConsolePrint(CC_HELP, "Usage: 'fps_trace abort':");
+		IConsolePrint(CC_HELP, "  End capturing and discard the trace.");
+		return true;
+	}
+
+	/* "start" sub-command */
+	if (StrStartsWithIgnoreCase(argv[1], "sta")) {
+		uint ticks = argc >= 3 ? std::max(atoi(argv[2]), 1) : 0;
+		if (!StartPerformanceTrace(ticks)) {
+			IConsolePrint(CC_ERROR, "A performance trace is already being captured.");
+			return true;
+		}
+		if (ticks > 0) {
+			IConsolePrint(CC_DEBUG, "Started performance trace, it will automatically stop after {} ticks.", ticks);
+		} else {
+			IConsolePrint(CC_DEBUG, "Started performance trace.");
+		}
+		return true;
+	}
+
+	/* "stop" sub-command */
+	if (StrStartsWithIgnoreCase(argv[1], "sto")) {
+		if (!FinishPerformanceTrace()) IConsolePrint(CC_ERROR, "No performance trace is being captured.");
+		return true;
+	}
+
+	/* "abort" sub-command */
+	if (StrStartsWithIgnoreCase(argv[1], "abo")) {
+		AbortPerformanceTrace();
+		IConsolePrint(CC_DEBUG, "Performance trace aborted.");
+		return true;
+	}
+
+	return false;
+}
+
 DEF_CONSOLE_CMD(ConFindNonRealisticBrakingSignal)
 {
 	if (argc == 0) {
@@ -4095,6 +4287,7 @@ void IConsoleStdLibRegister()
 #endif
 	IConsole::CmdRegister("fps",                     ConFramerate);
 	IConsole::CmdRegister("fps_wnd",                 ConFramerateWindow);
+	IConsole::CmdRegister("fps_trace",               ConFramerateTrace);
 
 	IConsole::CmdRegister("find_non_realistic_braking_signal", ConFindNonRealisticBrakingSignal);
 
@@ -4111,6 +4304,10 @@ void IConsoleStdLibRegister()
 	IConsole::CmdRegister("dump_load_debug_log",     ConDumpLoadDebugLog, nullptr, true);
 	IConsole::CmdRegister("dump_load_debug_config",  ConDumpLoadDebugConfig, nullptr, true);
 	IConsole::CmdRegister("dump_linkgraph_jobs",     ConDumpLinkgraphJobs, nullptr, true);
+	IConsole::CmdRegister("export_linkgraphs",       ConExportLinkgraphs, nullptr, true);
+	IConsole::CmdRegister("yapf_cache_stats",        ConYapfCacheStats,   nullptr, true);
+	IConsole::CmdRegister("yapf_rail_corridor_benchmark", ConYapfRailCorridorBenchmark, nullptr, true);
+	IConsole::CmdRegister("vehicle_tile_hash_benchmark", ConVehicleTileHashBenchmark, nullptr, true);
 	IConsole::CmdRegister("dump_road_types",         ConDumpRoadTypes,    nullptr, true);
 	IConsole::CmdRegister("dump_rail_types",         ConDumpRailTypes,    nullptr, true);
 	IConsole::CmdRegister("dump_bridge_types",       ConDumpBridgeTypes,  nullptr, true);
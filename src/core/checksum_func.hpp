@@ -33,13 +33,14 @@ struct SimpleChecksum64 {
 };
 
 extern SimpleChecksum64 _state_checksum;
+extern bool _benchmark_running;
 
 inline void UpdateStateChecksum(uint64_t input)
 {
 #if defined(DEDICATED)
 	_state_checksum.Update(input);
 #else
-	if (_networking) _state_checksum.Update(input);
+	if (_networking || _benchmark_running) _state_checksum.Update(input);
 #endif
 }
 
@@ -23,6 +23,8 @@ enum ChickenBitFlags {
 	DCBF_CMD_NO_TEST_ALL               = 6,
 	DCBF_WATER_REGION_CLEAR            = 7,
 	DCBF_WATER_REGION_INIT_ALL         = 8,
+	DCBF_NO_TRAIN_TICK_PLAN            = 9,
+	DCBF_TRAIN_TICK_PLAN_CHECK         = 10,
 };
 
 inline bool HasChickenBit(ChickenBitFlags flag)
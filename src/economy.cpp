@@ -59,6 +59,7 @@
 #include "debug_desync.h"
 #include "event_logs.h"
 #include "plans_func.h"
+#include "framerate_type.h"
 
 #include "table/strings.h"
 #include "table/pricebase.h"
@@ -2419,6 +2420,8 @@ void LoadUnloadStation(Station *st)
 	/* No vehicle is here... */
 	if (st->loading_vehicles.empty()) return;
 
+	PerformanceZoneMeasurer framerate(PFZ_LOAD_UNLOAD);
+
 	Vehicle *last_loading = nullptr;
 
 	/* Check if anything will be loaded at all. Otherwise we don't need to reserve either. */
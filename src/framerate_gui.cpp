@@ -18,6 +18,11 @@
 #include "console_func.h"
 #include "console_type.h"
 #include "guitimer_func.h"
+#include "fileio_func.h"
+#include "thread.h"
+#include "walltime_func.h"
+#include "timer/timer.h"
+#include "timer/timer_game_tick.h"
 #include "company_base.h"
 #include "ai/ai_info.hpp"
 #include "ai/ai_instance.hpp"
@@ -26,6 +31,7 @@
 
 #include "widgets/framerate_widget.h"
 
+#include <algorithm>
 #include <atomic>
 #include <mutex>
 #include <vector>
@@ -46,6 +52,9 @@ namespace {
 	/** %Units a second is divided into in performance measurements */
 	const TimingMeasurement TIMESTAMP_PRECISION = 1000000;
 
+	/** Start time of the current performance recording, only measurements starting at or after this time are recorded */
+	TimingMeasurement _pf_recording_start = 0;
+
 	struct PerformanceData {
 		/** Duration value indicating the value is not valid should be considered a gap in measurements */
 		static const TimingMeasurement INVALID_DURATION = UINT64_MAX;
@@ -68,19 +77,23 @@ namespace {
 		/** Start time for current accumulation cycle */
 		TimingMeasurement acc_timestamp;
 
+		/** Every measurement taken while a performance recording is active, or nullptr */
+		std::vector<TimingMeasurement> *recording;
+
 		/**
 		 * Initialize a data element with an expected collection rate
 		 * @param expected_rate
 		 * Expected number of cycles per second of the performance element. Use 1 if unknown or not relevant.
 		 * The rate is used for highlighting slow-running elements in the GUI.
 		 */
-		explicit PerformanceData(double expected_rate) : expected_rate(expected_rate), next_index(0), prev_index(0), num_valid(0) { }
+		explicit PerformanceData(double expected_rate) : expected_rate(expected_rate), next_index(0), prev_index(0), num_valid(0), recording(nullptr) { }
 
 		/** Collect a complete measurement, given start and ending times for a processing block */
 		void Add(TimingMeasurement start_time, TimingMeasurement end_time)
 		{
 			this->durations[this->next_index] = end_time - start_time;
 			this->timestamps[this->next_index] = start_time;
+			if (this->recording != nullptr && start_time >= _pf_recording_start) this->recording->push_back(end_time - start_time);
 			this->prev_index = this->next_index;
 			this->next_index += 1;
 			if (this->next_index >= NUM_FRAMERATE_POINTS) this->next_index = 0;
@@ -92,6 +105,7 @@ namespace {
 		{
 			this->timestamps[this->next_index] = this->acc_timestamp;
 			this->durations[this->next_index] = this->acc_duration;
+			if (this->recording != nullptr && this->acc_timestamp >= _pf_recording_start) this->recording->push_back(this->acc_duration);
 			this->prev_index = this->next_index;
 			this->next_index += 1;
 			if (this->next_index >= NUM_FRAMERATE_POINTS) this->next_index = 0;
@@ -217,6 +231,105 @@ namespace {
 		PerformanceData(1),                     // PFE_AI14
 	};
 
+	/** Measurements of a performance zone, accumulated per game loop cycle */
+	struct PerformanceZoneData : PerformanceData {
+		/** Number of times the zone was entered in each cycle, circular buffer in step with \c durations */
+		uint32_t calls[NUM_FRAMERATE_POINTS];
+		/** Number of times the zone was entered in the current cycle */
+		uint32_t acc_calls;
+		/** Number of nested scopes of the zone which are currently open */
+		uint depth;
+		/** Performance element the zone is a part of */
+		PerformanceElement parent;
+
+		explicit PerformanceZoneData(PerformanceElement parent) : PerformanceData(1), acc_calls(0), depth(0), parent(parent) { }
+
+		/** Store the previous cycle and begin a new cycle of accumulating measurements */
+		void BeginCycle(TimingMeasurement start_time)
+		{
+			this->calls[this->next_index] = this->acc_calls;
+			this->acc_calls = 0;
+			this->BeginAccumulate(start_time);
+		}
+
+		/** Get average number of calls per cycle over a number of data points */
+		double GetAverageCalls(int count)
+		{
+			count = std::min(count, this->num_valid);
+
+			int first_point = this->prev_index - count;
+			if (first_point < 0) first_point += NUM_FRAMERATE_POINTS;
+
+			uint64_t sumcalls = 0;
+			for (int i = first_point; i < first_point + count; i++) {
+				if (this->durations[i % NUM_FRAMERATE_POINTS] != INVALID_DURATION) {
+					sumcalls += this->calls[i % NUM_FRAMERATE_POINTS];
+				} else {
+					count--;
+				}
+			}
+
+			if (count == 0) return 0;
+			return (double)sumcalls / count;
+		}
+	};
+
+	/**
+	 * Storage for all performance zone measurements.
+	 * Zones are initialized with the performance element they are a part of.
+	 * @hideinitializer
+	 */
+	PerformanceZoneData _pf_zone_data[PFZ_MAX] = {
+		PerformanceZoneData(PFE_GL_ECONOMY),   // PFZ_LOAD_UNLOAD
+		PerformanceZoneData(PFE_GL_TRAINS),    // PFZ_TRAIN_PATHFINDER
+		PerformanceZoneData(PFE_GL_ROADVEHS),  // PFZ_ROADVEH_PATHFINDER
+		PerformanceZoneData(PFE_GL_SHIPS),     // PFZ_SHIP_PATHFINDER
+		PerformanceZoneData(PFE_GL_LANDSCAPE), // PFZ_ANIMATED_TILES
+		PerformanceZoneData(PFE_GL_LANDSCAPE), // PFZ_TILE_LOOP
+		PerformanceZoneData(PFE_GL_LANDSCAPE), // PFZ_TOWNS
+		PerformanceZoneData(PFE_GL_LANDSCAPE), // PFZ_STATION_RATINGS
+		PerformanceZoneData(PFE_GL_LANDSCAPE), // PFZ_INDUSTRIES
+	};
+
+	/** Item number of the first performance zone, items are numbered with the elements first */
+	const uint PF_ZONE_ITEM = PFE_MAX;
+	/** Number of performance elements and zones */
+	const uint PF_ITEM_COUNT = PF_ZONE_ITEM + PFZ_MAX;
+
+	/**
+	 * Performance elements and zones are shown together, as items numbered with the elements first.
+	 * @param item #PerformanceElement, or \c PF_ZONE_ITEM plus #PerformanceZone.
+	 */
+	PerformanceData &GetItemData(uint item)
+	{
+		if (item < PF_ZONE_ITEM) return _pf_data[item];
+		return _pf_zone_data[item - PF_ZONE_ITEM];
+	}
+
+	/** A measurement of a performance element or zone captured for a performance trace */
+	struct PerformanceTraceEvent {
+		TimingMeasurement start;    ///< Start time of the measurement
+		TimingMeasurement duration; ///< Duration of the measurement
+		uint item;                  ///< #PerformanceElement, or \c PF_ZONE_ITEM plus #PerformanceZone
+	};
+
+	/** Maximum number of events of a performance trace */
+	const size_t MAX_TRACE_EVENTS = 1 << 22;
+
+	/** Is a performance trace being captured? */
+	bool _pf_trace_active = false;
+	/** Start time of the current performance trace */
+	TimingMeasurement _pf_trace_start;
+	/** Events of the current performance trace */
+	std::vector<PerformanceTraceEvent> _pf_trace_events;
+
+	/** Capture an event for the current performance trace, measurements made by threads other than the game thread are ignored */
+	void AddTraceEvent(TimingMeasurement start_time, TimingMeasurement end_time, uint item)
+	{
+		if (_pf_trace_events.size() >= MAX_TRACE_EVENTS || !IsGameThread()) return;
+		_pf_trace_events.push_back({ start_time, end_time - start_time, item });
+	}
+
 }
 
 
@@ -265,7 +378,9 @@ PerformanceMeasurer::~PerformanceMeasurer()
 		_sound_perf_pending.store(true, std::memory_order_release);
 		return;
 	}
-	_pf_data[this->elem].Add(this->start_time, GetPerformanceTimer());
+	TimingMeasurement end = GetPerformanceTimer();
+	_pf_data[this->elem].Add(this->start_time, end);
+	if (_pf_trace_active) AddTraceEvent(this->start_time, end, this->elem);
 }
 
 /** Set the rate of expected cycles per second of a performance element. */
@@ -307,7 +422,9 @@ PerformanceAccumulator::PerformanceAccumulator(PerformanceElement elem)
 /** Finish and add one block of the accumulating value. */
 PerformanceAccumulator::~PerformanceAccumulator()
 {
-	_pf_data[this->elem].AddAccumulate(GetPerformanceTimer() - this->start_time);
+	TimingMeasurement end = GetPerformanceTimer();
+	_pf_data[this->elem].AddAccumulate(end - this->start_time);
+	if (_pf_trace_active) AddTraceEvent(this->start_time, end, this->elem);
 }
 
 /**
@@ -321,17 +438,246 @@ void PerformanceAccumulator::Reset(PerformanceElement elem)
 }
 
 
-void ShowFrametimeGraphWindow(PerformanceElement elem);
+/**
+ * Begin measuring one block of a zone.
+ * @param zone The zone to be measured
+ */
+PerformanceZoneMeasurer::PerformanceZoneMeasurer(PerformanceZone zone)
+{
+	assert(zone < PFZ_MAX);
+
+	this->zone = zone;
+	PerformanceZoneData &pf = _pf_zone_data[zone];
+	pf.acc_calls++;
+	if (pf.depth++ == 0) this->start_time = GetPerformanceTimer();
+}
+
+/** Finish and add one block of a zone, unless it is nested in another block of the same zone. */
+PerformanceZoneMeasurer::~PerformanceZoneMeasurer()
+{
+	PerformanceZoneData &pf = _pf_zone_data[this->zone];
+	if (--pf.depth != 0) return;
+
+	TimingMeasurement end = GetPerformanceTimer();
+	pf.AddAccumulate(end - this->start_time);
+	if (_pf_trace_active) AddTraceEvent(this->start_time, end, PF_ZONE_ITEM + this->zone);
+}
+
+/**
+ * Store the measurements of all zones and reset them for a new game loop cycle.
+ * @note This function must be called once per game loop cycle, otherwise measurements are not collected.
+ */
+/* static */ void PerformanceZoneMeasurer::Reset()
+{
+	TimingMeasurement now = GetPerformanceTimer();
+	for (PerformanceZoneData &pf : _pf_zone_data) {
+		pf.BeginCycle(now);
+	}
+}
+
+/** Indicate a game loop cycle of "pause" where none of the zones are processed. */
+/* static */ void PerformanceZoneMeasurer::Paused()
+{
+	TimingMeasurement now = GetPerformanceTimer();
+	for (PerformanceZoneData &pf : _pf_zone_data) {
+		pf.AddPause(now);
+	}
+}
+
+/**
+ * Start recording every measurement of every performance element, regardless of the size of the buffers used for display.
+ * Any recording already in progress is discarded.
+ */
+void StartPerformanceRecording()
+{
+	static std::array<std::vector<TimingMeasurement>, PF_ITEM_COUNT> recordings;
+
+	_pf_recording_start = GetPerformanceTimer();
+	for (uint item = 0; item < PF_ITEM_COUNT; item++) {
+		recordings[item].clear();
+		GetItemData(item).recording = &recordings[item];
+	}
+}
+
+/**
+ * Stop recording the measurements of performance elements.
+ * @return The durations of the measurements of each performance element and zone made since StartPerformanceRecording, in microseconds.
+ */
+PerformanceRecording StopPerformanceRecording()
+{
+	PerformanceRecording result;
+	for (uint item = 0; item < PF_ITEM_COUNT; item++) {
+		PerformanceData &pf = GetItemData(item);
+		if (pf.recording == nullptr) continue;
+
+		/* Include the accumulation cycle which is still in progress */
+		if (pf.acc_timestamp >= _pf_recording_start) pf.recording->push_back(pf.acc_duration);
+		std::vector<TimingMeasurement> &samples = item < PF_ZONE_ITEM ? result.elements[item] : result.zones[item - PF_ZONE_ITEM];
+		samples = std::move(*pf.recording);
+		pf.recording->clear();
+		pf.recording = nullptr;
+	}
+	return result;
+}
+
+
+static const char * GetAIName(int ai_index)
+{
+	if (!Company::IsValidAiID(ai_index)) return "";
+	return Company::Get(ai_index)->ai_info->GetName().c_str();
+}
+
+/**
+ * Get the name of a performance element or zone, as shown in the caption of its graph window.
+ * @param item #PerformanceElement, or \c PF_ZONE_ITEM plus #PerformanceZone.
+ * @return The name.
+ */
+static std::string GetItemCaption(uint item)
+{
+	if (item >= PF_ZONE_ITEM) return GetString(STR_FRAMETIME_CAPTION_ZONE_LOAD_UNLOAD + (item - PF_ZONE_ITEM));
+	if (item < PFE_AI0) return GetString(STR_FRAMETIME_CAPTION_GAMELOOP + item);
+	SetDParam(0, item - PFE_AI0 + 1);
+	SetDParamStr(1, GetAIName(item - PFE_AI0));
+	return GetString(STR_FRAMETIME_CAPTION_AI);
+}
+
+/**
+ * Quote a string for JSON output.
+ * @param str The string.
+ * @return The quoted and escaped string.
+ */
+static std::string QuoteJsonString(std::string_view str)
+{
+	std::string result = "\"";
+	for (char c : str) {
+		if (c == '"' || c == '\\') {
+			result += '\\';
+			result += c;
+		} else if (static_cast<uint8_t>(c) < 0x20) {
+			fmt::format_to(std::back_inserter(result), "\\u{:04x}", c);
+		} else {
+			result += c;
+		}
+	}
+	result += '"';
+	return result;
+}
+
+/** Finish the current performance trace when the number of ticks it was started for have passed. */
+static TimeoutTimer<TimerGameTick> _pf_trace_timeout({ TimerGameTick::Priority::NONE, 0 }, []()
+{
+	FinishPerformanceTrace();
+});
+
+/**
+ * Start capturing all measurements of performance elements and zones made by the game thread, to be written as a trace file.
+ * @param ticks Number of game ticks after which to finish the trace, or 0 to only finish it with FinishPerformanceTrace.
+ * @return False if a trace is already being captured.
+ */
+bool StartPerformanceTrace(uint ticks)
+{
+	if (_pf_trace_active) return false;
+
+	_pf_trace_events.clear();
+	_pf_trace_start = GetPerformanceTimer();
+	_pf_trace_active = true;
+	if (ticks > 0) _pf_trace_timeout.Reset({ TimerGameTick::Priority::NONE, ticks });
+	return true;
+}
+
+/**
+ * Finish capturing the current performance trace, and write it to a file in the Chrome trace event format,
+ * which can be opened by Perfetto and chrome://tracing.
+ * @return False if no trace is being captured.
+ */
+bool FinishPerformanceTrace()
+{
+	_pf_trace_timeout.Abort();
+	if (!_pf_trace_active) return false;
+	_pf_trace_active = false;
+
+	if (_pf_trace_events.empty()) {
+		IConsolePrint(CC_DEBUG, "Finished performance trace, no events collected, not writing a file");
+		return true;
+	}
+
+	char timestamp[16] = {};
+	LocalTime::Format(timestamp, lastof(timestamp), "%Y%m%d-%H%M%S");
+	std::string filename = fmt::format("{}fpstrace-{}.json", FiosGetScreenshotDir(), timestamp);
+
+	FILE *f = FioFOpenFile(filename, "w", Subdirectory::NO_DIRECTORY);
+	if (f == nullptr) {
+		IConsolePrint(CC_ERROR, "Cannot write performance trace to {}", filename);
+		_pf_trace_events.clear();
+		return true;
+	}
+	FileCloser fcloser(f);
+
+	IConsolePrint(CC_DEBUG, "Finished performance trace, writing {} events{} to {}",
+			_pf_trace_events.size(), _pf_trace_events.size() >= MAX_TRACE_EVENTS ? " (truncated)" : "", filename);
 
+	/* Events are captured when they end, sort them by start time with outer events first */
+	std::sort(_pf_trace_events.begin(), _pf_trace_events.end(), [](const PerformanceTraceEvent &a, const PerformanceTraceEvent &b) {
+		if (a.start != b.start) return a.start < b.start;
+		return a.duration > b.duration;
+	});
 
-static const PerformanceElement DISPLAY_ORDER_PFE[PFE_MAX] = {
+	std::array<std::string, PF_ITEM_COUNT> names;
+	for (uint item = 0; item < PF_ITEM_COUNT; item++) {
+		names[item] = QuoteJsonString(GetItemCaption(item));
+	}
+
+	std::string buffer = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	buffer += "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"OpenTTD\"}},\n";
+	buffer += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"Game\"}}";
+	for (const PerformanceTraceEvent &ev : _pf_trace_events) {
+		TimingMeasurement start = ev.start >= _pf_trace_start ? ev.start - _pf_trace_start : 0;
+		fmt::format_to(std::back_inserter(buffer), ",\n{{\"name\":{},\"cat\":\"{}\",\"ph\":\"X\",\"ts\":{},\"dur\":{},\"pid\":1,\"tid\":1}}",
+				names[ev.item], ev.item < PF_ZONE_ITEM ? "element" : "zone", start, ev.duration);
+		if (buffer.size() >= 65536) {
+			fwrite(buffer.data(), 1, buffer.size(), f);
+			buffer.clear();
+		}
+	}
+	buffer += "\n]}\n";
+	fwrite(buffer.data(), 1, buffer.size(), f);
+
+	_pf_trace_events.clear();
+	_pf_trace_events.shrink_to_fit();
+	return true;
+}
+
+/** Stop capturing the current performance trace and discard it. */
+void AbortPerformanceTrace()
+{
+	_pf_trace_timeout.Abort();
+	_pf_trace_active = false;
+	_pf_trace_events.clear();
+	_pf_trace_events.shrink_to_fit();
+}
+
+
+void ShowFrametimeGraphWindow(uint item);
+
+
+/** Display order of performance elements and zones, zones are numbered after the elements */
+static const uint DISPLAY_ORDER_PFE[PF_ITEM_COUNT] = {
 	PFE_GAMELOOP,
 	PFE_GL_ECONOMY,
+	PF_ZONE_ITEM + PFZ_LOAD_UNLOAD,
 	PFE_GL_TRAINS,
+	PF_ZONE_ITEM + PFZ_TRAIN_PATHFINDER,
 	PFE_GL_ROADVEHS,
+	PF_ZONE_ITEM + PFZ_ROADVEH_PATHFINDER,
 	PFE_GL_SHIPS,
+	PF_ZONE_ITEM + PFZ_SHIP_PATHFINDER,
 	PFE_GL_AIRCRAFT,
 	PFE_GL_LANDSCAPE,
+	PF_ZONE_ITEM + PFZ_ANIMATED_TILES,
+	PF_ZONE_ITEM + PFZ_TILE_LOOP,
+	PF_ZONE_ITEM + PFZ_TOWNS,
+	PF_ZONE_ITEM + PFZ_STATION_RATINGS,
+	PF_ZONE_ITEM + PFZ_INDUSTRIES,
 	PFE_ALLSCRIPTS,
 	PFE_GAMESCRIPT,
 	PFE_AI0,
@@ -356,10 +702,18 @@ static const PerformanceElement DISPLAY_ORDER_PFE[PFE_MAX] = {
 	PFE_SOUND,
 };
 
-static const char * GetAIName(int ai_index)
+/**
+ * Get the string for the name of a performance element or zone in the frame rate window, and set its parameters.
+ * @param item #PerformanceElement, or \c PF_ZONE_ITEM plus #PerformanceZone.
+ * @return The string.
+ */
+static StringID GetItemNameString(uint item)
 {
-	if (!Company::IsValidAiID(ai_index)) return "";
-	return Company::Get(ai_index)->ai_info->GetName().c_str();
+	if (item >= PF_ZONE_ITEM) return STR_FRAMERATE_ZONE_LOAD_UNLOAD + (item - PF_ZONE_ITEM);
+	if (item < PFE_AI0) return STR_FRAMERATE_GAMELOOP + item;
+	SetDParam(0, item - PFE_AI0 + 1);
+	SetDParamStr(1, GetAIName(item - PFE_AI0));
+	return STR_FRAMERATE_AI;
 }
 
 /** @hideinitializer */
@@ -435,8 +789,8 @@ struct FramerateWindow : Window {
 	CachedDecimal rate_gameloop;            ///< cached game loop tick rate
 	CachedDecimal rate_drawing;             ///< cached drawing frame rate
 	CachedDecimal speed_gameloop;           ///< cached game loop speed factor
-	CachedDecimal times_shortterm[PFE_MAX]; ///< cached short term average times
-	CachedDecimal times_longterm[PFE_MAX];  ///< cached long term average times
+	CachedDecimal times_shortterm[PF_ITEM_COUNT]; ///< cached short term average times
+	CachedDecimal times_longterm[PF_ITEM_COUNT];  ///< cached long term average times
 
 	static constexpr int MIN_ELEMENTS = 5;      ///< smallest number of elements to display
 
@@ -483,12 +837,13 @@ struct FramerateWindow : Window {
 		this->rate_drawing.SetRate(_pf_data[PFE_DRAWING].GetRate(), _settings_client.gui.refresh_rate);
 
 		int new_active = 0;
-		for (PerformanceElement e = PFE_FIRST; e < PFE_MAX; e++) {
-			this->times_shortterm[e].SetTime(_pf_data[e].GetAverageDurationMilliseconds(8), MILLISECONDS_PER_TICK);
-			this->times_longterm[e].SetTime(_pf_data[e].GetAverageDurationMilliseconds(NUM_FRAMERATE_POINTS), MILLISECONDS_PER_TICK);
-			if (_pf_data[e].num_valid > 0) {
+		for (uint e = 0; e < PF_ITEM_COUNT; e++) {
+			PerformanceData &pf = GetItemData(e);
+			this->times_shortterm[e].SetTime(pf.GetAverageDurationMilliseconds(8), MILLISECONDS_PER_TICK);
+			this->times_longterm[e].SetTime(pf.GetAverageDurationMilliseconds(NUM_FRAMERATE_POINTS), MILLISECONDS_PER_TICK);
+			if (pf.num_valid > 0) {
 				new_active++;
-				if (e == PFE_GAMESCRIPT || e >= PFE_AI0) have_script = true;
+				if (e == PFE_GAMESCRIPT || (e >= PFE_AI0 && e < PF_ZONE_ITEM)) have_script = true;
 			}
 		}
 
@@ -561,16 +916,9 @@ struct FramerateWindow : Window {
 				size->height = GetCharacterHeight(FS_NORMAL) + WidgetDimensions::scaled.vsep_normal + MIN_ELEMENTS * GetCharacterHeight(FS_NORMAL);
 				resize->width = 0;
 				resize->height = GetCharacterHeight(FS_NORMAL);
-				for (PerformanceElement e : DISPLAY_ORDER_PFE) {
-					if (_pf_data[e].num_valid == 0) continue;
-					Dimension line_size;
-					if (e < PFE_AI0) {
-						line_size = GetStringBoundingBox(STR_FRAMERATE_GAMELOOP + e);
-					} else {
-						SetDParam(0, e - PFE_AI0 + 1);
-						SetDParamStr(1, GetAIName(e - PFE_AI0));
-						line_size = GetStringBoundingBox(STR_FRAMERATE_AI);
-					}
+				for (uint e : DISPLAY_ORDER_PFE) {
+					if (GetItemData(e).num_valid == 0) continue;
+					Dimension line_size = GetStringBoundingBox(GetItemNameString(e));
 					size->width = std::max(size->width, line_size.width);
 				}
 				break;
@@ -601,8 +949,8 @@ struct FramerateWindow : Window {
 		int y = r.top;
 		DrawString(r.left, r.right, y, heading_str, TC_FROMSTRING, SA_CENTER, true);
 		y += GetCharacterHeight(FS_NORMAL) + WidgetDimensions::scaled.vsep_normal;
-		for (PerformanceElement e : DISPLAY_ORDER_PFE) {
-			if (_pf_data[e].num_valid == 0) continue;
+		for (uint e : DISPLAY_ORDER_PFE) {
+			if (GetItemData(e).num_valid == 0) continue;
 			if (skip > 0) {
 				skip--;
 			} else {
@@ -623,11 +971,11 @@ struct FramerateWindow : Window {
 		int y = r.top;
 		DrawString(r.left, r.right, y, STR_FRAMERATE_MEMORYUSE, TC_FROMSTRING, SA_CENTER, true);
 		y += GetCharacterHeight(FS_NORMAL) + WidgetDimensions::scaled.vsep_normal;
-		for (PerformanceElement e : DISPLAY_ORDER_PFE) {
-			if (_pf_data[e].num_valid == 0) continue;
+		for (uint e : DISPLAY_ORDER_PFE) {
+			if (GetItemData(e).num_valid == 0) continue;
 			if (skip > 0) {
 				skip--;
-			} else if (e == PFE_GAMESCRIPT || e >= PFE_AI0) {
+			} else if (e == PFE_GAMESCRIPT || (e >= PFE_AI0 && e < PF_ZONE_ITEM)) {
 				if (e == PFE_GAMESCRIPT) {
 					SetDParam(0, Game::GetInstance()->GetAllocatedMemory());
 				} else {
@@ -655,18 +1003,12 @@ struct FramerateWindow : Window {
 				int32_t skip = sb->GetPosition();
 				int drawable = this->num_displayed;
 				int y = r.top + GetCharacterHeight(FS_NORMAL) + WidgetDimensions::scaled.vsep_normal; // first line contains headings in the value columns
-				for (PerformanceElement e : DISPLAY_ORDER_PFE) {
-					if (_pf_data[e].num_valid == 0) continue;
+				for (uint e : DISPLAY_ORDER_PFE) {
+					if (GetItemData(e).num_valid == 0) continue;
 					if (skip > 0) {
 						skip--;
 					} else {
-						if (e < PFE_AI0) {
-							DrawString(r.left, r.right, y, STR_FRAMERATE_GAMELOOP + e, TC_FROMSTRING, SA_LEFT);
-						} else {
-							SetDParam(0, e - PFE_AI0 + 1);
-							SetDParamStr(1, GetAIName(e - PFE_AI0));
-							DrawString(r.left, r.right, y, STR_FRAMERATE_AI, TC_FROMSTRING, SA_LEFT);
-						}
+						DrawString(r.left, r.right, y, GetItemNameString(e), TC_FROMSTRING, SA_LEFT);
 						y += GetCharacterHeight(FS_NORMAL);
 						drawable--;
 						if (drawable == 0) break;
@@ -700,8 +1042,8 @@ struct FramerateWindow : Window {
 				if (line != INT32_MAX) {
 					line++;
 					/* Find the visible line that was clicked */
-					for (PerformanceElement e : DISPLAY_ORDER_PFE) {
-						if (_pf_data[e].num_valid > 0) line--;
+					for (uint e : DISPLAY_ORDER_PFE) {
+						if (GetItemData(e).num_valid > 0) line--;
 						if (line == 0) {
 							ShowFrametimeGraphWindow(e);
 							break;
@@ -748,12 +1090,12 @@ struct FrametimeGraphWindow : Window {
 	int horizontal_scale;     ///< number of half-second units horizontally
 	GUITimer next_scale_update; ///< interval for next scale update
 
-	PerformanceElement element; ///< what element this window renders graph for
+	uint element;               ///< what element or zone this window renders graph for, zones are numbered after the elements
 	Dimension graph_size;       ///< size of the main graph area (excluding axis labels)
 
 	FrametimeGraphWindow(WindowDesc *desc, WindowNumber number) : Window(desc)
 	{
-		this->element = (PerformanceElement)number;
+		this->element = number;
 		this->horizontal_scale = 4;
 		this->vertical_scale = TIMESTAMP_PRECISION / 10;
 		this->next_scale_update.SetInterval(1);
@@ -765,7 +1107,9 @@ struct FrametimeGraphWindow : Window {
 	{
 		switch (widget) {
 			case WID_FGW_CAPTION:
-				if (this->element < PFE_AI0) {
+				if (this->element >= PF_ZONE_ITEM) {
+					SetDParam(0, STR_FRAMETIME_CAPTION_ZONE_LOAD_UNLOAD + (this->element - PF_ZONE_ITEM));
+				} else if (this->element < PFE_AI0) {
 					SetDParam(0, STR_FRAMETIME_CAPTION_GAMELOOP + this->element);
 				} else {
 					SetDParam(0, STR_FRAMETIME_CAPTION_AI);
@@ -840,10 +1184,11 @@ struct FrametimeGraphWindow : Window {
 	/** Recalculate the graph scaling factors based on current recorded data */
 	void UpdateScale()
 	{
-		const TimingMeasurement *durations = _pf_data[this->element].durations;
-		const TimingMeasurement *timestamps = _pf_data[this->element].timestamps;
-		int num_valid = _pf_data[this->element].num_valid;
-		int point = _pf_data[this->element].prev_index;
+		const PerformanceData &pf = GetItemData(this->element);
+		const TimingMeasurement *durations = pf.durations;
+		const TimingMeasurement *timestamps = pf.timestamps;
+		int num_valid = pf.num_valid;
+		int point = pf.prev_index;
 
 		TimingMeasurement lastts = timestamps[point];
 		TimingMeasurement time_sum = 0;
@@ -902,9 +1247,10 @@ struct FrametimeGraphWindow : Window {
 	void DrawWidget(const Rect &r, WidgetID widget) const override
 	{
 		if (widget == WID_FGW_GRAPH) {
-			const TimingMeasurement *durations  = _pf_data[this->element].durations;
-			const TimingMeasurement *timestamps = _pf_data[this->element].timestamps;
-			int point = _pf_data[this->element].prev_index;
+			const PerformanceData &pf = GetItemData(this->element);
+			const TimingMeasurement *durations  = pf.durations;
+			const TimingMeasurement *timestamps = pf.timestamps;
+			int point = pf.prev_index;
 
 			const int x_zero = r.right - (int)this->graph_size.width;
 			const int x_max = r.right;
@@ -1028,11 +1374,11 @@ void ShowFramerateWindow()
 	AllocateWindowDescFront<FramerateWindow>(&_framerate_display_desc, 0);
 }
 
-/** Open a graph window for a performance element */
-void ShowFrametimeGraphWindow(PerformanceElement elem)
+/** Open a graph window for a performance element or zone, zones are numbered after the elements */
+void ShowFrametimeGraphWindow(uint item)
 {
-	if (elem < PFE_FIRST || elem >= PFE_MAX) return; // maybe warn?
-	AllocateWindowDescFront<FrametimeGraphWindow>(&_frametime_graph_window_desc, elem, true);
+	if (item >= PF_ITEM_COUNT) return; // maybe warn?
+	AllocateWindowDescFront<FrametimeGraphWindow>(&_frametime_graph_window_desc, item, true);
 }
 
 /** Print performance statistics to game console */
@@ -1060,6 +1406,17 @@ void ConPrintFramerate()
 		"AI/GS scripts total",
 		"Game script",
 	};
+	static const char *ZONE_NAMES[PFZ_MAX] = {
+		"    GL loading/unloading",
+		"    GL train pathfinder",
+		"    GL road vehicle pathfinder",
+		"    GL ship pathfinder",
+		"    GL animated tiles",
+		"    GL tile loop",
+		"    GL towns",
+		"    GL station ratings",
+		"    GL industries",
+	};
 	std::string ai_name_buf;
 
 	static const PerformanceElement rate_elements[] = { PFE_GAMELOOP, PFE_DRAWING, PFE_VIDEO };
@@ -1092,6 +1449,17 @@ void ConPrintFramerate()
 			pf.GetAverageDurationMilliseconds(count2),
 			pf.GetAverageDurationMilliseconds(count3));
 		printed_anything = true;
+
+		for (PerformanceZone z = PFZ_FIRST; z < PFZ_MAX; z++) {
+			auto &zone = _pf_zone_data[z];
+			if (zone.parent != e || zone.num_valid == 0) continue;
+			IConsolePrint(TC_LIGHT_BLUE, "{} times: {:.2f}ms  {:.2f}ms  {:.2f}ms  calls: {:.1f}",
+				ZONE_NAMES[z],
+				zone.GetAverageDurationMilliseconds(count1),
+				zone.GetAverageDurationMilliseconds(count2),
+				zone.GetAverageDurationMilliseconds(count3),
+				zone.GetAverageCalls(count3));
+		}
 	}
 
 	if (!printed_anything) {
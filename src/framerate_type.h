@@ -29,6 +29,12 @@
  * Either class is used by instantiating an object of it at the beginning of the block to be measured, so it auto-destructs at the end of the block.
  * For PerformanceAccumulator, make sure to also call PerformanceAccumulator::Reset once at the beginning of a new frame. Usually the StateGameLoop function is appropriate for this.
  *
+ * @par Adding new zones
+ * A part of the processing of a game loop element can be measured separately as a #PerformanceZone, using the PerformanceZoneMeasurer class.
+ * Add a member to the #PerformanceZone enum, a member with its parent element to the
+ * \link anonymous_namespace{framerate_gui.cpp}::_pf_zone_data _pf_zone_data \endlink array, the zone to \c DISPLAY_ORDER_PFE after its parent element,
+ * and strings to the array in #ConPrintFramerate, to \c PERFORMANCE_ZONE_KEYS in \c benchmark.cpp, and as \c STR_FRAMERATE_ZONE_* and \c STR_FRAMETIME_CAPTION_ZONE_* in \c lang/extra/english.txt.
+ *
  * @see framerate_gui.cpp for implementation
  */
 
@@ -38,6 +44,9 @@
 #include "stdafx.h"
 #include "core/enum_type.hpp"
 
+#include <array>
+#include <vector>
+
 /**
  * Elements of game performance that can be measured.
  *
@@ -79,6 +88,27 @@ enum PerformanceElement {
 };
 DECLARE_POSTFIX_INCREMENT(PerformanceElement)
 
+/**
+ * Zones of processing within game loop performance elements, which are measured separately.
+ *
+ * @note When adding new zones here, make sure to also update all other locations depending on the length and order of this enum.
+ * See <em>Adding new zones</em> above.
+ */
+enum PerformanceZone : uint8_t {
+	PFZ_FIRST = 0,
+	PFZ_LOAD_UNLOAD = 0,    ///< Loading and unloading at stations, part of PFE_GL_ECONOMY
+	PFZ_TRAIN_PATHFINDER,   ///< Pathfinder calls for trains, part of PFE_GL_TRAINS
+	PFZ_ROADVEH_PATHFINDER, ///< Pathfinder calls for road vehicles, part of PFE_GL_ROADVEHS
+	PFZ_SHIP_PATHFINDER,    ///< Pathfinder calls for ships, part of PFE_GL_SHIPS
+	PFZ_ANIMATED_TILES,     ///< Animated tiles, part of PFE_GL_LANDSCAPE
+	PFZ_TILE_LOOP,          ///< Tile loop, part of PFE_GL_LANDSCAPE
+	PFZ_TOWNS,              ///< Town ticks, part of PFE_GL_LANDSCAPE
+	PFZ_STATION_RATINGS,    ///< Station rating updates, part of PFE_GL_LANDSCAPE
+	PFZ_INDUSTRIES,         ///< Industry production, part of PFE_GL_LANDSCAPE
+	PFZ_MAX,                ///< End of enum, must be last.
+};
+DECLARE_POSTFIX_INCREMENT(PerformanceZone)
+
 /** Type used to hold a performance timing measurement */
 typedef uint64_t TimingMeasurement;
 
@@ -120,7 +150,36 @@ public:
 	static void Reset(PerformanceElement elem);
 };
 
+/**
+ * RAII class for measuring a zone of processing within a game loop performance element.
+ * Construct an object with the appropriate zone parameter at the beginning of the block to be measured.
+ * The time spent in each zone and the number of times each zone is entered are summed between calls of Reset.
+ *
+ * Zones can be nested, both in other zones and in themselves. A zone which is entered while it is already being measured
+ * is counted, but its time is not added again.
+ */
+class PerformanceZoneMeasurer {
+	PerformanceZone zone;
+	TimingMeasurement start_time;
+public:
+	PerformanceZoneMeasurer(PerformanceZone zone);
+	~PerformanceZoneMeasurer();
+	static void Reset();
+	static void Paused();
+};
+
+/** Durations of all the measurements of each performance element and zone made during a recording, in microseconds. */
+struct PerformanceRecording {
+	std::array<std::vector<TimingMeasurement>, PFE_MAX> elements; ///< Measurements of each performance element.
+	std::array<std::vector<TimingMeasurement>, PFZ_MAX> zones;    ///< Measurements of each performance zone, per game loop cycle.
+};
+
 void ShowFramerateWindow();
 void ProcessPendingPerformanceMeasurements();
+void StartPerformanceRecording();
+PerformanceRecording StopPerformanceRecording();
+bool StartPerformanceTrace(uint ticks);
+bool FinishPerformanceTrace();
+void AbortPerformanceTrace();
 
 #endif /* FRAMERATE_TYPE_H */
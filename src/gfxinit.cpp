@@ -82,9 +82,9 @@ static SpriteFile &LoadGrfFile(const std::string &filename, uint load_index, boo
  * @param filename   The name of the file to open.
  * @param index_tbl  The offsets of each of the sprites.
  * @param needs_palette_remap Whether the colours in the GRF file need a palette remap.
- * @return The number of loaded sprites.
+ * @return The loaded file.
  */
-static void LoadGrfFileIndexed(const std::string &filename, const SpriteID *index_tbl, bool needs_palette_remap)
+static SpriteFile &LoadGrfFileIndexed(const std::string &filename, const SpriteID *index_tbl, bool needs_palette_remap)
 {
 	uint start;
 	uint sprite_id = 0;
@@ -111,6 +111,8 @@ static void LoadGrfFileIndexed(const std::string &filename, const SpriteID *inde
 			sprite_id++;
 		} while (++start <= end);
 	}
+
+	return file;
 }
 
 /**
@@ -177,7 +179,14 @@ static void LoadSpriteTables()
 {
 	const GraphicsSet *used_set = BaseGraphics::GetUsedSet();
 
+	/* Identify the base set files by their checksums, for the sprite disk cache. */
+	auto set_base_file_md5 = [&](SpriteFile &file, GraphicsFileType type) {
+		const MD5File &md5_file = used_set->files[type];
+		if (md5_file.check_result == MD5File::CR_MATCH) file.SetContentMD5(md5_file.hash);
+	};
+
 	SpriteFile &baseset_file = LoadGrfFile(used_set->files[GFT_BASE].filename, 0, PAL_DOS != used_set->palette);
+	set_base_file_md5(baseset_file, GFT_BASE);
 	if (used_set->name.starts_with("original_")) {
 		baseset_file.flags |= SFF_OPENTTDGRF;
 	}
@@ -220,7 +229,8 @@ static void LoadSpriteTables()
 	 * has a few sprites less. However, we do not care about those missing
 	 * sprites as they are not shown anyway (logos in intro game).
 	 */
-	LoadGrfFile(used_set->files[GFT_LOGOS].filename, 4793, PAL_DOS != used_set->palette);
+	SpriteFile &logos_file = LoadGrfFile(used_set->files[GFT_LOGOS].filename, 4793, PAL_DOS != used_set->palette);
+	set_base_file_md5(logos_file, GFT_LOGOS);
 
 	/*
 	 * Load additional sprites for climates other than temperate.
@@ -228,11 +238,13 @@ static void LoadSpriteTables()
 	 * and the ground sprites.
 	 */
 	if (_settings_game.game_creation.landscape != LT_TEMPERATE) {
-		LoadGrfFileIndexed(
-			used_set->files[GFT_ARCTIC + _settings_game.game_creation.landscape - 1].filename,
+		const GraphicsFileType type = (GraphicsFileType)(GFT_ARCTIC + _settings_game.game_creation.landscape - 1);
+		SpriteFile &landscape_file = LoadGrfFileIndexed(
+			used_set->files[type].filename,
 			_landscape_spriteindexes[_settings_game.game_creation.landscape - 1],
 			PAL_DOS != used_set->palette
 		);
+		set_base_file_md5(landscape_file, type);
 	}
 
 	LoadGrfFile("innerhighlight.grf", SPR_ZONING_INNER_HIGHLIGHT_BASE, false);
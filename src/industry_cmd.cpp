@@ -44,6 +44,7 @@
 #include "cmd_helper.h"
 #include "string_func.h"
 #include "event_logs.h"
+#include "framerate_type.h"
 
 #include "table/strings.h"
 #include "table/industry_land.h"
@@ -1290,6 +1291,8 @@ void OnTick_Industry()
 
 	if (_game_mode == GM_EDITOR) return;
 
+	PerformanceZoneMeasurer framerate(PFZ_INDUSTRIES);
+
 	_scaled_production_ticks = _industry_inverse_cargo_scaler.Scale(INDUSTRY_PRODUCE_TICKS);
 	for (Industry *i : Industry::Iterate()) {
 		ProduceIndustryGoods(i);
@@ -3289,6 +3292,7 @@ extern const TileTypeProcs _tile_type_industry_procs = {
 	nullptr,                        // vehicle_enter_tile_proc
 	GetFoundation_Industry,      // get_foundation_proc
 	TerraformTile_Industry,      // terraform_tile_proc
+	nullptr,                     // tile_loop_quiescent_proc
 };
 
 bool IndustryCompare::operator() (const IndustryListEntry &lhs, const IndustryListEntry &rhs) const
@@ -37,6 +37,8 @@
 #include "scope_info.h"
 #include "core/ring_buffer.hpp"
 #include "network/network_sync.h"
+#include "newgrf_generic.h"
+#include "worker_thread.h"
 #include <array>
 #include <list>
 #include <set>
@@ -742,6 +744,75 @@ void SetupTileLoopCounts()
 	if (accumulator > 0) _tile_loop_counts[0]++;
 }
 
+static const uint TILE_LOOP_PARALLEL_MIN_TILES = 16384; ///< Minimum number of tiles in a call of RunTileLoop to check for quiescent tiles on the worker threads.
+static const uint TILE_LOOP_PARALLEL_GRAIN = 4096;      ///< Number of tiles per worker thread task when checking for quiescent tiles.
+
+/** Tile of the tile loop sequence, and its map data at the time that it was checked for quiescence. */
+struct TileLoopCheckedTile {
+	TileIndex tile;
+	bool quiescent;
+	Tile m;
+	TileExtended me;
+};
+
+/**
+ * Call the TileLoopProcs of a sequence of tiles, skipping those of quiescent tiles.
+ * All tiles of the sequence are first checked using the TileLoopQuiescentProcs on the worker threads.
+ * As the result of the check only depends on the map data of the tile itself, a quiescent tile can be skipped
+ * if its map data is still the same when its TileLoopProc would be called, after those of earlier tiles.
+ * The TileLoopProcs of all other tiles are called in sequence order on this thread, so the outcome,
+ * including the use of the game random, is the same as when calling every TileLoopProc in sequence.
+ * @param tile First tile of the sequence.
+ * @param count Number of tiles in the sequence.
+ * @param feedback Feedback of the Galois LFSR.
+ * @return The next tile after the sequence.
+ */
+static TileIndex RunTileLoopWithQuiescenceCheck(TileIndex tile, uint count, uint32_t feedback)
+{
+	/* static to avoid needing to re-alloc/resize on each call */
+	static std::vector<TileLoopCheckedTile> checked;
+	checked.resize(count);
+
+	for (TileLoopCheckedTile &ct : checked) {
+		ct.tile = tile;
+		/* Get the next tile in sequence using a Galois LFSR. */
+		tile = (tile >> 1) ^ (-(int32_t)(tile & 1) & feedback);
+	}
+
+	ParallelFor(0, count, TILE_LOOP_PARALLEL_GRAIN, [](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			TileLoopCheckedTile &ct = checked[i];
+			TileLoopQuiescentProc *proc = _tile_type_procs[GetTileType(ct.tile)]->tile_loop_quiescent_proc;
+			ct.quiescent = (proc != nullptr && proc(ct.tile));
+			if (ct.quiescent) {
+				ct.m = _m[ct.tile];
+				ct.me = _me[ct.tile];
+			}
+		}
+	});
+
+	for (const TileLoopCheckedTile &ct : checked) {
+		if (ct.quiescent && memcmp(&ct.m, &_m[ct.tile], sizeof(Tile)) == 0 && memcmp(&ct.me, &_me[ct.tile], sizeof(TileExtended)) == 0) {
+			/* Ambient sound effects are the only effect of the TileLoopProcs of quiescent tiles of these types */
+			switch (GetTileType(ct.tile)) {
+				case MP_CLEAR:
+				case MP_TREES:
+				case MP_WATER:
+					AmbientSoundEffect(ct.tile);
+					break;
+
+				default:
+					break;
+			}
+			continue;
+		}
+
+		_tile_type_procs[GetTileType(ct.tile)]->tile_loop_proc(ct.tile);
+	}
+
+	return tile;
+}
+
 /**
  * Gradually iterate over all tiles on the map, calling their TileLoopProcs once every 256 ticks.
  */
@@ -757,6 +828,7 @@ void RunTileLoop(bool apply_day_length)
 	}
 
 	PerformanceAccumulator framerate(PFE_GL_LANDSCAPE);
+	PerformanceZoneMeasurer framerate_zone(PFZ_TILE_LOOP);
 
 	const uint32_t feedback = GetTileLoopFeedback();
 
@@ -772,16 +844,20 @@ void RunTileLoop(bool apply_day_length)
 		count--;
 	}
 
-	while (count--) {
-		/* Get the next tile in sequence using a Galois LFSR. */
-		TileIndex next = (tile >> 1) ^ (-(int32_t)(tile & 1) & feedback);
-		if (count > 0) {
-			PREFETCH_NTA(&_m[next]);
-		}
+	if (count >= TILE_LOOP_PARALLEL_MIN_TILES && _general_worker_pool.GetWorkerCount() > 0) {
+		tile = RunTileLoopWithQuiescenceCheck(tile, count, feedback);
+	} else {
+		while (count--) {
+			/* Get the next tile in sequence using a Galois LFSR. */
+			TileIndex next = (tile >> 1) ^ (-(int32_t)(tile & 1) & feedback);
+			if (count > 0) {
+				PREFETCH_NTA(&_m[next]);
+			}
 
-		_tile_type_procs[GetTileType(tile)]->tile_loop_proc(tile);
+			_tile_type_procs[GetTileType(tile)]->tile_loop_proc(tile);
 
-		tile = next;
+			tile = next;
+		}
 	}
 
 	_cur_tileloop_tile = tile;
@@ -794,6 +870,7 @@ void RunAuxiliaryTileLoop()
 	if (DayLengthFactor() <= 4 || (_scaled_tick_counter % 4) != 0) return;
 
 	PerformanceAccumulator framerate(PFE_GL_LANDSCAPE);
+	PerformanceZoneMeasurer framerate_zone(PFZ_TILE_LOOP);
 
 	const uint32_t feedback = GetTileLoopFeedback();
 	uint count = 1 << (MapLogX() + MapLogY() - 8);
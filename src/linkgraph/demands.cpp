@@ -10,6 +10,12 @@
 
 typedef ring_buffer_queue<NodeID> NodeList;
 
+/**
+ * Maximum number of node pairs of a link graph for its minimised distance candidates to be cached between jobs.
+ * This limits the cache to at most 12 MB per link graph, which is link graphs of up to 1024 nodes.
+ */
+static const size_t DEMAND_CACHE_MAX_CANDIDATES = 1024 * 1023;
+
 /**
  * Scale various things according to symmetric/asymmetric distribution.
  */
@@ -308,26 +314,15 @@ void DemandCalculator::CalcDemand(LinkGraphJob &job, const std::vector<bool> &re
 			int32_t supply = scaler.EffectiveSupply(job[from_id], job[to_id]);
 			assert(supply > 0);
 
-			constexpr int32_t divisor_scale = 16;
-
-			int32_t scaled_distance = this->base_distance;
-			if (this->mod_dist > 0) {
-				const int32_t distance = DistanceMaxPlusManhattan(job[from_id].XY(), job[to_id].XY());
-				/* Scale distance around base_distance by (mod_dist * (100 / 1024)).
-				 * mod_dist may be > 1024, so clamp result to be non-negative */
-				scaled_distance = std::max(0, this->base_distance + (((distance - this->base_distance) * this->mod_dist) / 1024));
-			}
-
-			/* Scale the accuracy by distance around accuracy / 2 */
-			const int32_t divisor = divisor_scale + ((this->accuracy * scaled_distance * divisor_scale) / (this->base_distance * 2));
-			assert(divisor >= divisor_scale);
+			const int32_t divisor = this->CalcDivisor(job[from_id].XY(), job[to_id].XY());
+			assert(divisor >= DIVISOR_SCALE);
 
 			uint demand_forw = 0;
-			if (divisor <= (supply * divisor_scale)) {
+			if (divisor <= (supply * DIVISOR_SCALE)) {
 				/* At first only distribute demand if
 				 * effective supply / accuracy divisor >= 1
 				 * Others are too small or too far away to be considered. */
-				demand_forw = (supply * divisor_scale) / divisor;
+				demand_forw = (supply * DIVISOR_SCALE) / divisor;
 			} else if (++chance > this->accuracy * num_demands * num_supplies) {
 				/* After some trying, if there is still supply left, distribute
 				 * demand also to other nodes. */
@@ -383,29 +378,111 @@ void DemandCalculator::CalcMinimisedDistanceDemand(LinkGraphJob &job, const std:
 	scaler.SetDemandPerNode((uint)demands.size());
 	scaler.AdjustDemandNodes(job, demands);
 
-	struct EdgeCandidate {
-		NodeID from_id;
-		NodeID to_id;
-		uint distance;
+	auto process_candidate = [&](const DemandCache::Candidate &candidate) {
+		if (job[candidate.from_id].UndeliveredSupply() == 0) return;
+		if (!scaler.HasDemandLeft(job[candidate.to_id])) return;
+
+		scaler.SetDemands(job, candidate.from_id, candidate.to_id, std::min(job[candidate.from_id].UndeliveredSupply(), scaler.EffectiveSupply(job[candidate.from_id], job[candidate.to_id])));
 	};
-	std::vector<EdgeCandidate> candidates;
-	candidates.reserve(supplies.size() * demands.size() - std::min(supplies.size(), demands.size()));
+
+	/* The cached candidates include all pairs of nodes, only use them if most pairs are of this component's supplies and demands.
+	 * Skipping the other pairs doesn't change the order, so the result is the same either way. */
+	const size_t pair_count = supplies.size() * demands.size();
+	if (this->cache != nullptr && pair_count * 4 >= this->cache->candidates.size()) {
+		for (const DemandCache::Candidate &candidate : this->cache->candidates) {
+			if (!reachable_nodes[candidate.from_id] || !reachable_nodes[candidate.to_id]) continue;
+			if (job[candidate.from_id].Supply() == 0 || job[candidate.to_id].Demand() == 0) continue;
+			process_candidate(candidate);
+		}
+		return;
+	}
+
+	std::vector<DemandCache::Candidate> candidates;
+	candidates.reserve(pair_count - std::min(supplies.size(), demands.size()));
 	for (NodeID from_id : supplies) {
 		for (NodeID to_id : demands) {
 			if (from_id != to_id) {
-				candidates.push_back({ from_id, to_id, DistanceMaxPlusManhattan(job[from_id].XY(), job[to_id].XY()) });
+				candidates.push_back({ DistanceMaxPlusManhattan(job[from_id].XY(), job[to_id].XY()), from_id, to_id });
 			}
 		}
 	}
-	std::sort(candidates.begin(), candidates.end(), [](const EdgeCandidate &a, const EdgeCandidate &b) {
-		return std::tie(a.distance, a.from_id, a.to_id) < std::tie(b.distance, b.from_id, b.to_id);
-	});
-	for (const EdgeCandidate &candidate : candidates) {
-		if (job[candidate.from_id].UndeliveredSupply() == 0) continue;
-		if (!scaler.HasDemandLeft(job[candidate.to_id])) continue;
+	std::sort(candidates.begin(), candidates.end());
+	for (const DemandCache::Candidate &candidate : candidates) {
+		process_candidate(candidate);
+	}
+}
 
-		scaler.SetDemands(job, candidate.from_id, candidate.to_id, std::min(job[candidate.from_id].UndeliveredSupply(), scaler.EffectiveSupply(job[candidate.from_id], job[candidate.to_id])));
+/**
+ * Calculate the accuracy divisor for the demand between two nodes, this scales the accuracy by distance around accuracy / 2.
+ * @param from_xy Location of the supplying node.
+ * @param to_xy Location of the receiving node.
+ * @return Divisor, in units of 1 / DIVISOR_SCALE.
+ */
+int32_t DemandCalculator::CalcDivisor(TileIndex from_xy, TileIndex to_xy) const
+{
+	int32_t scaled_distance = this->base_distance;
+	if (this->mod_dist > 0) {
+		const int32_t distance = DistanceMaxPlusManhattan(from_xy, to_xy);
+		/* Scale distance around base_distance by (mod_dist * (100 / 1024)).
+		 * mod_dist may be > 1024, so clamp result to be non-negative */
+		scaled_distance = std::max(0, this->base_distance + (((distance - this->base_distance) * this->mod_dist) / 1024));
 	}
+
+	return DIVISOR_SCALE + ((this->accuracy * scaled_distance * DIVISOR_SCALE) / (this->base_distance * 2));
+}
+
+/**
+ * Set up the sorted candidate node pairs for this job's minimised distance demand calculation, from those of the link graph's last job where possible.
+ * Only the pairs of nodes which have been added, or whose location has changed, are recalculated and merged into the still valid pairs.
+ * @param job Job to calculate the demands for.
+ */
+void DemandCalculator::UpdateCache(LinkGraphJob &job)
+{
+	const uint size = job.Size();
+	if ((size_t)size * (size - 1) > DEMAND_CACHE_MAX_CANDIDATES) return;
+
+	const DemandCache *old = job.Graph().GetDemandCache().get();
+
+	std::shared_ptr<DemandCache> cache = std::make_shared<DemandCache>();
+	cache->node_xy.resize(size);
+
+	const uint old_size = (old != nullptr) ? (uint)old->node_xy.size() : 0;
+	std::vector<bool> changed(size, true);
+	for (NodeID node = 0; node < size; node++) {
+		cache->node_xy[node] = job[node].XY();
+		if (node < old_size && old->node_xy[node] == cache->node_xy[node]) changed[node] = false;
+	}
+
+	std::vector<DemandCache::Candidate> added;
+	for (NodeID from_id = 0; from_id < size; from_id++) {
+		for (NodeID to_id = 0; to_id < size; to_id++) {
+			if (from_id != to_id && (changed[from_id] || changed[to_id])) {
+				added.push_back({ DistanceMaxPlusManhattan(cache->node_xy[from_id], cache->node_xy[to_id]), from_id, to_id });
+			}
+		}
+	}
+	std::sort(added.begin(), added.end());
+
+	/* Merge the still valid pairs, which are already sorted, with the sorted new pairs. */
+	cache->candidates.reserve((size_t)size * (size - 1));
+	auto is_kept = [&](const DemandCache::Candidate &candidate) {
+		return candidate.from_id < size && candidate.to_id < size && !changed[candidate.from_id] && !changed[candidate.to_id];
+	};
+	auto next = added.begin();
+	if (old != nullptr) {
+		for (const DemandCache::Candidate &candidate : old->candidates) {
+			if (!is_kept(candidate)) continue;
+			while (next != added.end() && *next < candidate) {
+				cache->candidates.push_back(*next);
+				++next;
+			}
+			cache->candidates.push_back(candidate);
+		}
+	}
+	cache->candidates.insert(cache->candidates.end(), next, added.end());
+
+	this->cache = cache.get();
+	job.demand_cache = std::move(cache);
 }
 
 /**
@@ -432,7 +509,10 @@ DemandCalculator::DemandCalculator(LinkGraphJob &job) :
 		this->mod_dist = 100 + ((over100 * over100) / 12);
 	}
 
-	if (settings.GetDistributionType(cargo) == DT_MANUAL) return;
+	const DistributionType distribution_type = settings.GetDistributionType(cargo);
+	if (distribution_type == DT_MANUAL) return;
+
+	if (distribution_type == DT_ASYMMETRIC_EQ || distribution_type == DT_ASYMMETRIC_NEAR) this->UpdateCache(job);
 
 	const uint size = job.Size();
 
@@ -4,8 +4,31 @@
 #define DEMANDS_H
 
 #include "linkgraphjob_base.h"
+#include <tuple>
 #include <vector>
 
+/**
+ * Distance sorted node pairs of the minimised distance demand calculation, which are kept between jobs of a link graph.
+ * For the next job, only the pairs of nodes which have been added, replaced or moved are recalculated and merged in.
+ * Supply and acceptance aren't cached, as they change between almost all jobs and each affects the demands of all nodes.
+ */
+struct DemandCache {
+	/** Candidate pair of nodes for the minimised distance demand calculation. */
+	struct Candidate {
+		uint distance;
+		NodeID from_id;
+		NodeID to_id;
+
+		bool operator<(const Candidate &other) const
+		{
+			return std::tie(this->distance, this->from_id, this->to_id) < std::tie(other.distance, other.from_id, other.to_id);
+		}
+	};
+
+	std::vector<TileIndex> node_xy;    ///< Location of each node the data was calculated for.
+	std::vector<Candidate> candidates; ///< All pairs of different nodes, sorted by distance.
+};
+
 /**
  * Calculate the demands. This class has a state, but is recreated for each
  * call to of DemandHandler::Run.
@@ -18,6 +41,12 @@ private:
 	int32_t base_distance; ///< Base distance for scaling purposes.
 	int32_t mod_dist;      ///< Distance modifier, determines how much demands decrease with distance.
 	int32_t accuracy;      ///< Accuracy of the calculation.
+	const DemandCache *cache = nullptr; ///< Sorted minimised distance candidates, or nullptr if not used or the link graph is too large for them to be cached.
+
+	static constexpr int32_t DIVISOR_SCALE = 16; ///< Fixed point scale of the accuracy divisor.
+
+	int32_t CalcDivisor(TileIndex from_xy, TileIndex to_xy) const;
+	void UpdateCache(LinkGraphJob &job);
 
 	template<class Tscaler>
 	void CalcDemand(LinkGraphJob &job, const std::vector<bool> &reachable_nodes, Tscaler scaler);
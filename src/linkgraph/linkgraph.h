@@ -18,10 +18,12 @@
 #include "../sl/saveload_common.h"
 #include "linkgraph_type.h"
 #include "../3rdparty/cpp-btree/btree_map.h"
+#include <memory>
 #include <utility>
 #include <vector>
 
 class LinkGraph;
+struct DemandCache;
 
 /**
  * Type of the pool for link graph components. Each station can be in at up to
@@ -393,15 +395,20 @@ protected:
 	friend upstream_sl::SlLinkgraphEdge;
 
 	friend void LinkGraphFixupAfterLoad(bool compression_was_date);
+	friend bool ImportLinkGraphs(FILE *f, std::vector<LinkGraph *> &graphs);
 
 	CargoID cargo;         ///< Cargo of this component's link graph.
 	ScaledTickCounter last_compression; ///< Last time the capacities and supplies were compressed.
 	NodeVector nodes;      ///< Nodes in the component.
 	EdgeMatrix edges;      ///< Edges in the component.
+	std::shared_ptr<const DemandCache> demand_cache; ///< Demand calculation data of the last finished job, this is not saved.
 
 public:
 	const EdgeMatrix &GetEdges() const { return this->edges; }
 
+	const std::shared_ptr<const DemandCache> &GetDemandCache() const { return this->demand_cache; }
+	void SetDemandCache(std::shared_ptr<const DemandCache> cache) { this->demand_cache = std::move(cache); }
+
 	const BaseEdge &GetBaseEdge(NodeID from, NodeID to) const
 	{
 		auto iter = this->edges.find(std::make_pair(from, to));
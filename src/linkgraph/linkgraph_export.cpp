@@ -0,0 +1,64 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file linkgraph_export.cpp Definition of the link graph export format, used for offline benchmarking of link graph jobs. */
+
+#include "../stdafx.h"
+#include "linkgraph_export.h"
+#include "linkgraphjob.h"
+#include "../map_func.h"
+#include "../settings_type.h"
+#include "../date_func.h"
+
+#include "../safeguards.h"
+
+/*
+ * The export is a text file of the form:
+ *   linkgraph_export <version>
+ *   map <size x> <size y>
+ *   settings <accuracy> <demand size> <demand distance> <short path saturation> <aircraft link scale> <day length factor>
+ * followed by, for each link graph:
+ *   graph <cargo> <distribution type> <express> <ticks since compression> <node count> <edge count>
+ *   node <supply> <demand> <station> <tile>         (node count times)
+ *   edge <from> <to> <capacity> <usage> <travel time sum> <aircraft>  (edge count times)
+ */
+
+/**
+ * Export all link graphs, and the settings which affect the link graph jobs.
+ * @param f File to write to.
+ * @return True if the export succeeded.
+ */
+bool ExportLinkGraphs(FILE *f)
+{
+	const LinkGraphSettings &settings = _settings_game.linkgraph;
+	fprintf(f, "linkgraph_export %u\n", LINKGRAPH_EXPORT_VERSION);
+	fprintf(f, "map %u %u\n", MapSizeX(), MapSizeY());
+	fprintf(f, "settings %u %u %u %u %u %u\n", settings.accuracy, settings.demand_size, settings.demand_distance,
+			settings.short_path_saturation, settings.aircraft_link_scale, DayLengthFactor());
+
+	for (const LinkGraph *lg : LinkGraph::Iterate()) {
+		uint edge_count = 0;
+		for (const auto &it : lg->GetEdges()) {
+			if (it.first.first != it.first.second) edge_count++;
+		}
+
+		fprintf(f, "graph %u %u %u " OTTD_PRINTF64U " %u %u\n", lg->Cargo(), settings.GetDistributionType(lg->Cargo()),
+				IsLinkGraphCargoExpress(lg->Cargo()) ? 1 : 0, _scaled_tick_counter - lg->LastCompression(), lg->Size(), edge_count);
+		for (NodeID i = 0; i < lg->Size(); i++) {
+			LinkGraph::ConstNode node = (*lg)[i];
+			fprintf(f, "node %u %u %u %u\n", node.Supply(), node.Demand(), node.Station(), node.XY());
+		}
+		for (const auto &it : lg->GetEdges()) {
+			if (it.first.first == it.first.second) continue;
+			const LinkGraph::BaseEdge &edge = it.second;
+			fprintf(f, "edge %u %u %u %u " OTTD_PRINTF64U " %u\n", it.first.first, it.first.second, edge.capacity, edge.usage,
+					edge.travel_time_sum, edge.last_aircraft_update != EconTime::INVALID_DATE ? 1 : 0);
+		}
+	}
+
+	return ferror(f) == 0;
+}
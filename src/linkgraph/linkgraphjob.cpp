@@ -100,6 +100,8 @@ void LinkGraphJob::FinaliseJob()
 	/* Link graph has been merged into another one. */
 	if (!LinkGraph::IsValidID(this->link_graph.index)) return;
 
+	if (this->demand_cache != nullptr) LinkGraph::Get(this->link_graph.index)->SetDemandCache(std::move(this->demand_cache));
+
 	uint16_t size = this->Size();
 	for (NodeID node_id = 0; node_id < size; ++node_id) {
 		Node from = (*this)[node_id];
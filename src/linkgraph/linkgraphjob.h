@@ -13,6 +13,8 @@
 #include "../thread.h"
 #include "../core/dyn_arena_alloc.hpp"
 #include "linkgraph.h"
+#include <algorithm>
+#include <array>
 #include <vector>
 #include <memory>
 #include <atomic>
@@ -156,8 +158,10 @@ public:
 	std::unique_ptr<uint[]> demand_matrix;                        ///< Demand matrix.
 	uint demand_matrix_count;                                     ///< Count of non-zero entries in demand_matrix.
 	std::vector<DemandAnnotation> demand_annotation_store;        ///< Demand annotation store.
+	std::shared_ptr<const DemandCache> demand_cache;              ///< Demand calculation data for the next job of the link graph.
 
-	DynUniformArenaAllocator path_allocator; ///< Arena allocator used for paths
+	static constexpr uint PATH_ALLOCATOR_COUNT = 16; ///< Number of path allocators, this is the maximum number of path searches which may run in parallel.
+	std::array<DynUniformArenaAllocator, PATH_ALLOCATOR_COUNT> path_allocators; ///< Arena allocators used for paths, one for each parallel path search.
 
 	/**
 	 * Link graph job node. Wraps a constant link graph node and a modifiable
@@ -245,9 +249,11 @@ public:
 
 		Edge &GetEdgeTo(NodeID to)
 		{
-			for (Edge &edge : this->node_anno.edges) {
-				if (edge.To() == to) return edge;
-			}
+			/* The edges of each node are sorted by destination, as they are copied from the ordered edge matrix */
+			auto it = std::lower_bound(this->node_anno.edges.begin(), this->node_anno.edges.end(), to, [](const Edge &edge, NodeID to) {
+				return edge.To() < to;
+			});
+			if (it != this->node_anno.edges.end() && it->To() == to) return *it;
 
 			static Edge empty_edge = {};
 			return empty_edge;
@@ -231,15 +231,20 @@ LinkGraphJobGroup::LinkGraphJobGroup(constructor_token token, std::vector<LinkGr
 
 void LinkGraphJobGroup::SpawnThread()
 {
+	for (auto &it : this->jobs) {
+		it->SetJobGroup(this->shared_from_this());
+	}
+
 	/**
-	 * Spawn a thread if possible and run the link graph job in the thread. If
-	 * that's not possible run the job right now in the current thread.
+	 * Run the link graph jobs on the worker pool, as a long running job so that
+	 * they don't hold up the other users of the pool. If the pool is too small
+	 * to run long running jobs, spawn a thread instead.
 	 */
-	if (StartNewThread(&this->thread, "ottd:linkgraph", &(LinkGraphJobGroup::Run), this)) {
-		for (auto &it : this->jobs) {
-			it->SetJobGroup(this->shared_from_this());
-		}
-	} else {
+	if (_general_worker_pool.CanRunLongRunningJobs()) {
+		this->task.Run([this]() {
+			LinkGraphJobGroup::Run(this);
+		}, WJF_LONG_RUNNING);
+	} else if (!StartNewThread(&this->thread, "ottd:linkgraph", &(LinkGraphJobGroup::Run), this)) {
 		/* Of course this will hang a bit.
 		 * On the other hand, if you want to play games which make this hang noticably
 		 * on a platform without threads then you'll probably get other problems first.
@@ -253,6 +258,8 @@ void LinkGraphJobGroup::SpawnThread()
 
 void LinkGraphJobGroup::JoinThread()
 {
+	/* Long running tasks are never run by the waiting thread, this waits for the worker to finish the job group */
+	this->task.Wait();
 	if (this->thread.joinable()) {
 		this->thread.join();
 	}
@@ -11,6 +11,7 @@
 #define LINKGRAPHSCHEDULE_H
 
 #include "../thread.h"
+#include "../worker_thread.h"
 #include "linkgraph.h"
 #include <memory>
 #include <vector>
@@ -89,7 +90,8 @@ class LinkGraphJobGroup : public std::enable_shared_from_this<LinkGraphJobGroup>
 	friend LinkGraphJob;
 
 private:
-	std::thread thread;                      ///< Thread the job group is running in or nullptr if it's running in the main thread.
+	WorkerTaskGroup task;                    ///< Task running the job group on the worker pool.
+	std::thread thread;                      ///< Thread the job group is running in, if the worker pool can't run long running jobs.
 	const std::vector<LinkGraphJob *> jobs;  ///< The set of jobs in this job set
 
 private:
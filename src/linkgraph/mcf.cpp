@@ -4,26 +4,22 @@
 #include "../core/math_func.hpp"
 #include "mcf.h"
 #include "../3rdparty/cpp-btree/btree_map.h"
-#include <set>
+#include "../worker_thread.h"
+#include <algorithm>
+#include <array>
 
 #include "../safeguards.h"
 
 typedef btree::btree_map<NodeID, Path *> PathViaMap;
 
 /**
- * This is a wrapper around Tannotation* which also stores a cache of GetAnnotation() and GetNode()
- * to remove the need dereference the Tannotation* pointer when sorting/inseting/erasing in MultiCommodityFlow::Dijkstra::AnnoSet
+ * Minimum number of nodes for the path searches from several sources to be run in parallel.
+ * Smaller graphs are calculated one source at a time, as the overhead is not worth it.
  */
-template<typename Tannotation>
-class AnnoSetItem {
-public:
-	Tannotation *anno_ptr;
-	typename Tannotation::AnnotationValueType cached_annotation;
-	NodeID node_id;
+static const uint MCF_PARALLEL_MIN_NODES = 256;
 
-	AnnoSetItem(Tannotation *anno) : anno_ptr(anno), cached_annotation(anno->GetAnnotation()), node_id(anno->GetNode()) {}
-	AnnoSetItem() : anno_ptr(nullptr), cached_annotation(0), node_id(INVALID_NODE) {}
-};
+class DistanceAnnotationQueue;
+class CapacityAnnotationQueue;
 
 /**
  * Distance-based annotation for use in the Dijkstra algorithm. This is close
@@ -33,6 +29,7 @@ public:
 class DistanceAnnotation : public Path {
 public:
 	typedef uint AnnotationValueType;
+	typedef DistanceAnnotationQueue Queue;
 
 	/**
 	 * Constructor.
@@ -53,13 +50,6 @@ public:
 	 * Update the cached annotation value
 	 */
 	inline void UpdateAnnotation() { }
-
-	/**
-	 * Comparator for std containers.
-	 */
-	struct Comparator {
-		bool operator()(const AnnoSetItem<DistanceAnnotation> &x, const AnnoSetItem<DistanceAnnotation> &y) const;
-	};
 };
 
 /**
@@ -73,6 +63,7 @@ class CapacityAnnotation : public Path {
 
 public:
 	typedef int AnnotationValueType;
+	typedef CapacityAnnotationQueue Queue;
 
 	/**
 	 * Constructor.
@@ -96,13 +87,127 @@ public:
 	{
 		this->cached_annotation = this->GetCapacityRatio();
 	}
+};
+
+/**
+ * Priority queue of distance annotations for MultiCommodityFlow::Dijkstra, implemented as a radix heap.
+ * Annotations are popped in order of increasing distance, ties are broken by increasing node ID.
+ * A radix heap requires that no key is pushed which is less than the last key popped. This holds as
+ * a path is only ever forked from the last popped path, and edge distance annotations are at least 1.
+ * Entries superseded by pushing the same annotation again are not removed, but skipped when popped.
+ */
+class DistanceAnnotationQueue {
+	struct Item {
+		uint64_t key;
+		DistanceAnnotation *anno;
+	};
+
+	static constexpr uint BUCKET_COUNT = 65;
+	std::array<std::vector<Item>, BUCKET_COUNT> buckets; ///< Bucket i > 0 contains keys whose highest bit differing from last is bit i - 1.
+	uint64_t last = 0;                                   ///< Last key popped, bucket 0 contains keys equal to this.
+
+	static inline uint64_t GetKey(const DistanceAnnotation *anno)
+	{
+		return (static_cast<uint64_t>(anno->GetAnnotation()) << 16) | anno->GetNode();
+	}
 
+	inline uint GetBucket(uint64_t key) const
+	{
+		return key == this->last ? 0 : FindLastBit(key ^ this->last) + 1;
+	}
+
+public:
 	/**
-	 * Comparator for std containers.
+	 * Push an annotation with its current distance.
+	 * @param anno Annotation to push.
 	 */
-	struct Comparator {
-		bool operator()(const AnnoSetItem<CapacityAnnotation> &x, const AnnoSetItem<CapacityAnnotation> &y) const;
+	void Push(DistanceAnnotation *anno)
+	{
+		const uint64_t key = GetKey(anno);
+		dbg_assert(key >= this->last);
+		this->buckets[this->GetBucket(key)].push_back({ key, anno });
+		anno->SetAnnosSetFlag(true);
+	}
+
+	/**
+	 * Pop the annotation with the least distance.
+	 * @return Annotation, or nullptr if the queue is empty.
+	 */
+	DistanceAnnotation *Pop()
+	{
+		while (true) {
+			if (this->buckets[0].empty()) {
+				uint i = 1;
+				while (i < BUCKET_COUNT && this->buckets[i].empty()) i++;
+				if (i == BUCKET_COUNT) return nullptr;
+
+				/* Redistribute the first non-empty bucket around its smallest key, all of its items move to lower buckets. */
+				std::vector<Item> &bucket = this->buckets[i];
+				this->last = std::min_element(bucket.begin(), bucket.end(), [](const Item &a, const Item &b) { return a.key < b.key; })->key;
+				for (const Item &item : bucket) {
+					this->buckets[this->GetBucket(item.key)].push_back(item);
+				}
+				bucket.clear();
+			}
+
+			Item item = this->buckets[0].back();
+			this->buckets[0].pop_back();
+			if (!item.anno->GetAnnosSetFlag() || GetKey(item.anno) != item.key) continue;
+			item.anno->SetAnnosSetFlag(false);
+			return item.anno;
+		}
+	}
+};
+
+/**
+ * Priority queue of capacity annotations for MultiCommodityFlow::Dijkstra, implemented as a binary heap.
+ * Annotations are popped in order of decreasing capacity ratio, ties are broken by decreasing node ID.
+ * The capacity ratio of a forked path can be larger than that of its parent, so a monotone radix heap can't be used here.
+ * Entries superseded by pushing the same annotation again are not removed, but skipped when popped.
+ */
+class CapacityAnnotationQueue {
+	struct Item {
+		int annotation;
+		NodeID node;
+		CapacityAnnotation *anno;
+
+		bool operator<(const Item &other) const
+		{
+			if (this->annotation != other.annotation) return this->annotation < other.annotation;
+			return this->node < other.node;
+		}
 	};
+
+	std::vector<Item> heap;
+
+public:
+	/**
+	 * Push an annotation with its current capacity ratio.
+	 * @param anno Annotation to push.
+	 */
+	void Push(CapacityAnnotation *anno)
+	{
+		this->heap.push_back({ anno->GetAnnotation(), anno->GetNode(), anno });
+		std::push_heap(this->heap.begin(), this->heap.end());
+		anno->SetAnnosSetFlag(true);
+	}
+
+	/**
+	 * Pop the annotation with the largest capacity ratio.
+	 * @return Annotation, or nullptr if the queue is empty.
+	 */
+	CapacityAnnotation *Pop()
+	{
+		while (!this->heap.empty()) {
+			std::pop_heap(this->heap.begin(), this->heap.end());
+			Item item = this->heap.back();
+			this->heap.pop_back();
+			if (!item.anno->GetAnnosSetFlag() || item.anno->GetAnnotation() != item.annotation) continue;
+			item.anno->SetAnnosSetFlag(false);
+			return item.anno;
+		}
+		return nullptr;
+	}
 };
 
 /**
@@ -286,33 +391,28 @@ bool CapacityAnnotation::IsBetter(const CapacityAnnotation *base, uint cap,
  * setting to artificially decrease capacities.
  * @tparam Tannotation Annotation to be used.
  * @tparam Tedge_iterator Iterator to be used for getting outgoing edges.
+ * This only reads the link graph job, so several of these can run in parallel with different allocators.
  * @param source_node Node where the algorithm starts.
  * @param paths Container for the paths to be calculated.
+ * @param allocator Allocator for the paths.
  */
 template<class Tannotation, class Tedge_iterator>
-void MultiCommodityFlow::Dijkstra(NodeID source_node, PathVector &paths)
+void MultiCommodityFlow::Dijkstra(NodeID source_node, PathVector &paths, DynUniformArenaAllocator &allocator)
 {
-	typedef btree::btree_set<AnnoSetItem<Tannotation>, typename Tannotation::Comparator> AnnoSet;
-	AnnoSet annos = AnnoSet(typename Tannotation::Comparator());
+	typename Tannotation::Queue annos;
 	Tedge_iterator iter(this->job);
 	uint size = this->job.Size();
 	paths.resize(size, nullptr);
 
-	this->job.path_allocator.SetParameters(sizeof(Tannotation), (8192 - 32) / sizeof(Tannotation));
+	allocator.SetParameters(sizeof(Tannotation), (8192 - 32) / sizeof(Tannotation));
 
 	for (NodeID node = 0; node < size; ++node) {
-		Tannotation *anno = new (this->job.path_allocator.Allocate()) Tannotation(node, node == source_node);
+		Tannotation *anno = new (allocator.Allocate()) Tannotation(node, node == source_node);
 		anno->UpdateAnnotation();
-		if (node == source_node) {
-			annos.insert(AnnoSetItem<Tannotation>(anno));
-			anno->SetAnnosSetFlag(true);
-		}
+		if (node == source_node) annos.Push(anno);
 		paths[node] = anno;
 	}
-	while (!annos.empty()) {
-		typename AnnoSet::iterator i = annos.begin();
-		Tannotation *source = i->anno_ptr;
-		annos.erase(i);
+	while (Tannotation *source = annos.Pop()) {
 		NodeID from = source->GetNode();
 		iter.SetNode(source_node, from);
 		for (NodeID to = iter.Next(); to != INVALID_NODE; to = iter.Next()) {
@@ -327,22 +427,60 @@ void MultiCommodityFlow::Dijkstra(NodeID source_node, PathVector &paths)
 
 			Tannotation *dest = static_cast<Tannotation *>(paths[to]);
 			if (dest->IsBetter(source, capacity, capacity - edge.Flow(), edge.DistanceAnno())) {
-				if (dest->GetAnnosSetFlag()) annos.erase(AnnoSetItem<Tannotation>(dest));
 				dest->Fork(source, capacity, capacity - edge.Flow(), edge.DistanceAnno());
 				dest->UpdateAnnotation();
-				annos.insert(AnnoSetItem<Tannotation>(dest));
-				dest->SetAnnosSetFlag(true);
+				annos.Push(dest);
 			}
 		}
 	}
 }
 
+/**
+ * Calculate the paths from each source which isn't finished yet, and call a function for each of them in order of the source node ID.
+ * The paths from large graphs are calculated for a fixed size batch of sources in parallel, on the state of the link graph
+ * before the function is called for any of the sources in the batch.
+ * As the batches don't depend on the number of threads, the result is the same on all machines.
+ * @tparam Tannotation Annotation to be used.
+ * @tparam Tedge_iterator Iterator to be used for getting outgoing edges.
+ * @param finished_sources Sources to skip.
+ * @param proc Function to call with each source and its paths, the paths are cleaned up afterwards.
+ */
+template<class Tannotation, class Tedge_iterator, class Tproc>
+void MultiCommodityFlow::ForEachSource(const std::vector<bool> &finished_sources, Tproc proc)
+{
+	const uint size = this->job.Size();
+	const uint batch_size = (size >= MCF_PARALLEL_MIN_NODES) ? LinkGraphJob::PATH_ALLOCATOR_COUNT : 1;
+
+	std::array<NodeID, LinkGraphJob::PATH_ALLOCATOR_COUNT> batch;
+	std::array<PathVector, LinkGraphJob::PATH_ALLOCATOR_COUNT> paths;
+	NodeID source = 0;
+	while (source < size) {
+		uint count = 0;
+		for (; source < size && count < batch_size; ++source) {
+			if (!finished_sources[source]) batch[count++] = source;
+		}
+		if (count == 0) break;
+
+		ParallelFor(0, count, 1, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				this->Dijkstra<Tannotation, Tedge_iterator>(batch[i], paths[i], this->job.path_allocators[i]);
+			}
+		});
+
+		for (uint i = 0; i < count; i++) {
+			proc(batch[i], paths[i]);
+			this->CleanupPaths(batch[i], paths[i], this->job.path_allocators[i]);
+		}
+	}
+}
+
 /**
  * Clean up paths that lead nowhere and the root path.
  * @param source_id ID of the root node.
  * @param paths Paths to be cleaned up.
+ * @param allocator Allocator the paths were allocated from.
  */
-void MultiCommodityFlow::CleanupPaths(NodeID source_id, PathVector &paths)
+void MultiCommodityFlow::CleanupPaths(NodeID source_id, PathVector &paths, DynUniformArenaAllocator &allocator)
 {
 	Path *source = paths[source_id];
 	paths[source_id] = nullptr;
@@ -355,12 +493,12 @@ void MultiCommodityFlow::CleanupPaths(NodeID source_id, PathVector &paths)
 			path->Detach();
 			if (path->GetNumChildren() == 0) {
 				paths[path->GetNode()] = nullptr;
-				this->job.path_allocator.Free(path);
+				allocator.Free(path);
 			}
 			path = parent;
 		}
 	}
-	this->job.path_allocator.Free(source);
+	allocator.Free(source);
 	paths.clear();
 }
 
@@ -535,7 +673,6 @@ bool MCF1stPass::EliminateCycles()
  */
 MCF1stPass::MCF1stPass(LinkGraphJob &job) : MultiCommodityFlow(job)
 {
-	PathVector paths;
 	uint16_t size = job.Size();
 	uint accuracy = job.Settings().accuracy;
 	bool more_loops;
@@ -562,12 +699,8 @@ MCF1stPass::MCF1stPass(LinkGraphJob &job) : MultiCommodityFlow(job)
 
 	do {
 		more_loops = false;
-		for (NodeID source = 0; source < size; ++source) {
-			if (finished_sources[source]) continue;
-
-			/* First saturate the shortest paths. */
-			this->Dijkstra<DistanceAnnotation, GraphEdgeIterator>(source, paths);
-
+		/* First saturate the shortest paths. */
+		this->ForEachSource<DistanceAnnotation, GraphEdgeIterator>(finished_sources, [&](NodeID source, PathVector &paths) {
 			bool source_demand_left = false;
 			for (DemandAnnotation &anno : job[source].GetDemandAnnotations()) {
 				NodeID dest = anno.dest;
@@ -590,8 +723,7 @@ MCF1stPass::MCF1stPass(LinkGraphJob &job) : MultiCommodityFlow(job)
 				}
 			}
 			if (!source_demand_left) finished_sources[source] = true;
-			this->CleanupPaths(source, paths);
-		}
+		});
 	} while ((more_loops || this->EliminateCycles()) && !job.IsJobAborted());
 }
 
@@ -603,18 +735,13 @@ MCF1stPass::MCF1stPass(LinkGraphJob &job) : MultiCommodityFlow(job)
 MCF2ndPass::MCF2ndPass(LinkGraphJob &job) : MultiCommodityFlow(job)
 {
 	this->max_saturation = UINT_MAX; // disable artificial cap on saturation
-	PathVector paths;
 	uint16_t size = job.Size();
 	uint accuracy = job.Settings().accuracy;
 	bool demand_left = true;
 	std::vector<bool> finished_sources(size);
 	while (demand_left && !job.IsJobAborted()) {
 		demand_left = false;
-		for (NodeID source = 0; source < size; ++source) {
-			if (finished_sources[source]) continue;
-
-			this->Dijkstra<CapacityAnnotation, FlowEdgeIterator>(source, paths);
-
+		this->ForEachSource<CapacityAnnotation, FlowEdgeIterator>(finished_sources, [&](NodeID source, PathVector &paths) {
 			bool source_demand_left = false;
 			for (DemandAnnotation &anno : this->job[source].GetDemandAnnotations()) {
 				if (anno.unsatisfied_demand == 0) continue;
@@ -628,52 +755,6 @@ MCF2ndPass::MCF2ndPass(LinkGraphJob &job) : MultiCommodityFlow(job)
 				}
 			}
 			if (!source_demand_left) finished_sources[source] = true;
-			this->CleanupPaths(source, paths);
-		}
+		});
 	}
 }
-
-/**
- * Relation that creates a weak order without duplicates.
- * Avoid accidentally deleting different paths of the same capacity/distance in
- * a set. When the annotation is the same node IDs are compared, so there are
- * no equal ranges.
- * @tparam T Type to be compared on.
- * @param x_anno First value.
- * @param y_anno Second value.
- * @param x Node id associated with the first value.
- * @param y Node id associated with the second value.
- */
-template <typename T>
-bool Greater(T x_anno, T y_anno, NodeID x, NodeID y)
-{
-	if (x_anno > y_anno) return true;
-	if (x_anno < y_anno) return false;
-	return x > y;
-}
-
-/**
- * Compare two capacity annotations.
- * @param x First capacity annotation.
- * @param y Second capacity annotation.
- * @return If x is better than y.
- */
-bool CapacityAnnotation::Comparator::operator()(const AnnoSetItem<CapacityAnnotation> &x,
-		const AnnoSetItem<CapacityAnnotation> &y) const
-{
-	return x.anno_ptr != y.anno_ptr && Greater<int>(x.cached_annotation, y.cached_annotation,
-			x.node_id, y.node_id);
-}
-
-/**
- * Compare two distance annotations.
- * @param x First distance annotation.
- * @param y Second distance annotation.
- * @return If x is better than y.
- */
-bool DistanceAnnotation::Comparator::operator()(const AnnoSetItem<DistanceAnnotation> &x,
-		const AnnoSetItem<DistanceAnnotation> &y) const
-{
-	return x.anno_ptr != y.anno_ptr && !Greater<uint>(x.cached_annotation, y.cached_annotation,
-			x.node_id, y.node_id);
-}
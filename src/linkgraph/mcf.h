@@ -22,11 +22,14 @@ protected:
 	{}
 
 	template<class Tannotation, class Tedge_iterator>
-	void Dijkstra(NodeID from, PathVector &paths);
+	void Dijkstra(NodeID from, PathVector &paths, DynUniformArenaAllocator &allocator);
+
+	template<class Tannotation, class Tedge_iterator, class Tproc>
+	void ForEachSource(const std::vector<bool> &finished_sources, Tproc proc);
 
 	uint PushFlow(DemandAnnotation &anno, Path *path, uint min_step_size, uint accuracy, uint max_saturation);
 
-	void CleanupPaths(NodeID source, PathVector &paths);
+	void CleanupPaths(NodeID source, PathVector &paths, DynUniformArenaAllocator &allocator);
 
 	LinkGraphJob &job;   ///< Job we're working with.
 	uint max_saturation; ///< Maximum saturation for edges.
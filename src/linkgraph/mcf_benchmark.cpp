@@ -0,0 +1,195 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file mcf_benchmark.cpp Standalone benchmark of the link graph job handlers.
+ * This runs the link graph jobs for link graphs exported from a game using the export_linkgraphs console command,
+ * and prints the time taken by each handler, and a checksum of the resulting flows.
+ * Usage: openttd_mcf_benchmark <export file> [iterations] [worker threads]
+ * By default one less worker thread than the number of cores is used, 0 worker threads runs everything in the main thread.
+ */
+
+#include "../stdafx.h"
+#include "linkgraph_export.h"
+#include "linkgraphjob.h"
+#include "init.h"
+#include "demands.h"
+#include "mcf.h"
+#include "flowmapper.h"
+#include "../worker_thread.h"
+#include "../map_func.h"
+#include "../settings_type.h"
+#include "../date_func.h"
+#include <chrono>
+
+#include "../safeguards.h"
+
+/**
+ * Import link graphs written by ExportLinkGraphs into the link graph pool.
+ * This also applies the exported map size and link graph settings, and sets up the class of any cargo
+ * which isn't loaded so that it is treated as when exported, so it must only be used in this benchmark.
+ * @param f File to read from.
+ * @param graphs Output for the imported link graphs.
+ * @return True if the import succeeded.
+ */
+bool ImportLinkGraphs(FILE *f, std::vector<LinkGraph *> &graphs)
+{
+	uint version;
+	if (fscanf(f, " linkgraph_export %u", &version) != 1 || version != LINKGRAPH_EXPORT_VERSION) return false;
+
+	uint size_x, size_y;
+	if (fscanf(f, " map %u %u", &size_x, &size_y) != 2) return false;
+	if (MapSizeX() != size_x || MapSizeY() != size_y) AllocateMap(size_x, size_y);
+
+	LinkGraphSettings &settings = _settings_game.linkgraph;
+	uint accuracy, demand_size, demand_distance, short_path_saturation, aircraft_link_scale, day_length_factor;
+	if (fscanf(f, " settings %u %u %u %u %u %u", &accuracy, &demand_size, &demand_distance, &short_path_saturation,
+			&aircraft_link_scale, &day_length_factor) != 6) return false;
+	settings.accuracy = accuracy;
+	settings.demand_size = demand_size;
+	settings.demand_distance = demand_distance;
+	settings.short_path_saturation = short_path_saturation;
+	settings.aircraft_link_scale = aircraft_link_scale;
+	DateDetail::_effective_day_length = std::max<uint>(day_length_factor, 1);
+
+	uint cargo, distribution, express, node_count, edge_count;
+	unsigned long long age;
+	while (fscanf(f, " graph %u %u %u %llu %u %u", &cargo, &distribution, &express, &age, &node_count, &edge_count) == 6) {
+		if (cargo >= NUM_CARGO || node_count >= INVALID_NODE || !LinkGraph::CanAllocateItem()) return false;
+
+		settings.distribution_per_cargo[cargo] = static_cast<DistributionType>(distribution);
+		CargoSpec *cs = CargoSpec::Get(cargo);
+		if (!cs->IsValid()) cs->classes = express ? CC_EXPRESS : CC_NOAVAILABLE;
+
+		LinkGraph *lg = new LinkGraph(static_cast<CargoID>(cargo));
+		graphs.push_back(lg);
+		lg->last_compression = _scaled_tick_counter - age;
+		lg->nodes.resize(node_count);
+		for (LinkGraph::BaseNode &node : lg->nodes) {
+			uint supply, demand, station, xy;
+			if (fscanf(f, " node %u %u %u %u", &supply, &demand, &station, &xy) != 4) return false;
+			node.supply = supply;
+			node.demand = demand;
+			node.station = static_cast<StationID>(station);
+			node.xy = xy;
+			node.last_update = EconTime::CurDate();
+		}
+		for (uint i = 0; i < edge_count; i++) {
+			uint from, to, capacity, usage, aircraft;
+			unsigned long long travel_time_sum;
+			if (fscanf(f, " edge %u %u %u %u %llu %u", &from, &to, &capacity, &usage, &travel_time_sum, &aircraft) != 6) return false;
+			if (from >= node_count || to >= node_count) return false;
+			LinkGraph::BaseEdge &edge = lg->edges[std::make_pair(static_cast<NodeID>(from), static_cast<NodeID>(to))];
+			edge.capacity = capacity;
+			edge.usage = usage;
+			edge.travel_time_sum = travel_time_sum;
+			edge.last_unrestricted_update = EconTime::CurDate();
+			if (aircraft) edge.last_aircraft_update = EconTime::CurDate();
+		}
+	}
+
+	return feof(f) != 0;
+}
+
+/**
+ * Calculate a checksum of the flows of a finished job, this should not change with the number of threads or between
+ * optimisations which are intended to give the same result.
+ * @param job Job to checksum.
+ * @return Checksum.
+ */
+static uint64_t FlowChecksum(LinkGraphJob &job)
+{
+	/* FNV-1a */
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	auto add = [&](uint64_t value) {
+		hash ^= value;
+		hash *= 0x100000001b3ULL;
+	};
+	for (NodeID node = 0; node < job.Size(); node++) {
+		for (const FlowStat &flow : job[node].Flows()) {
+			add(node);
+			add(flow.GetOrigin());
+			for (const auto &share : flow) {
+				add(share.first);
+				add(share.second);
+			}
+		}
+	}
+	return hash;
+}
+
+int CDECL main(int argc, char *argv[])
+{
+	if (argc < 2) {
+		fprintf(stderr, "Usage: %s <link graph export file> [iterations] [worker threads]\n", argv[0]);
+		return 1;
+	}
+	const uint iterations = (argc > 2) ? std::max(atoi(argv[2]), 1) : 1;
+	const int worker_threads = (argc > 3) ? std::max(atoi(argv[3]), 0) : -1;
+
+	FILE *f = fopen(argv[1], "r");
+	if (f == nullptr) {
+		fprintf(stderr, "Could not open '%s'\n", argv[1]);
+		return 1;
+	}
+	std::vector<LinkGraph *> graphs;
+	bool ok = ImportLinkGraphs(f, graphs);
+	fclose(f);
+	if (!ok) {
+		fprintf(stderr, "Could not read link graph export '%s'\n", argv[1]);
+		return 1;
+	}
+
+	if (worker_threads != 0) {
+		_worker_thread_count = std::max(worker_threads, 0);
+		StartGeneralWorkerPool();
+	}
+
+	static const char * const handler_names[] = { "init", "demands", "mcf1", "flows1", "mcf2", "flows2" };
+	const InitHandler init;
+	const DemandHandler demands;
+	const MCFHandler<MCF1stPass> mcf1;
+	const FlowMapper flows1(false);
+	const MCFHandler<MCF2ndPass> mcf2;
+	const FlowMapper flows2(true);
+	const ComponentHandler * const handlers[] = { &init, &demands, &mcf1, &flows1, &mcf2, &flows2 };
+	static_assert(lengthof(handler_names) == lengthof(handlers));
+
+	printf("%u link graphs, %u iterations, %u worker threads\n", (uint)graphs.size(), iterations, _general_worker_pool.GetWorkerCount());
+
+	std::chrono::steady_clock::duration totals[lengthof(handlers)] = {};
+	for (const LinkGraph *lg : graphs) {
+		if (lg->Size() < 2) continue;
+
+		std::chrono::steady_clock::duration graph_totals[lengthof(handlers)] = {};
+		uint64_t checksum = 0;
+		for (uint i = 0; i < iterations; i++) {
+			LinkGraphJob *job = new LinkGraphJob(*lg, 1);
+			for (uint h = 0; h < lengthof(handlers); h++) {
+				auto start = std::chrono::steady_clock::now();
+				handlers[h]->Run(*job);
+				graph_totals[h] += std::chrono::steady_clock::now() - start;
+			}
+			checksum = FlowChecksum(*job);
+			delete job;
+		}
+
+		printf("graph %u: cargo %u, %u nodes, %u edges, checksum %016" PRIx64 "\n", lg->index, lg->Cargo(), lg->Size(), (uint)lg->GetEdges().size(), checksum);
+		for (uint h = 0; h < lengthof(handlers); h++) {
+			printf("  %-8s %10.3f ms\n", handler_names[h], std::chrono::duration<double, std::milli>(graph_totals[h]).count() / iterations);
+			totals[h] += graph_totals[h];
+		}
+	}
+
+	printf("total:\n");
+	for (uint h = 0; h < lengthof(handlers); h++) {
+		printf("  %-8s %10.3f ms\n", handler_names[h], std::chrono::duration<double, std::milli>(totals[h]).count() / iterations);
+	}
+
+	_general_worker_pool.Stop();
+	return 0;
+}
@@ -15,6 +15,9 @@
 #include "rail_map.h"
 #include "tunnelbridge_map.h"
 #include "pathfinder/water_regions.h"
+#include "pathfinder/rail_regions.h"
+#include "vehicle_func.h"
+#include "station_func.h"
 #include "3rdparty/cpp-btree/btree_map.h"
 #include "core/ring_buffer.hpp"
 #include <array>
@@ -131,6 +134,11 @@ void AllocateMap(uint size_x, uint size_y)
 	_me = reinterpret_cast<TileExtended *>(buf + (_map_size * sizeof(Tile)));
 
 	InitializeWaterRegions();
+	InitializeRailRegions();
+
+	InitializeVehicleTileHash();
+
+	InitializeStationCatchmentIndex();
 }
 
 
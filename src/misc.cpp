@@ -42,6 +42,7 @@
 #include "event_logs.h"
 #include "string_func.h"
 #include "plans_func.h"
+#include "pathfinder/yapf/yapf_cache.h"
 #include "core/format.hpp"
 #include "3rdparty/monocypher/monocypher.h"
 
@@ -138,6 +139,7 @@ void InitializeGame(uint size_x, uint size_y, bool reset_date, bool reset_settin
 	_aux_tileloop_tile = 1;
 	_thd.redsq = INVALID_TILE;
 	_road_layout_change_counter = 0;
+	YapfNotifyTrackLayoutChange(INVALID_TILE, INVALID_TRACK);
 	_loaded_local_company = COMPANY_SPECTATOR;
 	_game_events_since_load = (GameEventFlags) 0;
 	_game_events_overall = (GameEventFlags) 0;
@@ -183,6 +183,7 @@ public:
 	inline void Clear()
 	{
 		for (int i = 0; i < Tcapacity; i++) m_slots[i].Clear();
+		m_num_items = 0;
 	}
 
 	/** const item search */
@@ -254,4 +255,146 @@ public:
 	}
 };
 
+/**
+ * class CGenerationHashTableT<Titem, Thash_bits> - hash table
+ *  of pointers allocated elsewhere, with the same interface as
+ *  CHashTableT, which can be cleared in constant time.
+ *
+ *  Each slot is tagged with the generation in which it was last written,
+ *  slots from an older generation are treated as empty. This is for
+ *  tables which are cleared and refilled very frequently, such as the
+ *  open and closed lists of a pathfinder node list which is reused
+ *  between searches.
+ */
+template <class Titem_, int Thash_bits_>
+class CGenerationHashTableT {
+public:
+	typedef Titem_ Titem;                         // make Titem_ visible from outside of class
+	typedef typename Titem_::Key Tkey;            // make Titem_::Key a property of HashTable
+	static const int Thash_bits = Thash_bits_;    // publish num of hash bits
+	static const int Tcapacity = 1 << Thash_bits; // and num of slots 2^bits
+
+protected:
+	typedef CHashTableSlotT<Titem_> Slot;
+
+	Slot      m_slots[Tcapacity];            // here we store our data (array of blobs)
+	uint32_t  m_slot_generation[Tcapacity];  // generation in which each slot was last valid
+	uint32_t  m_generation;                  // current generation
+	int       m_num_items;                   // item counter
+
+public:
+	/* default constructor */
+	inline CGenerationHashTableT() : m_generation(1), m_num_items(0)
+	{
+		for (int i = 0; i < Tcapacity; i++) m_slot_generation[i] = 0;
+	}
+
+protected:
+	/** static helper - return hash for the given key modulo number of slots */
+	inline static int CalcHash(const Tkey &key)
+	{
+		uint32_t hash = key.CalcHash();
+		hash -= (hash >> 17);          // hash * 131071 / 131072
+		hash -= (hash >> 5);           //   * 31 / 32
+		hash &= (1 << Thash_bits) - 1; //   modulo slots
+		return hash;
+	}
+
+	/** return the slot for the given hash, for reading only */
+	inline const Slot *GetSlotForRead(int hash) const
+	{
+		return (m_slot_generation[hash] == m_generation) ? &m_slots[hash] : nullptr;
+	}
+
+	/** return the slot for the given hash, resetting it first if it is from an older generation */
+	inline Slot &GetSlotForWrite(int hash)
+	{
+		if (m_slot_generation[hash] != m_generation) {
+			m_slots[hash].Clear();
+			m_slot_generation[hash] = m_generation;
+		}
+		return m_slots[hash];
+	}
+
+public:
+	/** item count */
+	inline int Count() const
+	{
+		return m_num_items;
+	}
+
+	/** forget all items, in constant time except when the generation counter wraps */
+	inline void Clear()
+	{
+		m_num_items = 0;
+		m_generation++;
+		if (m_generation == 0) {
+			for (int i = 0; i < Tcapacity; i++) m_slot_generation[i] = 0;
+			m_generation = 1;
+		}
+	}
+
+	/** const item search */
+	const Titem_ *Find(const Tkey &key) const
+	{
+		const Slot *slot = GetSlotForRead(CalcHash(key));
+		return slot != nullptr ? slot->Find(key) : nullptr;
+	}
+
+	/** non-const item search */
+	Titem_ *Find(const Tkey &key)
+	{
+		const Slot *slot = GetSlotForRead(CalcHash(key));
+		return slot != nullptr ? const_cast<Slot *>(slot)->Find(key) : nullptr;
+	}
+
+	/** non-const item search & optional removal (if found) */
+	Titem_ *TryPop(const Tkey &key)
+	{
+		int hash = CalcHash(key);
+		if (GetSlotForRead(hash) == nullptr) return nullptr;
+		Titem_ *item = m_slots[hash].Detach(key);
+		if (item != nullptr) {
+			m_num_items--;
+		}
+		return item;
+	}
+
+	/** non-const item search & removal */
+	Titem_ &Pop(const Tkey &key)
+	{
+		Titem_ *item = TryPop(key);
+		assert(item != nullptr);
+		return *item;
+	}
+
+	/** non-const item search & optional removal (if found) */
+	bool TryPop(Titem_ &item)
+	{
+		int hash = CalcHash(item.GetKey());
+		if (GetSlotForRead(hash) == nullptr) return false;
+		bool ret = m_slots[hash].Detach(item);
+		if (ret) {
+			m_num_items--;
+		}
+		return ret;
+	}
+
+	/** non-const item search & removal */
+	void Pop(Titem_ &item)
+	{
+		[[maybe_unused]] bool ret = TryPop(item);
+		assert(ret);
+	}
+
+	/** add one item - copy it from the given item */
+	void Push(Titem_ &new_item)
+	{
+		Slot &slot = GetSlotForWrite(CalcHash(new_item.GetKey()));
+		assert(slot.Find(new_item.GetKey()) == nullptr);
+		slot.Attach(new_item);
+		m_num_items++;
+	}
+};
+
 #endif /* HASHTABLE_HPP */
@@ -107,6 +107,11 @@ typedef unsigned long in_addr_t;
 #	include <sys/time.h>
 #	include <netdb.h>
 
+#	if defined(__linux__) && !defined(__EMSCRIPTEN__)
+#		define HAVE_EPOLL
+#		include <sys/epoll.h>
+#	endif
+
 #   if defined(__EMSCRIPTEN__)
 /* Emscripten doesn't support AI_ADDRCONFIG and errors out on it. */
 #		undef AI_ADDRCONFIG
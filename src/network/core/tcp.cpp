@@ -14,6 +14,8 @@
 
 #include "tcp.h"
 
+#include <array>
+
 #include "../../safeguards.h"
 
 /**
@@ -54,6 +56,7 @@ NetworkRecvStatus NetworkTCPSocketHandler::CloseConnection([[maybe_unused]] bool
 	this->writable = false;
 
 	this->packet_queue.clear();
+	this->packet_queue_front_pos = 0;
 	this->packet_recv = nullptr;
 
 	return NETWORK_RECV_STATUS_OKAY;
@@ -72,6 +75,34 @@ void NetworkTCPSocketHandler::SendPacket(std::unique_ptr<Packet> packet)
 	packet->PrepareToSend();
 
 	this->packet_queue.push_back(std::move(packet));
+	this->OnPacketQueued();
+}
+
+/**
+ * Prepare a packet to be sent to several sockets using #SendSharedPacket.
+ * @param packet The packet, which must not be modified after this.
+ * @return The prepared packet.
+ */
+/* static */ std::shared_ptr<const Packet> NetworkTCPSocketHandler::PrepareSharedPacket(std::unique_ptr<Packet> packet)
+{
+	assert(packet != nullptr);
+
+	packet->PrepareToSend();
+
+	return std::shared_ptr<const Packet>(std::move(packet));
+}
+
+/**
+ * This function puts a packet which was prepared using #PrepareSharedPacket in the send-queue,
+ * the same packet may be queued on any number of sockets.
+ * @param packet the packet to send
+ */
+void NetworkTCPSocketHandler::SendSharedPacket(std::shared_ptr<const Packet> packet)
+{
+	assert(packet != nullptr);
+
+	this->packet_queue.push_back(std::move(packet));
+	this->OnPacketQueued();
 }
 
 /**
@@ -85,6 +116,7 @@ void NetworkTCPSocketHandler::SendPrependPacket(std::unique_ptr<Packet> packet,
 	assert(packet != nullptr);
 
 	packet->PrepareToSend();
+	this->OnPacketQueued();
 
 	if (queue_after_packet_type >= 0) {
 		for (auto iter = this->packet_queue.begin(); iter != this->packet_queue.end(); ++iter) {
@@ -99,10 +131,11 @@ void NetworkTCPSocketHandler::SendPrependPacket(std::unique_ptr<Packet> packet,
 	/* The very first packet in the queue may be partially written out, so cannot be replaced.
 	 * If the queue is non-empty, swap packet with the first packet in the queue.
 	 * The insert the packet (either the incoming packet or the previous first packet) at the front. */
+	std::shared_ptr<const Packet> queued = std::move(packet);
 	if (!this->packet_queue.empty()) {
-		packet.swap(this->packet_queue.front());
+		queued.swap(this->packet_queue.front());
 	}
-	this->packet_queue.push_front(std::move(packet));
+	this->packet_queue.push_front(std::move(queued));
 }
 
 /**
@@ -113,6 +146,58 @@ void NetworkTCPSocketHandler::ShrinkToFitSendQueue()
 	this->packet_queue.shrink_to_fit();
 }
 
+/**
+ * Send as much as possible of the first packets of the send queue in one system call.
+ * @param[out] batch_size The number of bytes which were passed to the system call.
+ * @return The number of bytes sent, or -1 on error.
+ */
+ssize_t NetworkTCPSocketHandler::TransferOutQueue(size_t &batch_size)
+{
+	/* Maximum number of packets to send at once */
+	static constexpr uint MAX_BATCH = 64;
+
+#if defined(UNIX) && !defined(__EMSCRIPTEN__)
+	std::array<struct iovec, MAX_BATCH> iov;
+	uint count = 0;
+	batch_size = 0;
+	size_t offset = this->packet_queue_front_pos;
+	for (auto it = this->packet_queue.begin(); it != this->packet_queue.end() && count < MAX_BATCH; ++it) {
+		const Packet &p = **it;
+		iov[count].iov_base = const_cast<uint8_t *>(p.GetBufferData() + offset);
+		iov[count].iov_len = p.Size() - offset;
+		batch_size += iov[count].iov_len;
+		count++;
+		offset = 0;
+	}
+
+	struct msghdr msg{};
+	msg.msg_iov = iov.data();
+	msg.msg_iovlen = count;
+	return sendmsg(this->sock, &msg, 0);
+#elif defined(_WIN32)
+	std::array<WSABUF, MAX_BATCH> bufs;
+	DWORD count = 0;
+	batch_size = 0;
+	size_t offset = this->packet_queue_front_pos;
+	for (auto it = this->packet_queue.begin(); it != this->packet_queue.end() && count < MAX_BATCH; ++it) {
+		const Packet &p = **it;
+		bufs[count].buf = reinterpret_cast<CHAR *>(const_cast<uint8_t *>(p.GetBufferData() + offset));
+		bufs[count].len = static_cast<ULONG>(p.Size() - offset);
+		batch_size += bufs[count].len;
+		count++;
+		offset = 0;
+	}
+
+	DWORD sent = 0;
+	if (WSASend(this->sock, bufs.data(), count, &sent, 0, nullptr, nullptr) == SOCKET_ERROR) return -1;
+	return static_cast<ssize_t>(sent);
+#else
+	const Packet &p = *this->packet_queue.front();
+	batch_size = p.Size() - this->packet_queue_front_pos;
+	return send(this->sock, reinterpret_cast<const char *>(p.GetBufferData() + this->packet_queue_front_pos), static_cast<int>(batch_size), 0);
+#endif
+}
+
 /**
  * Sends all the buffered packets out for this client. It stops when:
  *   1) all packets are send (queue is empty)
@@ -130,8 +215,8 @@ SendPacketsState NetworkTCPSocketHandler::SendPackets(bool closing_down)
 	if (!this->IsConnected()) return SPS_CLOSED;
 
 	while (!this->packet_queue.empty()) {
-		Packet &p = *this->packet_queue.front();
-		ssize_t res = p.TransferOut<int>(send, this->sock, 0);
+		size_t batch_size;
+		ssize_t res = this->TransferOutQueue(batch_size);
 		if (res == -1) {
 			NetworkError err = NetworkError::GetLast();
 			if (!err.WouldBlock()) {
@@ -142,6 +227,8 @@ SendPacketsState NetworkTCPSocketHandler::SendPackets(bool closing_down)
 				}
 				return SPS_CLOSED;
 			}
+			/* The OS buffer is full, wait until the socket is reported as writable again. */
+			this->writable = false;
 			return SPS_PARTLY_SENT;
 		}
 		if (res == 0) {
@@ -150,14 +237,24 @@ SendPacketsState NetworkTCPSocketHandler::SendPackets(bool closing_down)
 			return SPS_CLOSED;
 		}
 
-		/* Is this packet sent? */
-		if (p.RemainingBytesToTransfer() == 0) {
+		/* Remove the packets which were sent */
+		size_t sent = res;
+		while (sent > 0) {
+			const Packet &p = *this->packet_queue.front();
+			size_t remaining = p.Size() - this->packet_queue_front_pos;
+			if (sent < remaining) {
+				this->packet_queue_front_pos += sent;
+				break;
+			}
+			sent -= remaining;
+
 			/* Go to the next packet */
 			if (_debug_net_level >= 5) this->LogSentPacket(p);
 			this->packet_queue.pop_front();
-		} else {
-			return SPS_PARTLY_SENT;
+			this->packet_queue_front_pos = 0;
 		}
+
+		if (static_cast<size_t>(res) < batch_size) return SPS_PARTLY_SENT;
 	}
 
 	return SPS_ALL_SENT;
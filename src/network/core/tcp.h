@@ -34,8 +34,15 @@ enum SendPacketsState {
 /** Base socket handler for all TCP sockets */
 class NetworkTCPSocketHandler : public NetworkSocketHandler {
 private:
-	ring_buffer<std::unique_ptr<Packet>> packet_queue; ///< Packets that are awaiting delivery
-	std::unique_ptr<Packet> packet_recv;               ///< Partially received packet
+	ring_buffer<std::shared_ptr<const Packet>> packet_queue; ///< Packets that are awaiting delivery, which may be shared with other sockets
+	size_t packet_queue_front_pos = 0;                       ///< Number of bytes of the first packet in #packet_queue which were sent
+	std::unique_ptr<Packet> packet_recv;                     ///< Partially received packet
+
+	ssize_t TransferOutQueue(size_t &batch_size);
+
+protected:
+	/** Called when a packet is added to the send queue. */
+	virtual void OnPacketQueued() {}
 
 public:
 	SOCKET sock;              ///< The socket currently connected to
@@ -51,6 +58,8 @@ public:
 	void CloseSocket();
 
 	void SendPacket(std::unique_ptr<Packet> packet);
+	void SendSharedPacket(std::shared_ptr<const Packet> packet);
+	static std::shared_ptr<const Packet> PrepareSharedPacket(std::unique_ptr<Packet> packet);
 	void SendPrependPacket(std::unique_ptr<Packet> packet, int queue_after_packet_type);
 	void ShrinkToFitSendQueue();
 
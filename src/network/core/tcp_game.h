@@ -575,7 +575,7 @@ public:
 	NetworkRecvStatus ReceivePackets();
 
 	const char *ReceiveCommand(Packet &p, CommandPacket &cp);
-	void SendCommand(Packet &p, const CommandPacket &cp);
+	static void SendCommand(Packet &p, const CommandPacket &cp);
 
 	virtual std::string GetDebugInfo() const;
 	virtual void LogSentPacket(const Packet &pkt) override;
@@ -18,6 +18,8 @@
 #include "../../debug.h"
 #include "table/strings.h"
 
+#include <vector>
+
 /**
  * Template for TCP listeners.
  * @param Tsocket      The class we create sockets for.
@@ -29,7 +31,199 @@ class TCPListenHandler {
 	/** List of sockets we listen on. */
 	static SocketList sockets;
 
+#ifdef HAVE_EPOLL
+	/**
+	 * Readiness of the listener and connection sockets, when polling is active.
+	 * Reading is level-triggered, so that a socket whose packets were not all handled is reported again.
+	 * Writing is edge-triggered, #writable is set when a connection becomes writable and is cleared when sending would block.
+	 */
+	static inline int epoll_read_fd = -1;
+	static inline int epoll_write_fd = -1;
+	static inline std::vector<struct epoll_event> epoll_events;
+
+	/**
+	 * Poll data of the connections which may have something to send, when polling.
+	 * A connection is added when it queues a packet or becomes writable, so that sending does not need to visit every connection.
+	 */
+	static inline std::vector<uint64_t> send_pending;
+	bool in_send_pending = false; ///< Whether this connection is in #send_pending.
+
+	static constexpr uint32_t LISTENER_INDEX = UINT32_MAX; ///< Pool index used in the poll data of listener sockets.
+
+	static uint64_t GetPollData(SOCKET s, uint32_t index)
+	{
+		return (static_cast<uint64_t>(static_cast<uint32_t>(s)) << 32) | index;
+	}
+
+	/**
+	 * Get the connection of a poll event.
+	 * @param data The poll data of the event.
+	 * @return The connection, or nullptr if the connection was closed since the event was registered.
+	 */
+	static Tsocket *GetPolledSocket(uint64_t data)
+	{
+		Tsocket *cs = Tsocket::GetIfValid(static_cast<uint32_t>(data));
+		if (cs == nullptr || cs->sock != static_cast<SOCKET>(data >> 32)) return nullptr;
+		return cs;
+	}
+
+	static bool AddToPoll(SOCKET s, uint32_t index, bool write)
+	{
+		struct epoll_event ev{};
+		ev.data.u64 = GetPollData(s, index);
+		ev.events = EPOLLIN;
+		if (epoll_ctl(epoll_read_fd, EPOLL_CTL_ADD, s, &ev) < 0) return false;
+		if (!write) return true;
+		ev.events = EPOLLOUT | EPOLLET;
+		return epoll_ctl(epoll_write_fd, EPOLL_CTL_ADD, s, &ev) == 0;
+	}
+
+	/** Start polling the listener sockets, if polling is not possible the sockets are checked using select instead. */
+	static void StartPolling()
+	{
+		assert(epoll_read_fd < 0);
+		epoll_read_fd = epoll_create1(EPOLL_CLOEXEC);
+		epoll_write_fd = epoll_create1(EPOLL_CLOEXEC);
+		bool ok = (epoll_read_fd >= 0 && epoll_write_fd >= 0);
+		for (auto &s : sockets) {
+			if (ok) ok = AddToPoll(s.first, LISTENER_INDEX, false);
+		}
+		if (!ok) {
+			DEBUG(net, 1, "[%s] Could not set up epoll, falling back to select: %s", Tsocket::GetName(), NetworkError::GetLast().AsString());
+			StopPolling();
+			return;
+		}
+		DEBUG(net, 5, "[%s] Using epoll", Tsocket::GetName());
+	}
+
+	/** Stop polling, the sockets will be checked using select. */
+	static void StopPolling()
+	{
+		if (epoll_read_fd >= 0) close(epoll_read_fd);
+		if (epoll_write_fd >= 0) close(epoll_write_fd);
+		epoll_read_fd = -1;
+		epoll_write_fd = -1;
+		epoll_events.clear();
+		epoll_events.shrink_to_fit();
+		send_pending.clear();
+		for (Tsocket *cs : Tsocket::Iterate()) {
+			cs->in_send_pending = false;
+		}
+	}
+
+	/**
+	 * Handle the receiving of packets on the connections which are ready, and accept new connections.
+	 * @return true if everything went okay.
+	 */
+	static bool ReceivePolled()
+	{
+		epoll_events.resize(Tsocket::GetNumItems() + sockets.size() + 1);
+
+		int count = epoll_wait(epoll_write_fd, epoll_events.data(), static_cast<int>(epoll_events.size()), 0);
+		if (count < 0 && errno != EINTR) return false;
+		for (int i = 0; i < count; i++) {
+			Tsocket *cs = GetPolledSocket(epoll_events[i].data.u64);
+			if (cs != nullptr) {
+				cs->writable = true;
+				cs->MarkSendPending();
+			}
+		}
+
+		count = epoll_wait(epoll_read_fd, epoll_events.data(), static_cast<int>(epoll_events.size()), 0);
+		if (count < 0 && errno != EINTR) return false;
+		for (int i = 0; i < count; i++) {
+			const uint64_t data = epoll_events[i].data.u64;
+			if (static_cast<uint32_t>(data) == LISTENER_INDEX) {
+				AcceptClient(static_cast<SOCKET>(data >> 32));
+				continue;
+			}
+			Tsocket *cs = GetPolledSocket(data);
+			if (cs != nullptr) cs->ReceivePackets();
+		}
+		return _networking;
+	}
+#endif /* HAVE_EPOLL */
+
 public:
+	/**
+	 * Register a newly accepted connection, this must be called by Tsocket::AcceptConnection.
+	 * @param cs The connection.
+	 */
+	static void RegisterConnection(Tsocket *cs)
+	{
+#ifdef HAVE_EPOLL
+		if (epoll_read_fd >= 0 && !AddToPoll(cs->sock, cs->index, true)) {
+			DEBUG(net, 1, "[%s] Could not add connection to epoll, falling back to select: %s", Tsocket::GetName(), NetworkError::GetLast().AsString());
+			StopPolling();
+		}
+#endif /* HAVE_EPOLL */
+	}
+
+	/**
+	 * Note that this connection may have something to send, this must be called by Tsocket whenever it queues a packet.
+	 */
+	void MarkSendPending()
+	{
+#ifdef HAVE_EPOLL
+		if (epoll_read_fd < 0 || this->in_send_pending) return;
+		const Tsocket *cs = static_cast<const Tsocket *>(this);
+		this->in_send_pending = true;
+		send_pending.push_back(GetPollData(cs->sock, cs->index));
+#endif /* HAVE_EPOLL */
+	}
+
+	/**
+	 * Call a function for the connections which can be written to and may have something to send.
+	 * When polling, these are only the connections which queued packets or became writable since they were last visited.
+	 * Otherwise these are all connections which select reported as writable.
+	 * @param send The function to call, which returns whether the connection should be visited again even when it queued nothing, e.g. to continue a map download. It may delete the connection.
+	 */
+	template <typename F>
+	static void IterateSendable(F send)
+	{
+#ifdef HAVE_EPOLL
+		if (epoll_read_fd >= 0) {
+			/* Connections which queue packets whilst sending are added to the next round */
+			std::vector<uint64_t> pending;
+			pending.swap(send_pending);
+			for (uint64_t data : pending) {
+				Tsocket *cs = GetPolledSocket(data);
+				if (cs == nullptr || !cs->in_send_pending) continue;
+				cs->in_send_pending = false;
+				if (!cs->writable) continue; // Added again when it becomes writable
+
+				const bool again = send(cs);
+
+				cs = GetPolledSocket(data);
+				if (cs != nullptr && cs->writable && (again || cs->HasSendQueue())) cs->MarkSendPending();
+			}
+			if (send_pending.empty()) {
+				/* Reuse the storage */
+				pending.clear();
+				send_pending.swap(pending);
+			}
+			return;
+		}
+#endif /* HAVE_EPOLL */
+
+		for (Tsocket *cs : Tsocket::Iterate()) {
+			if (cs->writable) send(cs);
+		}
+	}
+
+	/**
+	 * Whether the connections are checked using epoll, instead of select.
+	 * @return true if polling is active.
+	 */
+	static bool IsPolling()
+	{
+#ifdef HAVE_EPOLL
+		return epoll_read_fd >= 0;
+#else
+		return false;
+#endif /* HAVE_EPOLL */
+	}
+
 	static bool ValidateClient(SOCKET s, NetworkAddress &address)
 	{
 		/* Check if the client is banned. */
@@ -100,6 +294,10 @@ public:
 	 */
 	static bool Receive()
 	{
+#ifdef HAVE_EPOLL
+		if (epoll_read_fd >= 0) return ReceivePolled();
+#endif /* HAVE_EPOLL */
+
 		fd_set read_fd, write_fd;
 		struct timeval tv;
 
@@ -157,12 +355,19 @@ public:
 			return false;
 		}
 
+#ifdef HAVE_EPOLL
+		StartPolling();
+#endif /* HAVE_EPOLL */
+
 		return true;
 	}
 
 	/** Close the sockets we're listening on. */
 	static void CloseListeners()
 	{
+#ifdef HAVE_EPOLL
+		StopPolling();
+#endif /* HAVE_EPOLL */
 		for (auto &s : sockets) {
 			closesocket(s.first);
 		}
@@ -47,9 +47,6 @@
 
 #ifdef DEBUG_DUMP_COMMANDS
 #include "../fileio_func.h"
-#include "../command_aux.h"
-#include "../3rdparty/nlohmann/json.hpp"
-#include <charconv>
 /** When running the server till the wait point, run as fast as we can! */
 bool _ddc_fastforward = true;
 #endif /* DEBUG_DUMP_COMMANDS */
@@ -68,6 +65,7 @@ bool _network_server;                                   ///< network-server is a
 bool _network_available;                                ///< is network mode available?
 bool _network_dedicated;                                ///< are we a dedicated server?
 bool _is_network_server;                                ///< Does this client wants to be a network-server?
+bool _network_relay;                                    ///< Does this client relay the game of its server to spectators?
 bool _network_settings_access;                          ///< Can this client change server settings?
 NetworkCompanyState *_network_company_states = nullptr; ///< Statistics about some companies.
 std::string _network_company_server_id;                 ///< Server ID string used for company passwords
@@ -620,6 +618,7 @@ NetworkAddress ParseConnectionString(const std::string &connection_string, uint1
 
 	ServerNetworkGameSocketHandler *cs = new ServerNetworkGameSocketHandler(s);
 	cs->client_address = address; // Save the IP of the client
+	ServerNetworkGameSocketHandler::RegisterConnection(cs);
 
 	InvalidateWindowData(WC_CLIENT_LIST, 0);
 }
@@ -659,6 +658,8 @@ void NetworkClose(bool close_admins)
 			MyClient::my_client->CloseConnection(NETWORK_RECV_STATUS_CLIENT_QUIT);
 		}
 
+		if (_network_relay) NetworkRelayClose();
+
 		_network_coordinator_client.CloseAllConnections();
 	}
 	NetworkGameSocketHandler::ProcessDeferredDeletions();
@@ -819,6 +820,8 @@ public:
 	}
 };
 
+static void CheckClientAndServerName();
+
 /**
  * Join a client to the server at with the given connection string.
  * The default for the passwords is \c nullptr. When the server or company needs a
@@ -842,6 +845,12 @@ bool NetworkClientConnectGame(const std::string &connection_string, CompanyID de
 	std::string resolved_connection_string = ServerAddress::Parse(connection_string, NETWORK_DEFAULT_PORT, &join_as).connection_string;
 
 	if (!_network_available) return false;
+
+	if (_network_relay) {
+		/* A relay has no write access to the game, and like a dedicated server runs without anyone to enter a name. */
+		join_as = COMPANY_SPECTATOR;
+		CheckClientAndServerName();
+	}
 	if (!NetworkValidateOurClientName()) return false;
 
 	_network_join.connection_string = resolved_connection_string;
@@ -997,6 +1006,27 @@ bool NetworkServerStart()
 	return true;
 }
 
+/**
+ * Start listening for the spectators of a relay, once the game of the server it relays has been loaded.
+ * The spectators are served by the same socket handlers as the clients of a server, but only get
+ * the game state and the commands of the relayed server and cannot send anything to it.
+ */
+void NetworkRelayListen()
+{
+	DEBUG(net, 5, "Starting listeners for relay spectators");
+	if (!ServerNetworkGameSocketHandler::Listen(_settings_client.network.server_port)) {
+		DEBUG(net, 0, "Could not start listeners for relay spectators");
+		return;
+	}
+
+	_last_sync_frame = _frame_counter;
+	_network_clients_connected = 0;
+
+	FillStaticNetworkServerGameInfo();
+	/* The relay itself is a client of the relayed server, not of the relay. */
+	_network_game_info.clients_on = 0;
+}
+
 /* The server is rebooting...
  * The only difference with NetworkDisconnect, is the packets that is sent */
 void NetworkReboot()
@@ -1081,6 +1111,7 @@ static bool NetworkReceive()
 		result = ServerNetworkGameSocketHandler::Receive();
 	} else {
 		result = ClientNetworkGameSocketHandler::Receive();
+		if (result && _network_relay) ServerNetworkGameSocketHandler::Receive();
 	}
 	NetworkGameSocketHandler::ProcessDeferredDeletions();
 	return result;
@@ -1094,6 +1125,7 @@ static void NetworkSend()
 		ServerNetworkGameSocketHandler::Send();
 	} else {
 		ClientNetworkGameSocketHandler::Send();
+		if (_network_relay) ServerNetworkGameSocketHandler::Send();
 	}
 	NetworkGameSocketHandler::ProcessDeferredDeletions();
 }
@@ -1177,9 +1209,9 @@ void NetworkGameLoop()
 		static EconTime::Date next_date = 0;
 		static uint next_date_fract;
 		static uint next_tick_skip_counter;
-		static std::unique_ptr<CommandPacket> cp;
+		static CommandLogLine line;
+		static bool inject_cmd = false;
 		static bool check_sync_state = false;
-		static uint32_t sync_state[2];
 		if (f == nullptr && next_date == 0) {
 			DEBUG(desync, 0, "Cannot open commands.log");
 			next_date = 1;
@@ -1187,113 +1219,72 @@ void NetworkGameLoop()
 
 		while (f != nullptr && !feof(f)) {
 			if (EconTime::CurDate() == next_date && EconTime::CurDateFract() == next_date_fract) {
-				if (cp != nullptr) {
-					NetworkSendCommand(cp->tile, cp->p1, cp->p2, cp->p3, cp->cmd & ~CMD_FLAGS_MASK, nullptr, cp->text.c_str(), cp->company, cp->aux_data.get());
+				if (inject_cmd) {
+					const CommandContainer &cmd = line.cmd;
+					NetworkSendCommand(cmd.tile, cmd.p1, cmd.p2, cmd.p3, cmd.cmd & ~CMD_FLAGS_MASK, nullptr, cmd.text.c_str(), line.company, cmd.aux_data.get());
 					DEBUG(net, 0, "injecting: %s; %02x; %06x; %08x; %08x; " OTTD_PRINTFHEX64PAD " %08x; \"%s\"%s (%s)",
-							debug_date_dumper().HexDate(), (int)_current_company, cp->tile, cp->p1, cp->p2, cp->p3, cp->cmd, cp->text.c_str(), cp->aux_data != nullptr ? " (aux data present)" : "", GetCommandName(cp->cmd));
-					cp.reset();
+							debug_date_dumper().HexDate(), (int)_current_company, cmd.tile, cmd.p1, cmd.p2, cmd.p3, cmd.cmd, cmd.text.c_str(), cmd.aux_data != nullptr ? " (aux data present)" : "", GetCommandName(cmd.cmd));
+					inject_cmd = false;
 				}
 				if (check_sync_state) {
-					if (sync_state[0] == _random.state[0] && sync_state[1] == _random.state[1]) {
+					if (line.sync_state[0] == _random.state[0] && line.sync_state[1] == _random.state[1]) {
 						DEBUG(net, 0, "sync check: %s; match", debug_date_dumper().HexDate());
 					} else {
 						DEBUG(net, 0, "sync check: %s; mismatch expected {%08x, %08x}, got {%08x, %08x}",
-									debug_date_dumper().HexDate(), sync_state[0], sync_state[1], _random.state[0], _random.state[1]);
+									debug_date_dumper().HexDate(), line.sync_state[0], line.sync_state[1], _random.state[0], _random.state[1]);
 						NOT_REACHED();
 					}
 					check_sync_state = false;
 				}
 			}
 
-			if (cp != nullptr || check_sync_state) break;
+			if (inject_cmd || check_sync_state) break;
 
 			static char buff[65536];
 			if (fgets(buff, lengthof(buff), f) == nullptr) break;
 
-			char *p = buff;
-			/* Ignore the "[date time] " part of the message */
-			if (*p == '[') {
-				p = strchr(p, ']');
-				if (p == nullptr) break;
-				p += 2;
+			const CommandLogLineType type = ParseCommandLogLine(buff, line);
+			if (type != CLLT_OTHER && type != CLLT_INVALID) {
+				next_date = EconTime::Date{static_cast<int32_t>(line.date)};
+				next_date_fract = line.date_fract;
+				next_tick_skip_counter = line.tick_skip_counter;
 			}
 
-			if (strncmp(p, "cmd: ", 5) == 0
+			switch (type) {
+				case CLLT_COMMAND:
 #ifdef DEBUG_FAILED_DUMP_COMMANDS
-				|| strncmp(p, "cmdf: ", 6) == 0
+				case CLLT_FAILED_COMMAND:
 #endif
-				) {
-				p += 5;
-				if (*p == ' ') p++;
-				cp.reset(new CommandPacket());
-				int company;
-				int offset;
-				int ret = sscanf(p, "date{%x; %x; %x}; company: %x; tile: %x (%*u x %*u); p1: %x; p2: %x; p3: " OTTD_PRINTFHEX64 "; cmd: %x; %n\"",
-						&next_date.edit_base(), &next_date_fract, &next_tick_skip_counter, &company, &cp->tile, &cp->p1, &cp->p2, &cp->p3, &cp->cmd, &offset);
-				assert(ret == 9);
-				cp->company = (CompanyID)company;
-
-				const char *text_start = p + offset;
-				const char *text_end = text_start + 1;
-				while (*text_end != 0) {
-					char current = *text_end;
-					text_end++;
-					if (current == '"') break;
-					if (current == '\\' && *text_end != 0) {
-						text_end++;
-					}
-				}
-				auto json = nlohmann::json::parse(text_start, text_end, nullptr, false);
-				if (json.is_string()) {
-					cp->text = json.get<std::string>();
-				}
-
-				const char *aux_str = text_end;
-				while (*aux_str != 0 && *aux_str != '<') aux_str++;
+					inject_cmd = true;
+					break;
+
+				case CLLT_JOIN:
+					/* Manually insert a pause when joining; this way the client can join at the exact right time. */
+					DEBUG(net, 0, "injecting pause for join at %s; please join when paused", debug_date_dumper().HexDate(next_date, next_date_fract, next_tick_skip_counter));
+					line.company = COMPANY_SPECTATOR;
+					line.cmd = NewCommandContainerBasic(0, PM_PAUSED_NORMAL, 1, CMD_PAUSE);
+					inject_cmd = true;
+					_ddc_fastforward = false;
+					break;
+
+				case CLLT_SYNC:
+					check_sync_state = true;
+					break;
+
+				case CLLT_OTHER:
+					/* A message that is not very important to the log playback, but part of the log. */
+					break;
 
-				if (aux_str[0] == '<' && aux_str[1] != '>') {
-					auto aux = std::make_unique<CommandAuxiliarySerialised>();
-					for (const char *data = aux_str + 1; data[0] != 0 && data[1] != 0 && data[0] != '>'; data += 2) {
-						uint8_t e = 0;
-						std::from_chars(data, data + 2, e, 16);
-						aux->serialised_data.emplace_back(e);
-					}
-					cp->aux_data = std::move(aux);
-				} else {
-					cp->aux_data = nullptr;
-				}
-			} else if (strncmp(p, "join: ", 6) == 0) {
-				/* Manually insert a pause when joining; this way the client can join at the exact right time. */
-				int ret = sscanf(p + 6, "date{%x; %x; %x}", &next_date.edit_base(), &next_date_fract, &next_tick_skip_counter);
-				assert(ret == 3);
-				DEBUG(net, 0, "injecting pause for join at %s; please join when paused", debug_date_dumper().HexDate(next_date, next_date_fract, next_tick_skip_counter));
-				cp.reset(new CommandPacket());
-				cp->tile = 0;
-				cp->company = COMPANY_SPECTATOR;
-				cp->cmd = CMD_PAUSE;
-				cp->p1 = PM_PAUSED_NORMAL;
-				cp->p2 = 1;
-				cp->p3 = 0;
-				cp->callback = nullptr;
-				cp->aux_data = nullptr;
-				_ddc_fastforward = false;
-			} else if (strncmp(p, "sync: ", 6) == 0) {
-				int ret = sscanf(p + 6, "date{%x; %x; %x}; %x; %x", &next_date.edit_base(), &next_date_fract, &next_tick_skip_counter, &sync_state[0], &sync_state[1]);
-				assert(ret == 5);
-				check_sync_state = true;
-			} else if (strncmp(p, "msg: ", 5) == 0 || strncmp(p, "client: ", 8) == 0 ||
-						strncmp(p, "load: ", 6) == 0 || strncmp(p, "save: ", 6) == 0 ||
-						strncmp(p, "new_company: ", 13) == 0 || strncmp(p, "new_company_ai: ", 16) == 0 ||
-						strncmp(p, "buy_company: ", 13) == 0 || strncmp(p, "delete_company: ", 16) == 0) {
-				/* A message that is not very important to the log playback, but part of the log. */
 #ifndef DEBUG_FAILED_DUMP_COMMANDS
-			} else if (strncmp(p, "cmdf: ", 6) == 0) {
-				DEBUG(desync, 0, "Skipping replay of failed command: %s", p + 6);
+				case CLLT_FAILED_COMMAND:
+					DEBUG(desync, 0, "Skipping replay of failed command: %s", buff);
+					break;
 #endif
-			} else {
-				/* Can't parse a line; what's wrong here? */
-				DEBUG(desync, 0, "Trying to parse: %s", p);
-				NOT_REACHED();
+
+				case CLLT_INVALID:
+					/* Can't parse a line; what's wrong here? */
+					DEBUG(desync, 0, "Trying to parse: %s", buff);
+					NOT_REACHED();
 			}
 		}
 		if (f != nullptr && feof(f)) {
@@ -1360,6 +1351,8 @@ void NetworkGameLoop()
 				if (!ClientNetworkGameSocketHandler::GameLoop()) return;
 			}
 		}
+
+		if (_network_relay) NetworkRelay_Tick();
 	}
 
 	NetworkSend();
@@ -20,6 +20,7 @@ extern bool _network_server;     ///< network-server is active
 extern bool _network_available;  ///< is network mode available?
 extern bool _network_dedicated;  ///< are we a dedicated server?
 extern bool _is_network_server;  ///< Does this client wants to be a network-server?
+extern bool _network_relay;      ///< Does this client relay the game of its server to spectators?
 extern bool _network_settings_access;  ///< Can this client change server settings?
 
 inline bool IsNetworkSettingsAdmin()
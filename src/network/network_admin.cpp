@@ -106,12 +106,13 @@ ServerNetworkAdminSocketHandler::~ServerNetworkAdminSocketHandler()
 		if (as->status == ADMIN_STATUS_INACTIVE && std::chrono::steady_clock::now() > as->connect_time + ADMIN_AUTHORISATION_TIMEOUT) {
 			DEBUG(net, 2, "[admin] Admin did not send its authorisation within %d seconds", (uint32_t)std::chrono::duration_cast<std::chrono::seconds>(ADMIN_AUTHORISATION_TIMEOUT).count());
 			as->CloseConnection(true);
-			continue;
-		}
-		if (as->writable) {
-			as->SendPackets();
 		}
 	}
+
+	IterateSendable([](ServerNetworkAdminSocketHandler *as) {
+		as->SendPackets();
+		return false;
+	});
 }
 
 /**
@@ -123,6 +124,7 @@ ServerNetworkAdminSocketHandler::~ServerNetworkAdminSocketHandler()
 {
 	ServerNetworkAdminSocketHandler *as = new ServerNetworkAdminSocketHandler(s);
 	as->address = address; // Save the IP of the client
+	ServerNetworkAdminSocketHandler::RegisterConnection(as);
 }
 
 /***********
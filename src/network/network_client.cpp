@@ -26,6 +26,7 @@
 #include "network.h"
 #include "network_base.h"
 #include "network_client.h"
+#include "network_server.h"
 #include "network_gamelist.h"
 #include "../core/backup_type.hpp"
 #include "../thread.h"
@@ -272,6 +273,8 @@ void ClientNetworkGameSocketHandler::ClientError(NetworkRecvStatus res)
 	CloseNetworkClientWindows();
 	CloseWindowById(WC_NETWORK_STATUS_WINDOW, WN_NETWORK_STATUS_WINDOW_JOIN);
 
+	if (_network_relay) NetworkRelayClose();
+
 	if (_game_mode != GM_MENU) _switch_mode = SM_MENU;
 	_networking = false;
 }
@@ -546,8 +549,10 @@ NetworkRecvStatus ClientNetworkGameSocketHandler::SendGetMap()
 	auto p = std::make_unique<Packet>(PACKET_CLIENT_GETMAP, TCP_MTU);
 #if defined(WITH_ZSTD)
 	p->Send_bool(true);
+	p->Send_bool(true); // supports block-parallel zstd
 #else
 	p->Send_bool(false);
+	p->Send_bool(false);
 #endif
 	my_client->SendPacket(std::move(p));
 	return NETWORK_RECV_STATUS_OKAY;
@@ -805,6 +810,7 @@ NetworkRecvStatus ClientNetworkGameSocketHandler::Receive_SERVER_CLIENT_INFO(Pac
 		ci->client_name = name;
 
 		InvalidateWindowData(WC_CLIENT_LIST, 0);
+		if (_network_relay) NetworkUpdateClientInfo(client_id);
 
 		return NETWORK_RECV_STATUS_OKAY;
 	}
@@ -824,6 +830,7 @@ NetworkRecvStatus ClientNetworkGameSocketHandler::Receive_SERVER_CLIENT_INFO(Pac
 	ci->client_name = name;
 
 	InvalidateWindowData(WC_CLIENT_LIST, 0);
+	if (_network_relay) NetworkUpdateClientInfo(client_id);
 
 	return NETWORK_RECV_STATUS_OKAY;
 }
@@ -1058,6 +1065,8 @@ NetworkRecvStatus ClientNetworkGameSocketHandler::Receive_SERVER_MAP_DONE(Packet
 	/* Say we received the map and loaded it correctly! */
 	SendMapOk();
 
+	if (_network_relay) NetworkRelayListen();
+
 	/* As we skipped switch-mode, update the time we "switched". */
 	_game_session_stats.start_time = std::chrono::steady_clock::now();
 	_game_session_stats.savegame_size = std::nullopt;
@@ -1145,6 +1154,7 @@ NetworkRecvStatus ClientNetworkGameSocketHandler::Receive_SERVER_COMMAND(Packet
 		return NETWORK_RECV_STATUS_MALFORMED_PACKET;
 	}
 
+	if (_network_relay) NetworkRelayDistributeCommand(cp);
 	this->incoming_queue.push_back(std::move(cp));
 
 	return NETWORK_RECV_STATUS_OKAY;
@@ -1228,11 +1238,13 @@ NetworkRecvStatus ClientNetworkGameSocketHandler::Receive_SERVER_ERROR_QUIT(Pack
 	ClientID client_id = (ClientID)p.Recv_uint32();
 	if (client_id == _network_own_client_id) return NETWORK_RECV_STATUS_OKAY; // do not try to clear our own client info
 
+	NetworkErrorCode errorno = (NetworkErrorCode)p.Recv_uint8();
 	NetworkClientInfo *ci = NetworkClientInfo::GetByClientID(client_id);
 	if (ci != nullptr) {
-		NetworkTextMessage(NETWORK_ACTION_LEAVE, CC_DEFAULT, false, ci->client_name, "", GetNetworkErrorMsg((NetworkErrorCode)p.Recv_uint8()));
+		NetworkTextMessage(NETWORK_ACTION_LEAVE, CC_DEFAULT, false, ci->client_name, "", GetNetworkErrorMsg(errorno));
 		delete ci;
 	}
+	if (_network_relay) NetworkRelayClientQuit(client_id, errorno);
 
 	InvalidateWindowData(WC_CLIENT_LIST, 0);
 
@@ -1261,6 +1273,7 @@ NetworkRecvStatus ClientNetworkGameSocketHandler::Receive_SERVER_QUIT(Packet &p)
 	} else {
 		DEBUG(net, 1, "Unknown client (%d) is leaving the game", client_id);
 	}
+	if (_network_relay) NetworkRelayClientQuit(client_id, NETWORK_ERROR_END);
 
 	InvalidateWindowData(WC_CLIENT_LIST, 0);
 
@@ -1309,6 +1322,8 @@ NetworkRecvStatus ClientNetworkGameSocketHandler::Receive_SERVER_NEWGAME(Packet
 		ShowErrorMessage(STR_NETWORK_MESSAGE_SERVER_REBOOT, INVALID_STRING_ID, WL_CRITICAL);
 	}
 
+	if (_network_relay) NetworkRelayNewGame();
+
 	if (this->status == STATUS_ACTIVE) ClientNetworkEmergencySave();
 
 	return NETWORK_RECV_STATUS_SERVER_ERROR;
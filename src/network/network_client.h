@@ -47,6 +47,7 @@ private:
 
 protected:
 	friend void NetworkExecuteLocalCommandQueue();
+	friend void NetworkSyncCommandQueue(NetworkClientSocket *cs);
 	friend void NetworkClose(bool close_admins);
 	static ClientNetworkGameSocketHandler *my_client; ///< This is us!
 
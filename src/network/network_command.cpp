@@ -122,16 +122,38 @@ void NetworkSendCommand(TileIndex tile, uint32_t p1, uint32_t p2, uint64_t p3, u
  * execution of those commands. Not syncing those commands means
  * that the client will never get them and as such will be in a
  * desynced state from the time it started with joining.
+ * On a relay these are the commands received from the relayed server.
  * @param cs The client to sync the queue to.
  */
 void NetworkSyncCommandQueue(NetworkClientSocket *cs)
 {
-	for (CommandPacket &p : _local_execution_queue) {
+	const CommandQueue &queue = (_network_server ? _local_execution_queue : ClientNetworkGameSocketHandler::my_client->incoming_queue);
+	for (const CommandPacket &p : queue) {
 		CommandPacket &c = cs->outgoing_queue.emplace_back(p);
 		c.callback = nullptr;
 	}
 }
 
+/**
+ * Pass a command received from the relayed server on to the spectators of a relay.
+ * The command keeps the frame given by the server, as the relay runs the same frames.
+ * @param cp The command.
+ */
+void NetworkRelayDistributeCommand(const CommandPacket &cp)
+{
+	CommandPacket c = cp;
+	c.callback = nullptr;
+	c.my_cmd = false;
+
+	for (NetworkClientSocket *cs : NetworkClientSocket::Iterate()) {
+		if (cs->status >= NetworkClientSocket::STATUS_MAP) {
+			/* The packet is the same for all spectators, so prepare it once and share it. */
+			if (c.server_packet == nullptr) c.server_packet = ServerNetworkGameSocketHandler::PrepareCommandPacket(c);
+			cs->outgoing_queue.push_back(c);
+		}
+	}
+}
+
 /**
  * Execute all commands on the local command queue that ought to be executed this frame.
  */
@@ -191,13 +213,21 @@ static void DistributeCommandPacket(CommandPacket &cp, const NetworkClientSocket
 	CommandCallback *callback = cp.callback;
 	cp.frame = _frame_counter_max + 1;
 
+	/* The packet is the same for all clients other than the owner, so prepare it once and share it. */
+	std::shared_ptr<const Packet> shared_packet;
+
 	for (NetworkClientSocket *cs : NetworkClientSocket::Iterate()) {
 		if (cs->status >= NetworkClientSocket::STATUS_MAP) {
 			/* Callbacks are only send back to the client who sent them in the
 			 *  first place. This filters that out. */
 			cp.callback = (cs != owner) ? nullptr : callback;
 			cp.my_cmd = (cs == owner);
+			if (cs != owner) {
+				if (shared_packet == nullptr) shared_packet = ServerNetworkGameSocketHandler::PrepareCommandPacket(cp);
+				cp.server_packet = shared_packet;
+			}
 			cs->outgoing_queue.push_back(cp);
+			cp.server_packet.reset();
 		}
 	}
 
@@ -19,6 +19,7 @@
 #include "../date_type.h"
 
 #include <array>
+#include <memory>
 #include <vector>
 
 static const uint32_t FIND_SERVER_EXTENDED_TOKEN = 0x2A49582A;
@@ -128,12 +129,15 @@ struct CommandPacket : CommandContainer {
 	ClientID client_id;  ///< originating client ID (or INVALID_CLIENT_ID if not specified)
 	CompanyID company;   ///< company that is executing the command
 	bool my_cmd;         ///< did the command originate from "me"
+	std::shared_ptr<const Packet> server_packet; ///< server only: the prepared command packet, shared between the clients which receive the same packet
 };
 
 void NetworkDistributeCommands();
 void NetworkExecuteLocalCommandQueue();
 void NetworkFreeLocalCommandQueue();
 void NetworkSyncCommandQueue(NetworkClientSocket *cs);
+void NetworkRelayDistributeCommand(const CommandPacket &cp);
+void NetworkRelayListen();
 
 void ShowNetworkError(StringID error_string);
 void NetworkTextMessage(NetworkAction action, TextColour colour, bool self_send, const std::string &name, const std::string &str = "", NetworkTextMessageData data = NetworkTextMessageData(), const char *data_str = "");
@@ -28,6 +28,7 @@
 #include "../order_backup.h"
 #include "../core/pool_func.hpp"
 #include "../core/random_func.hpp"
+#include "../core/checksum_func.hpp"
 #include "../rev.h"
 #include "../timer/timer.h"
 #include "../timer/timer_game_realtime.h"
@@ -58,21 +59,25 @@ INSTANTIATE_POOL_METHODS(NetworkClientSocket)
 /** Instantiate the listen sockets. */
 template SocketList TCPListenHandler<ServerNetworkGameSocketHandler, PACKET_SERVER_FULL, PACKET_SERVER_BANNED>::sockets;
 
-/** Writing a savegame directly to a number of packets. */
+/**
+ * Writing a savegame directly to a number of packets.
+ * A single savegame snapshot is shared by all of the clients which start downloading the map at the same time,
+ * each client keeps its own position in the packet list.
+ */
 struct PacketWriter : SaveFilter {
-	ServerNetworkGameSocketHandler *cs; ///< Socket we are associated with.
+	uint clients;                       ///< Number of clients still downloading this savegame.
 	std::unique_ptr<Packet> current;    ///< The packet we're currently writing to.
 	size_t total_size;                  ///< Total size of the compressed savegame.
-	std::vector<std::unique_ptr<Packet>> packets; ///< Packet queue of the savegame; send these "slowly" to the client.
-	std::unique_ptr<Packet> map_size_packet; ///< Map size packet, fast tracked to the client
+	std::vector<std::shared_ptr<const Packet>> packets; ///< Packets of the savegame; these are queued "slowly" on each client's socket, and shared between them.
+	bool finished;                      ///< Whether the savegame has been completely written.
 	std::mutex mutex;                   ///< Mutex for making threaded saving safe.
 	std::condition_variable exit_sig;   ///< Signal for threaded destruction of this packet writer.
 
 	/**
 	 * Create the packet writer.
-	 * @param cs The socket handler we're making the packets for.
+	 * @param clients The number of clients we're making the packets for.
 	 */
-	PacketWriter(ServerNetworkGameSocketHandler *cs) : SaveFilter(nullptr), cs(cs), total_size(0)
+	PacketWriter(uint clients) : SaveFilter(nullptr), clients(clients), total_size(0), finished(false)
 	{
 	}
 
@@ -81,20 +86,20 @@ struct PacketWriter : SaveFilter {
 	{
 		std::unique_lock<std::mutex> lock(this->mutex);
 
-		if (this->cs != nullptr) this->exit_sig.wait(lock);
+		if (this->clients != 0) this->exit_sig.wait(lock, [this]() { return this->clients == 0; });
 
-		/* This must all wait until the Destroy function is called. */
+		/* This must all wait until the Destroy function is called by every client. */
 
 		this->packets.clear();
-		this->map_size_packet.reset();
 		this->current.reset();
 	}
 
 	/**
-	 * Begin the destruction of this packet writer. It can happen in two ways:
-	 * in the first case the client disconnected while saving the map. In this
+	 * Remove a client from this packet writer. When the last client is removed, the destruction of the
+	 * packet writer begins. It can happen in two ways:
+	 * in the first case the clients disconnected while saving the map. In this
 	 * case the saving has not finished and killed this PacketWriter. In that
-	 * case we simply set cs to nullptr, triggering the appending to fail due to
+	 * case we simply set clients to 0, triggering the appending to fail due to
 	 * the connection problem and eventually triggering the destructor. In the
 	 * second case the destructor is already called, and it is waiting for our
 	 * signal which we will send. Only then the packets will be removed by the
@@ -104,7 +109,8 @@ struct PacketWriter : SaveFilter {
 	{
 		std::unique_lock<std::mutex> lock(this->mutex);
 
-		this->cs = nullptr;
+		assert(this->clients > 0);
+		if (--this->clients != 0) return;
 
 		this->exit_sig.notify_all();
 		lock.unlock();
@@ -116,25 +122,29 @@ struct PacketWriter : SaveFilter {
 	}
 
 	/**
-	 * Transfer all packets from here to the network's queue while holding
+	 * Transfer the packets which the given client has not had yet from here to the network's queue while holding
 	 * the lock on our mutex.
+	 * @param cs The client to transfer the packets to.
 	 * @return True iff the last packet of the map has been sent.
 	 */
-	bool TransferToNetworkQueue()
+	bool TransferToNetworkQueue(ServerNetworkGameSocketHandler *cs)
 	{
 		std::lock_guard<std::mutex> lock(this->mutex);
 
-		if (this->map_size_packet) {
-			/* Don't queue the PACKET_SERVER_MAP_SIZE before the corresponding PACKET_SERVER_MAP_BEGIN */
-			this->cs->SendPrependPacket(std::move(this->map_size_packet), PACKET_SERVER_MAP_BEGIN);
+		if (this->finished && !cs->savegame_size_sent) {
+			/* Fast-track the size to the client.
+			 * Don't queue the PACKET_SERVER_MAP_SIZE before the corresponding PACKET_SERVER_MAP_BEGIN */
+			auto p = std::make_unique<Packet>(PACKET_SERVER_MAP_SIZE, TCP_MTU);
+			p->Send_uint32((uint32_t)this->total_size);
+			cs->SendPrependPacket(std::move(p), PACKET_SERVER_MAP_BEGIN);
+			cs->savegame_size_sent = true;
 		}
 		bool last_packet = false;
-		for (auto &p : this->packets) {
+		for (; cs->savegame_packets_sent < this->packets.size(); cs->savegame_packets_sent++) {
+			const std::shared_ptr<const Packet> &p = this->packets[cs->savegame_packets_sent];
 			if (p->GetPacketType() == PACKET_SERVER_MAP_DONE) last_packet = true;
-			this->cs->SendPacket(std::move(p));
-
+			cs->SendSharedPacket(p);
 		}
-		this->packets.clear();
 
 		return last_packet;
 	}
@@ -143,8 +153,8 @@ struct PacketWriter : SaveFilter {
 	{
 		std::lock_guard<std::mutex> lock(this->mutex);
 
-		/* We want to abort the saving when the socket is closed. */
-		if (this->cs == nullptr) SlError(STR_NETWORK_ERROR_LOSTCONNECTION);
+		/* We want to abort the saving when all of the sockets are closed. */
+		if (this->clients == 0) SlError(STR_NETWORK_ERROR_LOSTCONNECTION);
 
 		if (this->current == nullptr) this->current = std::make_unique<Packet>(PACKET_SERVER_MAP_DATA, TCP_MTU);
 
@@ -154,7 +164,7 @@ struct PacketWriter : SaveFilter {
 			buf += written;
 
 			if (!this->current->CanWriteToPacket(1)) {
-				this->packets.push_back(std::move(this->current));
+				this->packets.push_back(NetworkTCPSocketHandler::PrepareSharedPacket(std::move(this->current)));
 				if (buf != bufe) this->current = std::make_unique<Packet>(PACKET_SERVER_MAP_DATA, TCP_MTU);
 			}
 		}
@@ -166,18 +176,16 @@ struct PacketWriter : SaveFilter {
 	{
 		std::lock_guard<std::mutex> lock(this->mutex);
 
-		/* We want to abort the saving when the socket is closed. */
-		if (this->cs == nullptr) SlError(STR_NETWORK_ERROR_LOSTCONNECTION);
+		/* We want to abort the saving when all of the sockets are closed. */
+		if (this->clients == 0) SlError(STR_NETWORK_ERROR_LOSTCONNECTION);
 
 		/* Make sure the last packet is flushed. */
-		if (this->current != nullptr) this->packets.push_back(std::move(this->current));
+		if (this->current != nullptr) this->packets.push_back(NetworkTCPSocketHandler::PrepareSharedPacket(std::move(this->current)));
 
 		/* Add a packet stating that this is the end to the queue. */
-		this->packets.push_back(std::make_unique<Packet>(PACKET_SERVER_MAP_DONE));
+		this->packets.push_back(NetworkTCPSocketHandler::PrepareSharedPacket(std::make_unique<Packet>(PACKET_SERVER_MAP_DONE)));
 
-		/* Fast-track the size to the client. */
-		this->map_size_packet.reset(new Packet(PACKET_SERVER_MAP_SIZE, TCP_MTU));
-		this->map_size_packet->Send_uint32((uint32_t)this->total_size);
+		this->finished = true;
 	}
 };
 
@@ -189,6 +197,8 @@ struct PacketWriter : SaveFilter {
 ServerNetworkGameSocketHandler::ServerNetworkGameSocketHandler(SOCKET s) : NetworkGameSocketHandler(s)
 {
 	this->status = STATUS_INACTIVE;
+	/* The spectators of a relay share the client information with the clients of the relayed server, so must not reuse their IDs. */
+	if (_network_relay && _network_client_id < CLIENT_ID_RELAY_FIRST) _network_client_id = CLIENT_ID_RELAY_FIRST;
 	this->client_id = _network_client_id++;
 	this->receive_limit = _settings_client.network.bytes_per_frame_burst;
 
@@ -206,10 +216,14 @@ ServerNetworkGameSocketHandler::~ServerNetworkGameSocketHandler()
 	delete this->GetInfo();
 
 	if (_redirect_console_to_client == this->client_id) _redirect_console_to_client = INVALID_CLIENT_ID;
-	OrderBackup::ResetUser(this->client_id);
 
-	extern void RemoveVirtualTrainsOfUser(uint32_t user);
-	RemoveVirtualTrainsOfUser(this->client_id);
+	/* The spectators of a relay cannot run commands, so have no order backups or virtual trains to remove. */
+	if (_network_server) {
+		OrderBackup::ResetUser(this->client_id);
+
+		extern void RemoveVirtualTrainsOfUser(uint32_t user);
+		RemoveVirtualTrainsOfUser(this->client_id);
+	}
 
 	if (this->savegame != nullptr) {
 		this->savegame->Destroy();
@@ -360,21 +374,21 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::CloseConnection(NetworkRecvSta
 /** Send the packets for the server sockets. */
 /* static */ void ServerNetworkGameSocketHandler::Send()
 {
-	for (NetworkClientSocket *cs : NetworkClientSocket::Iterate()) {
-		if (cs->writable) {
-			if (cs->status == STATUS_CLOSE_PENDING) {
-				SendPacketsState send_state = cs->SendPackets(true);
-				if (send_state == SPS_CLOSED) {
-					cs->CloseConnection(NETWORK_RECV_STATUS_CLIENT_QUIT);
-				} else if (send_state != SPS_PARTLY_SENT && send_state != SPS_NONE_SENT) {
-					ShutdownSocket(cs->sock, true, false, 2);
-				}
-			} else if (cs->SendPackets() != SPS_CLOSED && cs->status == STATUS_MAP) {
-				/* This client is in the middle of a map-send, call the function for that */
-				cs->SendMap();
+	IterateSendable([](NetworkClientSocket *cs) {
+		if (cs->status == STATUS_CLOSE_PENDING) {
+			SendPacketsState send_state = cs->SendPackets(true);
+			if (send_state == SPS_CLOSED) {
+				cs->CloseConnection(NETWORK_RECV_STATUS_CLIENT_QUIT);
+			} else if (send_state != SPS_PARTLY_SENT && send_state != SPS_NONE_SENT) {
+				ShutdownSocket(cs->sock, true, false, 2);
 			}
+		} else if (cs->SendPackets() != SPS_CLOSED && cs->status == STATUS_MAP) {
+			/* This client is in the middle of a map-send, call the function for that */
+			cs->SendMap();
+			return true;
 		}
-	}
+		return false;
+	});
 }
 
 static void NetworkHandleCommandQueue(NetworkClientSocket *cs);
@@ -581,6 +595,15 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendWelcome()
 	p->Send_string(_network_company_server_id);
 	this->SendPacket(std::move(p));
 
+	if (_network_relay) {
+		/* Transmit info about the clients of the relayed server, including the relay itself, and the other active spectators */
+		for (NetworkClientInfo *ci : NetworkClientInfo::Iterate()) {
+			const NetworkClientSocket *cs = NetworkClientSocket::GetByClientID(ci->client_id);
+			if (cs != this && (cs == nullptr || cs->status >= STATUS_AUTHORIZED)) this->SendClientInfo(ci);
+		}
+		return NETWORK_RECV_STATUS_OKAY;
+	}
+
 	/* Transmit info about all the active clients */
 	for (NetworkClientSocket *new_cs : NetworkClientSocket::Iterate()) {
 		if (new_cs != this && new_cs->status >= STATUS_AUTHORIZED) {
@@ -615,6 +638,9 @@ void ServerNetworkGameSocketHandler::CheckNextClientToSendMap(NetworkClientSocke
 	for (NetworkClientSocket *new_cs : NetworkClientSocket::Iterate()) {
 		if (ignore_cs == new_cs) continue;
 
+		/* Wait until every client sharing the current savegame has finished downloading it. */
+		if (new_cs->status == STATUS_MAP) return;
+
 		if (new_cs->status == STATUS_MAP_WAIT) {
 			if (best == nullptr || best->GetInfo()->join_date > new_cs->GetInfo()->join_date || (best->GetInfo()->join_date == new_cs->GetInfo()->join_date && best->client_id > new_cs->client_id)) {
 				best = new_cs;
@@ -645,27 +671,45 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendMap()
 
 	if (this->status == STATUS_AUTHORIZED) {
 		WaitTillSaved();
-		this->savegame = std::make_shared<PacketWriter>(this);
 
-		/* Now send the _frame_counter and how many packets are coming */
-		auto p = std::make_unique<Packet>(PACKET_SERVER_MAP_BEGIN, TCP_MTU);
-		p->Send_uint32(_frame_counter);
-		this->SendPacket(std::move(p));
+		/* All of the waiting clients which can use the same savegame format download this savegame too */
+		std::vector<ServerNetworkGameSocketHandler *> recipients;
+		recipients.push_back(this);
+		for (NetworkClientSocket *new_cs : NetworkClientSocket::Iterate()) {
+			if (new_cs == this || new_cs->status != STATUS_MAP_WAIT) continue;
+			if (new_cs->supports_zstd != this->supports_zstd || new_cs->supports_zstd_parallel != this->supports_zstd_parallel) continue;
+			recipients.push_back(new_cs);
+		}
 
-		NetworkSyncCommandQueue(this);
-		this->status = STATUS_MAP;
-		/* Mark the start of download */
-		this->last_frame = _frame_counter;
-		this->last_frame_server = _frame_counter;
+		std::shared_ptr<PacketWriter> savegame = std::make_shared<PacketWriter>((uint)recipients.size());
+		for (ServerNetworkGameSocketHandler *cs : recipients) {
+			cs->savegame = savegame;
+			cs->savegame_packets_sent = 0;
+			cs->savegame_size_sent = false;
+
+			/* Now send the _frame_counter and how many packets are coming */
+			auto p = std::make_unique<Packet>(PACKET_SERVER_MAP_BEGIN, TCP_MTU);
+			p->Send_uint32(_frame_counter);
+			cs->SendPacket(std::move(p));
+
+			NetworkSyncCommandQueue(cs);
+			cs->status = STATUS_MAP;
+			/* Mark the start of download */
+			cs->last_frame = _frame_counter;
+			cs->last_frame_server = _frame_counter;
+		}
+
+		if (recipients.size() > 1) DEBUG(net, 3, "[%s] Sending map to %u clients", ServerNetworkGameSocketHandler::GetName(), (uint)recipients.size());
 
 		/* Make a dump of the current game */
 		SaveModeFlags flags = SMF_NET_SERVER;
 		if (this->supports_zstd) flags |= SMF_ZSTD_OK;
-		if (SaveWithFilter(this->savegame, true, flags) != SL_OK) usererror("network savedump failed");
+		if (this->supports_zstd_parallel) flags |= SMF_ZSTD_PARALLEL_OK;
+		if (SaveWithFilter(savegame, true, flags) != SL_OK) usererror("network savedump failed");
 	}
 
 	if (this->status == STATUS_MAP) {
-		bool last_packet = this->savegame->TransferToNetworkQueue();
+		bool last_packet = this->savegame->TransferToNetworkQueue(this);
 		if (last_packet) {
 			/* Done reading, make sure saving is done as well */
 			this->savegame->Destroy();
@@ -695,16 +739,47 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendJoin(ClientID client_id)
 	return NETWORK_RECV_STATUS_OKAY;
 }
 
-/** Tell the client that they may run to a particular frame. */
-NetworkRecvStatus ServerNetworkGameSocketHandler::SendFrame()
+/**
+ * Write the state of the current frame for the clients to check whether they are in sync.
+ * @param p The packet to write to.
+ */
+static void SendFrameSyncState(Packet &p)
+{
+	if (_network_relay) {
+		/* On a relay the sync variables hold the state announced by the relayed server, for checking the relay itself. */
+		p.Send_uint32(_random.state[0]);
+		p.Send_uint64(_state_checksum.state);
+	} else {
+		p.Send_uint32(_sync_seed_1);
+		p.Send_uint64(_sync_state_checksum);
+	}
+}
+
+/** Create a frame packet, without a token. */
+static std::unique_ptr<Packet> MakeFramePacket()
 {
 	auto p = std::make_unique<Packet>(PACKET_SERVER_FRAME, TCP_MTU);
 	p->Send_uint32(_frame_counter);
 	p->Send_uint32(_frame_counter_max);
 #ifdef ENABLE_NETWORK_SYNC_EVERY_FRAME
-	p->Send_uint32(_sync_seed_1);
-	p->Send_uint64(_sync_state_checksum);
+	SendFrameSyncState(*p);
 #endif
+	return p;
+}
+
+/**
+ * Tell the client that they may run to a particular frame.
+ * @param shared_frame If not nullptr, the frame packet shared between the clients which do not need a new token in this frame, created if it is nullptr.
+ */
+NetworkRecvStatus ServerNetworkGameSocketHandler::SendFrame(std::shared_ptr<const Packet> *shared_frame)
+{
+	if (this->last_token != 0 && shared_frame != nullptr) {
+		if (*shared_frame == nullptr) *shared_frame = PrepareSharedPacket(MakeFramePacket());
+		this->SendSharedPacket(*shared_frame);
+		return NETWORK_RECV_STATUS_OKAY;
+	}
+
+	auto p = MakeFramePacket();
 
 	/* If token equals 0, we need to make a new token and send that. */
 	if (this->last_token == 0) {
@@ -716,15 +791,27 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendFrame()
 	return NETWORK_RECV_STATUS_OKAY;
 }
 
-/** Request the client to sync. */
-NetworkRecvStatus ServerNetworkGameSocketHandler::SendSync()
+/**
+ * Request the client to sync.
+ * @param shared_sync If not nullptr, the sync packet shared between the clients, created if it is nullptr.
+ */
+NetworkRecvStatus ServerNetworkGameSocketHandler::SendSync(std::shared_ptr<const Packet> *shared_sync)
 {
+	if (shared_sync != nullptr && *shared_sync != nullptr) {
+		this->SendSharedPacket(*shared_sync);
+		return NETWORK_RECV_STATUS_OKAY;
+	}
+
 	auto p = std::make_unique<Packet>(PACKET_SERVER_SYNC, TCP_MTU);
 	p->Send_uint32(_frame_counter);
-	p->Send_uint32(_sync_seed_1);
+	SendFrameSyncState(*p);
 
-	p->Send_uint64(_sync_state_checksum);
-	this->SendPacket(std::move(p));
+	if (shared_sync != nullptr) {
+		*shared_sync = PrepareSharedPacket(std::move(p));
+		this->SendSharedPacket(*shared_sync);
+	} else {
+		this->SendPacket(std::move(p));
+	}
 	return NETWORK_RECV_STATUS_OKAY;
 }
 
@@ -734,6 +821,11 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendSync()
  */
 NetworkRecvStatus ServerNetworkGameSocketHandler::SendCommand(const CommandPacket &cp)
 {
+	if (cp.server_packet != nullptr) {
+		this->SendSharedPacket(cp.server_packet);
+		return NETWORK_RECV_STATUS_OKAY;
+	}
+
 	auto p = std::make_unique<Packet>(PACKET_SERVER_COMMAND, TCP_MTU);
 
 	this->NetworkGameSocketHandler::SendCommand(*p, cp);
@@ -744,6 +836,22 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendCommand(const CommandPacke
 	return NETWORK_RECV_STATUS_OKAY;
 }
 
+/**
+ * Prepare a command packet which can be sent to several clients.
+ * @param cp The command to send.
+ * @return The prepared packet.
+ */
+/* static */ std::shared_ptr<const Packet> ServerNetworkGameSocketHandler::PrepareCommandPacket(const CommandPacket &cp)
+{
+	auto p = std::make_unique<Packet>(PACKET_SERVER_COMMAND, TCP_MTU);
+
+	NetworkGameSocketHandler::SendCommand(*p, cp);
+	p->Send_uint32(cp.frame);
+	p->Send_bool  (cp.my_cmd);
+
+	return PrepareSharedPacket(std::move(p));
+}
+
 /**
  * Send a chat message.
  * @param action The action associated with the message.
@@ -979,6 +1087,12 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::Receive_CLIENT_JOIN(Packet &p)
 
 	if (this->HasClientQuit()) return NETWORK_RECV_STATUS_CLIENT_QUIT;
 
+	if (_network_relay) {
+		/* The spectators of a relay cannot play, and the client information of the relayed server takes precedence. */
+		if (playas != COMPANY_SPECTATOR) return this->SendError(NETWORK_ERROR_NOT_AUTHORIZED);
+		if (!NetworkClientInfo::CanAllocateItem()) return this->SendError(NETWORK_ERROR_FULL);
+	}
+
 	/* join another company does not affect these values */
 	switch (playas) {
 		case COMPANY_NEW_COMPANY: // New company
@@ -1101,6 +1215,7 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::Receive_CLIENT_GETMAP(Packet &
 	}
 
 	this->supports_zstd = p.Recv_bool();
+	this->supports_zstd_parallel = p.CanReadFromPacket(1) && p.Recv_bool();
 
 	/* Check if someone else is receiving the map */
 	for (NetworkClientSocket *new_cs : NetworkClientSocket::Iterate()) {
@@ -1176,6 +1291,12 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::Receive_CLIENT_COMMAND(Packet
 		return this->SendError(NETWORK_ERROR_NOT_EXPECTED);
 	}
 
+	if (_network_relay) {
+		/* The spectators of a relay have no write access to the game. */
+		DEBUG(net, 3, "[%s] Ignoring command from relay spectator client #%u", ServerNetworkGameSocketHandler::GetName(), this->client_id);
+		return NETWORK_RECV_STATUS_OKAY;
+	}
+
 	if (this->incoming_queue.size() >= _settings_client.network.max_commands_in_queue) {
 		return this->SendError(NETWORK_ERROR_TOO_MANY_COMMANDS);
 	}
@@ -1589,6 +1710,9 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::Receive_CLIENT_CHAT(Packet &p)
 		return this->SendError(NETWORK_ERROR_NOT_AUTHORIZED);
 	}
 
+	/* Chat of the spectators of a relay would not reach the clients of the relayed server. */
+	if (_network_relay) return NETWORK_RECV_STATUS_OKAY;
+
 	NetworkAction action = (NetworkAction)p.Recv_uint8();
 	DestType desttype = (DestType)p.Recv_uint8();
 	int dest = p.Recv_uint32();
@@ -1621,6 +1745,9 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::Receive_CLIENT_SET_PASSWORD(Pa
 		return this->SendError(NETWORK_ERROR_NOT_EXPECTED);
 	}
 
+	/* The spectators of a relay have no company to set a password for. */
+	if (_network_relay) return NETWORK_RECV_STATUS_OKAY;
+
 	std::string password = p.Recv_string(NETWORK_PASSWORD_LENGTH);
 	const NetworkClientInfo *ci = this->GetInfo();
 
@@ -1692,6 +1819,9 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::Receive_CLIENT_MOVE(Packet &p)
 {
 	if (this->status != STATUS_ACTIVE) return this->SendError(NETWORK_ERROR_NOT_EXPECTED);
 
+	/* The spectators of a relay cannot join a company. */
+	if (_network_relay) return NETWORK_RECV_STATUS_OKAY;
+
 	CompanyID company_id = (Owner)p.Recv_uint8();
 
 	/* Check if the company is valid, we don't allow moving to AI companies */
@@ -1980,6 +2110,10 @@ void NetworkServer_Tick(bool send_frame)
 	}
 #endif
 
+	/* The frame and sync packets are the same for all clients, so are only prepared once. */
+	std::shared_ptr<const Packet> shared_frame;
+	[[maybe_unused]] std::shared_ptr<const Packet> shared_sync;
+
 	/* Now we are done with the frame, inform the clients that they can
 	 *  do their frame! */
 	for (NetworkClientSocket *cs : NetworkClientSocket::Iterate()) {
@@ -2093,16 +2227,69 @@ void NetworkServer_Tick(bool send_frame)
 			NetworkHandleCommandQueue(cs);
 
 			/* Send an updated _frame_counter_max to the client */
-			if (send_frame) cs->SendFrame();
+			if (send_frame) cs->SendFrame(&shared_frame);
 
 #ifndef ENABLE_NETWORK_SYNC_EVERY_FRAME
 			/* Send a sync-check packet */
-			if (send_sync) cs->SendSync();
+			if (send_sync) cs->SendSync(&shared_sync);
 #endif
 		}
 	}
 }
 
+/**
+ * This is called every tick if this is a relay, after running the frames allowed by the relayed server.
+ */
+void NetworkRelay_Tick()
+{
+	/* The relay passes on the frames of the relayed server, so only has to send a frame when the server did. */
+	static uint32_t last_frame_counter_max = 0;
+	bool send_frame = (_frame_counter_max != last_frame_counter_max);
+	last_frame_counter_max = _frame_counter_max;
+
+	NetworkServer_Tick(send_frame);
+}
+
+/**
+ * Tell the spectators of a relay that the relayed server is starting a new game, so they reconnect after the relay.
+ */
+void NetworkRelayNewGame()
+{
+	for (NetworkClientSocket *cs : NetworkClientSocket::Iterate()) {
+		cs->SendNewGame();
+		cs->SendPackets();
+	}
+}
+
+/**
+ * Disconnect the spectators of a relay and stop accepting new ones, as the relay is no longer connected to the relayed server.
+ */
+void NetworkRelayClose()
+{
+	for (NetworkClientSocket *cs : NetworkClientSocket::Iterate()) {
+		cs->SendShutdown();
+		cs->CloseConnection(NETWORK_RECV_STATUS_CLIENT_QUIT);
+	}
+	ServerNetworkGameSocketHandler::CloseListeners();
+}
+
+/**
+ * Tell the spectators of a relay that a client of the relayed server has left.
+ * @param client_id The client that left.
+ * @param errorno The error which made the client leave, or #NETWORK_ERROR_END when it left by itself.
+ */
+void NetworkRelayClientQuit(ClientID client_id, NetworkErrorCode errorno)
+{
+	for (NetworkClientSocket *cs : NetworkClientSocket::Iterate()) {
+		if (cs->status <= NetworkClientSocket::STATUS_AUTHORIZED) continue;
+		if (errorno == NETWORK_ERROR_END) {
+			cs->SendQuit(client_id);
+		} else {
+			cs->SendErrorQuit(client_id, errorno);
+		}
+	}
+}
+
 /** Helper function to restart the map. */
 static void NetworkRestartMap()
 {
@@ -57,6 +57,8 @@ protected:
 
 	bool ParseKeyPasswordPacket(Packet &p, NetworkSharedSecrets &ss, const std::string &password, std::string *payload, size_t length);
 
+	void OnPacketQueued() override { this->MarkSendPending(); }
+
 public:
 	/** Status of a client */
 	enum ClientStatus {
@@ -84,8 +86,11 @@ public:
 	size_t receive_limit;        ///< Amount of bytes that we can receive at this moment
 	bool settings_authed = false;///< Authorised to control all game settings
 	bool supports_zstd = false;  ///< Client supports zstd compression
+	bool supports_zstd_parallel = false; ///< Client supports block-parallel zstd compression
 
-	std::shared_ptr<struct PacketWriter> savegame; ///< Writer used to write the savegame.
+	std::shared_ptr<struct PacketWriter> savegame; ///< Writer used to write the savegame, shared with the other clients downloading the same savegame.
+	size_t savegame_packets_sent = 0;            ///< Number of packets of the savegame which have been queued for this client.
+	bool savegame_size_sent = false;             ///< Whether the size of the savegame has been queued for this client.
 	NetworkAddress client_address; ///< IP-address of the client (so they can be banned)
 
 	std::string desync_log;
@@ -119,9 +124,11 @@ public:
 	NetworkRecvStatus SendChat(NetworkAction action, ClientID client_id, bool self_send, const std::string &msg, NetworkTextMessageData data);
 	NetworkRecvStatus SendExternalChat(const std::string &source, TextColour colour, const std::string &user, const std::string &msg);
 	NetworkRecvStatus SendJoin(ClientID client_id);
-	NetworkRecvStatus SendFrame();
-	NetworkRecvStatus SendSync();
+	NetworkRecvStatus SendFrame(std::shared_ptr<const Packet> *shared_frame = nullptr);
+	NetworkRecvStatus SendSync(std::shared_ptr<const Packet> *shared_sync = nullptr);
 	NetworkRecvStatus SendCommand(const CommandPacket &cp);
+
+	static std::shared_ptr<const Packet> PrepareCommandPacket(const CommandPacket &cp);
 	NetworkRecvStatus SendCompanyUpdate();
 	NetworkRecvStatus SendConfigUpdate();
 	NetworkRecvStatus SendSettingsAccessUpdate(bool ok);
@@ -155,6 +162,10 @@ public:
 };
 
 void NetworkServer_Tick(bool send_frame);
+void NetworkRelay_Tick();
+void NetworkRelayNewGame();
+void NetworkRelayClose();
+void NetworkRelayClientQuit(ClientID client_id, NetworkErrorCode errorno);
 void ChangeNetworkRestartTime(bool reset);
 void NetworkServerSetCompanyPassword(CompanyID company_id, const std::string &password, bool already_hashed = true);
 void NetworkServerUpdateCompanyPassworded(CompanyID company_id, bool passworded);
@@ -50,6 +50,7 @@ enum ClientID : uint32_t {
 	INVALID_CLIENT_ID = 0, ///< Client is not part of anything
 	CLIENT_ID_SERVER  = 1, ///< Servers always have this ID
 	CLIENT_ID_FIRST   = 2, ///< The first client ID
+	CLIENT_ID_RELAY_FIRST = 0x40000000, ///< The first client ID given out by a relay, above the IDs given out by the server it relays
 };
 
 /** Indices into the client tables */
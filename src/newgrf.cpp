@@ -11413,6 +11413,7 @@ void LoadNewGRFFile(GRFConfig *config, GrfLoadingStage stage, Subdirectory subdi
 		LoadNewGRFFileFromFile(config, stage, temporarySpriteFile);
 	} else {
 		SpriteFile &file = OpenCachedSpriteFile(filename, subdir, needs_palette_remap);
+		if (config->ident.md5sum != MD5Hash{}) file.SetContentMD5(config->ident.md5sum);
 		LoadNewGRFFileFromFile(config, stage, file);
 		if (!HasBit(config->flags, GCF_SYSTEM)) file.flags |= SFF_USERGRF;
 		if (config->ident.grfid == BSWAP32(0xFFFFFFFE)) file.flags |= SFF_OPENTTDGRF;
@@ -938,6 +938,21 @@ static void TileLoopObjectGroundDesert(TileIndex tile)
 	MarkTileDirtyByTile(tile);
 }
 
+/** @see TileLoopQuiescentProc */
+static bool IsTileLoopQuiescent_Object(TileIndex tile)
+{
+	const ObjectSpec *spec = ObjectSpec::GetByTile(tile);
+	if ((spec->flags & OBJECT_FLAG_ANIMATION) || IsObjectType(tile, OBJECT_HQ)) return false;
+
+	if (IsTileOnWater(tile)) return IsTileLoopWaterQuiescent(tile);
+	if (spec->ctrl_flags & OBJECT_CTRL_FLAG_USE_LAND_GROUND) {
+		if (GetObjectGroundType(tile) == OBJECT_GROUND_SHORE) return IsTileLoopWaterQuiescent(tile);
+		if (_settings_game.game_creation.landscape != LT_TEMPERATE) return false;
+		return GetObjectGroundType(tile) != OBJECT_GROUND_GRASS || GetObjectGroundDensity(tile) == 3;
+	}
+	return true;
+}
+
 static void TileLoop_Object(TileIndex tile)
 {
 	const ObjectSpec *spec = ObjectSpec::GetByTile(tile);
@@ -1274,4 +1289,5 @@ extern const TileTypeProcs _tile_type_object_procs = {
 	nullptr,                        // vehicle_enter_tile_proc
 	GetFoundation_Object,        // get_foundation_proc
 	TerraformTile_Object,        // terraform_tile_proc
+	IsTileLoopQuiescent_Object,  // tile_loop_quiescent_proc
 };
@@ -295,6 +295,7 @@ static void ShowHelp()
 		"  -p password         = Password to join server\n"
 		"  -P password         = Password to join company\n"
 		"  -D [host][:port]    = Start dedicated server\n"
+		"                        (with -n: relay the game of that server to spectators)\n"
 #if !defined(_WIN32)
 		"  -f                  = Fork into the background (dedicated only)\n"
 #endif
@@ -959,6 +960,9 @@ int openttd_main(int argc, char *argv[])
 	DeterminePaths(argv[0], only_local_path);
 	TarScanner::DoScan(TarScanner::BASESET);
 
+	/* A dedicated server which joins another server relays the game of that server to spectators. */
+	_network_relay = dedicated && !scanner->connection_string.empty();
+
 	if (dedicated) DEBUG(net, 3, "Starting dedicated server, version %s", _openttd_revision);
 	if (_dedicated_forks && !dedicated) _dedicated_forks = false;
 
@@ -1111,7 +1115,7 @@ int openttd_main(int argc, char *argv[])
 	/* ScanNewGRFFiles now has control over the scanner. */
 	RequestNewGRFScan(scanner.release());
 
-	_general_worker_pool.Start("ottd:worker", 8);
+	StartGeneralWorkerPool();
 
 	VideoDriver::GetInstance()->MainLoop();
 
@@ -1730,6 +1734,7 @@ void CheckCaches(bool force_check, std::function<void(const char *)> log, CheckC
 			old_station_catchment_tiles.push_back(st->catchment_tiles);
 			old_station_tiles.push_back(st->station_tiles);
 		}
+		StationCatchmentIndex old_station_catchment_index = _station_catchment_index;
 
 		std::vector<StationList> old_industry_stations_nears;
 		for (Industry *ind : Industry::Iterate()) {
@@ -1776,6 +1781,9 @@ void CheckCaches(bool force_check, std::function<void(const char *)> log, CheckC
 			}
 			i++;
 		}
+		if (!(old_station_catchment_index == _station_catchment_index)) {
+			CCLOG("station catchment index mismatch");
+		}
 		i = 0;
 		for (Industry *ind : Industry::Iterate()) {
 			if (old_industry_stations_nears[i] != ind->stations_near) {
@@ -2131,6 +2139,11 @@ void CheckCaches(bool force_check, std::function<void(const char *)> log, CheckC
 		WaterRegionCheckCaches(log);
 	}
 
+	if (flags & CHECK_CACHE_RAIL_REGIONS) {
+		extern void RailRegionCheckCaches(std::function<void(const char *)> log);
+		RailRegionCheckCaches(log);
+	}
+
 	if ((flags & CHECK_CACHE_EMIT_LOG) && !saved_messages.empty()) {
 		InconsistencyExtraInfo info;
 		info.check_caches_result = std::move(saved_messages);
@@ -2183,6 +2196,7 @@ void StateGameLoop()
 		PerformanceMeasurer::Paused(PFE_GL_SHIPS);
 		PerformanceMeasurer::Paused(PFE_GL_AIRCRAFT);
 		PerformanceMeasurer::Paused(PFE_GL_LANDSCAPE);
+		PerformanceZoneMeasurer::Paused();
 
 		if (!HasModalProgress()) UpdateLandscapingLimits();
 #ifndef DEBUG_DUMP_COMMANDS
@@ -2193,6 +2207,7 @@ void StateGameLoop()
 
 	PerformanceMeasurer framerate(PFE_GAMELOOP);
 	PerformanceAccumulator::Reset(PFE_GL_LANDSCAPE);
+	PerformanceZoneMeasurer::Reset();
 
 	Layouter::ReduceLineCache();
 
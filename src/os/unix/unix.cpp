@@ -275,6 +275,16 @@ void SetCurrentThreadName([[maybe_unused]] const char *threadName)
 #endif /* defined(__APPLE__) */
 }
 
+void SetCurrentThreadAffinity([[maybe_unused]] uint cpu)
+{
+#if !defined(NO_THREADS) && defined(__GLIBC__)
+	cpu_set_t cpu_set;
+	CPU_ZERO(&cpu_set);
+	CPU_SET(cpu % std::max<uint>(std::thread::hardware_concurrency(), 1), &cpu_set);
+	pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+#endif /* !defined(NO_THREADS) && defined(__GLIBC__) */
+}
+
 int GetCurrentThreadName(char *str, const char *last)
 {
 #if !defined(NO_THREADS) && defined(__GLIBC__)
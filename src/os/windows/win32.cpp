@@ -711,6 +711,11 @@ bool IsNonGameThread()
 	return game_thread_id != GetCurrentThreadId();
 }
 
+void SetCurrentThreadAffinity(uint cpu)
+{
+	SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << (cpu % std::max<uint>(std::thread::hardware_concurrency(), 1) % (sizeof(DWORD_PTR) * 8)));
+}
+
 static std::map<DWORD, std::string> _thread_name_map;
 static std::mutex _thread_name_map_mutex;
 
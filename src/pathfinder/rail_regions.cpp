@@ -0,0 +1,405 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file rail_regions.cpp Handles dividing the rail network in the map into square regions to assist long distance train pathfinding. */
+
+#include "stdafx.h"
+#include "rail_regions.h"
+#include "map_func.h"
+#include "track_func.h"
+#include "transport_type.h"
+#include "landscape.h"
+#include "rail_map.h"
+#include "tilearea_type.h"
+#include "tunnelbridge_map.h"
+#include "debug.h"
+#include "string_func.h"
+
+#include <array>
+#include <vector>
+
+#include "safeguards.h"
+
+using TRailRegionTraversabilityBits = uint16_t;
+constexpr TRailRegionPatchLabel MAX_RAIL_REGION_PATCH_LABEL = UINT8_MAX;
+
+static_assert(sizeof(TRailRegionTraversabilityBits) * 8 == RAIL_REGION_EDGE_LENGTH);
+static_assert(sizeof(TRailRegionPatchLabel) == sizeof(uint8_t)); // Important for the hash calculation.
+
+using TRailRegionPatchLabelArray = std::array<TRailRegionPatchLabel, RAIL_REGION_NUMBER_OF_TILES>;
+
+/**
+ * Get the sides of a tile through which rail track leaves it.
+ * Rail types, signals and one-way restrictions are ignored, so the connectivity derived from this is never narrower than that which a train sees.
+ * @param tile The tile.
+ * @return Bit set of DiagDirections.
+ */
+static uint8_t GetRailRegionTileSides(TileIndex tile)
+{
+	const TrackBits tracks = TrackStatusToTrackBits(GetTileTrackStatus(tile, TRANSPORT_RAIL, 0));
+	if (tracks == TRACK_BIT_NONE) return 0;
+	if (IsRailDepotTile(tile)) return 1 << GetRailDepotDirection(tile);
+
+	uint8_t sides = 0;
+	for (const Trackdir td : SetTrackdirBitIterator(TrackBitsToTrackdirBits(tracks))) SetBit(sides, TrackdirToExitdir(td));
+	return sides;
+}
+
+/**
+ * Get the tile which rail track leaving a tile through the given side leads to.
+ * @param tile The tile.
+ * @param side The side of the tile.
+ * @return The adjacent tile, the other end of a tunnel or bridge, or INVALID_TILE at the edge of the map.
+ */
+static TileIndex GetRailRegionNextTile(TileIndex tile, DiagDirection side)
+{
+	if (IsTileType(tile, MP_TUNNELBRIDGE) && GetTunnelBridgeDirection(tile) == side) return GetOtherTunnelBridgeEnd(tile);
+	const TileIndexDiffC offset = TileIndexDiffCByDiagDir(side);
+	return TileAddWrap(tile, offset.x, offset.y);
+}
+
+/**
+ * Represents a square section of the map of a fixed size. Within this square the track is divided into patches of connected track.
+ * As for water regions, all information stored applies only to tiles within the square, so that a region can be updated
+ * independently of the rest of the map whenever the track within it changes.
+ */
+class RailRegion
+{
+	friend class RailRegionReference;
+
+	std::array<TRailRegionTraversabilityBits, DIAGDIR_END> edge_traversability_bits{};
+	bool initialized = false;
+	bool has_cross_region_tunnel_bridges = false;
+	TRailRegionPatchLabel number_of_patches = 0; // 0 = no track, 1 = one single patch of track, etc...
+	std::unique_ptr<TRailRegionPatchLabelArray> tile_patch_labels;
+
+public:
+	void Invalidate() { this->initialized = false; }
+};
+
+static std::unique_ptr<TRailRegionPatchLabelArray> _spare_rail_labels;
+static std::unique_ptr<RailRegion[]> _rail_regions;
+
+class RailRegionReference {
+	const uint32_t tile_x;
+	const uint32_t tile_y;
+	RailRegion &rr;
+
+	inline bool ContainsTile(TileIndex tile) const
+	{
+		const uint32_t x = TileX(tile);
+		const uint32_t y = TileY(tile);
+		return x >= this->tile_x && x < this->tile_x + RAIL_REGION_EDGE_LENGTH
+				&& y >= this->tile_y && y < this->tile_y + RAIL_REGION_EDGE_LENGTH;
+	}
+
+	/**
+	 * Returns the local index of the tile within the region, in the same coordinate system as water regions.
+	 * @param tile Tile within the rail region.
+	 * @returns The local index.
+	 */
+	inline int GetLocalIndex(TileIndex tile) const
+	{
+		assert(this->ContainsTile(tile));
+		return (TileX(tile) - this->tile_x) + RAIL_REGION_EDGE_LENGTH * (TileY(tile) - this->tile_y);
+	}
+
+public:
+	RailRegionReference(uint32_t region_x, uint32_t region_y, RailRegion &rr)
+		: tile_x(region_x * RAIL_REGION_EDGE_LENGTH), tile_y(region_y * RAIL_REGION_EDGE_LENGTH), rr(rr)
+	{}
+
+	OrthogonalTileArea GetTileArea() const { return OrthogonalTileArea(TileXY(this->tile_x, this->tile_y), RAIL_REGION_EDGE_LENGTH, RAIL_REGION_EDGE_LENGTH); }
+
+	bool IsInitialized() const { return this->rr.initialized; }
+
+	TRailRegionTraversabilityBits GetEdgeTraversabilityBits(DiagDirection side) const { return this->rr.edge_traversability_bits[side]; }
+
+	int NumberOfPatches() const { return this->rr.number_of_patches; }
+
+	bool HasCrossRegionTunnelBridges() const { return this->rr.has_cross_region_tunnel_bridges; }
+
+	TRailRegionPatchLabel GetLabel(TileIndex tile) const
+	{
+		assert(this->ContainsTile(tile));
+		if (this->rr.tile_patch_labels == nullptr) return INVALID_RAIL_REGION_PATCH;
+		return (*this->rr.tile_patch_labels)[this->GetLocalIndex(tile)];
+	}
+
+	/**
+	 * Performs the connected component labeling of the track in the region.
+	 * If there are more patches than there are labels, the remaining patches share the last label.
+	 * This is safe as it can only make the region graph better connected than the track.
+	 */
+	void ForceUpdate()
+	{
+		this->rr.has_cross_region_tunnel_bridges = false;
+		this->rr.edge_traversability_bits.fill(0);
+
+		if (this->rr.tile_patch_labels == nullptr) {
+			if (_spare_rail_labels != nullptr) {
+				this->rr.tile_patch_labels = std::move(_spare_rail_labels);
+			} else {
+				this->rr.tile_patch_labels = std::make_unique<TRailRegionPatchLabelArray>();
+			}
+		}
+		TRailRegionPatchLabelArray &labels = *this->rr.tile_patch_labels;
+		labels.fill(INVALID_RAIL_REGION_PATCH);
+
+		TRailRegionPatchLabel current_label = INVALID_RAIL_REGION_PATCH;
+
+		static std::vector<TileIndex> tiles_to_check;
+		for (const TileIndex start_tile : this->GetTileArea()) {
+			if (labels[this->GetLocalIndex(start_tile)] != INVALID_RAIL_REGION_PATCH) continue;
+			if (GetRailRegionTileSides(start_tile) == 0) continue;
+
+			if (current_label < MAX_RAIL_REGION_PATCH_LABEL) current_label++;
+			labels[this->GetLocalIndex(start_tile)] = current_label;
+
+			tiles_to_check.clear();
+			tiles_to_check.push_back(start_tile);
+			while (!tiles_to_check.empty()) {
+				const TileIndex tile = tiles_to_check.back();
+				tiles_to_check.pop_back();
+
+				for (const DiagDirection side : SetBitIterator<DiagDirection>(GetRailRegionTileSides(tile))) {
+					const TileIndex next_tile = GetRailRegionNextTile(tile, side);
+					if (next_tile == INVALID_TILE || !HasBit(GetRailRegionTileSides(next_tile), ReverseDiagDir(side))) continue;
+
+					if (this->ContainsTile(next_tile)) {
+						TRailRegionPatchLabel &next_label = labels[this->GetLocalIndex(next_tile)];
+						if (next_label == INVALID_RAIL_REGION_PATCH) {
+							next_label = current_label;
+							tiles_to_check.push_back(next_tile);
+						}
+					} else if (DistanceManhattan(tile, next_tile) != 1) {
+						this->rr.has_cross_region_tunnel_bridges = true;
+					} else {
+						const int local_x_or_y = DiagDirToAxis(side) == AXIS_X ? TileY(tile) - this->tile_y : TileX(tile) - this->tile_x;
+						SetBit(this->rr.edge_traversability_bits[side], local_x_or_y);
+					}
+				}
+			}
+		}
+
+		this->rr.number_of_patches = current_label;
+		this->rr.initialized = true;
+
+		if (this->rr.number_of_patches == 0) {
+			/* No need for patch storage when there is no track */
+			_spare_rail_labels = std::move(this->rr.tile_patch_labels);
+		}
+	}
+
+	inline void UpdateIfNotInitialized()
+	{
+		if (!this->rr.initialized) this->ForceUpdate();
+	}
+
+	TRailRegionPatchLabelArray CopyPatchLabelArray() const
+	{
+		TRailRegionPatchLabelArray out;
+		if (this->rr.tile_patch_labels != nullptr) {
+			out = *this->rr.tile_patch_labels;
+		} else {
+			out.fill(INVALID_RAIL_REGION_PATCH);
+		}
+		return out;
+	}
+};
+
+static TileIndex GetRailRegionEdgeTile(uint32_t region_x, uint32_t region_y, DiagDirection side, uint32_t x_or_y)
+{
+	assert(x_or_y < RAIL_REGION_EDGE_LENGTH);
+	const uint32_t x = region_x * RAIL_REGION_EDGE_LENGTH;
+	const uint32_t y = region_y * RAIL_REGION_EDGE_LENGTH;
+	switch (side) {
+		case DIAGDIR_NE: return TileXY(x, y + x_or_y);
+		case DIAGDIR_SW: return TileXY(x + RAIL_REGION_EDGE_MASK, y + x_or_y);
+		case DIAGDIR_NW: return TileXY(x + x_or_y, y);
+		case DIAGDIR_SE: return TileXY(x + x_or_y, y + RAIL_REGION_EDGE_MASK);
+		default: NOT_REACHED();
+	}
+}
+
+static inline RailRegionReference GetRailRegionRef(uint32_t region_x, uint32_t region_y)
+{
+	return RailRegionReference(region_x, region_y, _rail_regions[GetRailRegionIndex(region_x, region_y)]);
+}
+
+static RailRegionReference GetUpdatedRailRegion(uint32_t region_x, uint32_t region_y)
+{
+	RailRegionReference ref = GetRailRegionRef(region_x, region_y);
+	ref.UpdateIfNotInitialized();
+	return ref;
+}
+
+/**
+ * Calculates a number that uniquely identifies the provided rail region patch.
+ * @param rail_region_patch The rail region patch to calculate the hash for.
+ */
+uint32_t CalculateRailRegionPatchHash(const RailRegionPatchDesc &rail_region_patch)
+{
+	return rail_region_patch.label | GetRailRegionIndex(rail_region_patch.x, rail_region_patch.y) << 8;
+}
+
+/**
+ * Returns the rail region patch of the provided tile.
+ * @param tile The tile for which the information will be calculated.
+ * @return The patch, the label is INVALID_RAIL_REGION_PATCH if there is no track on the tile.
+ */
+RailRegionPatchDesc GetRailRegionPatchInfo(TileIndex tile)
+{
+	const RailRegionReference region = GetUpdatedRailRegion(GetRailRegionX(tile), GetRailRegionY(tile));
+	return RailRegionPatchDesc{ GetRailRegionX(tile), GetRailRegionY(tile), region.GetLabel(tile) };
+}
+
+/**
+ * Marks the rail region that tile is part of as invalid.
+ * The edge traversability of a region depends only on its own tiles, so adjacent regions are not affected,
+ * except for the region at the other end of a tunnel or bridge.
+ * @param tile Tile within the rail region that we wish to invalidate.
+ */
+void InvalidateRailRegion(TileIndex tile)
+{
+	if (tile >= MapSize()) return;
+
+	_rail_regions[GetRailRegionIndex(tile)].Invalidate();
+
+	/* The region at the other end of a tunnel or bridge is linked to this one through the tunnel or bridge */
+	if (IsTileType(tile, MP_TUNNELBRIDGE)) _rail_regions[GetRailRegionIndex(GetOtherTunnelBridgeEnd(tile))].Invalidate();
+}
+
+/**
+ * Marks all rail regions as invalid.
+ */
+void InvalidateAllRailRegions()
+{
+	const uint32_t count = GetRailRegionMapSizeX() * GetRailRegionMapSizeY();
+	for (uint32_t i = 0; i < count; i++) {
+		_rail_regions[i].Invalidate();
+	}
+}
+
+/**
+ * Calls the provided callback function for all rail region patches connected to the starting patch
+ * through one particular side of its region.
+ * @param rail_region_patch Rail patch within the rail region to start searching from
+ * @param side Side of the rail region to look for neighbouring patches of track
+ * @param callback The function that will be called for each neighbour that is found
+ */
+static inline void VisitAdjacentRailRegionPatchNeighbors(const RailRegionPatchDesc &rail_region_patch, const RailRegionReference &current_region, DiagDirection side, TVisitRailRegionPatchCallBack &callback)
+{
+	const TRailRegionTraversabilityBits current_bits = current_region.GetEdgeTraversabilityBits(side);
+	if (current_bits == 0) return;
+
+	const TileIndexDiffC offset = TileIndexDiffCByDiagDir(side);
+	/* Unsigned underflow is allowed here, not UB */
+	const uint32_t nx = rail_region_patch.x + (uint32_t)offset.x;
+	const uint32_t ny = rail_region_patch.y + (uint32_t)offset.y;
+	if (nx >= GetRailRegionMapSizeX() || ny >= GetRailRegionMapSizeY()) return;
+
+	const RailRegionReference neighbouring_region = GetUpdatedRailRegion(nx, ny);
+	const DiagDirection opposite_side = ReverseDiagDir(side);
+
+	/* Both edge tiles must have track leading into the other for the patches to be connected */
+	const TRailRegionTraversabilityBits traversability_bits = current_bits & neighbouring_region.GetEdgeTraversabilityBits(opposite_side);
+	if (traversability_bits == 0) return;
+
+	static std::vector<TRailRegionPatchLabel> unique_labels; // static and vector-instead-of-map for performance reasons
+	unique_labels.clear();
+	for (const uint x_or_y : SetBitIterator(traversability_bits)) {
+		const TileIndex current_edge_tile = GetRailRegionEdgeTile(rail_region_patch.x, rail_region_patch.y, side, x_or_y);
+		if (current_region.GetLabel(current_edge_tile) != rail_region_patch.label) continue;
+
+		const TileIndex neighbour_edge_tile = GetRailRegionEdgeTile(nx, ny, opposite_side, x_or_y);
+		const TRailRegionPatchLabel neighbour_label = neighbouring_region.GetLabel(neighbour_edge_tile);
+		assert(neighbour_label != INVALID_RAIL_REGION_PATCH);
+		if (std::find(unique_labels.begin(), unique_labels.end(), neighbour_label) == unique_labels.end()) unique_labels.push_back(neighbour_label);
+	}
+	for (const TRailRegionPatchLabel unique_label : unique_labels) callback(RailRegionPatchDesc{ nx, ny, unique_label });
+}
+
+/**
+ * Calls the provided callback function on all rail region patches connected to the starting patch
+ * in each cardinal direction, plus any others that are reachable via tunnels or bridges.
+ * @param rail_region_patch Rail patch within the rail region to start searching from
+ * @param callback The function that will be called for each connected rail patch that is found
+ */
+void VisitRailRegionPatchNeighbors(const RailRegionPatchDesc &rail_region_patch, TVisitRailRegionPatchCallBack &callback)
+{
+	if (rail_region_patch.label == INVALID_RAIL_REGION_PATCH) return;
+
+	const RailRegionReference current_region = GetUpdatedRailRegion(rail_region_patch.x, rail_region_patch.y);
+
+	for (DiagDirection side = DIAGDIR_BEGIN; side < DIAGDIR_END; side++) {
+		VisitAdjacentRailRegionPatchNeighbors(rail_region_patch, current_region, side, callback);
+	}
+
+	if (current_region.HasCrossRegionTunnelBridges()) {
+		const TRailRegionIndex current_index = GetRailRegionIndex(rail_region_patch.x, rail_region_patch.y);
+		for (const TileIndex tile : current_region.GetTileArea()) {
+			if (!IsTileType(tile, MP_TUNNELBRIDGE) || GetTunnelBridgeTransportType(tile) != TRANSPORT_RAIL) continue;
+			if (current_region.GetLabel(tile) != rail_region_patch.label) continue;
+			const TileIndex other_end_tile = GetOtherTunnelBridgeEnd(tile);
+			if (GetRailRegionIndex(other_end_tile) != current_index) callback(GetRailRegionPatchInfo(other_end_tile));
+		}
+	}
+}
+
+/**
+ * Initializes all rail regions, these are updated when first used.
+ */
+void InitializeRailRegions()
+{
+	_rail_regions.reset(new RailRegion[GetRailRegionMapSizeX() * GetRailRegionMapSizeY()]);
+}
+
+void RailRegionCheckCaches(std::function<void(const char *)> log)
+{
+	char cclog_buffer[1024];
+#define CCLOG(...) { \
+	char *cc_log_pos = cclog_buffer + seprintf(cclog_buffer, lastof(cclog_buffer), "Rail region: %u x %u to %u x %u: ", \
+			x * RAIL_REGION_EDGE_LENGTH, y * RAIL_REGION_EDGE_LENGTH, (x * RAIL_REGION_EDGE_LENGTH) + RAIL_REGION_EDGE_MASK, (y * RAIL_REGION_EDGE_LENGTH) + RAIL_REGION_EDGE_MASK); \
+	seprintf(cc_log_pos, lastof(cclog_buffer), __VA_ARGS__); \
+	DEBUG(desync, 0, "%s", cclog_buffer); \
+	if (log) log(cclog_buffer); \
+}
+
+	const uint32_t size_x = GetRailRegionMapSizeX();
+	const uint32_t size_y = GetRailRegionMapSizeY();
+	for (uint32_t y = 0; y < size_y; y++) {
+		for (uint32_t x = 0; x < size_x; x++) {
+			RailRegionReference rr = GetRailRegionRef(x, y);
+			if (!rr.IsInitialized()) continue;
+
+			const bool old_has_cross_region_tunnel_bridges = rr.HasCrossRegionTunnelBridges();
+			const int old_number_of_patches = rr.NumberOfPatches();
+			std::array<TRailRegionTraversabilityBits, DIAGDIR_END> old_edge_bits;
+			for (DiagDirection side = DIAGDIR_BEGIN; side < DIAGDIR_END; side++) old_edge_bits[side] = rr.GetEdgeTraversabilityBits(side);
+			const TRailRegionPatchLabelArray old_patch_labels = rr.CopyPatchLabelArray();
+
+			rr.ForceUpdate();
+
+			if (old_has_cross_region_tunnel_bridges != rr.HasCrossRegionTunnelBridges()) {
+				CCLOG("Has cross region tunnel/bridges mismatch: %u -> %u", old_has_cross_region_tunnel_bridges, rr.HasCrossRegionTunnelBridges());
+			}
+			if (old_number_of_patches != rr.NumberOfPatches()) {
+				CCLOG("Number of patches mismatch: %u -> %u", old_number_of_patches, rr.NumberOfPatches());
+			}
+			for (DiagDirection side = DIAGDIR_BEGIN; side < DIAGDIR_END; side++) {
+				if (old_edge_bits[side] != rr.GetEdgeTraversabilityBits(side)) {
+					CCLOG("Edge traversability mismatch: side %u, %04X -> %04X", side, old_edge_bits[side], rr.GetEdgeTraversabilityBits(side));
+				}
+			}
+			if (old_patch_labels != rr.CopyPatchLabelArray()) {
+				CCLOG("Patch label mismatch");
+			}
+		}
+	}
+#undef CCLOG
+}
@@ -0,0 +1,65 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file rail_regions.h Handles dividing the rail network in the map into regions to assist long distance train pathfinding. */
+
+#ifndef RAIL_REGIONS_H
+#define RAIL_REGIONS_H
+
+#include "tile_type.h"
+#include "map_func.h"
+
+#include <functional>
+
+using TRailRegionPatchLabel = uint8_t;
+using TRailRegionIndex = uint32_t;
+
+constexpr uint32_t RAIL_REGION_EDGE_LENGTH = 16;
+constexpr uint32_t RAIL_REGION_EDGE_LENGTH_LOG = 4;
+static_assert(1 << RAIL_REGION_EDGE_LENGTH_LOG == RAIL_REGION_EDGE_LENGTH);
+
+constexpr uint32_t RAIL_REGION_EDGE_MASK = RAIL_REGION_EDGE_LENGTH - 1;
+constexpr uint32_t RAIL_REGION_NUMBER_OF_TILES = RAIL_REGION_EDGE_LENGTH * RAIL_REGION_EDGE_LENGTH;
+
+constexpr TRailRegionPatchLabel INVALID_RAIL_REGION_PATCH = 0;
+
+/**
+ * Describes a single patch of connected track within a particular rail region.
+ * Connectivity ignores rail types, signals and the direction of travel, so a patch may contain track which a particular train can't use.
+ */
+struct RailRegionPatchDesc
+{
+	uint32_t x; ///< The X coordinate of the rail region, i.e. X=2 is the 3rd rail region along the X-axis
+	uint32_t y; ///< The Y coordinate of the rail region, i.e. Y=2 is the 3rd rail region along the Y-axis
+	TRailRegionPatchLabel label; ///< Unique label identifying the patch within the region
+
+	bool operator==(const RailRegionPatchDesc &other) const { return x == other.x && y == other.y && label == other.label; }
+	bool operator!=(const RailRegionPatchDesc &other) const { return !(*this == other); }
+};
+
+inline uint32_t GetRailRegionX(TileIndex tile) { return TileX(tile) / RAIL_REGION_EDGE_LENGTH; }
+inline uint32_t GetRailRegionY(TileIndex tile) { return TileY(tile) / RAIL_REGION_EDGE_LENGTH; }
+
+inline uint32_t GetRailRegionMapSizeX() { return MapSizeX() / RAIL_REGION_EDGE_LENGTH; }
+inline uint32_t GetRailRegionMapSizeY() { return MapSizeY() / RAIL_REGION_EDGE_LENGTH; }
+
+inline TRailRegionIndex GetRailRegionIndex(uint32_t region_x, uint32_t region_y) { return (region_y << (MapLogX() - RAIL_REGION_EDGE_LENGTH_LOG)) + region_x; }
+inline TRailRegionIndex GetRailRegionIndex(TileIndex tile) { return GetRailRegionIndex(GetRailRegionX(tile), GetRailRegionY(tile)); }
+
+uint32_t CalculateRailRegionPatchHash(const RailRegionPatchDesc &rail_region_patch);
+
+RailRegionPatchDesc GetRailRegionPatchInfo(TileIndex tile);
+
+void InvalidateRailRegion(TileIndex tile);
+void InvalidateAllRailRegions();
+
+using TVisitRailRegionPatchCallBack = std::function<void(const RailRegionPatchDesc &)>;
+void VisitRailRegionPatchNeighbors(const RailRegionPatchDesc &rail_region_patch, TVisitRailRegionPatchCallBack &callback);
+
+void InitializeRailRegions();
+
+#endif /* RAIL_REGIONS_H */
@@ -10,42 +10,190 @@
 #ifndef NODELIST_HPP
 #define NODELIST_HPP
 
-#include "../../misc/array.hpp"
 #include "../../misc/hashtable.hpp"
 #include "../../misc/binaryheap.hpp"
+#include "../../string_func.h"
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Item storage for CNodeList_HashTableT.
+ *  Items are allocated in cache line aligned blocks of fixed size so that
+ *  their addresses are stable. Clearing the arena keeps the blocks, so that
+ *  a reused node list does not need to allocate again.
+ */
+template <class Titem_, uint Tblock_size_>
+class CNodeArenaT {
+	static constexpr std::align_val_t BLOCK_ALIGNMENT{64};
+
+	std::vector<Titem_ *> m_blocks; ///< Allocated blocks of items.
+	uint m_num_items = 0;           ///< Number of constructed items.
+
+	static Titem_ *AllocateBlock()
+	{
+		return static_cast<Titem_ *>(::operator new(sizeof(Titem_) * Tblock_size_, BLOCK_ALIGNMENT));
+	}
+
+	static void FreeBlock(Titem_ *block)
+	{
+		::operator delete(block, BLOCK_ALIGNMENT);
+	}
+
+public:
+	CNodeArenaT() = default;
+	CNodeArenaT(const CNodeArenaT &) = delete;
+	CNodeArenaT &operator=(const CNodeArenaT &) = delete;
+
+	~CNodeArenaT()
+	{
+		this->Clear();
+		this->Trim(0);
+	}
+
+	/** Destroy all items, but keep the blocks allocated. */
+	inline void Clear()
+	{
+		if constexpr (!std::is_trivially_destructible_v<Titem_>) {
+			for (uint i = 0; i < this->m_num_items; i++) (*this)[i].~Titem_();
+		}
+		this->m_num_items = 0;
+	}
+
+	/** Free blocks which are not in use, beyond the given number of blocks. */
+	inline void Trim(uint max_blocks)
+	{
+		uint used_blocks = CeilDiv(this->m_num_items, Tblock_size_);
+		max_blocks = std::max(max_blocks, used_blocks);
+		while (this->m_blocks.size() > max_blocks) {
+			FreeBlock(this->m_blocks.back());
+			this->m_blocks.pop_back();
+		}
+	}
+
+	/** return number of items */
+	inline uint Length() const
+	{
+		return this->m_num_items;
+	}
+
+	/** allocate and construct a new item */
+	inline Titem_ *AppendC()
+	{
+		uint block = this->m_num_items / Tblock_size_;
+		if (block == this->m_blocks.size()) this->m_blocks.push_back(AllocateBlock());
+		Titem_ *item = this->m_blocks[block] + (this->m_num_items % Tblock_size_);
+		this->m_num_items++;
+		new (item) Titem_;
+		return item;
+	}
+
+	/** indexed access (non-const) */
+	inline Titem_ &operator[](uint index)
+	{
+		return this->m_blocks[index / Tblock_size_][index % Tblock_size_];
+	}
+
+	/** indexed access (const) */
+	inline const Titem_ &operator[](uint index) const
+	{
+		return this->m_blocks[index / Tblock_size_][index % Tblock_size_];
+	}
+
+	template <typename D> void Dump(D &dmp) const
+	{
+		dmp.WriteValue("num_blocks", (uint)this->m_blocks.size());
+		uint num_items = this->Length();
+		dmp.WriteValue("num_items", num_items);
+		for (uint i = 0; i < num_items; i++) {
+			const Titem_ &item = (*this)[i];
+			char name[32];
+			seprintf(name, lastof(name), "item[%d]", i);
+			dmp.WriteStructT(name, &item);
+		}
+	}
+};
 
 /**
  * Hash table based node list multi-container class.
  *  Implements open list, closed list and priority queue for A-star
  *  path finder.
+ *
+ *  The storage of all containers is taken from a per-thread pool and returned
+ *  to it when the node list is destroyed, so that consecutive searches reuse
+ *  the item blocks, hash table slots and priority queue of previous searches.
  */
 template <class Titem_, int Thash_bits_open_, int Thash_bits_closed_>
 class CNodeList_HashTableT {
 public:
 	typedef Titem_ Titem;                                        ///< Make #Titem_ visible from outside of class.
 	typedef typename Titem_::Key Key;                            ///< Make Titem_::Key a property of this class.
-	typedef SmallArray<Titem_, 65536, 256> CItemArray;           ///< Type that we will use as item container.
-	typedef CHashTableT<Titem_, Thash_bits_open_  > COpenList;   ///< How pointers to open nodes will be stored.
-	typedef CHashTableT<Titem_, Thash_bits_closed_> CClosedList; ///< How pointers to closed nodes will be stored.
-	typedef CBinaryHeapT<Titem_> CPriorityQueue;                 ///< How the priority queue will be managed.
+	typedef CNodeArenaT<Titem_, 4096> CItemArray;                          ///< Type that we will use as item container.
+	typedef CGenerationHashTableT<Titem_, Thash_bits_open_  > COpenList;   ///< How pointers to open nodes will be stored.
+	typedef CGenerationHashTableT<Titem_, Thash_bits_closed_> CClosedList; ///< How pointers to closed nodes will be stored.
+	typedef CBinaryHeapT<Titem_> CPriorityQueue;                           ///< How the priority queue will be managed.
 
 protected:
-	CItemArray      m_arr;        ///< Here we store full item data (Titem_).
-	COpenList       m_open;       ///< Hash table of pointers to open item data.
-	CClosedList     m_closed;     ///< Hash table of pointers to closed item data.
-	CPriorityQueue  m_open_queue; ///< Priority queue of pointers to open item data.
-	Titem          *m_new_node;   ///< New open node under construction.
+	/** Storage of all containers, reused between searches. */
+	struct Storage {
+		CItemArray      arr;
+		COpenList       open;
+		CClosedList     closed;
+		CPriorityQueue  open_queue{2048};
+	};
+
+	static constexpr uint MAX_POOLED_STORAGE = 4;   ///< Maximum number of unused storages kept per thread.
+	static constexpr uint MAX_RETAINED_BLOCKS = 16; ///< Maximum number of item blocks kept by an unused storage.
+
+	static std::vector<std::unique_ptr<Storage>> &GetStoragePool()
+	{
+		thread_local std::vector<std::unique_ptr<Storage>> pool;
+		return pool;
+	}
+
+	static std::unique_ptr<Storage> AcquireStorage()
+	{
+		std::vector<std::unique_ptr<Storage>> &pool = GetStoragePool();
+		if (pool.empty()) return std::make_unique<Storage>();
+		std::unique_ptr<Storage> storage = std::move(pool.back());
+		pool.pop_back();
+		return storage;
+	}
+
+	static void ReleaseStorage(std::unique_ptr<Storage> storage)
+	{
+		std::vector<std::unique_ptr<Storage>> &pool = GetStoragePool();
+		if (pool.size() >= MAX_POOLED_STORAGE) return;
+		storage->arr.Clear();
+		storage->arr.Trim(MAX_RETAINED_BLOCKS);
+		storage->open.Clear();
+		storage->closed.Clear();
+		storage->open_queue.Clear();
+		pool.push_back(std::move(storage));
+	}
+
+	std::unique_ptr<Storage> m_storage; ///< Storage of the containers below, owned while this node list is alive.
+	CItemArray     &m_arr;              ///< Here we store full item data (Titem_).
+	COpenList      &m_open;             ///< Hash table of pointers to open item data.
+	CClosedList    &m_closed;           ///< Hash table of pointers to closed item data.
+	CPriorityQueue &m_open_queue;       ///< Priority queue of pointers to open item data.
+	Titem          *m_new_node;         ///< New open node under construction.
 
 public:
 	/** default constructor */
-	CNodeList_HashTableT() : m_open_queue(2048)
+	CNodeList_HashTableT() : m_storage(AcquireStorage()), m_arr(m_storage->arr), m_open(m_storage->open), m_closed(m_storage->closed), m_open_queue(m_storage->open_queue)
 	{
 		m_new_node = nullptr;
 	}
 
+	CNodeList_HashTableT(const CNodeList_HashTableT &) = delete;
+	CNodeList_HashTableT &operator=(const CNodeList_HashTableT &) = delete;
+
 	/** destructor */
 	~CNodeList_HashTableT()
 	{
+		ReleaseStorage(std::move(m_storage));
 	}
 
 	/** return number of open nodes */
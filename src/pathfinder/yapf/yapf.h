@@ -101,4 +101,14 @@ bool YapfTrainCheckDepotReverse(const Train *v, TileIndex forward_depot, TileInd
  */
 bool YapfTrainFindNearestSafeTile(const Train *v, TileIndex tile, Trackdir td, bool override_railtype);
 
+/** Result of a single train pathfinder search for benchmarking, see YapfTrainBenchmarkChooseTrack. */
+struct YapfTrainBenchmarkResult {
+	Trackdir trackdir;         ///< First trackdir of the chosen path.
+	bool path_found;           ///< Whether a path was found.
+	bool region_corridor_used; ///< Whether the search was first restricted to a rail region corridor.
+	uint expanded_nodes;       ///< Number of nodes expanded, including by a repeated unrestricted search.
+};
+
+YapfTrainBenchmarkResult YapfTrainBenchmarkChooseTrack(const Train *v, bool use_region_corridor);
+
 #endif /* YAPF_H */
@@ -14,9 +14,30 @@
 
 /**
  * Use this function to notify YAPF that track layout (or signal configuration) has change.
- * @param tile  the tile that is changed
+ * @param tile  the tile that is changed, or INVALID_TILE to invalidate all cached segments
  * @param track what piece of track is changed
  */
 void YapfNotifyTrackLayoutChange(TileIndex tile, Track track);
 
+/**
+ * Use this function to notify YAPF that the road layout, road types, one-way state or road works of a tile have changed.
+ * @param tile  the tile that is changed, or INVALID_TILE to invalidate all cached segments
+ */
+void YapfNotifyRoadLayoutChange(TileIndex tile);
+
+/** Statistics of the global segment cost caches, see the yapf_cache_stats console command. */
+struct YapfSegmentCostCacheStats {
+	uint64_t rail_hits = 0;            ///< Number of rail segments found in the cache.
+	uint64_t rail_misses = 0;          ///< Number of rail segments which had to be calculated and added to the cache.
+	uint64_t road_hits = 0;            ///< Number of road segments found in the cache.
+	uint64_t road_misses = 0;          ///< Number of road segments which had to be calculated, or could not use the cached segment.
+	uint64_t region_invalidations = 0; ///< Number of track layout or reservation changes which invalidated only the surrounding regions.
+	uint64_t segments_invalidated = 0; ///< Number of cached segments removed by region invalidations.
+	uint64_t flushes = 0;              ///< Number of changes which flushed the whole cache.
+};
+
+const YapfSegmentCostCacheStats &YapfGetSegmentCostCacheStats();
+void YapfResetSegmentCostCacheStats();
+size_t YapfGetSegmentCostCacheSize();
+
 #endif /* YAPF_CACHE_H */
@@ -11,6 +11,11 @@
 #define YAPF_COSTCACHE_HPP
 
 #include "../../date_func.h"
+#include "yapf_cache.h"
+#include "../../map_func.h"
+#include "../../settings_type.h"
+#include "../../3rdparty/robin_hood/robin_hood.h"
+#include <vector>
 
 /**
  * CYapfSegmentCostCacheNoneT - the formal only yapf cost cache provider that implements
@@ -94,17 +99,152 @@ public:
  * Base class for segment cost cache providers. Contains global counter
  *  of track layout changes and static notification function called whenever
  *  the track layout changes. It is implemented as base class because it needs
- *  to be shared between all rail YAPF types (one shared counter, one notification
+ *  to be shared between all rail and road YAPF types (one shared counter, one notification
  *  function.
+ * Cached segments are also indexed by the map regions which they depend on, so that
+ *  a change to a single tile only invalidates the segments near that tile.
  */
 struct CSegmentCostCacheBase
 {
+	static const uint REGION_BITS = 4; ///< Log2 of the width and height of the regions by which segments are indexed.
+
 	static int   s_rail_change_counter;
+	static YapfSegmentCostCacheStats s_stats;
 
-	static void NotifyTrackLayoutChange(TileIndex, Track)
+	/**
+	 * Invalidate the cached segments which depend on the given tile.
+	 * @param tile Changed tile, or INVALID_TILE to flush the whole cache.
+	 */
+	static void NotifyTrackLayoutChange(TileIndex tile, Track)
 	{
-		s_rail_change_counter++;
+		if (tile == INVALID_TILE) {
+			s_rail_change_counter++;
+			s_stats.flushes++;
+			return;
+		}
+
+		/* Caches which will be flushed anyway, or which are empty, don't need to be searched */
+		auto needs_invalidation = [](const CSegmentCostCacheBase *cache) {
+			return cache->m_layout_change_counter == s_rail_change_counter && cache->HasRegions();
+		};
+		if (std::none_of(s_caches.begin(), s_caches.end(), needs_invalidation)) return;
+
+		/* Segments which end next to the tile also depend on it, as the tile following the segment is examined too. */
+		uint32_t regions[5];
+		uint count = 0;
+		auto add_region = [&](uint x, uint y) {
+			if (x >= MapSizeX() || y >= MapSizeY()) return;
+			uint32_t region = GetRegion(TileXY(x, y));
+			for (uint i = 0; i < count; i++) {
+				if (regions[i] == region) return;
+			}
+			regions[count++] = region;
+		};
+		const uint x = TileX(tile);
+		const uint y = TileY(tile);
+		add_region(x, y);
+		add_region(x - 1, y);
+		add_region(x + 1, y);
+		add_region(x, y - 1);
+		add_region(x, y + 1);
+
+		s_stats.region_invalidations++;
+		for (CSegmentCostCacheBase *cache : s_caches) {
+			if (!needs_invalidation(cache)) continue;
+			for (uint i = 0; i < count; i++) {
+				cache->InvalidateRegion(regions[i]);
+			}
+		}
+	}
+
+	/**
+	 * Get the region of a tile.
+	 * @param tile Tile.
+	 * @return Region index.
+	 */
+	static inline uint32_t GetRegion(TileIndex tile)
+	{
+		return ((TileY(tile) >> REGION_BITS) << (MapLogX() - REGION_BITS)) | (TileX(tile) >> REGION_BITS);
+	}
+
+	/**
+	 * Add the regions of the tiles from one tile to another to a list of regions, if not already present.
+	 * @param regions List of regions.
+	 * @param from Start tile.
+	 * @param to End tile, this is in a straight line from the start tile.
+	 */
+	static void AddRegions(std::vector<uint32_t> &regions, TileIndex from, TileIndex to)
+	{
+		const uint x_min = std::min(TileX(from), TileX(to)) >> REGION_BITS;
+		const uint x_max = std::max(TileX(from), TileX(to)) >> REGION_BITS;
+		const uint y_min = std::min(TileY(from), TileY(to)) >> REGION_BITS;
+		const uint y_max = std::max(TileY(from), TileY(to)) >> REGION_BITS;
+		for (uint y = y_min; y <= y_max; y++) {
+			for (uint x = x_min; x <= x_max; x++) {
+				const uint32_t region = GetRegion(TileXY(x << REGION_BITS, y << REGION_BITS));
+				if (std::find(regions.begin(), regions.end(), region) == regions.end()) regions.push_back(region);
+			}
+		}
 	}
+
+	/**
+	 * Get the total number of segments in all global segment cost caches.
+	 * @return Number of cached segments.
+	 */
+	static size_t GetTotalCachedSegments()
+	{
+		size_t total = 0;
+		for (const CSegmentCostCacheBase *cache : s_caches) {
+			total += cache->GetCachedSegments();
+		}
+		return total;
+	}
+
+protected:
+	static std::vector<CSegmentCostCacheBase *> s_caches; ///< All global segment cost caches.
+
+	int                m_layout_change_counter = 0; ///< Value of s_rail_change_counter when the cache was last flushed.
+	PathfinderSettings m_pf_settings;               ///< Pathfinder settings when the cache was last flushed.
+	uint8_t            m_road_side;                 ///< Road side setting when the cache was last flushed.
+
+	CSegmentCostCacheBase()
+	{
+		memset(&m_pf_settings, 0, sizeof(m_pf_settings));
+		m_road_side = _settings_game.vehicle.road_side;
+		s_caches.push_back(this);
+	}
+
+	/**
+	 * Check whether the layout change counter or any of the settings which the cached costs depend on have changed
+	 * since the last call, the cache must be flushed if so.
+	 * @return True if the cache must be flushed.
+	 */
+	bool CheckChanged()
+	{
+		bool changed = false;
+		if (m_layout_change_counter != s_rail_change_counter) {
+			m_layout_change_counter = s_rail_change_counter;
+			changed = true;
+		}
+		if (memcmp(&m_pf_settings, &_settings_game.pf, sizeof(m_pf_settings)) != 0 || m_road_side != _settings_game.vehicle.road_side) {
+			memcpy(&m_pf_settings, &_settings_game.pf, sizeof(m_pf_settings));
+			m_road_side = _settings_game.vehicle.road_side;
+			changed = true;
+		}
+		return changed;
+	}
+
+	virtual ~CSegmentCostCacheBase()
+	{
+		s_caches.erase(std::find(s_caches.begin(), s_caches.end(), this));
+	}
+
+	CSegmentCostCacheBase(const CSegmentCostCacheBase &) = delete;
+	CSegmentCostCacheBase &operator=(const CSegmentCostCacheBase &) = delete;
+
+	virtual bool HasRegions() const = 0;
+	virtual void InvalidateRegion(uint32_t region) = 0;
+	virtual size_t GetCachedSegments() const = 0;
 };
 
 
@@ -121,6 +261,7 @@ struct CSegmentCostCacheBase
 template <class Tsegment>
 struct CSegmentCostCacheT : public CSegmentCostCacheBase {
 	static const int C_HASH_BITS = 14;
+	static const uint MAX_STORED_SEGMENTS = 1 << 19; ///< Flush well before the storage limit of 1M segments is reached, as a single search may add many segments.
 
 	typedef CHashTableT<Tsegment, C_HASH_BITS> HashTable;
 	typedef SmallArray<Tsegment> Heap;
@@ -128,6 +269,8 @@ struct CSegmentCostCacheT : public CSegmentCostCacheBase {
 
 	HashTable    m_map;
 	Heap         m_heap;
+	robin_hood::unordered_flat_map<uint32_t, std::vector<Tsegment *>> m_regions; ///< Segments which depend on each region, this may include segments which have since been removed from m_map.
+	uint         m_num_removed = 0;                                              ///< Number of segments in m_heap which have been removed from m_map.
 
 	inline CSegmentCostCacheT() {}
 
@@ -136,6 +279,55 @@ struct CSegmentCostCacheT : public CSegmentCostCacheBase {
 	{
 		m_map.Clear();
 		m_heap.Clear();
+		m_regions.clear();
+		m_num_removed = 0;
+	}
+
+	/**
+	 * Flush the cache if the track layout or pathfinder settings have changed since it was last used,
+	 * or if most of the segment storage is used by segments which have been invalidated or the storage is nearly full.
+	 * The storage of invalidated segments can't be reused immediately, as they may still be referenced by nodes,
+	 * so this must only be called when no pathfinder is using the cache.
+	 */
+	inline void FlushIfChanged()
+	{
+		if (CheckChanged() || (m_num_removed >= 1024 && m_num_removed > (uint)m_map.Count()) || m_heap.Length() >= MAX_STORED_SEGMENTS) Flush();
+	}
+
+	/**
+	 * Record the regions which a newly calculated segment depends on.
+	 * @param segment Segment.
+	 * @param regions Regions which the segment cost depends on.
+	 */
+	inline void SetRegions(Tsegment &segment, const std::vector<uint32_t> &regions)
+	{
+		for (uint32_t region : regions) {
+			m_regions[region].push_back(&segment);
+		}
+	}
+
+	bool HasRegions() const override
+	{
+		return !m_regions.empty();
+	}
+
+	void InvalidateRegion(uint32_t region) override
+	{
+		auto iter = m_regions.find(region);
+		if (iter == m_regions.end()) return;
+		for (Tsegment *segment : iter->second) {
+			/* The segment may have already been removed via another region, and replaced by a new segment with the same key */
+			if (m_map.Find(segment->GetKey()) != segment) continue;
+			m_map.Pop(*segment);
+			m_num_removed++;
+			s_stats.segments_invalidated++;
+		}
+		m_regions.erase(iter);
+	}
+
+	size_t GetCachedSegments() const override
+	{
+		return m_map.Count();
 	}
 
 	inline Tsegment &Get(Key &key, bool *found)
@@ -181,14 +373,10 @@ protected:
 
 	inline static Cache &stGetGlobalCache()
 	{
-		static int last_rail_change_counter = 0;
 		static Cache C;
 
 		/* delete the cache sometimes... */
-		if (last_rail_change_counter != Cache::s_rail_change_counter) {
-			last_rail_change_counter = Cache::s_rail_change_counter;
-			C.Flush();
-		}
+		C.FlushIfChanged();
 		return C;
 	}
 
@@ -206,6 +394,11 @@ public:
 		bool found;
 		CachedData &item = m_global_cache.Get(key, &found);
 		Yapf().ConnectNodeToCachedData(n, item);
+		if (found) {
+			Cache::s_stats.rail_hits++;
+		} else {
+			Cache::s_stats.rail_misses++;
+		}
 		return found;
 	}
 
@@ -216,6 +409,18 @@ public:
 	inline void PfNodeCacheFlush(Node &)
 	{
 	}
+
+	/**
+	 * Called by YAPF after calculating the cost of a segment, with the map regions which the calculation depended on.
+	 *  The segment is invalidated when the track layout or reservations in any of those regions change.
+	 */
+	inline void PfNodeCacheSetRegions(Node &n, const std::vector<uint32_t> &regions)
+	{
+		if (!Yapf().CanUseGlobalCache(n)) return;
+		CacheKey key(n.GetKey());
+		CachedData *segment = m_global_cache.m_map.Find(key);
+		if (segment != nullptr) m_global_cache.SetRegions(*segment, regions);
+	}
 };
 
 #endif /* YAPF_COSTCACHE_HPP */
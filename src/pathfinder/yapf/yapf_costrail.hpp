@@ -58,6 +58,7 @@ protected:
 	int m_max_cost;
 	bool m_disable_cache;
 	std::vector<int> m_sig_look_ahead_costs;
+	std::vector<uint32_t> m_segment_regions; ///< Map regions which the segment currently being calculated depends on, see CSegmentCostCacheBase.
 
 public:
 	bool          m_stopped_on_first_two_way_signal;
@@ -521,6 +522,7 @@ public:
 		/* Do we already have a cached segment? */
 		CachedData &segment = *n.m_segment;
 		bool is_cached_segment = (segment.m_cost >= 0);
+		m_segment_regions.clear();
 
 		int parent_cost = has_parent ? n.m_parent->m_cost : 0;
 
@@ -614,6 +616,9 @@ public:
 
 no_entry_cost: // jump here at the beginning if the node has no parent (it is the first node)
 
+			/* Remember which regions the segment covers, so that it can be invalidated when any of them change. */
+			CSegmentCostCacheBase::AddRegions(m_segment_regions, (tf->m_tiles_skipped > 0 && tf->m_old_tile != INVALID_TILE) ? tf->m_old_tile : cur.tile, cur.tile);
+
 			/* All other tile costs will be calculated here. */
 			segment_cost += Yapf().OneTileCost(cur.tile, cur.td);
 
@@ -828,6 +833,9 @@ no_entry_cost: // jump here at the beginning if the node has no parent (it is th
 			segment.m_end_segment_reason = end_segment_reason & ESRB_CACHED_MASK;
 			/* Save end of segment back to the node. */
 			n.SetLastTileTrackdir(cur.tile, cur.td);
+			/* The tile following the end of the segment was examined too. */
+			if (tf_local.m_new_tile != INVALID_TILE) CSegmentCostCacheBase::AddRegions(m_segment_regions, tf_local.m_new_tile, tf_local.m_new_tile);
+			Yapf().PfNodeCacheSetRegions(n, m_segment_regions);
 		}
 
 		/* Do we have an excuse why not to continue pathfinding in this direction? */
@@ -173,6 +173,28 @@ public:
 		CYapfDestinationRailBase::SetDestination(v);
 	}
 
+	/**
+	 * Get the tiles of the destination, for the rail region search.
+	 * @param tiles Output for the destination tiles.
+	 * @return False if the destination isn't a fixed set of tiles.
+	 */
+	bool GetDestinationTiles(std::vector<TileIndex> &tiles) const
+	{
+		if (m_any_depot) return false;
+
+		if (m_dest_station_id != INVALID_STATION) {
+			const BaseStation *st = BaseStation::Get(m_dest_station_id);
+			TileArea ta;
+			st->GetTileArea(&ta, Station::IsExpected(st) ? STATION_RAIL : STATION_WAYPOINT);
+			for (TileIndex tile : ta) {
+				if (HasStationTileRail(tile) && GetStationIndex(tile) == m_dest_station_id) tiles.push_back(tile);
+			}
+		} else if (m_destTile < MapSize()) {
+			tiles.push_back(m_destTile);
+		}
+		return !tiles.empty();
+	}
+
 	/** Called by YAPF to detect if node ends in the desired destination */
 	inline bool PfDetectDestination(Node &n)
 	{
@@ -10,6 +10,97 @@
 #ifndef YAPF_NODE_ROAD_HPP
 #define YAPF_NODE_ROAD_HPP
 
+#include "../../road_type.h"
+
+/** key for cached segment cost for road YAPF */
+struct CYapfRoadSegmentKey
+{
+	TileIndex    m_tile;
+	Trackdir     m_td;
+	RoadTramType m_rtt;                  ///< road or tram, this determines the road bits and speed limits which are used
+	RoadTypes    m_compatible_roadtypes; ///< road types which the vehicle can use
+
+	inline CYapfRoadSegmentKey(TileIndex tile, Trackdir td, RoadTramType rtt, RoadTypes compatible_roadtypes)
+		: m_tile(tile), m_td(td), m_rtt(rtt), m_compatible_roadtypes(compatible_roadtypes)
+	{}
+
+	inline int32_t CalcHash() const
+	{
+		return (m_tile << 4) | m_td;
+	}
+
+	inline bool operator==(const CYapfRoadSegmentKey &other) const
+	{
+		return m_tile == other.m_tile && m_td == other.m_td && m_rtt == other.m_rtt && m_compatible_roadtypes == other.m_compatible_roadtypes;
+	}
+};
+
+/** speed limit penalty of one or more tiles of a cached road segment, this depends on the vehicle speed so is applied when the segment is used */
+struct CYapfRoadSegmentSpeedLimit
+{
+	int      m_max_speed;     ///< speed limit
+	int      m_min_speed;     ///< minimum speed
+	uint16_t m_tiles_skipped; ///< number of tunnel/bridge tiles skipped by the step
+	uint16_t m_count;         ///< number of steps with this speed limit
+};
+
+/**
+ * cached segment cost for road YAPF
+ * Only the vehicle independent part of the cost is cached, segments which contain road stops or depots,
+ * or which end next to a road stop or depot, are not cached as their cost and extent depends on the vehicle.
+ */
+struct CYapfRoadSegment
+{
+	typedef CYapfRoadSegmentKey Key;
+	static const uint MAX_SPEED_LIMITS = 4;
+
+	CYapfRoadSegmentKey        m_key;
+	TileIndex                  m_last_tile;
+	Trackdir                   m_last_td;
+	int                        m_cost;          ///< vehicle independent cost, -1 if not calculated
+	bool                       m_loop;          ///< segment is a simple loop with no junctions
+	bool                       m_uncacheable;   ///< segment cost can't be cached
+	uint8_t                    m_num_speed_limits;
+	CYapfRoadSegmentSpeedLimit m_speed_limits[MAX_SPEED_LIMITS];
+	uint                       m_min_x, m_min_y, m_max_x, m_max_y; ///< bounding box of the segment tiles
+	CYapfRoadSegment          *m_hash_next;
+
+	inline CYapfRoadSegment(const CYapfRoadSegmentKey &key)
+		: m_key(key)
+		, m_last_tile(INVALID_TILE)
+		, m_last_td(INVALID_TRACKDIR)
+		, m_cost(-1)
+		, m_loop(false)
+		, m_uncacheable(false)
+		, m_num_speed_limits(0)
+		, m_min_x(0), m_min_y(0), m_max_x(0), m_max_y(0)
+		, m_hash_next(nullptr)
+	{}
+
+	inline const Key &GetKey() const
+	{
+		return m_key;
+	}
+
+	inline CYapfRoadSegment *GetHashNext()
+	{
+		return m_hash_next;
+	}
+
+	inline void SetHashNext(CYapfRoadSegment *next)
+	{
+		m_hash_next = next;
+	}
+
+	/** Is the tile within the bounding box of the segment? */
+	inline bool Contains(TileIndex tile) const
+	{
+		const uint x = TileX(tile);
+		const uint y = TileY(tile);
+		return x >= m_min_x && x <= m_max_x && y >= m_min_y && y <= m_max_y;
+	}
+};
+
 /** Yapf Node for road YAPF */
 template <class Tkey_>
 struct CYapfRoadNodeT : CYapfNodeT<Tkey_, CYapfRoadNodeT<Tkey_> > {
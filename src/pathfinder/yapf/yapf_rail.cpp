@@ -14,6 +14,7 @@
 #include "yapf_node_rail.hpp"
 #include "yapf_costrail.hpp"
 #include "yapf_destrail.hpp"
+#include "yapf_rail_regions.h"
 #include "../../viewport_func.h"
 #include "../../newgrf_station.h"
 #include "../../tracerestrict.h"
@@ -290,7 +291,13 @@ public:
 		if (target != nullptr) target->okay = true;
 
 		if (Yapf().CanUseGlobalCache(*m_res_node)) {
-			YapfNotifyTrackLayoutChange(INVALID_TILE, INVALID_TRACK);
+			/* Only the cached segments around the newly reserved tiles are affected */
+			for (Node *node = m_res_node; node->m_parent != nullptr; node = node->m_parent) {
+				node->template IterateTiles<CYapfReserveTrack>(Yapf().GetVehicle(), Yapf(), [&](TileIndex tile, Trackdir td) -> bool {
+					CSegmentCostCacheBase::NotifyTrackLayoutChange(tile, TrackdirToTrack(td));
+					return true;
+				});
+			}
 		}
 
 		return true;
@@ -540,13 +547,25 @@ public:
 	typedef typename Node::Key Key;                      ///< key to hash tables
 
 protected:
+	std::vector<TRailRegionIndex> m_region_corridor; ///< sorted rail regions to which the search is restricted, empty if unrestricted
+
 	/** to access inherited path finder */
 	inline Tpf &Yapf()
 	{
 		return *static_cast<Tpf *>(this);
 	}
 
+	inline bool IsInRegionCorridor(TileIndex tile) const
+	{
+		return m_region_corridor.empty() || std::binary_search(m_region_corridor.begin(), m_region_corridor.end(), GetRailRegionIndex(tile));
+	}
+
 public:
+	inline bool HasRegionCorridor() const
+	{
+		return !m_region_corridor.empty();
+	}
+
 	/**
 	 * Called by YAPF to move from the given node to the next tile. For each
 	 *  reachable trackdir on the new tile creates new node, initializes it
@@ -564,7 +583,7 @@ public:
 				rev_node = rev_node->m_parent;
 			}
 			if (rev_node && length >= v->gcache.cached_total_length) {
-				if (F.Follow(rev_node->GetLastTile(), ReverseTrackdir(rev_node->GetLastTrackdir()))) {
+				if (F.Follow(rev_node->GetLastTile(), ReverseTrackdir(rev_node->GetLastTrackdir())) && IsInRegionCorridor(F.m_new_tile)) {
 					Yapf().AddMultipleNodes(&old_node, F, [&](Node &n) {
 						n.flags_u.flags_s.m_reverse_pending = false;
 						n.flags_u.flags_s.m_teleport = true;
@@ -575,7 +594,7 @@ public:
 				return;
 			}
 		}
-		if (F.Follow(old_node.GetLastTile(), old_node.GetLastTrackdir())) {
+		if (F.Follow(old_node.GetLastTile(), old_node.GetLastTrackdir()) && IsInRegionCorridor(F.m_new_tile)) {
 			Yapf().AddMultipleNodes(&old_node, F);
 		}
 	}
@@ -587,18 +606,32 @@ public:
 	}
 
 	static Trackdir stChooseRailTrack(const Train *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks, bool &path_found, bool reserve_track, PBSTileInfo *target, TileIndex *dest)
+	{
+		if (_settings_game.pf.rail_region_corridor) {
+			bool region_corridor_used;
+			Trackdir result = stChooseRailTrack(v, tile, enterdir, tracks, path_found, reserve_track, target, dest, true, region_corridor_used);
+
+			/* Nothing has been reserved if no path was found, so the search can just be repeated without the corridor */
+			if (path_found || !region_corridor_used) return result;
+		}
+
+		bool region_corridor_used;
+		return stChooseRailTrack(v, tile, enterdir, tracks, path_found, reserve_track, target, dest, false, region_corridor_used);
+	}
+
+	static Trackdir stChooseRailTrack(const Train *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks, bool &path_found, bool reserve_track, PBSTileInfo *target, TileIndex *dest, bool use_region_corridor, bool &region_corridor_used)
 	{
 		/* create pathfinder instance */
 		Tpf pf1;
 		Trackdir result1;
 
 		if (_debug_yapfdesync_level < 1 && _debug_desync_level < 2) {
-			result1 = pf1.ChooseRailTrack(v, tile, enterdir, tracks, path_found, reserve_track, target, dest);
+			result1 = pf1.ChooseRailTrack(v, tile, enterdir, tracks, path_found, reserve_track, target, dest, use_region_corridor);
 		} else {
-			result1 = pf1.ChooseRailTrack(v, tile, enterdir, tracks, path_found, false, nullptr, nullptr);
+			result1 = pf1.ChooseRailTrack(v, tile, enterdir, tracks, path_found, false, nullptr, nullptr, use_region_corridor);
 			Tpf pf2;
 			pf2.DisableCache(true);
-			Trackdir result2 = pf2.ChooseRailTrack(v, tile, enterdir, tracks, path_found, reserve_track, target, dest);
+			Trackdir result2 = pf2.ChooseRailTrack(v, tile, enterdir, tracks, path_found, reserve_track, target, dest, use_region_corridor);
 			if (result1 != result2) {
 				DEBUG(desync, 0, "CACHE ERROR: ChooseRailTrack() = [%d, %d]", result1, result2);
 				DumpState(pf1, pf2);
@@ -607,10 +640,11 @@ public:
 			}
 		}
 
+		region_corridor_used = pf1.HasRegionCorridor();
 		return result1;
 	}
 
-	inline Trackdir ChooseRailTrack(const Train *v, TileIndex, DiagDirection, TrackBits, bool &path_found, bool reserve_track, PBSTileInfo *target, TileIndex *dest)
+	inline Trackdir ChooseRailTrack(const Train *v, TileIndex, DiagDirection, TrackBits, bool &path_found, bool reserve_track, PBSTileInfo *target, TileIndex *dest, bool use_region_corridor)
 	{
 		if (target != nullptr) target->tile = INVALID_TILE;
 		if (dest != nullptr) *dest = INVALID_TILE;
@@ -620,6 +654,11 @@ public:
 		Yapf().SetOrigin(origin.tile, origin.trackdir, INVALID_TILE, INVALID_TRACKDIR, 1, true);
 		Yapf().SetDestination(v);
 
+		if (use_region_corridor) {
+			std::vector<TileIndex> dest_tiles;
+			if (Yapf().GetDestinationTiles(dest_tiles)) m_region_corridor = YapfTrainFindRailRegionCorridor(v, origin.tile, dest_tiles);
+		}
+
 		/* find the best path */
 		path_found = Yapf().FindPath(v);
 
@@ -659,6 +698,19 @@ public:
 		return next_trackdir;
 	}
 
+	static YapfTrainBenchmarkResult stBenchmarkChooseRailTrack(const Train *v, bool use_region_corridor)
+	{
+		YapfTrainBenchmarkResult result{};
+		for (bool use_corridor : { use_region_corridor, false }) {
+			Tpf pf;
+			result.trackdir = pf.ChooseRailTrack(v, INVALID_TILE, INVALID_DIAGDIR, TRACK_BIT_NONE, result.path_found, false, nullptr, nullptr, use_corridor);
+			result.expanded_nodes += pf.m_nodes.ClosedCount();
+			if (pf.HasRegionCorridor()) result.region_corridor_used = true;
+			if (result.path_found || !pf.HasRegionCorridor()) break;
+		}
+		return result;
+	}
+
 	static bool stCheckReverseTrain(const Train *v, TileIndex t1, Trackdir td1, TileIndex t2, Trackdir td2, int reverse_penalty)
 	{
 		Tpf pf1;
@@ -747,6 +799,18 @@ Track YapfTrainChooseTrack(const Train *v, TileIndex tile, DiagDirection enterdi
 	return (td_ret != INVALID_TRACKDIR) ? TrackdirToTrack(td_ret) : FindFirstTrack(tracks);
 }
 
+/**
+ * Run the train pathfinder for benchmarking, as YapfTrainChooseTrack but without reserving a path.
+ * @param v The train.
+ * @param use_region_corridor Whether to first restrict the search to a rail region corridor, as for the rail_region_corridor setting.
+ * @return The result of the search.
+ */
+YapfTrainBenchmarkResult YapfTrainBenchmarkChooseTrack(const Train *v, bool use_region_corridor)
+{
+	if (_settings_game.pf.forbid_90_deg) return CYapfRail2::stBenchmarkChooseRailTrack(v, use_region_corridor);
+	return CYapfRail1::stBenchmarkChooseRailTrack(v, use_region_corridor);
+}
+
 bool YapfTrainCheckReverse(const Train *v)
 {
 	const Train *last_veh = v->Last();
@@ -858,10 +922,32 @@ bool YapfTrainFindNearestSafeTile(const Train *v, TileIndex tile, Trackdir td, b
 
 /** if any track changes, this counter is incremented - that will invalidate segment cost cache */
 int CSegmentCostCacheBase::s_rail_change_counter = 0;
+YapfSegmentCostCacheStats CSegmentCostCacheBase::s_stats;
+std::vector<CSegmentCostCacheBase *> CSegmentCostCacheBase::s_caches;
 
 void YapfNotifyTrackLayoutChange(TileIndex tile, Track track)
 {
 	CSegmentCostCacheBase::NotifyTrackLayoutChange(tile, track);
+	if (tile == INVALID_TILE) {
+		InvalidateAllRailRegions();
+	} else {
+		InvalidateRailRegion(tile);
+	}
+}
+
+const YapfSegmentCostCacheStats &YapfGetSegmentCostCacheStats()
+{
+	return CSegmentCostCacheBase::s_stats;
+}
+
+void YapfResetSegmentCostCacheStats()
+{
+	CSegmentCostCacheBase::s_stats = {};
+}
+
+size_t YapfGetSegmentCostCacheSize()
+{
+	return CSegmentCostCacheBase::GetTotalCachedSegments();
 }
 
 void YapfCheckRailSignalPenalties()
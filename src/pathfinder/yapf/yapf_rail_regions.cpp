@@ -0,0 +1,294 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file yapf_rail_regions.cpp Implementation of YAPF for rail regions, which are used for restricting long distance train searches to a corridor. */
+
+#include "../../stdafx.h"
+#include "../../train.h"
+#include "../../core/math_func.hpp"
+
+#include "yapf.hpp"
+#include "yapf_rail_regions.h"
+#include "../rail_regions.h"
+
+#include "../../safeguards.h"
+
+constexpr int RAIL_REGION_NEIGHBOUR_COST = 100;
+constexpr int RAIL_NODES_PER_REGION = 4;
+constexpr uint32_t MAX_NUMBER_OF_RAIL_REGION_NODES = 1 << 18;
+
+/** Minimum distance in regions between the start and every destination, below which the detailed search is not restricted to a corridor. */
+constexpr uint RAIL_REGION_CORRIDOR_MIN_DISTANCE = 8;
+
+/** Yapf Node Key that represents a single patch of connected track within a rail region. */
+struct CYapfRailRegionPatchNodeKey {
+	RailRegionPatchDesc m_rail_region_patch;
+
+	inline void Set(const RailRegionPatchDesc &rail_region_patch)
+	{
+		m_rail_region_patch = rail_region_patch;
+	}
+
+	inline uint32_t CalcHash() const { return CalculateRailRegionPatchHash(m_rail_region_patch); }
+	inline bool operator==(const CYapfRailRegionPatchNodeKey &other) const { return CalcHash() == other.CalcHash(); }
+};
+
+static inline uint RailRegionManhattanDistance(const RailRegionPatchDesc &a, const RailRegionPatchDesc &b)
+{
+	return Delta(a.x, b.x) + Delta(a.y, b.y);
+}
+
+/** Yapf Node for rail regions. */
+template <class Tkey_>
+struct CYapfRailRegionNodeT {
+	typedef Tkey_ Key;
+	typedef CYapfRailRegionNodeT<Tkey_> Node;
+
+	Tkey_       m_key;
+	Node       *m_hash_next;
+	Node       *m_parent;
+	int         m_cost;
+	int         m_estimate;
+
+	inline void Set(Node *parent, const RailRegionPatchDesc &rail_region_patch)
+	{
+		m_key.Set(rail_region_patch);
+		m_hash_next = nullptr;
+		m_parent = parent;
+		m_cost = 0;
+		m_estimate = 0;
+	}
+
+	inline void Set(Node *parent, const Key &key)
+	{
+		Set(parent, key.m_rail_region_patch);
+	}
+
+	inline Node *GetHashNext() { return m_hash_next; }
+	inline void SetHashNext(Node *pNext) { m_hash_next = pNext; }
+	inline const Tkey_ &GetKey() const { return m_key; }
+	inline int GetCost() { return m_cost; }
+	inline int GetCostEstimate() { return m_estimate; }
+	inline bool operator<(const Node &other) const { return m_estimate < other.m_estimate; }
+};
+
+/** YAPF origin for rail regions. */
+template <class Types>
+class CYapfOriginRailRegionT
+{
+public:
+	typedef typename Types::Tpf Tpf;              ///< The pathfinder class (derived from THIS class).
+	typedef typename Types::NodeList::Titem Node; ///< This will be our node type.
+	typedef typename Node::Key Key;               ///< Key to hash tables.
+
+protected:
+	inline Tpf &Yapf() { return *static_cast<Tpf*>(this); }
+
+private:
+	std::vector<CYapfRailRegionPatchNodeKey> m_origin_keys;
+
+public:
+	void AddOrigin(const RailRegionPatchDesc &rail_region_patch)
+	{
+		if (rail_region_patch.label == INVALID_RAIL_REGION_PATCH) return;
+		if (!HasOrigin(rail_region_patch)) m_origin_keys.push_back(CYapfRailRegionPatchNodeKey{ rail_region_patch });
+	}
+
+	bool HasOrigin(const RailRegionPatchDesc &rail_region_patch)
+	{
+		return std::find(m_origin_keys.begin(), m_origin_keys.end(), CYapfRailRegionPatchNodeKey{ rail_region_patch }) != m_origin_keys.end();
+	}
+
+	bool HasAnyOrigin() const
+	{
+		return !m_origin_keys.empty();
+	}
+
+	void PfSetStartupNodes()
+	{
+		for (const CYapfRailRegionPatchNodeKey &origin_key : m_origin_keys) {
+			Node &node = Yapf().CreateNewNode();
+			node.Set(nullptr, origin_key);
+			Yapf().AddStartupNode(node);
+		}
+	}
+};
+
+/** YAPF destination provider for rail regions. */
+template <class Types>
+class CYapfDestinationRailRegionT
+{
+public:
+	typedef typename Types::Tpf Tpf;              ///< The pathfinder class (derived from THIS class).
+	typedef typename Types::NodeList::Titem Node; ///< This will be our node type.
+	typedef typename Node::Key Key;               ///< Key to hash tables.
+
+protected:
+	Key m_dest;
+
+public:
+	void SetDestination(const RailRegionPatchDesc &rail_region_patch)
+	{
+		m_dest.Set(rail_region_patch);
+	}
+
+protected:
+	Tpf &Yapf() { return *static_cast<Tpf*>(this); }
+
+public:
+	inline bool PfDetectDestination(Node &n) const
+	{
+		return n.m_key == m_dest;
+	}
+
+	inline bool PfCalcEstimate(Node &n)
+	{
+		if (PfDetectDestination(n)) {
+			n.m_estimate = n.m_cost;
+			return true;
+		}
+
+		n.m_estimate = n.m_cost + RailRegionManhattanDistance(n.m_key.m_rail_region_patch, m_dest.m_rail_region_patch) * RAIL_REGION_NEIGHBOUR_COST;
+
+		return true;
+	}
+};
+
+/** YAPF node following for rail region pathfinding. */
+template <class Types>
+class CYapfFollowRailRegionT
+{
+public:
+	typedef typename Types::Tpf Tpf;                     ///< The pathfinder class (derived from THIS class).
+	typedef typename Types::TrackFollower TrackFollower;
+	typedef typename Types::NodeList::Titem Node;        ///< This will be our node type.
+	typedef typename Node::Key Key;                      ///< Key to hash tables.
+
+protected:
+	inline Tpf &Yapf() { return *static_cast<Tpf*>(this); }
+
+public:
+	inline void PfFollowNode(Node &old_node)
+	{
+		TVisitRailRegionPatchCallBack visitFunc = [&](const RailRegionPatchDesc &rail_region_patch)
+		{
+			Node &node = Yapf().CreateNewNode();
+			node.Set(&old_node, rail_region_patch);
+			Yapf().AddNewNode(node, TrackFollower{});
+		};
+		VisitRailRegionPatchNeighbors(old_node.m_key.m_rail_region_patch, visitFunc);
+	}
+
+	inline char TransportTypeChar() const { return '='; }
+
+	static std::vector<TRailRegionIndex> FindRailRegionCorridor(const Train *v, TileIndex start_tile, const std::vector<TileIndex> &dest_tiles)
+	{
+		const RailRegionPatchDesc start_rail_region_patch = GetRailRegionPatchInfo(start_tile);
+		if (start_rail_region_patch.label == INVALID_RAIL_REGION_PATCH) return {};
+
+		/* As for water regions, this is a generous limit, a region rarely contains more than a few separate patches of track. */
+		Tpf pf(std::min(static_cast<uint32_t>(MapSize() * RAIL_NODES_PER_REGION) / RAIL_REGION_NUMBER_OF_TILES, MAX_NUMBER_OF_RAIL_REGION_NODES));
+		pf.SetDestination(start_rail_region_patch);
+
+		/* The search runs from the destinations to the start, so that multiple destination tiles can be handled as multiple origins. */
+		bool is_near = false;
+		for (TileIndex tile : dest_tiles) {
+			const RailRegionPatchDesc patch = GetRailRegionPatchInfo(tile);
+			if (RailRegionManhattanDistance(patch, start_rail_region_patch) < RAIL_REGION_CORRIDOR_MIN_DISTANCE) is_near = true;
+			pf.AddOrigin(patch);
+		}
+		if (is_near || !pf.HasAnyOrigin()) return {};
+
+		if (!pf.FindPath(v)) return {};
+
+		/* The corridor is the regions along the path, and those adjacent to them. */
+		std::vector<TRailRegionIndex> corridor;
+		const uint32_t size_x = GetRailRegionMapSizeX();
+		const uint32_t size_y = GetRailRegionMapSizeY();
+		for (Node *node = pf.GetBestNode(); node != nullptr; node = node->m_parent) {
+			const RailRegionPatchDesc &patch = node->m_key.m_rail_region_patch;
+			for (uint32_t y = std::max<uint32_t>(patch.y, 1) - 1; y <= std::min(patch.y + 1, size_y - 1); y++) {
+				for (uint32_t x = std::max<uint32_t>(patch.x, 1) - 1; x <= std::min(patch.x + 1, size_x - 1); x++) {
+					corridor.push_back(GetRailRegionIndex(x, y));
+				}
+			}
+		}
+		std::sort(corridor.begin(), corridor.end());
+		corridor.erase(std::unique(corridor.begin(), corridor.end()), corridor.end());
+		return corridor;
+	}
+};
+
+/** Cost Provider of YAPF for rail regions. */
+template <class Types>
+class CYapfCostRailRegionT
+{
+public:
+	typedef typename Types::Tpf Tpf;              ///< The pathfinder class (derived from THIS class).
+	typedef typename Types::TrackFollower TrackFollower;
+	typedef typename Types::NodeList::Titem Node; ///< This will be our node type.
+	typedef typename Node::Key Key;               ///< Key to hash tables.
+
+protected:
+	/** To access inherited path finder. */
+	Tpf &Yapf() { return *static_cast<Tpf*>(this); }
+
+public:
+	/**
+	 * Called by YAPF to calculate the cost from the origin to the given node.
+	 * The cost is the distance in regions, tunnels and bridges may span several regions.
+	 */
+	inline bool PfCalcCost(Node &n, const TrackFollower *)
+	{
+		n.m_cost = n.m_parent->m_cost + RailRegionManhattanDistance(n.m_key.m_rail_region_patch, n.m_parent->m_key.m_rail_region_patch) * RAIL_REGION_NEIGHBOUR_COST;
+		return true;
+	}
+};
+
+/* We don't need a follower but YAPF requires one. */
+struct CRailRegionDummyFollower {};
+
+/**
+ * Config struct of YAPF for rail region route planning.
+ * Defines all 6 base YAPF modules as classes providing services for CYapfBaseT.
+ */
+template <class Tpf_, class Tnode_list>
+struct CYapfRailRegion_TypesT
+{
+	typedef CYapfRailRegion_TypesT<Tpf_, Tnode_list> Types;         ///< Shortcut for this struct type.
+	typedef Tpf_                                     Tpf;           ///< Pathfinder type.
+	typedef CRailRegionDummyFollower                 TrackFollower; ///< Track follower helper class
+	typedef Tnode_list                               NodeList;
+	typedef Train                                    VehicleType;
+
+	/** Pathfinder components (modules). */
+	typedef CYapfBaseT<Types>                 PfBase;        ///< Base pathfinder class.
+	typedef CYapfFollowRailRegionT<Types>     PfFollow;      ///< Node follower.
+	typedef CYapfOriginRailRegionT<Types>     PfOrigin;      ///< Origin provider.
+	typedef CYapfDestinationRailRegionT<Types> PfDestination; ///< Destination/distance provider.
+	typedef CYapfSegmentCostCacheNoneT<Types> PfCache;       ///< Segment cost cache provider.
+	typedef CYapfCostRailRegionT<Types>       PfCost;        ///< Cost provider.
+};
+
+typedef CNodeList_HashTableT<CYapfRailRegionNodeT<CYapfRailRegionPatchNodeKey>, 12, 12> CRailRegionNodeList;
+
+struct CYapfRailRegion : CYapfT<CYapfRailRegion_TypesT<CYapfRailRegion, CRailRegionNodeList>>
+{
+	explicit CYapfRailRegion(int max_nodes) { m_max_search_nodes = max_nodes; }
+};
+
+/**
+ * Finds a corridor of rail regions between the start tile and any of the destination tiles, to which the detailed train pathfinder can be restricted.
+ * @param v The train to find a path for.
+ * @param start_tile The tile to start searching from.
+ * @param dest_tiles The destination tiles.
+ * @returns The sorted indices of the regions in the corridor, or an empty vector if the search should not be restricted.
+ */
+std::vector<TRailRegionIndex> YapfTrainFindRailRegionCorridor(const Train *v, TileIndex start_tile, const std::vector<TileIndex> &dest_tiles)
+{
+	return CYapfRailRegion::FindRailRegionCorridor(v, start_tile, dest_tiles);
+}
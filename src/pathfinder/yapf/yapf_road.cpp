@@ -26,6 +26,19 @@ const uint MAX_RV_PF_TILES = 1 << 11;
 
 const int MAX_RV_LEADER_TARGETS = 4;
 
+typedef CSegmentCostCacheT<CYapfRoadSegment> CRoadSegmentCostCache;
+
+/**
+ * Get the global road segment cost cache, this is shared by all road pathfinder types.
+ * @return The cache, flushed if necessary.
+ */
+static CRoadSegmentCostCache &GetGlobalRoadSegmentCostCache()
+{
+	static CRoadSegmentCostCache cache;
+	cache.FlushIfChanged();
+	return cache;
+}
+
 template <class Types>
 class CYapfCostRoadT
 {
@@ -37,8 +50,11 @@ public:
 
 protected:
 	int m_max_cost;
+	bool m_disable_cache = false; ///< Don't use or add to the global segment cost cache, see DisableCache
+	CRoadSegmentCostCache &m_global_cache;
+	std::vector<uint32_t> m_segment_regions; ///< Map regions which the segment currently being calculated depends on, see CSegmentCostCacheBase.
 
-	CYapfCostRoadT() : m_max_cost(0) {};
+	CYapfCostRoadT() : m_max_cost(0), m_global_cache(GetGlobalRoadSegmentCostCache()) {};
 
 	/** to access inherited path finder */
 	Tpf &Yapf()
@@ -134,12 +150,42 @@ protected:
 		return cost;
 	}
 
+	/** return the speed limit penalty of one step */
+	static inline int SpeedLimitCost(int max_veh_speed, int max_speed, int min_speed, int tiles_skipped)
+	{
+		int cost = 0;
+		if (max_speed < max_veh_speed) cost += YAPF_TILE_LENGTH * (max_veh_speed - max_speed) * (4 + tiles_skipped) / max_veh_speed;
+		if (min_speed > max_veh_speed) cost += YAPF_TILE_LENGTH * (min_speed - max_veh_speed);
+		return cost;
+	}
+
+	/**
+	 * Check whether a cached segment can be used for this vehicle.
+	 * The walk along the segment and its cost depend on the vehicle only if the segment contains the destination or the target of a vehicle in front.
+	 */
+	inline bool CanUseCachedSegment(const CYapfRoadSegment &segment)
+	{
+		for (int i = 0; i < MAX_RV_LEADER_TARGETS && Yapf().leader_targets[i] != INVALID_TILE; ++i) {
+			if (segment.Contains(Yapf().leader_targets[i])) return false;
+		}
+		return !Yapf().PfDestinationMayBeInSegment(segment);
+	}
+
 public:
 	inline void SetMaxCost(int max_cost)
 	{
 		m_max_cost = max_cost;
 	}
 
+	/**
+	 * Disable the use of the global segment cost cache, this is used to check that the cached segments give the same results.
+	 * @param disable Whether to disable the cache.
+	 */
+	void DisableCache(bool disable)
+	{
+		m_disable_cache = disable;
+	}
+
 	/**
 	 * Called by YAPF to calculate the cost from the origin to the given node.
 	 *  Calculates only the cost of given node, adds it to the parent node cost
@@ -149,7 +195,8 @@ public:
 	{
 		/* this is to handle the case where the starting tile is a junction custom bridge head,
 		 * and we have advanced across the bridge in the initial step */
-		int segment_cost = tf->m_tiles_skipped * YAPF_TILE_LENGTH;
+		const int entry_cost = tf->m_tiles_skipped * YAPF_TILE_LENGTH;
+		int segment_cost = entry_cost;
 
 		uint tiles = 0;
 		/* start at n.m_key.m_tile / n.m_key.m_td and walk to the end of segment */
@@ -157,11 +204,80 @@ public:
 		Trackdir trackdir = n.m_key.m_td;
 		int parent_cost = (n.m_parent != nullptr) ? n.m_parent->m_cost : 0;
 
+		const RoadVehicle *v = Yapf().GetVehicle();
+		const int max_veh_speed = std::min<int>(v->GetDisplayMaxSpeed(), v->current_order.GetMaxSpeed() * 2);
+
+		/* Use the vehicle independent cost of the segment if it is cached */
+		CYapfRoadSegmentKey key(tile, trackdir, GetRoadTramType(v->roadtype), v->compatible_roadtypes);
+		bool found;
+		CYapfRoadSegment uncached_segment(key);
+		CYapfRoadSegment &segment = m_disable_cache ? uncached_segment : m_global_cache.Get(key, &found);
+		if (segment.m_cost >= 0 && CanUseCachedSegment(segment)) {
+			int cost = segment_cost + segment.m_cost;
+			for (uint i = 0; i < segment.m_num_speed_limits; i++) {
+				const CYapfRoadSegmentSpeedLimit &limit = segment.m_speed_limits[i];
+				cost += limit.m_count * SpeedLimitCost(max_veh_speed, limit.m_max_speed, limit.m_min_speed, limit.m_tiles_skipped);
+			}
+			/* If the maximum cost is exceeded, the walk is needed to find whether it is exceeded before the end of the segment */
+			if (m_max_cost == 0 || parent_cost + cost <= m_max_cost) {
+				CSegmentCostCacheBase::s_stats.road_hits++;
+				if (segment.m_loop) return false;
+				n.m_segment_last_tile = segment.m_last_tile;
+				n.m_segment_last_td = segment.m_last_td;
+				n.m_cost = parent_cost + cost;
+				return true;
+			}
+		}
+		if (!m_disable_cache) CSegmentCostCacheBase::s_stats.road_misses++;
+
+		/* Record the vehicle independent parts of the segment whilst walking it, if it isn't yet cached */
+		const bool record = !m_disable_cache && segment.m_cost < 0 && !segment.m_uncacheable;
+		bool uncacheable = false;
+		int speed_limit_cost = 0;
+		if (record) {
+			segment.m_num_speed_limits = 0;
+			segment.m_min_x = segment.m_max_x = TileX(tile);
+			segment.m_min_y = segment.m_max_y = TileY(tile);
+			m_segment_regions.clear();
+		}
+		auto record_tiles = [&](TileIndex from, TileIndex to) {
+			segment.m_min_x = std::min({ segment.m_min_x, TileX(from), TileX(to) });
+			segment.m_max_x = std::max({ segment.m_max_x, TileX(from), TileX(to) });
+			segment.m_min_y = std::min({ segment.m_min_y, TileY(from), TileY(to) });
+			segment.m_max_y = std::max({ segment.m_max_y, TileY(from), TileY(to) });
+			CSegmentCostCacheBase::AddRegions(m_segment_regions, from, to);
+		};
+		auto store_segment = [&](bool loop) {
+			if (!record) return;
+			record_tiles(tile, tile);
+			/* The walk must not have been affected by the destination or by vehicles in front */
+			if (uncacheable || !CanUseCachedSegment(segment)) {
+				segment.m_uncacheable = uncacheable;
+				return;
+			}
+			segment.m_cost = segment_cost - entry_cost - speed_limit_cost;
+			segment.m_loop = loop;
+			segment.m_last_tile = tile;
+			segment.m_last_td = trackdir;
+			m_global_cache.SetRegions(segment, m_segment_regions);
+		};
+
 		for (;;) {
+			if (record) {
+				record_tiles(tile, tile);
+
+				/* Road stops and depots have vehicle dependent costs, and can't be entered by all vehicles.
+				 * The next tile is checked too, as whether it can be entered determines where the segment ends. */
+				TileIndex next_tile = AddTileIndexDiffCWrap(tile, TileIndexDiffCByDiagDir(TrackdirToExitdir(trackdir)));
+				if (IsTileType(tile, MP_STATION) || IsRoadDepotTile(tile) ||
+						(next_tile != INVALID_TILE && (IsTileType(next_tile, MP_STATION) || IsRoadDepotTile(next_tile)))) {
+					uncacheable = true;
+				}
+			}
+
 			/* base tile cost depending on distance between edges */
 			segment_cost += Yapf().OneTileCost(tile, trackdir, tf);
 
-			const RoadVehicle *v = Yapf().GetVehicle();
 			/* we have reached the vehicle's destination - segment should end here to avoid target skipping */
 			if (Yapf().PfDetectDestinationTile(tile, trackdir)) break;
 
@@ -179,30 +295,58 @@ public:
 
 			/* if there are no reachable trackdirs on new tile, we have end of road */
 			TrackFollower F(Yapf().GetVehicle());
-			if (!F.Follow(tile, trackdir)) break;
+			if (!F.Follow(tile, trackdir)) {
+				if (record && F.m_new_tile != INVALID_TILE) record_tiles(F.m_new_tile, F.m_new_tile);
+				break;
+			}
 
 			/* if we skipped some tunnel tiles, add their cost */
 			/* with custom bridge heads, this cost must be added before checking if the segment has ended */
 			segment_cost += F.m_tiles_skipped * YAPF_TILE_LENGTH;
 			tiles += F.m_tiles_skipped + 1;
+			if (record && F.m_tiles_skipped > 0) record_tiles(tile, F.m_new_tile);
 
 			/* if there are more trackdirs available & reachable, we are at the end of segment */
-			if (KillFirstBit(F.m_new_td_bits) != TRACKDIR_BIT_NONE) break;
+			if (KillFirstBit(F.m_new_td_bits) != TRACKDIR_BIT_NONE) {
+				if (record) record_tiles(F.m_new_tile, F.m_new_tile);
+				break;
+			}
 
 			Trackdir new_td = (Trackdir)FindFirstBit(F.m_new_td_bits);
 
 			/* stop if RV is on simple loop with no junctions */
-			if (F.m_new_tile == n.m_key.m_tile && new_td == n.m_key.m_td) return false;
+			if (F.m_new_tile == n.m_key.m_tile && new_td == n.m_key.m_td) {
+				store_segment(true);
+				return false;
+			}
 
 			/* add hilly terrain penalty */
 			segment_cost += Yapf().SlopeCost(tile, F.m_new_tile, trackdir);
 
 			/* add min/max speed penalties */
 			int min_speed = 0;
-			int max_veh_speed = std::min<int>(v->GetDisplayMaxSpeed(), v->current_order.GetMaxSpeed() * 2);
 			int max_speed = F.GetSpeedLimit(&min_speed);
-			if (max_speed < max_veh_speed) segment_cost += YAPF_TILE_LENGTH * (max_veh_speed - max_speed) * (4 + F.m_tiles_skipped) / max_veh_speed;
-			if (min_speed > max_veh_speed) segment_cost += YAPF_TILE_LENGTH * (min_speed - max_veh_speed);
+			int step_speed_limit_cost = SpeedLimitCost(max_veh_speed, max_speed, min_speed, F.m_tiles_skipped);
+			segment_cost += step_speed_limit_cost;
+			if (record && (max_speed != INT_MAX || min_speed != 0)) {
+				speed_limit_cost += step_speed_limit_cost;
+				uint i = 0;
+				for (; i < segment.m_num_speed_limits; i++) {
+					CYapfRoadSegmentSpeedLimit &limit = segment.m_speed_limits[i];
+					if (limit.m_max_speed == max_speed && limit.m_min_speed == min_speed && limit.m_tiles_skipped == F.m_tiles_skipped) {
+						limit.m_count++;
+						break;
+					}
+				}
+				if (i == segment.m_num_speed_limits) {
+					if (i < CYapfRoadSegment::MAX_SPEED_LIMITS) {
+						segment.m_speed_limits[i] = { max_speed, min_speed, static_cast<uint16_t>(F.m_tiles_skipped), 1 };
+						segment.m_num_speed_limits++;
+					} else {
+						uncacheable = true;
+					}
+				}
+			}
 
 			/* move to the next tile */
 			tile = F.m_new_tile;
@@ -210,6 +354,8 @@ public:
 			if (tiles > MAX_RV_PF_TILES) break;
 		}
 
+		store_segment(false);
+
 		/* save end of segment back to the node */
 		n.m_segment_last_tile = tile;
 		n.m_segment_last_td = trackdir;
@@ -247,6 +393,12 @@ public:
 		return IsRoadDepotTile(tile);
 	}
 
+	/** Called by YAPF to check whether the destination may be within a cached segment, which never contains depots */
+	inline bool PfDestinationMayBeInSegment(const CYapfRoadSegment &)
+	{
+		return false;
+	}
+
 	/**
 	 * Called by YAPF to calculate cost estimate. Calculates distance to the destination
 	 *  adds it to the actual cost from origin and stores the sum to the Node::m_estimate
@@ -334,6 +486,12 @@ public:
 		return tile == m_destTile && HasTrackdir(m_destTrackdirs, trackdir);
 	}
 
+	/** Called by YAPF to check whether the destination may be within a cached segment, which never contains road stops */
+	inline bool PfDestinationMayBeInSegment(const CYapfRoadSegment &segment)
+	{
+		return m_dest_station == INVALID_STATION && segment.Contains(m_destTile);
+	}
+
 	/**
 	 * Called by YAPF to calculate cost estimate. Calculates distance to the destination
 	 *  adds it to the actual cost from origin and stores the sum to the Node::m_estimate
@@ -438,8 +596,36 @@ public:
 
 	static Trackdir stChooseRoadTrack(const RoadVehicle *v, TileIndex tile, DiagDirection enterdir, bool &path_found, RoadVehPathCache &path_cache)
 	{
-		Tpf pf;
-		return pf.ChooseRoadTrack(v, tile, enterdir, path_found, path_cache);
+		Tpf pf1;
+		if (_debug_yapfdesync_level < 1 && _debug_desync_level < 2) {
+			return pf1.ChooseRoadTrack(v, tile, enterdir, path_found, path_cache);
+		}
+
+		/* Check that the cached segment costs give the same result as an uncached search, the result of which is used */
+		bool path_found1;
+		RoadVehPathCache path_cache1 = path_cache;
+		Trackdir result1 = pf1.ChooseRoadTrack(v, tile, enterdir, path_found1, path_cache1);
+		Tpf pf2;
+		pf2.DisableCache(true);
+		Trackdir result2 = pf2.ChooseRoadTrack(v, tile, enterdir, path_found, path_cache);
+
+		auto same_path_cache = [&]() -> bool {
+			if (path_cache1.size() != path_cache.size()) return false;
+			for (uint i = 0; i < path_cache.size(); i++) {
+				const uint index1 = (path_cache1.start + i) & RV_PATH_CACHE_SEGMENT_MASK;
+				const uint index2 = (path_cache.start + i) & RV_PATH_CACHE_SEGMENT_MASK;
+				if (path_cache1.tile[index1] != path_cache.tile[index2] || path_cache1.td[index1] != path_cache.td[index2]) return false;
+			}
+			return true;
+		};
+		if (result1 != result2 || path_found1 != path_found) {
+			DEBUG(desync, 0, "CACHE ERROR: ChooseRoadTrack() = [%d, %d], path found = [%s, %s], vehicle: %u, tile: 0x%X",
+					result1, result2, path_found1 ? "T" : "F", path_found ? "T" : "F", v->index, tile);
+		} else if (!same_path_cache()) {
+			DEBUG(desync, 0, "CACHE ERROR: ChooseRoadTrack() path cache mismatch, length = [%u, %u], vehicle: %u, tile: 0x%X",
+					path_cache1.size(), path_cache.size(), v->index, tile);
+		}
+		return result2;
 	}
 
 	inline Trackdir ChooseRoadTrack(const RoadVehicle *v, TileIndex tile, DiagDirection enterdir, bool &path_found, RoadVehPathCache &path_cache)
@@ -571,8 +757,21 @@ public:
 
 	static FindDepotData stFindNearestDepot(const RoadVehicle *v, TileIndex tile, Trackdir td, int max_distance)
 	{
-		Tpf pf;
-		return pf.FindNearestDepot(v, tile, td, max_distance);
+		Tpf pf1;
+		FindDepotData result1 = pf1.FindNearestDepot(v, tile, td, max_distance);
+
+		if (_debug_yapfdesync_level > 0 || _debug_desync_level >= 2) {
+			Tpf pf2;
+			pf2.DisableCache(true);
+			FindDepotData result2 = pf2.FindNearestDepot(v, tile, td, max_distance);
+			if (result1.tile != result2.tile || result1.best_length != result2.best_length) {
+				DEBUG(desync, 0, "CACHE ERROR: FindNearestDepot() = [(0x%X, %u), (0x%X, %u)], vehicle: %u",
+						result1.tile, result1.best_length, result2.tile, result2.best_length, v->index);
+			}
+			return result2;
+		}
+
+		return result1;
 	}
 
 	/**
@@ -616,7 +815,7 @@ struct CYapfRoad_TypesT
 
 template <class Types>
 struct CYapfRoadCommon : CYapfT<Types> {
-	TileIndex leader_targets[MAX_RV_LEADER_TARGETS]; ///< the tiles targeted by vehicles in front of the current vehicle
+	TileIndex leader_targets[MAX_RV_LEADER_TARGETS] = { INVALID_TILE }; ///< the tiles targeted by vehicles in front of the current vehicle
 };
 
 struct CYapfRoad1         : CYapfRoadCommon<CYapfRoad_TypesT<CYapfRoad1        , CRoadNodeListTrackDir, CYapfDestinationTileRoadT    > > {};
@@ -661,3 +860,8 @@ FindDepotData YapfRoadVehicleFindNearestDepot(const RoadVehicle *v, int max_dist
 
 	return pfnFindNearestDepot(v, tile, trackdir, max_distance);
 }
+
+void YapfNotifyRoadLayoutChange(TileIndex tile)
+{
+	CSegmentCostCacheBase::NotifyTrackLayoutChange(tile, INVALID_TRACK);
+}
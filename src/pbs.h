@@ -71,6 +71,8 @@ struct TrainReservationLookAheadItem {
 	uint16_t data_aux;
 	TrainReservationLookAheadItemType type;
 	/* gap: 1 byte */
+
+	bool operator==(const TrainReservationLookAheadItem &) const = default;
 };
 
 struct TrainReservationLookAheadCurve {
@@ -14,6 +14,8 @@
 #include "fileio_func.h"
 #include "string_func.h"
 
+#include <sys/stat.h>
+
 #include "safeguards.h"
 
 /**
@@ -21,9 +23,16 @@
  * @param filename Name of the file at the disk.
  * @param subdir   The sub directory to search this file in.
  */
-RandomAccessFile::RandomAccessFile(const std::string &filename, Subdirectory subdir) : filename(filename)
+RandomAccessFile::RandomAccessFile(const std::string &filename, Subdirectory subdir) : RandomAccessFile(filename, FioFOpenFile(filename, "rb", subdir)) {}
+
+/**
+ * Create the RandomAccesFile from an already opened file.
+ * This allows callers which can't use usererror, such as worker threads, to handle failure to open the file themselves.
+ * @param filename    Name of the file at the disk.
+ * @param file_handle File handle of the opened file, at the begin of the file, this takes ownership of it.
+ */
+RandomAccessFile::RandomAccessFile(const std::string &filename, FILE *file_handle) : filename(filename), file_handle(file_handle)
 {
-	this->file_handle = FioFOpenFile(filename, "rb", subdir);
 	if (this->file_handle == nullptr) usererror("Cannot open file '%s'", filename.c_str());
 
 	/* When files are in a tar-file, the begin of the file might not be at 0. */
@@ -66,6 +75,26 @@ const std::string &RandomAccessFile::GetSimplifiedFilename() const
 	return this->simplified_filename;
 }
 
+/**
+ * Get the size and last modification time of the opened file, to detect when the file on disk has been changed.
+ * @param[out] size Size of the file.
+ * @param[out] mtime Last modification time of the file.
+ * @return True if these could be determined.
+ */
+bool RandomAccessFile::GetFileStatus(uint64_t &size, int64_t &mtime) const
+{
+#ifdef _WIN32
+	struct _stat64 st;
+	if (_fstat64(_fileno(this->file_handle), &st) != 0) return false;
+#else
+	struct stat st;
+	if (fstat(fileno(this->file_handle), &st) != 0) return false;
+#endif
+	size = st.st_size;
+	mtime = st.st_mtime;
+	return true;
+}
+
 /**
  * Get position in the file.
  * @return Position in the file.
@@ -41,6 +41,7 @@ class RandomAccessFile {
 
 public:
 	RandomAccessFile(const std::string &filename, Subdirectory subdir);
+	RandomAccessFile(const std::string &filename, FILE *file_handle);
 	RandomAccessFile(const RandomAccessFile&) = delete;
 	void operator=(const RandomAccessFile&) = delete;
 
@@ -48,6 +49,7 @@ public:
 
 	const std::string &GetFilename() const;
 	const std::string &GetSimplifiedFilename() const;
+	bool GetFileStatus(uint64_t &size, int64_t &mtime) const;
 
 	size_t GetPos() const;
 	void SeekTo(size_t pos, int mode);
@@ -254,6 +254,8 @@ bool _mark_tile_dirty_on_road_cache_one_way_state_update = false;
 
 static void RefreshTileOnCachedOneWayStateChange(TileIndex tile)
 {
+	YapfNotifyRoadLayoutChange(tile);
+
 	if (IsAnyRoadStopTile(tile) && IsCustomRoadStopSpecIndex(tile)) {
 		MarkTileGroundDirtyByTile(tile, VMDF_NOT_MAP_MODE);
 		return;
@@ -412,6 +414,7 @@ static void InterpolateRoadCachedOneWayStates()
 
 void RecalculateRoadCachedOneWayStates()
 {
+	YapfNotifyRoadLayoutChange(INVALID_TILE);
 	for (TileIndex tile = 0; tile != MapSize(); tile++) {
 		if (MayHaveRoad(tile)) UpdateTileRoadCachedOneWayState(tile);
 	}
@@ -422,6 +425,8 @@ void UpdateRoadCachedOneWayStatesAroundTile(TileIndex tile)
 {
 	if (_generating_world) return;
 
+	YapfNotifyRoadLayoutChange(tile);
+
 	auto check_tile = [](TileIndex t) {
 		if (_defer_update_road_cache_one_way_state) {
 			_road_cache_one_way_state_pending_tiles.insert(t);
@@ -1783,6 +1788,7 @@ CommandCost CmdBuildRoadDepot(TileIndex tile, DoCommandFlag flags, uint32_t p1,
 		MakeDefaultName(dep);
 
 		NotifyRoadLayoutChanged(true);
+		YapfNotifyRoadLayoutChange(tile);
 	}
 	cost.AddCost(_price[PR_BUILD_DEPOT_ROAD]);
 	return cost;
@@ -1812,6 +1818,7 @@ static CommandCost RemoveRoadDepot(TileIndex tile, DoCommandFlag flags)
 		DoClearSquare(tile);
 
 		NotifyRoadLayoutChanged(false);
+		YapfNotifyRoadLayoutChange(tile);
 		DeleteNewGRFInspectWindow(GSF_ROADTYPES, tile);
 	}
 
@@ -2613,6 +2620,7 @@ static void TileLoop_Road(TileIndex tile)
 					IsNormalRoad(tile) && !HasAtMostOneBit(GetAllRoadBits(tile))) {
 				if (std::get<0>(GetFoundationSlope(tile)) == SLOPE_FLAT && EnsureNoVehicleOnGround(tile).Succeeded() && Chance16(1, 40)) {
 					StartRoadWorks(tile);
+					YapfNotifyRoadLayoutChange(tile);
 
 					if (_settings_client.sound.ambient) SndPlayTileFx(SND_21_ROAD_WORKS, tile);
 					CreateEffectVehicleAbove(
@@ -2649,6 +2657,7 @@ static void TileLoop_Road(TileIndex tile)
 		}
 	} else if (IncreaseRoadWorksCounter(tile)) {
 		TerminateRoadWorks(tile);
+		YapfNotifyRoadLayoutChange(tile);
 
 		if (_settings_game.economy.mod_road_rebuild) {
 			/* Generate a nicer town surface */
@@ -3191,6 +3200,7 @@ CommandCost CmdConvertRoad(TileIndex tile, DoCommandFlag flags, uint32_t p1, uin
 				/* Perform the conversion */
 				SetRoadType(tile, rtt, to_type);
 				MarkTileDirtyByTile(tile);
+				YapfNotifyRoadLayoutChange(tile);
 
 				/* update power of train on this tile */
 				FindVehicleOnPos(tile, VEH_ROAD, &affected_rvs, &UpdateRoadVehPowerProc);
@@ -3277,6 +3287,8 @@ CommandCost CmdConvertRoad(TileIndex tile, DoCommandFlag flags, uint32_t p1, uin
 				/* Perform the conversion */
 				SetRoadType(tile, rtt, to_type);
 				if (include_middle) SetRoadType(endtile, rtt, to_type);
+				YapfNotifyRoadLayoutChange(tile);
+				YapfNotifyRoadLayoutChange(endtile);
 
 				AddRoadTunnelBridgeInfrastructure(tile, endtile);
 
@@ -3320,4 +3332,5 @@ extern const TileTypeProcs _tile_type_road_procs = {
 	VehicleEnter_Road,       // vehicle_enter_tile_proc
 	GetFoundation_Road,      // get_foundation_proc
 	TerraformTile_Road,      // terraform_tile_proc
+	nullptr,                 // tile_loop_quiescent_proc
 };
@@ -364,6 +364,7 @@ static FindDepotData FindClosestRoadDepot(const RoadVehicle *v, int max_distance
 {
 	if (IsRoadDepotTile(v->tile)) return FindDepotData(v->tile, 0);
 
+	PerformanceZoneMeasurer framerate(PFZ_ROADVEH_PATHFINDER);
 	switch (_settings_game.pf.pathfinder_for_roadvehs) {
 		case VPF_NPF: return NPFRoadVehicleFindNearestDepot(v, max_distance);
 		case VPF_YAPF: return YapfRoadVehicleFindNearestDepot(v, max_distance);
@@ -1293,11 +1294,14 @@ static Trackdir RoadFindPathToDest(RoadVehicle *v, TileIndex tile, DiagDirection
 		}
 	}
 
-	switch (_settings_game.pf.pathfinder_for_roadvehs) {
-		case VPF_NPF:  best_track = NPFRoadVehicleChooseTrack(v, tile, enterdir, path_found); break;
-		case VPF_YAPF: best_track = YapfRoadVehicleChooseTrack(v, tile, enterdir, trackdirs, path_found, v->GetOrCreatePathCache()); break;
+	{
+		PerformanceZoneMeasurer framerate(PFZ_ROADVEH_PATHFINDER);
+		switch (_settings_game.pf.pathfinder_for_roadvehs) {
+			case VPF_NPF:  best_track = NPFRoadVehicleChooseTrack(v, tile, enterdir, path_found); break;
+			case VPF_YAPF: best_track = YapfRoadVehicleChooseTrack(v, tile, enterdir, trackdirs, path_found, v->GetOrCreatePathCache()); break;
 
-		default: NOT_REACHED();
+			default: NOT_REACHED();
+		}
 	}
 	DEBUG_UPDATESTATECHECKSUM("RoadFindPathToDest: v: %u, path_found: %d, best_track: %d", v->index, path_found, best_track);
 	UpdateStateChecksum((((uint64_t) v->index) << 32) | (path_found << 16) | best_track);
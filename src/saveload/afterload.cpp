@@ -4204,6 +4204,8 @@ bool AfterLoadGame()
 
 	if (SlXvIsFeatureMissing(XSLFI_ANIMATED_TILE_EXTRA)) {
 		UpdateAllAnimatedTileSpeeds();
+	} else {
+		RebuildAnimatedTileSpeedBuckets();
 	}
 
 	if (!SlXvIsFeaturePresent(XSLFI_REALISTIC_TRAIN_BRAKING, 2)) {
@@ -83,6 +83,7 @@
 #include "void_map.h"
 #include "station_base.h"
 #include "infrastructure_func.h"
+#include "worker_thread.h"
 
 #if defined(WITH_FREETYPE) || defined(_WIN32) || defined(WITH_COCOA)
 #define HAS_TRUETYPE_FONT
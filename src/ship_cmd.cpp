@@ -432,6 +432,7 @@ static bool CheckReverseShip(const Ship *v, Trackdir *trackdir = nullptr)
 {
 	/* Ask pathfinder for best direction */
 	bool reverse = false;
+	PerformanceZoneMeasurer framerate(PFZ_SHIP_PATHFINDER);
 	switch (_settings_game.pf.pathfinder_for_ships) {
 		case VPF_NPF: reverse = NPFShipCheckReverse(v, trackdir); break;
 		case VPF_YAPF: reverse = YapfShipCheckReverse(v, trackdir); break;
@@ -619,6 +620,7 @@ static Track ChooseShipTrack(Ship *v, TileIndex tile, DiagDirection enterdir, Tr
 			v->cached_path.clear();
 		}
 
+		PerformanceZoneMeasurer framerate(PFZ_SHIP_PATHFINDER);
 		switch (_settings_game.pf.pathfinder_for_ships) {
 			case VPF_NPF: track = NPFShipChooseTrack(v, path_found); break;
 			case VPF_YAPF: track = YapfShipChooseTrack(v, tile, enterdir, tracks, path_found, v->cached_path); break;
@@ -15,7 +15,7 @@
  * <li>use their description array (#SaveLoad) to know what elements to save and in what version
  *    of the game it was active (used when loading)
  * <li>write all data byte-by-byte to the temporary buffer so it is endian-safe
- * <li>when the buffer is full; flush it to the output (eg save to file) (_sl.buf, _sl.bufp, _sl.bufe)
+ * <li>when the buffer is full; flush it to the output (eg save to file) (_sl->buf, _sl->bufp, _sl->bufe)
  * <li>repeat this until everything is done, and flush any remaining output to file
  * </ol>
  */
@@ -47,6 +47,7 @@
 #include "../scope.h"
 #include "../core/ring_buffer.hpp"
 #include "../timer/timer_game_tick.h"
+#include "../worker_thread.h"
 #include <atomic>
 #include <string>
 #include <sys/stat.h>
@@ -156,7 +157,7 @@ void ReadBuffer::AcquireBytes()
 void MemoryDumper::FinaliseBlock()
 {
 	assert(this->saved_buf == nullptr);
-	if (!this->blocks.empty()) {
+	if (this->bufe != nullptr) {
 		size_t s = MEMORY_CHUNK_SIZE - (this->bufe - this->buf);
 		this->blocks.back().size = s;
 		this->completed_block_bytes += s;
@@ -181,6 +182,23 @@ void MemoryDumper::AllocateBuffer()
 	this->bufe = this->buf + MEMORY_CHUNK_SIZE;
 }
 
+/**
+ * Move all of the blocks written to another dumper onto the end of this dumper.
+ * @param other The dumper to take the blocks from.
+ */
+void MemoryDumper::AppendBlocks(MemoryDumper &other)
+{
+	this->FinaliseBlock();
+	other.FinaliseBlock();
+
+	for (BufferInfo &block : other.blocks) {
+		this->completed_block_bytes += block.size;
+		this->blocks.push_back(std::move(block));
+	}
+	other.blocks.clear();
+	other.completed_block_bytes = 0;
+}
+
 /**
  * Flush this dumper into a writer.
  * @param writer The filter we want to use.
@@ -263,16 +281,17 @@ struct SaveLoadParams {
 	SaveModeFlags save_flags;            ///< Save mode flags
 };
 
-static SaveLoadParams _sl; ///< Parameters used for/at saveload.
+static SaveLoadParams _sl_main;                      ///< Parameters used for/at saveload.
+static thread_local SaveLoadParams *_sl = &_sl_main; ///< Parameters of the current thread, only differs from _sl_main for chunks which are saved in parallel.
 
 ReadBuffer *ReadBuffer::GetCurrent()
 {
-	return _sl.reader.get();
+	return _sl->reader.get();
 }
 
 MemoryDumper *MemoryDumper::GetCurrent()
 {
-	return _sl.dumper.get();
+	return _sl->dumper.get();
 }
 
 static const std::vector<ChunkHandler> &ChunkHandlers()
@@ -394,12 +413,12 @@ static void SlNullPointers()
 		return;
 	}
 
-	_sl.action = SLA_NULL;
+	_sl->action = SLA_NULL;
 
 	/* Do upstream chunk tests before clearing version data */
 	ring_buffer<uint32_t> upstream_null_chunks;
 	for (auto &ch : ChunkHandlers()) {
-		_sl.current_chunk_id = ch.id;
+		_sl->current_chunk_id = ch.id;
 		if (ch.special_proc != nullptr && ch.special_proc(ch.id, CSLSO_PRE_NULL_PTRS) == CSLSOR_UPSTREAM_NULL_PTRS) {
 			upstream_null_chunks.push_back(ch.id);
 		}
@@ -412,7 +431,7 @@ static void SlNullPointers()
 	SlXvSetCurrentState();
 
 	for (auto &ch : ChunkHandlers()) {
-		_sl.current_chunk_id = ch.id;
+		_sl->current_chunk_id = ch.id;
 		if (!upstream_null_chunks.empty() && upstream_null_chunks.front() == ch.id) {
 			upstream_null_chunks.pop_front();
 			SlExecWithSlVersion(MAX_LOAD_SAVEGAME_VERSION, [&]() {
@@ -427,7 +446,7 @@ static void SlNullPointers()
 		}
 	}
 
-	assert(_sl.action == SLA_NULL);
+	assert(_sl->action == SLA_NULL);
 }
 
 struct ThreadSlErrorException {
@@ -445,24 +464,28 @@ struct ThreadSlErrorException {
  */
 [[noreturn]] void SlError(StringID string, std::string extra_msg)
 {
-	if (IsNonMainThread() && IsNonGameThread() && _sl.action != SLA_SAVE) {
+	if (IsNonMainThread() && IsNonGameThread() && _sl->action != SLA_SAVE) {
 		throw ThreadSlErrorException{ string, std::move(extra_msg) };
 	}
 
 	/* Distinguish between loading into _load_check_data vs. normal save/load. */
-	if (_sl.action == SLA_LOAD_CHECK) {
+	if (_sl->action == SLA_LOAD_CHECK) {
 		_load_check_data.error = string;
 		_load_check_data.error_msg = std::move(extra_msg);
 	} else {
-		_sl.error_str = string;
-		_sl.extra_msg = std::move(extra_msg);
+		_sl->error_str = string;
+		_sl->extra_msg = std::move(extra_msg);
 	}
 
+	/* Saving a chunk in parallel, or writing the savegame on the save thread: the error is
+	 * handled by the game thread or by SaveFileToDisk, leave the global state to them. */
+	if (_sl != &_sl_main || (IsNonMainThread() && IsNonGameThread())) throw std::exception();
+
 	/* We have to nullptr all pointers here; we might be in a state where
 	 * the pointers are actually filled with indices, which means that
 	 * when we access them during cleaning the pool dereferences of
 	 * those indices will be made with segmentation faults as result. */
-	if (_sl.action == SLA_LOAD || _sl.action == SLA_PTRS) SlNullPointers();
+	if (_sl->action == SLA_LOAD || _sl->action == SLA_PTRS) SlNullPointers();
 
 	/* Logging could be active. */
 	GamelogStopAnyAction();
@@ -585,7 +608,7 @@ void ProcessAsyncSaveFinish()
  */
 uint8_t SlReadByte()
 {
-	return _sl.reader->ReadByte();
+	return _sl->reader->ReadByte();
 }
 
 /**
@@ -595,25 +618,25 @@ uint8_t SlReadByte()
  */
 void SlSkipBytes(size_t length)
 {
-	return _sl.reader->SkipBytes(length);
+	return _sl->reader->SkipBytes(length);
 }
 
 int SlReadUint16()
 {
-	_sl.reader->CheckBytes(2);
-	return _sl.reader->RawReadUint16();
+	_sl->reader->CheckBytes(2);
+	return _sl->reader->RawReadUint16();
 }
 
 uint32_t SlReadUint32()
 {
-	_sl.reader->CheckBytes(4);
-	return _sl.reader->RawReadUint32();
+	_sl->reader->CheckBytes(4);
+	return _sl->reader->RawReadUint32();
 }
 
 uint64_t SlReadUint64()
 {
-	_sl.reader->CheckBytes(8);
-	return _sl.reader->RawReadUint64();
+	_sl->reader->CheckBytes(8);
+	return _sl->reader->RawReadUint64();
 }
 
 /**
@@ -622,25 +645,25 @@ uint64_t SlReadUint64()
  */
 void SlWriteByte(uint8_t b)
 {
-	_sl.dumper->WriteByte(b);
+	_sl->dumper->WriteByte(b);
 }
 
 void SlWriteUint16(uint16_t v)
 {
-	_sl.dumper->CheckBytes(2);
-	_sl.dumper->RawWriteUint16(v);
+	_sl->dumper->CheckBytes(2);
+	_sl->dumper->RawWriteUint16(v);
 }
 
 void SlWriteUint32(uint32_t v)
 {
-	_sl.dumper->CheckBytes(4);
-	_sl.dumper->RawWriteUint32(v);
+	_sl->dumper->CheckBytes(4);
+	_sl->dumper->RawWriteUint32(v);
 }
 
 void SlWriteUint64(uint64_t v)
 {
-	_sl.dumper->CheckBytes(8);
-	_sl.dumper->RawWriteUint64(v);
+	_sl->dumper->CheckBytes(8);
+	_sl->dumper->RawWriteUint64(v);
 }
 
 /**
@@ -649,8 +672,8 @@ void SlWriteUint64(uint64_t v)
  */
 size_t SlGetBytesRead()
 {
-	assert(_sl.action == SLA_LOAD || _sl.action == SLA_LOAD_CHECK);
-	return _sl.reader->GetSize();
+	assert(_sl->action == SLA_LOAD || _sl->action == SLA_LOAD_CHECK);
+	return _sl->reader->GetSize();
 }
 
 /**
@@ -659,8 +682,8 @@ size_t SlGetBytesRead()
  */
 size_t SlGetBytesWritten()
 {
-	assert(_sl.action == SLA_SAVE);
-	return _sl.dumper->GetSize();
+	assert(_sl->action == SLA_SAVE);
+	return _sl->dumper->GetSize();
 }
 
 /**
@@ -815,8 +838,8 @@ static inline size_t SlCalcRefLen()
 
 void SlSetArrayIndex(uint index)
 {
-	_sl.need_length = NL_WANTLENGTH;
-	_sl.array_index = index;
+	_sl->need_length = NL_WANTLENGTH;
+	_sl->array_index = index;
 }
 
 static size_t _next_offs;
@@ -831,35 +854,35 @@ int SlIterateArray()
 
 	/* After reading in the whole array inside the loop
 	 * we must have read in all the data, so we must be at end of current block. */
-	if (_next_offs != 0 && _sl.reader->GetSize() != _next_offs) {
-		DEBUG(sl, 1, "Invalid chunk size: " PRINTF_SIZE " != " PRINTF_SIZE, _sl.reader->GetSize(), _next_offs);
-		SlErrorCorruptFmt("Invalid chunk size iterating array - expected to be at position " PRINTF_SIZE ", actually at " PRINTF_SIZE, _next_offs, _sl.reader->GetSize());
+	if (_next_offs != 0 && _sl->reader->GetSize() != _next_offs) {
+		DEBUG(sl, 1, "Invalid chunk size: " PRINTF_SIZE " != " PRINTF_SIZE, _sl->reader->GetSize(), _next_offs);
+		SlErrorCorruptFmt("Invalid chunk size iterating array - expected to be at position " PRINTF_SIZE ", actually at " PRINTF_SIZE, _next_offs, _sl->reader->GetSize());
 	}
 
 	for (;;) {
 		uint length = SlReadArrayLength();
 		if (length == 0) {
-			assert(!_sl.expect_table_header);
+			assert(!_sl->expect_table_header);
 			_next_offs = 0;
 			return -1;
 		}
 
-		_sl.obj_len = --length;
-		_next_offs = _sl.reader->GetSize() + length;
+		_sl->obj_len = --length;
+		_next_offs = _sl->reader->GetSize() + length;
 
-		if (_sl.expect_table_header) {
-			_sl.expect_table_header = false;
+		if (_sl->expect_table_header) {
+			_sl->expect_table_header = false;
 			return INT32_MAX;
 		}
 
-		switch (_sl.block_mode) {
+		switch (_sl->block_mode) {
 			case CH_SPARSE_ARRAY:
 			case CH_SPARSE_TABLE:
 				index = (int)SlReadSparseIndex();
 				break;
 			case CH_ARRAY:
 			case CH_TABLE:
-				index = _sl.array_index++;
+				index = _sl->array_index++;
 				break;
 			default:
 				DEBUG(sl, 0, "SlIterateArray error");
@@ -876,7 +899,7 @@ int SlIterateArray()
 void SlSkipArray()
 {
 	while (SlIterateArray() != -1) {
-		SlSkipBytes(_next_offs - _sl.reader->GetSize());
+		SlSkipBytes(_next_offs - _sl->reader->GetSize());
 	}
 }
 
@@ -887,18 +910,18 @@ void SlSkipArray()
  */
 void SlSetLength(size_t length)
 {
-	assert(_sl.action == SLA_SAVE);
+	assert(_sl->action == SLA_SAVE);
 
-	switch (_sl.need_length) {
+	switch (_sl->need_length) {
 		case NL_WANTLENGTH:
-			_sl.need_length = NL_NONE;
-			if ((_sl.block_mode == CH_TABLE || _sl.block_mode == CH_SPARSE_TABLE) && _sl.expect_table_header) {
-				_sl.expect_table_header = false;
+			_sl->need_length = NL_NONE;
+			if ((_sl->block_mode == CH_TABLE || _sl->block_mode == CH_SPARSE_TABLE) && _sl->expect_table_header) {
+				_sl->expect_table_header = false;
 				SlWriteArrayLength(length + 1);
 				break;
 			}
 
-			switch (_sl.block_mode) {
+			switch (_sl->block_mode) {
 				case CH_RIFF:
 					/* Ugly encoding of >16M RIFF chunks
 					 * The lower 24 bits are normal
@@ -921,16 +944,16 @@ void SlSetLength(size_t length)
 					break;
 				case CH_ARRAY:
 				case CH_TABLE:
-					assert(_sl.last_array_index <= _sl.array_index);
-					while (++_sl.last_array_index <= _sl.array_index) {
+					assert(_sl->last_array_index <= _sl->array_index);
+					while (++_sl->last_array_index <= _sl->array_index) {
 						SlWriteArrayLength(1);
 					}
 					SlWriteArrayLength(length + 1);
 					break;
 				case CH_SPARSE_ARRAY:
 				case CH_SPARSE_TABLE:
-					SlWriteArrayLength(length + 1 + SlGetArrayLength(_sl.array_index)); // Also include length of sparse index.
-					SlWriteSparseIndex(_sl.array_index);
+					SlWriteArrayLength(length + 1 + SlGetArrayLength(_sl->array_index)); // Also include length of sparse index.
+					SlWriteSparseIndex(_sl->array_index);
 					break;
 				default: NOT_REACHED();
 			}
@@ -950,13 +973,13 @@ static void SlCopyBytes(void *ptr, size_t length)
 {
 	uint8_t *p = (uint8_t *)ptr;
 
-	switch (_sl.action) {
+	switch (_sl->action) {
 		case SLA_LOAD_CHECK:
 		case SLA_LOAD:
-			_sl.reader->CopyBytes(p, length);
+			_sl->reader->CopyBytes(p, length);
 			break;
 		case SLA_SAVE:
-			_sl.dumper->CopyBytes(p, length);
+			_sl->dumper->CopyBytes(p, length);
 			break;
 		default: NOT_REACHED();
 	}
@@ -964,18 +987,18 @@ static void SlCopyBytes(void *ptr, size_t length)
 
 void SlCopyBytesRead(void *p, size_t length)
 {
-	_sl.reader->CopyBytes((uint8_t *)p, length);
+	_sl->reader->CopyBytes((uint8_t *)p, length);
 }
 
 void SlCopyBytesWrite(void *p, size_t length)
 {
-	_sl.dumper->CopyBytes((uint8_t *)p, length);
+	_sl->dumper->CopyBytes((uint8_t *)p, length);
 }
 
 /** Get the length of the current object */
 size_t SlGetFieldLength()
 {
-	return _sl.obj_len;
+	return _sl->obj_len;
 }
 
 /**
@@ -1096,7 +1119,7 @@ static void SlSaveLoadConvGeneric(void *ptr, VarType conv)
 
 void SlSaveLoadConv(void *ptr, VarType conv)
 {
-	switch (_sl.action) {
+	switch (_sl->action) {
 		case SLA_SAVE:
 			SlSaveLoadConvGeneric<SLA_SAVE>(ptr, conv);
 			return;
@@ -1177,7 +1200,7 @@ static inline size_t SlCalcStringLen(const void *ptr, size_t length, VarType con
  */
 static void SlString(void *ptr, size_t length, VarType conv)
 {
-	switch (_sl.action) {
+	switch (_sl->action) {
 		case SLA_SAVE: {
 			size_t len;
 			switch (GetVarMemType(conv)) {
@@ -1256,7 +1279,7 @@ static void SlString(void *ptr, size_t length, VarType conv)
  */
 static void SlStdString(std::string &str, VarType conv)
 {
-	switch (_sl.action) {
+	switch (_sl->action) {
 		case SLA_SAVE: {
 			SlWriteArrayLength(str.size());
 			SlCopyBytes(str.data(), str.size());
@@ -1311,19 +1334,19 @@ static inline size_t SlCalcArrayLen(size_t length, VarType conv)
  */
 void SlArray(void *array, size_t length, VarType conv)
 {
-	if (_sl.action == SLA_PTRS || _sl.action == SLA_NULL) return;
+	if (_sl->action == SLA_PTRS || _sl->action == SLA_NULL) return;
 
 	if (SlIsTableChunk()) {
-		assert(_sl.need_length == NL_NONE);
+		assert(_sl->need_length == NL_NONE);
 
-		switch (_sl.action) {
+		switch (_sl->action) {
 			case SLA_SAVE:
 				SlWriteArrayLength(length);
 				break;
 
 			case SLA_LOAD_CHECK:
 			case SLA_LOAD: {
-				if (!HasBit(_sl.block_flags, SLBF_TABLE_ARRAY_LENGTH_PREFIX_MISSING)) {
+				if (!HasBit(_sl->block_flags, SLBF_TABLE_ARRAY_LENGTH_PREFIX_MISSING)) {
 					size_t sv_length = SlReadArrayLength();
 					if (GetVarMemType(conv) == SLE_VAR_NULL) {
 						/* We don't know this field, so we assume the length in the savegame is correct. */
@@ -1344,13 +1367,13 @@ void SlArray(void *array, size_t length, VarType conv)
 	}
 
 	/* Automatically calculate the length? */
-	if (_sl.need_length != NL_NONE) {
+	if (_sl->need_length != NL_NONE) {
 		SlSetLength(SlCalcArrayLen(length, conv));
 	}
 
 	/* NOTICE - handle some buggy stuff, in really old versions everything was saved
 	 * as a byte-type. So detect this, and adjust array size accordingly */
-	if (_sl.action != SLA_SAVE && _sl_version == 0) {
+	if (_sl->action != SLA_SAVE && _sl_version == 0) {
 		/* all arrays except difficulty settings */
 		if (conv == SLE_INT16 || conv == SLE_UINT16 || conv == SLE_STRINGID ||
 				conv == SLE_INT32 || conv == SLE_UINT32) {
@@ -1394,7 +1417,7 @@ void SlArray(void *array, size_t length, VarType conv)
  */
 static size_t ReferenceToInt(const void *obj, SLRefType rt)
 {
-	assert(_sl.action == SLA_SAVE);
+	assert(_sl->action == SLA_SAVE);
 
 	if (obj == nullptr) return 0;
 
@@ -1430,7 +1453,7 @@ static void *IntToReference(size_t index, SLRefType rt)
 {
 	static_assert(sizeof(size_t) <= sizeof(void *));
 
-	assert(_sl.action == SLA_PTRS);
+	assert(_sl->action == SLA_PTRS);
 
 	/* After version 4.3 REF_VEHICLE_OLD is saved as REF_VEHICLE,
 	 * and should be loaded like that */
@@ -1508,7 +1531,7 @@ static void *IntToReference(size_t index, SLRefType rt)
  */
 void SlSaveLoadRef(void *ptr, VarType conv)
 {
-	switch (_sl.action) {
+	switch (_sl->action) {
 		case SLA_SAVE:
 			SlWriteUint32((uint32_t)ReferenceToInt(*(void **)ptr, (SLRefType)conv));
 			break;
@@ -1572,7 +1595,7 @@ public:
 
 		SlStorageT *list = static_cast<SlStorageT *>(storage);
 
-		switch (_sl.action) {
+		switch (_sl->action) {
 			case SLA_SAVE:
 				SlWriteUint32((uint32_t)list->size());
 
@@ -1651,13 +1674,13 @@ template<typename PtrList>
 static void SlRefList(void *list, SLRefType conv)
 {
 	/* Automatically calculate the length? */
-	if (_sl.need_length != NL_NONE) {
+	if (_sl->need_length != NL_NONE) {
 		SlSetLength(SlCalcRefListLen<PtrList>(list));
 	}
 
 	PtrList *l = (PtrList *)list;
 
-	switch (_sl.action) {
+	switch (_sl->action) {
 		case SLA_SAVE: {
 			SlWriteUint32((uint32_t)l->size());
 
@@ -1704,13 +1727,13 @@ static void SlVarList(void *list, VarType conv)
 {
 	const size_t size_len = SlCalcConvMemLen(conv);
 	/* Automatically calculate the length? */
-	if (_sl.need_length != NL_NONE) {
+	if (_sl->need_length != NL_NONE) {
 		SlSetLength(SlCalcVarListLen<PtrList>(list, size_len));
 	}
 
 	PtrList *l = (PtrList *)list;
 
-	switch (_sl.action) {
+	switch (_sl->action) {
 		case SLA_SAVE: {
 			SlWriteUint32((uint32_t)l->size());
 
@@ -1809,7 +1832,7 @@ size_t SlCalcObjLength(const void *object, const SaveLoadTable &slt)
 
 size_t SlCalcObjMemberLength(const void *object, const SaveLoad &sld)
 {
-	assert(_sl.action == SLA_SAVE);
+	assert(_sl->action == SLA_SAVE);
 
 	switch (sld.cmd) {
 		case SL_VAR:
@@ -1874,7 +1897,7 @@ static void SlFilterObjectMember(const SaveLoad &sld, std::vector<SaveLoad> &sav
 			/* CONDITIONAL saveload types depend on the savegame version */
 			if (!SlIsObjectValidInSavegame(sld)) return;
 
-			switch (_sl.action) {
+			switch (_sl->action) {
 				case SLA_SAVE:
 				case SLA_LOAD_CHECK:
 				case SLA_LOAD:
@@ -1903,7 +1926,7 @@ static void SlFilterObjectMember(const SaveLoad &sld, std::vector<SaveLoad> &sav
 		 * When loading, the value is read explictly with SlReadByte() to determine which
 		 * object description to use. */
 		case SL_WRITEBYTE:
-			if (_sl.action == SLA_SAVE) save.push_back(sld);
+			if (_sl->action == SLA_SAVE) save.push_back(sld);
 			break;
 
 		/* SL_VEH_INCLUDE loads common code for vehicles */
@@ -2027,7 +2050,7 @@ bool SlObjectMemberGeneric(void *object, const SaveLoad &sld)
 
 bool SlObjectMember(void *object, const SaveLoad &sld)
 {
-	switch (_sl.action) {
+	switch (_sl->action) {
 		case SLA_SAVE:
 			return SlObjectMemberGeneric<SLA_SAVE, true>(object, sld);
 		case SLA_LOAD_CHECK:
@@ -2049,7 +2072,7 @@ bool SlObjectMember(void *object, const SaveLoad &sld)
 void SlObject(void *object, const SaveLoadTable &slt)
 {
 	/* Automatically calculate the length? */
-	if (_sl.need_length != NL_NONE) {
+	if (_sl->need_length != NL_NONE) {
 		SlSetLength(SlCalcObjLength(object, slt));
 	}
 
@@ -2068,14 +2091,14 @@ void SlObjectIterateBase(void *object, const SaveLoadTable &slt)
 
 void SlObjectSaveFiltered(void *object, const SaveLoadTable &slt)
 {
-	if (_sl.need_length != NL_NONE) {
-		_sl.need_length = NL_NONE;
-		_sl.dumper->StartAutoLength();
+	if (_sl->need_length != NL_NONE) {
+		_sl->need_length = NL_NONE;
+		_sl->dumper->StartAutoLength();
 		SlObjectIterateBase<SLA_SAVE, false>(object, slt);
-		auto result = _sl.dumper->StopAutoLength();
-		_sl.need_length = NL_WANTLENGTH;
+		auto result = _sl->dumper->StopAutoLength();
+		_sl->need_length = NL_WANTLENGTH;
 		SlSetLength(result.size());
-		_sl.dumper->CopyBytes(result);
+		_sl->dumper->CopyBytes(result);
 	} else {
 		SlObjectIterateBase<SLA_SAVE, false>(object, slt);
 	}
@@ -2088,7 +2111,7 @@ void SlObjectLoadFiltered(void *object, const SaveLoadTable &slt)
 
 void SlObjectPtrOrNullFiltered(void *object, const SaveLoadTable &slt)
 {
-	switch (_sl.action) {
+	switch (_sl->action) {
 		case SLA_PTRS:
 			SlObjectIterateBase<SLA_PTRS, false>(object, slt);
 			return;
@@ -2101,7 +2124,7 @@ void SlObjectPtrOrNullFiltered(void *object, const SaveLoadTable &slt)
 
 bool SlIsTableChunk()
 {
-	return (_sl.block_mode == CH_TABLE || _sl.block_mode == CH_SPARSE_TABLE);
+	return (_sl->block_mode == CH_TABLE || _sl->block_mode == CH_SPARSE_TABLE);
 }
 
 void SlSkipTableHeader()
@@ -2176,11 +2199,11 @@ static uint8_t GetSavegameTableFileType(const SaveLoad &sld)
 std::vector<SaveLoad> SlTableHeader(const NamedSaveLoadTable &slt)
 {
 	/* You can only use SlTableHeader if you are a CH_TABLE. */
-	assert(_sl.block_mode == CH_TABLE || _sl.block_mode == CH_SPARSE_TABLE);
+	assert(_sl->block_mode == CH_TABLE || _sl->block_mode == CH_SPARSE_TABLE);
 
 	std::vector<SaveLoad> saveloads;
 
-	switch (_sl.action) {
+	switch (_sl->action) {
 		case SLA_LOAD_CHECK:
 		case SLA_LOAD: {
 			/* Build a key lookup mapping based on the available fields. */
@@ -2221,7 +2244,7 @@ std::vector<SaveLoad> SlTableHeader(const NamedSaveLoadTable &slt)
 				auto sld_it = std::lower_bound(key_lookup.begin(), key_lookup.end(), key);
 				if (sld_it == key_lookup.end() || sld_it->name != key) {
 					/* SLA_LOADCHECK triggers this debug statement a lot and is perfectly normal. */
-					DEBUG(sl, _sl.action == SLA_LOAD ? 2 : 6, "Field '%s' of type 0x%02X not found, skipping", key.c_str(), type);
+					DEBUG(sl, _sl->action == SLA_LOAD ? 2 : 6, "Field '%s' of type 0x%02X not found, skipping", key.c_str(), type);
 
 					SaveLoadType saveload_type;
 					switch (type & SLE_FILE_TYPE_MASK) {
@@ -2264,7 +2287,7 @@ std::vector<SaveLoad> SlTableHeader(const NamedSaveLoadTable &slt)
 
 		case SLA_SAVE: {
 			/* Automatically calculate the length? */
-			if (_sl.need_length != NL_NONE) {
+			if (_sl->need_length != NL_NONE) {
 				SlSetLength(SlCalcTableHeader(slt));
 			}
 
@@ -2316,14 +2339,14 @@ void SlLoadTableOrRiffFiltered(const SaveLoadTable &slt)
 	if (SlIsTableChunk() && SlIterateArray() == -1) return;
 	SlObjectLoadFiltered(nullptr, slt);
 	if (SlIsTableChunk() && SlIterateArray() != -1) {
-		uint32_t id = _sl.current_chunk_id;
+		uint32_t id = _sl->current_chunk_id;
 		SlErrorCorruptFmt("Too many %s entries", ChunkIDDumper()(id));
 	}
 }
 
 void SlLoadTableWithArrayLengthPrefixesMissing()
 {
-	SetBit(_sl.block_flags, SLBF_TABLE_ARRAY_LENGTH_PREFIX_MISSING);
+	SetBit(_sl->block_flags, SLBF_TABLE_ARRAY_LENGTH_PREFIX_MISSING);
 }
 
 /**
@@ -2342,26 +2365,26 @@ void SlGlobList(const SaveLoadTable &slt)
  */
 void SlAutolength(AutolengthProc *proc, void *arg)
 {
-	assert(_sl.action == SLA_SAVE);
-	assert(_sl.need_length == NL_WANTLENGTH);
+	assert(_sl->action == SLA_SAVE);
+	assert(_sl->need_length == NL_WANTLENGTH);
 
-	_sl.need_length = NL_NONE;
-	_sl.dumper->StartAutoLength();
+	_sl->need_length = NL_NONE;
+	_sl->dumper->StartAutoLength();
 	proc(arg);
-	auto result = _sl.dumper->StopAutoLength();
+	auto result = _sl->dumper->StopAutoLength();
 	/* Setup length */
-	_sl.need_length = NL_WANTLENGTH;
+	_sl->need_length = NL_WANTLENGTH;
 	SlSetLength(result.size());
-	_sl.dumper->CopyBytes(result);
+	_sl->dumper->CopyBytes(result);
 }
 
 uint8_t SlSaveToTempBufferSetup()
 {
-	assert(_sl.action == SLA_SAVE);
-	NeedLength orig_need_length = _sl.need_length;
+	assert(_sl->action == SLA_SAVE);
+	NeedLength orig_need_length = _sl->need_length;
 
-	_sl.need_length = NL_NONE;
-	_sl.dumper->StartAutoLength();
+	_sl->need_length = NL_NONE;
+	_sl->dumper->StartAutoLength();
 
 	return (uint8_t) orig_need_length;
 }
@@ -2370,17 +2393,17 @@ std::span<uint8_t> SlSaveToTempBufferRestore(uint8_t state)
 {
 	NeedLength orig_need_length = (NeedLength)state;
 
-	auto result = _sl.dumper->StopAutoLength();
+	auto result = _sl->dumper->StopAutoLength();
 	/* Setup length */
-	_sl.need_length = orig_need_length;
+	_sl->need_length = orig_need_length;
 	return result;
 }
 
 SlConditionallySaveState SlConditionallySaveSetup()
 {
-	assert(_sl.action == SLA_SAVE);
-	if (_sl.dumper->IsAutoLengthActive()) {
-		return { (size_t)(_sl.dumper->buf - _sl.dumper->autolen_buf), 0, true };
+	assert(_sl->action == SLA_SAVE);
+	if (_sl->dumper->IsAutoLengthActive()) {
+		return { (size_t)(_sl->dumper->buf - _sl->dumper->autolen_buf), 0, true };
 	} else {
 		return { 0, SlSaveToTempBufferSetup(), false };
 	}
@@ -2389,21 +2412,21 @@ SlConditionallySaveState SlConditionallySaveSetup()
 extern void SlConditionallySaveCompletion(const SlConditionallySaveState &state, bool save)
 {
 	if (state.nested) {
-		if (!save) _sl.dumper->buf = _sl.dumper->autolen_buf + state.current_len;
+		if (!save) _sl->dumper->buf = _sl->dumper->autolen_buf + state.current_len;
 	} else {
 		auto result = SlSaveToTempBufferRestore(state.need_length);
-		if (save) _sl.dumper->CopyBytes(result);
+		if (save) _sl->dumper->CopyBytes(result);
 	}
 }
 
 SlLoadFromBufferState SlLoadFromBufferSetup(const uint8_t *buffer, size_t length)
 {
-	assert(_sl.action == SLA_LOAD || _sl.action == SLA_LOAD_CHECK);
+	assert(_sl->action == SLA_LOAD || _sl->action == SLA_LOAD_CHECK);
 
 	SlLoadFromBufferState state;
 
-	state.old_obj_len = _sl.obj_len;
-	_sl.obj_len = length;
+	state.old_obj_len = _sl->obj_len;
+	_sl->obj_len = length;
 
 	ReadBuffer *reader = ReadBuffer::GetCurrent();
 	state.old_bufp = reader->bufp;
@@ -2421,7 +2444,7 @@ void SlLoadFromBufferRestore(const SlLoadFromBufferState &state, const uint8_t *
 		SlErrorCorrupt("SlLoadFromBuffer: Wrong number of bytes read");
 	}
 
-	_sl.obj_len = state.old_obj_len;
+	_sl->obj_len = state.old_obj_len;
 	reader->bufp = state.old_bufp;
 	reader->bufe = state.old_bufe;
 }
@@ -2467,9 +2490,9 @@ static void SlLoadChunk(const ChunkHandler &ch)
 	size_t len;
 	size_t endoffs;
 
-	_sl.block_mode = m;
-	_sl.block_flags = 0;
-	_sl.obj_len = 0;
+	_sl->block_mode = m;
+	_sl->block_flags = 0;
+	_sl->obj_len = 0;
 
 	SaveLoadChunkExtHeaderFlags ext_flags = static_cast<SaveLoadChunkExtHeaderFlags>(0);
 	if ((m & 0xF) == CH_EXT_HDR) {
@@ -2477,21 +2500,21 @@ static void SlLoadChunk(const ChunkHandler &ch)
 
 		/* read in real header */
 		m = SlReadByte();
-		_sl.block_mode = m;
+		_sl->block_mode = m;
 	}
 
-	_sl.expect_table_header = (_sl.block_mode == CH_TABLE || _sl.block_mode == CH_SPARSE_TABLE);
+	_sl->expect_table_header = (_sl->block_mode == CH_TABLE || _sl->block_mode == CH_SPARSE_TABLE);
 
 	/* The header should always be at the start. Read the length; the
 	 * LoadCheck() should as first action process the header. */
-	if (_sl.expect_table_header) {
+	if (_sl->expect_table_header) {
 		SlIterateArray();
 	}
 
 	switch (m) {
 		case CH_ARRAY:
 		case CH_TABLE:
-			_sl.array_index = 0;
+			_sl->array_index = 0;
 			ch.load_proc();
 			if (_next_offs != 0) SlErrorCorruptFmt("Invalid array length in %s", ChunkIDDumper()(ch.id));
 			break;
@@ -2516,13 +2539,13 @@ static void SlLoadChunk(const ChunkHandler &ch)
 					len |= SlReadUint32() << 28;
 				}
 
-				_sl.obj_len = len;
-				endoffs = _sl.reader->GetSize() + len;
+				_sl->obj_len = len;
+				endoffs = _sl->reader->GetSize() + len;
 				ch.load_proc();
-				if (_sl.reader->GetSize() != endoffs) {
-					DEBUG(sl, 1, "Invalid chunk size: " PRINTF_SIZE " != " PRINTF_SIZE ", (" PRINTF_SIZE ")  for %s", _sl.reader->GetSize(), endoffs, len, ChunkIDDumper()(ch.id));
+				if (_sl->reader->GetSize() != endoffs) {
+					DEBUG(sl, 1, "Invalid chunk size: " PRINTF_SIZE " != " PRINTF_SIZE ", (" PRINTF_SIZE ")  for %s", _sl->reader->GetSize(), endoffs, len, ChunkIDDumper()(ch.id));
 					SlErrorCorruptFmt("Invalid chunk size - expected to be at position " PRINTF_SIZE ", actually at " PRINTF_SIZE ", length: " PRINTF_SIZE " for %s",
-							endoffs, _sl.reader->GetSize(), len, ChunkIDDumper()(ch.id));
+							endoffs, _sl->reader->GetSize(), len, ChunkIDDumper()(ch.id));
 				}
 			} else {
 				SlErrorCorruptFmt("Invalid chunk type for %s", ChunkIDDumper()(ch.id));
@@ -2530,7 +2553,7 @@ static void SlLoadChunk(const ChunkHandler &ch)
 			break;
 	}
 
-	if (_sl.expect_table_header) SlErrorCorruptFmt("Table chunk without header: %s", ChunkIDDumper()(ch.id));
+	if (_sl->expect_table_header) SlErrorCorruptFmt("Table chunk without header: %s", ChunkIDDumper()(ch.id));
 }
 
 /**
@@ -2554,9 +2577,9 @@ static void SlLoadCheckChunk(const ChunkHandler *ch, uint32_t chunk_id)
 	size_t len;
 	size_t endoffs;
 
-	_sl.block_mode = m;
-	_sl.block_flags = 0;
-	_sl.obj_len = 0;
+	_sl->block_mode = m;
+	_sl->block_flags = 0;
+	_sl->obj_len = 0;
 
 	SaveLoadChunkExtHeaderFlags ext_flags = static_cast<SaveLoadChunkExtHeaderFlags>(0);
 	if ((m & 0xF) == CH_EXT_HDR) {
@@ -2564,21 +2587,21 @@ static void SlLoadCheckChunk(const ChunkHandler *ch, uint32_t chunk_id)
 
 		/* read in real header */
 		m = SlReadByte();
-		_sl.block_mode = m;
+		_sl->block_mode = m;
 	}
 
-	_sl.expect_table_header = (_sl.block_mode == CH_TABLE || _sl.block_mode == CH_SPARSE_TABLE);
+	_sl->expect_table_header = (_sl->block_mode == CH_TABLE || _sl->block_mode == CH_SPARSE_TABLE);
 
 	/* The header should always be at the start. Read the length; the
 	 * LoadCheck() should as first action process the header. */
-	if (_sl.expect_table_header) {
+	if (_sl->expect_table_header) {
 		SlIterateArray();
 	}
 
 	switch (m) {
 		case CH_ARRAY:
 		case CH_TABLE:
-			_sl.array_index = 0;
+			_sl->array_index = 0;
 			if (ext_flags) {
 				SlErrorCorruptFmt("CH_ARRAY does not take chunk header extension flags: 0x%X in %s", ext_flags, ChunkIDDumper()(chunk_id));
 			}
@@ -2624,17 +2647,17 @@ static void SlLoadCheckChunk(const ChunkHandler *ch, uint32_t chunk_id)
 					}
 					len = static_cast<size_t>(full_len);
 				}
-				_sl.obj_len = len;
-				endoffs = _sl.reader->GetSize() + len;
+				_sl->obj_len = len;
+				endoffs = _sl->reader->GetSize() + len;
 				if (ch && ch->load_check_proc) {
 					ch->load_check_proc();
 				} else {
 					SlSkipBytes(len);
 				}
-				if (_sl.reader->GetSize() != endoffs) {
-					DEBUG(sl, 1, "Invalid chunk size: " PRINTF_SIZE " != " PRINTF_SIZE ", (" PRINTF_SIZE ") for %s", _sl.reader->GetSize(), endoffs, len, ChunkIDDumper()(chunk_id));
+				if (_sl->reader->GetSize() != endoffs) {
+					DEBUG(sl, 1, "Invalid chunk size: " PRINTF_SIZE " != " PRINTF_SIZE ", (" PRINTF_SIZE ") for %s", _sl->reader->GetSize(), endoffs, len, ChunkIDDumper()(chunk_id));
 					SlErrorCorruptFmt("Invalid chunk size - expected to be at position " PRINTF_SIZE ", actually at " PRINTF_SIZE ", length: " PRINTF_SIZE " for %s",
-							endoffs, _sl.reader->GetSize(), len, ChunkIDDumper()(chunk_id));
+							endoffs, _sl->reader->GetSize(), len, ChunkIDDumper()(chunk_id));
 				}
 			} else {
 				SlErrorCorruptFmt("Invalid chunk type for: %s", ChunkIDDumper()(chunk_id));
@@ -2642,7 +2665,7 @@ static void SlLoadCheckChunk(const ChunkHandler *ch, uint32_t chunk_id)
 			break;
 	}
 
-	if (_sl.expect_table_header) SlErrorCorruptFmt("Table chunk without header: %s", ChunkIDDumper()(chunk_id));
+	if (_sl->expect_table_header) SlErrorCorruptFmt("Table chunk without header: %s", ChunkIDDumper()(chunk_id));
 }
 
 /**
@@ -2671,17 +2694,17 @@ static void SlSaveChunk(const ChunkHandler &ch)
 	/* Don't save any chunk information if there is no save handler. */
 	if (proc == nullptr) return;
 
-	_sl.current_chunk_id = ch.id;
+	_sl->current_chunk_id = ch.id;
 	SlWriteUint32(ch.id);
 	DEBUG(sl, 2, "Saving chunk %s", ChunkIDDumper()(ch.id));
 
 	size_t written = 0;
 	if (_debug_sl_level >= 3) written = SlGetBytesWritten();
 
-	_sl.block_mode = ch.type;
-	_sl.block_flags = 0;
-	_sl.expect_table_header = (_sl.block_mode == CH_TABLE || _sl.block_mode == CH_SPARSE_TABLE);
-	_sl.need_length = (_sl.expect_table_header || _sl.block_mode == CH_RIFF) ? NL_WANTLENGTH : NL_NONE;
+	_sl->block_mode = ch.type;
+	_sl->block_flags = 0;
+	_sl->expect_table_header = (_sl->block_mode == CH_TABLE || _sl->block_mode == CH_SPARSE_TABLE);
+	_sl->need_length = (_sl->expect_table_header || _sl->block_mode == CH_RIFF) ? NL_WANTLENGTH : NL_NONE;
 
 	switch (ch.type) {
 		case CH_RIFF:
@@ -2689,7 +2712,7 @@ static void SlSaveChunk(const ChunkHandler &ch)
 			break;
 		case CH_ARRAY:
 		case CH_TABLE:
-			_sl.last_array_index = 0;
+			_sl->last_array_index = 0;
 			SlWriteByte(ch.type);
 			proc();
 			SlWriteArrayLength(0); // Terminate arrays
@@ -2703,20 +2726,97 @@ static void SlSaveChunk(const ChunkHandler &ch)
 		default: NOT_REACHED();
 	}
 
-	if (_sl.expect_table_header) SlErrorCorruptFmt("Table chunk without header: %s", ChunkIDDumper()(ch.id));
+	if (_sl->expect_table_header) SlErrorCorruptFmt("Table chunk without header: %s", ChunkIDDumper()(ch.id));
 
 	DEBUG(sl, 3, "Saved chunk %s (" PRINTF_SIZE " bytes)", ChunkIDDumper()(ch.id), SlGetBytesWritten() - written);
 }
 
-/** Save all chunks */
-static void SlSaveChunks()
-{
-	for (auto &ch : ChunkHandlers()) {
-		SlSaveChunk(ch);
+/** Chunk which is being saved in parallel with the other chunks. */
+struct ParallelSaveChunk {
+	const ChunkHandler *ch;                 ///< The chunk handler.
+	SaveLoadParams sl;                      ///< Saveload parameters used by the worker thread, the chunk is saved to its own dumper.
+	bool error = false;                     ///< Whether saving the chunk failed.
+	std::chrono::steady_clock::duration duration{}; ///< Time taken to save the chunk.
+	WorkerTaskGroup task;                   ///< Task saving the chunk, destroying this waits for the chunk to be saved if saving is aborted by an error.
+
+	void Run()
+	{
+		/* This may also be run on the game thread, when waiting for the chunk before a worker has started it */
+		SaveLoadParams *prev_sl = _sl;
+		_sl = &this->sl;
+		auto start = std::chrono::steady_clock::now();
+		try {
+			SlSaveChunk(*this->ch);
+		} catch (...) {
+			this->error = true;
+		}
+		this->duration = std::chrono::steady_clock::now() - start;
+		_sl = prev_sl;
+	}
+};
+
+/**
+ * Save all chunks.
+ * @param handlers The chunk handlers to save.
+ */
+static void SlSaveChunks(const std::vector<ChunkHandler> &handlers)
+{
+	using Clock = std::chrono::steady_clock;
+	auto to_ms = [](Clock::duration d) -> uint { return (uint)std::chrono::duration_cast<std::chrono::milliseconds>(d).count(); };
+
+	/* Start saving the chunks which can be saved in parallel first, these are joined into the savegame in chunk order below */
+	std::deque<ParallelSaveChunk> parallel;
+	for (auto &ch : handlers) {
+		if (!ch.parallel_save || ch.save_proc == nullptr) continue;
+		if (ch.special_proc != nullptr && ch.special_proc(ch.id, CSLSO_SHOULD_SAVE_CHUNK) != CSLSOR_NONE) continue;
+		ParallelSaveChunk &chunk = parallel.emplace_back();
+		chunk.ch = &ch;
+		chunk.sl.action = SLA_SAVE;
+		chunk.sl.save_flags = _sl->save_flags;
+		chunk.sl.dumper = std::make_unique<MemoryDumper>();
+	}
+	for (ParallelSaveChunk &chunk : parallel) {
+		chunk.task.Run([&chunk]() { chunk.Run(); });
+	}
+
+	const Clock::time_point start = Clock::now();
+	Clock::duration waited{};
+	auto parallel_iter = parallel.begin();
+	for (auto &ch : handlers) {
+		const Clock::time_point chunk_start = Clock::now();
+		if (parallel_iter != parallel.end() && parallel_iter->ch == &ch) {
+			ParallelSaveChunk &chunk = *parallel_iter;
+			++parallel_iter;
+			chunk.task.Wait();
+			if (chunk.error) SlError(chunk.sl.error_str, std::move(chunk.sl.extra_msg));
+			_sl->dumper->AppendBlocks(*chunk.sl.dumper);
+			chunk.sl.dumper.reset();
+			const Clock::duration blocked = Clock::now() - chunk_start;
+			waited += blocked;
+			DEBUG(sl, 3, "Chunk %s: saved in parallel in %u ms, game thread blocked for %u ms", ChunkIDDumper()(ch.id), to_ms(chunk.duration), to_ms(blocked));
+		} else {
+			if (ch.special_proc != nullptr && ch.special_proc(ch.id, CSLSO_SHOULD_SAVE_CHUNK) == CSLSOR_UPSTREAM_SAVE_CHUNK) {
+				/* Upstream chunks temporarily change _sl_version, which the parallel chunks may still be reading */
+				for (ParallelSaveChunk &chunk : parallel) {
+					chunk.task.Wait();
+				}
+			}
+			SlSaveChunk(ch);
+			if (_debug_sl_level >= 3 && ch.save_proc != nullptr) {
+				DEBUG(sl, 3, "Chunk %s: game thread blocked for %u ms", ChunkIDDumper()(ch.id), to_ms(Clock::now() - chunk_start));
+			}
+		}
 	}
 
 	/* Terminator */
 	SlWriteUint32(0);
+
+	Clock::duration parallel_duration{};
+	for (const ParallelSaveChunk &chunk : parallel) {
+		parallel_duration += chunk.duration;
+	}
+	DEBUG(sl, 2, "Saved chunks: game thread blocked for %u ms, of which %u ms waiting for %u parallel chunks which took %u ms",
+			to_ms(Clock::now() - start), to_ms(waited), (uint)parallel.size(), to_ms(parallel_duration));
 }
 
 /**
@@ -2740,11 +2840,11 @@ static void SlLoadChunks()
 	}
 
 	for (uint32_t id = SlReadUint32(); id != 0; id = SlReadUint32()) {
-		_sl.current_chunk_id = id;
+		_sl->current_chunk_id = id;
 		size_t read = 0;
 		if (_debug_sl_level >= 3) read = SlGetBytesRead();
 
-		_sl.chunk_block_modes[id] = ReadBuffer::GetCurrent()->PeekByte();
+		_sl->chunk_block_modes[id] = ReadBuffer::GetCurrent()->PeekByte();
 
 		if (SlXvIsChunkDiscardable(id)) {
 			SlLoadCheckChunk(nullptr, id);
@@ -2772,11 +2872,11 @@ static void SlLoadCheckChunks()
 	const ChunkHandler *ch;
 
 	for (id = SlReadUint32(); id != 0; id = SlReadUint32()) {
-		_sl.current_chunk_id = id;
+		_sl->current_chunk_id = id;
 		size_t read = 0;
 		if (_debug_sl_level >= 3) read = SlGetBytesRead();
 
-		_sl.chunk_block_modes[id] = ReadBuffer::GetCurrent()->PeekByte();
+		_sl->chunk_block_modes[id] = ReadBuffer::GetCurrent()->PeekByte();
 
 		if (SlXvIsChunkDiscardable(id)) {
 			ch = nullptr;
@@ -2797,10 +2897,10 @@ static void SlFixPointers()
 		return;
 	}
 
-	_sl.action = SLA_PTRS;
+	_sl->action = SLA_PTRS;
 
 	for (auto &ch : ChunkHandlers()) {
-		_sl.current_chunk_id = ch.id;
+		_sl->current_chunk_id = ch.id;
 		if (ch.special_proc != nullptr) {
 			if (ch.special_proc(ch.id, CSLSO_PRE_PTRS) == CSLSOR_LOAD_CHUNK_CONSUMED) continue;
 		}
@@ -2810,7 +2910,7 @@ static void SlFixPointers()
 		}
 	}
 
-	assert(_sl.action == SLA_PTRS);
+	assert(_sl->action == SLA_PTRS);
 }
 
 
@@ -3192,6 +3292,19 @@ struct ZlibSaveFilter : SaveFilter {
  */
 static const lzma_stream _lzma_init = LZMA_STREAM_INIT;
 
+/** Memory limit of the LZMA decoder, this allows saves up to 256 MB uncompressed. */
+static const uint64_t LZMA_DECODER_MEMLIMIT = 1 << 28;
+
+/**
+ * Get the number of threads to use for LZMA compression and decompression.
+ * This matches the size of the worker pool, as both are sized by the number of available cores, but is limited to bound the memory used.
+ * @return The number of threads, 1 means to use the single-threaded encoder and decoder.
+ */
+static uint32_t GetLZMAThreadCount()
+{
+	return Clamp<uint32_t>(_general_worker_pool.GetWorkerCount(), 1, 8);
+}
+
 /** Filter without any compression. */
 struct LZMALoadFilter : LoadFilter {
 	lzma_stream lzma;                     ///< Stream state that we are reading from.
@@ -3203,8 +3316,18 @@ struct LZMALoadFilter : LoadFilter {
 	 */
 	LZMALoadFilter(std::shared_ptr<LoadFilter> chain) : LoadFilter(std::move(chain)), lzma(_lzma_init)
 	{
-		/* Allow saves up to 256 MB uncompressed */
-		if (lzma_auto_decoder(&this->lzma, 1 << 28, 0) != LZMA_OK) SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_INTERNAL_ERROR, "cannot initialize decompressor");
+#if LZMA_VERSION >= 50040002
+		/* Saves written by the multi-threaded encoder contain multiple independent blocks, which can be decoded in parallel */
+		const uint32_t threads = GetLZMAThreadCount();
+		if (threads > 1) {
+			lzma_mt mt{};
+			mt.threads = threads;
+			mt.memlimit_threading = LZMA_DECODER_MEMLIMIT;
+			mt.memlimit_stop = LZMA_DECODER_MEMLIMIT;
+			if (lzma_stream_decoder_mt(&this->lzma, &mt) == LZMA_OK) return;
+		}
+#endif
+		if (lzma_auto_decoder(&this->lzma, LZMA_DECODER_MEMLIMIT, 0) != LZMA_OK) SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_INTERNAL_ERROR, "cannot initialize decompressor");
 	}
 
 	/** Clean everything up. */
@@ -3247,6 +3370,18 @@ struct LZMASaveFilter : SaveFilter {
 	 */
 	LZMASaveFilter(std::shared_ptr<SaveFilter> chain, uint8_t compression_level) : SaveFilter(std::move(chain)), lzma(_lzma_init)
 	{
+#if LZMA_VERSION >= 50020002
+		/* The multi-threaded encoder splits the stream into independent blocks, the output is still a single .xz stream
+		 * which older versions can load, and it doesn't depend on the number of threads. */
+		const uint32_t threads = GetLZMAThreadCount();
+		if (threads > 1) {
+			lzma_mt mt{};
+			mt.threads = threads;
+			mt.preset = compression_level;
+			mt.check = LZMA_CHECK_CRC32;
+			if (lzma_stream_encoder_mt(&this->lzma, &mt) == LZMA_OK) return;
+		}
+#endif
 		if (lzma_easy_encoder(&this->lzma, compression_level, LZMA_CHECK_CRC32) != LZMA_OK) SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_INTERNAL_ERROR, "cannot initialize compressor");
 	}
 
@@ -3408,6 +3543,215 @@ struct ZSTDSaveFilter : SaveFilter {
 	}
 };
 
+/** Maximum uncompressed size of each block of the block-parallel zstd format. */
+static const size_t ZSTD_PARALLEL_BLOCK_SIZE = 4 * 1024 * 1024;
+
+/** Size of the header of each block of the block-parallel zstd format: the compressed and uncompressed sizes, big endian. */
+static const size_t ZSTD_PARALLEL_HEADER_SIZE = 8;
+
+/** Block of the block-parallel zstd format, which is compressed or decompressed on the worker pool. */
+struct ZSTDParallelBlock {
+	std::vector<uint8_t> input;  ///< Data to compress or decompress.
+	std::vector<uint8_t> output; ///< Compressed data including the block header, or decompressed data.
+	int compression_level = 0;   ///< zstd compression level, only used when saving.
+	bool error = false;          ///< Whether compressing or decompressing failed.
+	WorkerTaskGroup task;        ///< Task compressing or decompressing the block.
+};
+
+/**
+ * Blocks which are being compressed or decompressed on the worker pool.
+ * Blocks are only added and removed by the thread which owns the filter, and are consumed in order.
+ */
+struct ZSTDParallelBlocks {
+	ring_buffer<std::unique_ptr<ZSTDParallelBlock>> blocks;
+	const size_t max_in_flight;  ///< Maximum number of blocks to have queued at once, this bounds the memory used.
+
+	ZSTDParallelBlocks() : max_in_flight(std::min<uint>(_general_worker_pool.GetWorkerCount(), 16) + 1) {}
+
+	bool IsFull() const { return this->blocks.size() >= this->max_in_flight; }
+	bool IsEmpty() const { return this->blocks.empty(); }
+
+	void Enqueue(std::unique_ptr<ZSTDParallelBlock> block, void (*proc)(ZSTDParallelBlock *))
+	{
+		ZSTDParallelBlock *job = block.get();
+		this->blocks.push_back(std::move(block));
+		job->task.Run([job, proc]() { proc(job); });
+	}
+
+	std::unique_ptr<ZSTDParallelBlock> PopFront()
+	{
+		std::unique_ptr<ZSTDParallelBlock> block = std::move(this->blocks.front());
+		this->blocks.pop_front();
+		block->task.Wait();
+		return block;
+	}
+};
+
+/**
+ * Filter using ZSTD compression, with the savegame split into independently compressed blocks.
+ * Each block is prefixed by its compressed and uncompressed size, a block with a compressed size of 0 terminates the stream.
+ */
+struct ZSTDParallelLoadFilter : LoadFilter {
+	ZSTDParallelBlocks blocks;                    ///< Blocks which are being decompressed.
+	std::unique_ptr<ZSTDParallelBlock> current;   ///< Decompressed block currently being read from.
+	size_t current_pos = 0;                       ///< Read position within the current block.
+	bool end_of_stream = false;                   ///< Whether the terminating block has been read.
+
+	/**
+	 * Initialise this filter.
+	 * @param chain The next filter in this chain.
+	 */
+	ZSTDParallelLoadFilter(std::shared_ptr<LoadFilter> chain) : LoadFilter(std::move(chain)) {}
+
+	static void Decompress(ZSTDParallelBlock *block)
+	{
+		size_t size = ZSTD_decompress(block->output.data(), block->output.size(), block->input.data(), block->input.size());
+		block->error = ZSTD_isError(size) || size != block->output.size();
+		block->input = {};
+	}
+
+	void ReadFully(uint8_t *buf, size_t size)
+	{
+		while (size > 0) {
+			size_t read = this->chain->Read(buf, size);
+			if (read == 0) SlError(STR_GAME_SAVELOAD_ERROR_FILE_NOT_READABLE, "unexpected end of zstd block stream");
+			buf += read;
+			size -= read;
+		}
+	}
+
+	/** Read blocks from the chain and start decompressing them, until enough blocks are queued. */
+	void QueueBlocks()
+	{
+		while (!this->end_of_stream && !this->blocks.IsFull()) {
+			uint8_t header[ZSTD_PARALLEL_HEADER_SIZE];
+			this->ReadFully(header, sizeof(header));
+			const uint32_t compressed_size = (header[0] << 24) | (header[1] << 16) | (header[2] << 8) | header[3];
+			const uint32_t uncompressed_size = (header[4] << 24) | (header[5] << 16) | (header[6] << 8) | header[7];
+			if (compressed_size == 0) {
+				this->end_of_stream = true;
+				break;
+			}
+			if (uncompressed_size > ZSTD_PARALLEL_BLOCK_SIZE || compressed_size > ZSTD_compressBound(ZSTD_PARALLEL_BLOCK_SIZE)) {
+				SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_INTERNAL_ERROR, "invalid zstd block size");
+			}
+
+			std::unique_ptr<ZSTDParallelBlock> block = std::make_unique<ZSTDParallelBlock>();
+			block->input.resize(compressed_size);
+			this->ReadFully(block->input.data(), compressed_size);
+			block->output.resize(uncompressed_size);
+			this->blocks.Enqueue(std::move(block), &ZSTDParallelLoadFilter::Decompress);
+		}
+	}
+
+	size_t Read(uint8_t *buf, size_t size) override
+	{
+		size_t read = 0;
+		while (read < size) {
+			if (this->current == nullptr || this->current_pos == this->current->output.size()) {
+				this->current.reset();
+				this->QueueBlocks();
+				if (this->blocks.IsEmpty()) break;
+				this->current = this->blocks.PopFront();
+				this->current_pos = 0;
+				if (this->current->error) SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_INTERNAL_ERROR, "libzstd returned error code");
+			}
+
+			size_t to_read = std::min(size - read, this->current->output.size() - this->current_pos);
+			memcpy(buf + read, this->current->output.data() + this->current_pos, to_read);
+			this->current_pos += to_read;
+			read += to_read;
+		}
+		return read;
+	}
+};
+
+/**
+ * Filter using ZSTD compression, the savegame is split into blocks which are compressed in parallel on the worker pool.
+ * @see ZSTDParallelLoadFilter
+ */
+struct ZSTDParallelSaveFilter : SaveFilter {
+	ZSTDParallelBlocks blocks;                    ///< Blocks which are being compressed.
+	std::unique_ptr<ZSTDParallelBlock> current;   ///< Block currently being filled.
+	int compression_level;                        ///< zstd compression level.
+
+	/**
+	 * Initialise this filter.
+	 * @param chain             The next filter in this chain.
+	 * @param compression_level The requested level of compression.
+	 */
+	ZSTDParallelSaveFilter(std::shared_ptr<SaveFilter> chain, uint8_t compression_level) : SaveFilter(std::move(chain)), compression_level((int)compression_level - 100)
+	{
+		if (this->compression_level < ZSTD_minCLevel() || this->compression_level > ZSTD_maxCLevel()) {
+			SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_INTERNAL_ERROR, "invalid compression level");
+		}
+	}
+
+	static void Compress(ZSTDParallelBlock *block)
+	{
+		block->output.resize(ZSTD_PARALLEL_HEADER_SIZE + ZSTD_compressBound(block->input.size()));
+		size_t size = ZSTD_compress(block->output.data() + ZSTD_PARALLEL_HEADER_SIZE, block->output.size() - ZSTD_PARALLEL_HEADER_SIZE,
+				block->input.data(), block->input.size(), block->compression_level);
+		if (ZSTD_isError(size)) {
+			block->error = true;
+		} else {
+			const size_t uncompressed_size = block->input.size();
+			uint8_t *header = block->output.data();
+			header[0] = GB(size, 24, 8);
+			header[1] = GB(size, 16, 8);
+			header[2] = GB(size, 8, 8);
+			header[3] = GB(size, 0, 8);
+			header[4] = GB(uncompressed_size, 24, 8);
+			header[5] = GB(uncompressed_size, 16, 8);
+			header[6] = GB(uncompressed_size, 8, 8);
+			header[7] = GB(uncompressed_size, 0, 8);
+			block->output.resize(ZSTD_PARALLEL_HEADER_SIZE + size);
+		}
+		block->input = {};
+	}
+
+	/** Write the oldest queued block to the chain, once it has been compressed. */
+	void WriteBlock()
+	{
+		std::unique_ptr<ZSTDParallelBlock> block = this->blocks.PopFront();
+		if (block->error) SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_INTERNAL_ERROR, "libzstd returned error code");
+		this->chain->Write(block->output.data(), block->output.size());
+	}
+
+	/** Start compressing the current block. */
+	void QueueBlock()
+	{
+		this->current->compression_level = this->compression_level;
+		this->blocks.Enqueue(std::move(this->current), &ZSTDParallelSaveFilter::Compress);
+		while (this->blocks.IsFull()) this->WriteBlock();
+	}
+
+	void Write(uint8_t *buf, size_t size) override
+	{
+		while (size > 0) {
+			if (this->current == nullptr) {
+				this->current = std::make_unique<ZSTDParallelBlock>();
+				this->current->input.reserve(ZSTD_PARALLEL_BLOCK_SIZE);
+			}
+			size_t to_write = std::min(size, ZSTD_PARALLEL_BLOCK_SIZE - this->current->input.size());
+			this->current->input.insert(this->current->input.end(), buf, buf + to_write);
+			buf += to_write;
+			size -= to_write;
+			if (this->current->input.size() == ZSTD_PARALLEL_BLOCK_SIZE) this->QueueBlock();
+		}
+	}
+
+	void Finish() override
+	{
+		if (this->current != nullptr) this->QueueBlock();
+		while (!this->blocks.IsEmpty()) this->WriteBlock();
+
+		uint8_t terminator[ZSTD_PARALLEL_HEADER_SIZE] = {};
+		this->chain->Write(terminator, sizeof(terminator));
+		this->chain->Finish();
+	}
+};
+
 #endif /* WITH_LIBZSTD */
 
 /*******************************************
@@ -3418,6 +3762,7 @@ enum SaveLoadFormatFlags : uint8_t {
 	SLF_NONE             = 0,
 	SLF_NO_THREADED_LOAD = 1 << 0, ///< Unsuitable for threaded loading
 	SLF_REQUIRES_ZSTD    = 1 << 1, ///< Automatic selection requires the zstd flag
+	SLF_REQUIRES_ZSTD_PARALLEL = 1 << 2, ///< Automatic selection requires the block-parallel zstd flag
 };
 DECLARE_ENUM_AS_BIT_SET(SaveLoadFormatFlags);
 
@@ -3474,6 +3819,13 @@ static const SaveLoadFormat _saveload_formats[] = {
 #else
 	{"zstd",   TO_BE32X('OTTS'), nullptr,                            nullptr,                            0, 0, 0, SLF_REQUIRES_ZSTD},
 #endif
+#if defined(WITH_ZSTD)
+	/* The same compression as zstd, but split into independent 4 MB blocks which are compressed and decompressed in parallel
+	 * on the worker threads. Saves are slightly larger, but saving and loading large games scales with the number of cores. */
+	{"zstd-mt", TO_BE32X('OTTM'), CreateLoadFilter<ZSTDParallelLoadFilter>, CreateSaveFilter<ZSTDParallelSaveFilter>, 0, 101, 122, SLF_REQUIRES_ZSTD | SLF_REQUIRES_ZSTD_PARALLEL},
+#else
+	{"zstd-mt", TO_BE32X('OTTM'), nullptr,                           nullptr,                            0, 0, 0, SLF_REQUIRES_ZSTD | SLF_REQUIRES_ZSTD_PARALLEL},
+#endif
 };
 
 /**
@@ -3488,7 +3840,10 @@ static const SaveLoadFormat *GetSavegameFormat(const std::string &full_name, uin
 	const SaveLoadFormat *def = lastof(_saveload_formats);
 
 	/* find default savegame format, the highest one with which files can be written */
-	while (!def->init_write || ((def->flags & SLF_REQUIRES_ZSTD) && !(flags & SMF_ZSTD_OK))) def--;
+	while (!def->init_write || ((def->flags & SLF_REQUIRES_ZSTD) && !(flags & SMF_ZSTD_OK)) ||
+			((def->flags & SLF_REQUIRES_ZSTD_PARALLEL) && !(flags & SMF_ZSTD_PARALLEL_OK))) {
+		def--;
+	}
 
 	if (!full_name.empty()) {
 		/* Get the ":..." of the compression level out of the way */
@@ -3544,13 +3899,13 @@ static void ResetSaveloadData()
  */
 static inline void ClearSaveLoadState()
 {
-	_sl.dumper = nullptr;
-	_sl.sf = nullptr;
-	_sl.reader = nullptr;
-	_sl.lf = nullptr;
-	_sl.save_flags = SMF_NONE;
-	_sl.current_chunk_id = 0;
-	_sl.chunk_block_modes.clear();
+	_sl->dumper = nullptr;
+	_sl->sf = nullptr;
+	_sl->reader = nullptr;
+	_sl->lf = nullptr;
+	_sl->save_flags = SMF_NONE;
+	_sl->current_chunk_id = 0;
+	_sl->chunk_block_modes.clear();
 
 	GamelogStopAnyAction();
 }
@@ -3561,7 +3916,7 @@ static void SaveFileStart()
 	SetMouseCursorBusy(true);
 
 	InvalidateWindowData(WC_STATUS_BAR, 0, SBI_SAVELOAD_START);
-	_sl.saveinprogress = true;
+	_sl->saveinprogress = true;
 }
 
 /** Update the gui accordingly when saving is done and release locks on saveload. */
@@ -3570,7 +3925,7 @@ static void SaveFileDone()
 	SetMouseCursorBusy(false);
 
 	InvalidateWindowData(WC_STATUS_BAR, 0, SBI_SAVELOAD_FINISH);
-	_sl.saveinprogress = false;
+	_sl->saveinprogress = false;
 
 #ifdef __EMSCRIPTEN__
 	EM_ASM(if (window["openttd_syncfs"]) openttd_syncfs());
@@ -3580,15 +3935,15 @@ static void SaveFileDone()
 /** Set the error message from outside of the actual loading/saving of the game (AfterLoadGame and friends) */
 void SetSaveLoadError(StringID str)
 {
-	_sl.error_str = str;
+	_sl->error_str = str;
 }
 
 /** Get the string representation of the error message */
 std::string GetSaveLoadErrorString()
 {
-	SetDParam(0, _sl.error_str);
-	SetDParamStr(1, _sl.extra_msg);
-	return GetString(_sl.action == SLA_SAVE ? STR_ERROR_GAME_SAVE_FAILED : STR_ERROR_GAME_LOAD_FAILED);
+	SetDParam(0, _sl->error_str);
+	SetDParamStr(1, _sl->extra_msg);
+	return GetString(_sl->action == SLA_SAVE ? STR_ERROR_GAME_SAVE_FAILED : STR_ERROR_GAME_LOAD_FAILED);
 }
 
 /** Show a gui message when saving has failed */
@@ -3607,16 +3962,16 @@ static SaveOrLoadResult SaveFileToDisk(bool threaded)
 {
 	try {
 		uint8_t compression;
-		const SaveLoadFormat *fmt = GetSavegameFormat(_savegame_format, &compression, _sl.save_flags);
+		const SaveLoadFormat *fmt = GetSavegameFormat(_savegame_format, &compression, _sl->save_flags);
 
 		DEBUG(sl, 3, "Using compression format: %s, level: %u", fmt->name, compression);
 
 		/* We have written our stuff to memory, now write it to file! */
 		uint32_t hdr[2] = { fmt->tag, TO_BE32((uint32_t) (SAVEGAME_VERSION | SAVEGAME_VERSION_EXT) << 16) };
-		_sl.sf->Write((uint8_t*)hdr, sizeof(hdr));
+		_sl->sf->Write((uint8_t*)hdr, sizeof(hdr));
 
-		_sl.sf = fmt->init_write(_sl.sf, compression);
-		_sl.dumper->Flush(*(_sl.sf));
+		_sl->sf = fmt->init_write(_sl->sf, compression);
+		_sl->dumper->Flush(*(_sl->sf));
 
 		ClearSaveLoadState();
 
@@ -3630,7 +3985,7 @@ static SaveOrLoadResult SaveFileToDisk(bool threaded)
 
 		/* We don't want to shout when saving is just
 		 * cancelled due to a client disconnecting. */
-		if (_sl.error_str != STR_NETWORK_ERROR_LOSTCONNECTION) {
+		if (_sl->error_str != STR_NETWORK_ERROR_LOSTCONNECTION) {
 			/* Skip the "colour" character */
 			DEBUG(sl, 0, "%s", strip_leading_colours(GetSaveLoadErrorString()));
 			asfp = SaveFileError;
@@ -3660,16 +4015,16 @@ void WaitTillSaved()
  */
 static SaveOrLoadResult DoSave(std::shared_ptr<SaveFilter> writer, bool threaded)
 {
-	assert(!_sl.saveinprogress);
+	assert(!_sl->saveinprogress);
 
-	_sl.dumper = std::make_unique<MemoryDumper>();
-	_sl.sf = std::move(writer);
+	_sl->dumper = std::make_unique<MemoryDumper>();
+	_sl->sf = std::move(writer);
 
 	_sl_version = SAVEGAME_VERSION;
 	SlXvSetCurrentState();
 
 	SaveViewportBeforeSaveGame();
-	SlSaveChunks();
+	SlSaveChunks(ChunkHandlers());
 
 	SaveFileStart();
 
@@ -3695,8 +4050,8 @@ static SaveOrLoadResult DoSave(std::shared_ptr<SaveFilter> writer, bool threaded
 SaveOrLoadResult SaveWithFilter(std::shared_ptr<SaveFilter> writer, bool threaded, SaveModeFlags flags)
 {
 	try {
-		_sl.action = SLA_SAVE;
-		_sl.save_flags = flags;
+		_sl->action = SLA_SAVE;
+		_sl->save_flags = flags;
 		return DoSave(std::move(writer), threaded);
 	} catch (...) {
 		ClearSaveLoadState();
@@ -3704,14 +4059,39 @@ SaveOrLoadResult SaveWithFilter(std::shared_ptr<SaveFilter> writer, bool threade
 	}
 }
 
+/**
+ * Save only the given chunks, without the savegame header and compression.
+ * This allows testing the saving of chunks without a loaded game.
+ * @param handlers The chunk handlers to save, instead of those of the game.
+ * @param writer The filter to write the chunks to.
+ * @param[out] error_msg The extra error message when saving failed.
+ * @return Return the result of the action. #SL_OK or #SL_ERROR
+ */
+SaveOrLoadResult SaveChunksWithFilter(const std::vector<ChunkHandler> &handlers, SaveFilter &writer, std::string &error_msg)
+{
+	try {
+		_sl->action = SLA_SAVE;
+		_sl->save_flags = SMF_NONE;
+		_sl->dumper = std::make_unique<MemoryDumper>();
+		SlSaveChunks(handlers);
+		_sl->dumper->Flush(writer);
+		ClearSaveLoadState();
+		return SL_OK;
+	} catch (...) {
+		error_msg = _sl->extra_msg;
+		ClearSaveLoadState();
+		return SL_ERROR;
+	}
+}
+
 bool IsNetworkServerSave()
 {
-	return _sl.save_flags & SMF_NET_SERVER;
+	return _sl->save_flags & SMF_NET_SERVER;
 }
 
 bool IsScenarioSave()
 {
-	return _sl.save_flags & SMF_SCENARIO;
+	return _sl->save_flags & SMF_SCENARIO;
 }
 
 struct ThreadedLoadFilter : LoadFilter {
@@ -3828,7 +4208,7 @@ struct ThreadedLoadFilter : LoadFilter {
  */
 static SaveOrLoadResult DoLoad(std::shared_ptr<LoadFilter> reader, bool load_check)
 {
-	_sl.lf = std::move(reader);
+	_sl->lf = std::move(reader);
 
 	if (load_check) {
 		/* Clear previous check data */
@@ -3846,7 +4226,7 @@ static SaveOrLoadResult DoLoad(std::shared_ptr<LoadFilter> reader, bool load_che
 	});
 
 	uint32_t hdr[2];
-	if (_sl.lf->Read((uint8_t*)hdr, sizeof(hdr)) != sizeof(hdr)) SlError(STR_GAME_SAVELOAD_ERROR_FILE_NOT_READABLE);
+	if (_sl->lf->Read((uint8_t*)hdr, sizeof(hdr)) != sizeof(hdr)) SlError(STR_GAME_SAVELOAD_ERROR_FILE_NOT_READABLE);
 
 	SaveLoadVersion original_sl_version = SL_MIN_VERSION;
 
@@ -3856,7 +4236,7 @@ static SaveOrLoadResult DoLoad(std::shared_ptr<LoadFilter> reader, bool load_che
 		/* No loader found, treat as version 0 and use LZO format */
 		if (fmt == endof(_saveload_formats)) {
 			DEBUG(sl, 0, "Unknown savegame type, trying to load it as the buggy format");
-			_sl.lf->Reset();
+			_sl->lf->Reset();
 			_sl_version = SL_MIN_VERSION;
 			_sl_minor_version = 0;
 			SlXvResetState();
@@ -3920,11 +4300,11 @@ static SaveOrLoadResult DoLoad(std::shared_ptr<LoadFilter> reader, bool load_che
 		SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_INTERNAL_ERROR, err_str);
 	}
 
-	_sl.lf = fmt->init_load(std::move(_sl.lf));
+	_sl->lf = fmt->init_load(std::move(_sl->lf));
 	if (!(fmt->flags & SLF_NO_THREADED_LOAD)) {
-		_sl.lf = std::make_shared<ThreadedLoadFilter>(std::move(_sl.lf));
+		_sl->lf = std::make_shared<ThreadedLoadFilter>(std::move(_sl->lf));
 	}
-	_sl.reader = std::make_unique<ReadBuffer>(_sl.lf);
+	_sl->reader = std::make_unique<ReadBuffer>(_sl->lf);
 	_next_offs = 0;
 
 	upstream_sl::SlResetLoadState();
@@ -4066,7 +4446,7 @@ static SaveOrLoadResult DoLoad(std::shared_ptr<LoadFilter> reader, bool load_che
 SaveOrLoadResult LoadWithFilter(std::shared_ptr<LoadFilter> reader)
 {
 	try {
-		_sl.action = SLA_LOAD;
+		_sl->action = SLA_LOAD;
 		return DoLoad(std::move(reader), false);
 	} catch (...) {
 		ClearSaveLoadState();
@@ -4090,7 +4470,7 @@ SaveOrLoadResult LoadWithFilter(std::shared_ptr<LoadFilter> reader)
 SaveOrLoadResult SaveOrLoad(const std::string &filename, SaveLoadOperation fop, DetailedFileType dft, Subdirectory sb, bool threaded, SaveModeFlags save_flags)
 {
 	/* An instance of saving is already active, so don't go saving again */
-	if (_sl.saveinprogress && fop == SLO_SAVE && dft == DFT_GAME_FILE && threaded) {
+	if (_sl->saveinprogress && fop == SLO_SAVE && dft == DFT_GAME_FILE && threaded) {
 		/* if not an autosave, but a user action, show error message */
 		if (!_do_autosave) ShowErrorMessage(STR_ERROR_SAVE_STILL_IN_PROGRESS, INVALID_STRING_ID, WL_ERROR);
 		return SL_OK;
@@ -4129,20 +4509,20 @@ SaveOrLoadResult SaveOrLoad(const std::string &filename, SaveLoadOperation fop,
 		assert(dft == DFT_GAME_FILE);
 		switch (fop) {
 			case SLO_CHECK:
-				_sl.action = SLA_LOAD_CHECK;
+				_sl->action = SLA_LOAD_CHECK;
 				break;
 
 			case SLO_LOAD:
-				_sl.action = SLA_LOAD;
+				_sl->action = SLA_LOAD;
 				break;
 
 			case SLO_SAVE:
-				_sl.action = SLA_SAVE;
+				_sl->action = SLA_SAVE;
 				break;
 
 			default: NOT_REACHED();
 		}
-		_sl.save_flags = save_flags;
+		_sl->save_flags = save_flags;
 
 		FILE *fh = nullptr;
 		std::string temp_save_filename;
@@ -4332,7 +4712,7 @@ SaveLoadVersion GeneralUpstreamChunkLoadInfo::GetLoadVersion()
 {
 	extern SaveLoadVersion _sl_xv_upstream_version;
 
-	uint8_t block_mode = _sl.chunk_block_modes[_sl.current_chunk_id];
+	uint8_t block_mode = _sl->chunk_block_modes[_sl->current_chunk_id];
 	return (block_mode == CH_TABLE || block_mode == CH_SPARSE_TABLE) ? _sl_xv_upstream_version : _sl_version;
 }
 
@@ -61,6 +61,7 @@ enum SaveModeFlags : uint8_t {
 	SMF_NET_SERVER       = 1 << 0, ///< Network server save
 	SMF_ZSTD_OK          = 1 << 1, ///< Zstd OK
 	SMF_SCENARIO         = 1 << 2, ///< Scenario save
+	SMF_ZSTD_PARALLEL_OK = 1 << 3, ///< Block-parallel zstd OK
 };
 DECLARE_ENUM_AS_BIT_SET(SaveModeFlags);
 
@@ -123,6 +124,7 @@ struct ChunkHandler {
 	ChunkSaveLoadProc *load_check_proc; ///< Load procedure for game preview.
 	ChunkType type;                     ///< Type of the chunk. @see ChunkType
 	ChunkSaveLoadSpecialProc *special_proc = nullptr;
+	bool parallel_save = false;         ///< The save procedure only reads state which is not modified by any save procedure, so may be run in parallel with them.
 };
 
 struct ChunkIDDumper {
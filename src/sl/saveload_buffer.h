@@ -189,6 +189,7 @@ struct MemoryDumper {
 
 	void FinaliseBlock();
 	void AllocateBuffer();
+	void AppendBlocks(MemoryDumper &other);
 
 	inline void CheckBytes(size_t bytes)
 	{
@@ -69,4 +69,6 @@ Order UnpackOldOrder(uint16_t packed);
 
 void ResetSettingsToDefaultForLoad();
 
+SaveOrLoadResult SaveChunksWithFilter(const std::vector<ChunkHandler> &handlers, struct SaveFilter &writer, std::string &error_msg);
+
 #endif /* SL_SAVELOAD_INTERNAL_H */
@@ -12,6 +12,7 @@
 #include "spriteloader/grf.hpp"
 #include "gfx_func.h"
 #include "error.h"
+#include "fileio_func.h"
 #include "zoom_func.h"
 #include "settings_type.h"
 #include "blitter/factory.hpp"
@@ -19,18 +20,28 @@
 #include "core/math_func.hpp"
 #include "core/mem_func.hpp"
 #include "video/video_driver.hpp"
+#include "viewport_func.h"
 #include "scope_info.h"
 #include "spritecache.h"
 #include "spritecache_internal.h"
+#include "spritecache_disk.h"
+#include "spritecache_arena.h"
 
 #include "table/sprites.h"
 #include "table/strings.h"
 #include "table/palette_convert.h"
 
+#include "worker_thread.h"
+
 #include "3rdparty/cpp-btree/btree_map.h"
+#include "3rdparty/cpp-btree/btree_set.h"
 
 #include <vector>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
 
 #include "safeguards.h"
 
@@ -38,20 +49,39 @@
 uint _sprite_cache_size = 4;
 
 size_t _spritecache_bytes_used = 0;
-static uint32_t _sprite_lru_counter;
 static uint32_t _spritecache_prune_events = 0;
 static size_t _spritecache_prune_entries = 0;
 static size_t _spritecache_prune_total = 0;
+static uint64_t _spritecache_hits = 0;
+static uint64_t _spritecache_misses = 0;
+static std::chrono::steady_clock::time_point _spritecache_stats_start;
+static std::chrono::steady_clock::time_point _spritecache_stats_last_dump;
+static size_t _spritecache_stats_last_dump_entries = 0;
+static bool _prefetched_sprites_inserted = false; ///< Whether background decodes completed since viewports waiting for them were last redrawn, main thread only.
+
+/* The arena must be constructed before, and so destroyed after, everything which holds sprite data */
+SpriteArena _sprite_arena;
+SpriteLRUList _sprite_lru;
 
 static std::vector<SpriteCache> _spritecache;
 static SpriteDataBuffer _last_sprite_allocation;
 static std::vector<std::unique_ptr<SpriteFile>> _sprite_files;
 
+bool _sprite_disk_cache_enabled = true; ///< Whether to use the sprite disk cache.
+
+/** Sprite disk caches of the sprite files, nullptr for files without a disk cache. */
+static btree::btree_map<const SpriteFile *, std::unique_ptr<SpriteDiskCache>> _sprite_disk_caches;
+
 static inline SpriteCache *GetSpriteCache(uint index)
 {
 	return &_spritecache[index];
 }
 
+SpriteID GetSpriteCacheIndex(const SpriteCache *sc)
+{
+	return static_cast<SpriteID>(sc - _spritecache.data());
+}
+
 SpriteCache *AllocateSpriteCache(uint index)
 {
 	if (index >= _spritecache.size()) {
@@ -493,6 +523,44 @@ static const char *GetSpriteTypeName(SpriteType type)
 	return sprite_types[static_cast<uint8_t>(type)];
 }
 
+/**
+ * Get the sprite disk cache of a sprite file, for sprites encoded by the current blitter.
+ * @param file The sprite file.
+ * @return The sprite disk cache, or nullptr if the file has no disk cache.
+ */
+static SpriteDiskCache *GetSpriteDiskCache(const SpriteFile *file)
+{
+	if (!_sprite_disk_cache_enabled || file == nullptr) return nullptr;
+
+	auto it = _sprite_disk_caches.find(file);
+	if (it != _sprite_disk_caches.end()) return it->second.get();
+
+	std::unique_ptr<SpriteDiskCache> &cache = _sprite_disk_caches[file];
+	Blitter *blitter = BlitterFactory::GetCurrentBlitter();
+	if (blitter == nullptr || blitter->NoSpriteDataRequired() || !file->GetContentMD5().has_value()) return nullptr;
+
+	/* The MD5 is from when the file was scanned, the file may have been changed since then */
+	uint64_t source_size;
+	int64_t source_mtime;
+	if (!file->GetFileStatus(source_size, source_mtime)) return nullptr;
+
+	/* Everything other than the sprite file which affects how its sprites are encoded */
+	const uint8_t config[] = { file->NeedsPaletteRemap(), (uint8_t)_settings_client.gui.sprite_zoom_min, file->GetContainerVersion() };
+	const uint32_t config_hash = SpriteDiskCacheChecksum(config, sizeof(config), SpriteDiskCacheChecksum(_cur_palette.palette, PALETTE_ANIM_START * sizeof(Colour)));
+	cache = SpriteDiskCache::Open(*file->GetContentMD5(), source_size, source_mtime, blitter->GetName(), config_hash);
+	return cache.get();
+}
+
+static SpriteDiskCache::Key GetSpriteDiskCacheKey(size_t file_pos, uint count, uint16_t flags, uint8_t zoom_levels)
+{
+	SpriteDiskCache::Key key;
+	key.file_pos = file_pos;
+	key.count = count;
+	key.flags = flags & ~(1 << SCCF_WARNED);
+	key.zoom_levels = zoom_levels;
+	return key;
+}
+
 /**
  * Read a sprite from disk.
  * @param sc          Location of sprite.
@@ -516,6 +584,17 @@ static void *ReadSprite(const SpriteCache *sc, SpriteID id, SpriteType sprite_ty
 	SpriteFile &file = *sc->file;
 	size_t file_pos = sc->file_pos;
 
+	/* Sprites loaded into the sprite cache for the current blitter may be in the sprite disk cache */
+	SpriteDiskCache *disk_cache = nullptr;
+	SpriteDiskCache::Key disk_cache_key{};
+	if (sprite_type == SpriteType::Normal && allocator == AllocSprite && encoder == BlitterFactory::GetCurrentBlitter()) {
+		disk_cache = GetSpriteDiskCache(&file);
+		if (disk_cache != nullptr) {
+			disk_cache_key = GetSpriteDiskCacheKey(file_pos, sc->count, sc->flags, zoom_levels);
+			if (disk_cache->Load(disk_cache_key, _last_sprite_allocation)) return _last_sprite_allocation.GetPtr();
+		}
+	}
+
 	SCOPE_INFO_FMT([&], "ReadSprite: pos: " PRINTF_SIZE ", id: %u, file: (%s), type: %s", file_pos, id, file.GetSimplifiedFilename().c_str(), GetSpriteTypeName(sprite_type));
 
 	assert(sprite_type != SpriteType::Recolour);
@@ -595,7 +674,9 @@ static void *ReadSprite(const SpriteCache *sc, SpriteID id, SpriteType sprite_ty
 		}
 	}
 
-	return encoder->Encode(sprite, allocator);
+	void *encoded = encoder->Encode(sprite, allocator);
+	if (disk_cache != nullptr) disk_cache->Store(disk_cache_key, _last_sprite_allocation.GetPtr(), _last_sprite_allocation.GetSize());
+	return encoded;
 }
 
 struct GrfSpriteOffset {
@@ -773,9 +854,14 @@ void DupSprite(SpriteID old_spr, SpriteID new_spr)
 	scnew->SetWarned(false);
 }
 
-static size_t GetSpriteCacheUsage()
+/**
+ * Get the memory used by the sprite cache, which is counted against its budget.
+ * Free slots in partially used slabs are not counted, as they are reused before the arena grows.
+ * @return The memory used, including size class rounding, slab headers and allocator overhead.
+ */
+size_t GetSpriteCacheUsage()
 {
-	return _spritecache_bytes_used;
+	return _sprite_arena.GetStats().live_bytes;
 }
 
 /**
@@ -787,79 +873,35 @@ static void DeleteEntryFromSpriteCache(uint item)
 	GetSpriteCache(item)->Clear();
 }
 
-static void DeleteEntriesFromSpriteCache(size_t target)
+/**
+ * Evict the least recently used sprite structures from the sprite cache, until the memory used by the sprite cache is within a target.
+ * @param target Target memory usage, including allocator overhead.
+ */
+void DeleteEntriesFromSpriteCache(size_t target)
 {
 	const size_t initial_in_use = GetSpriteCacheUsage();
 
-	struct SpriteInfo {
-		uint32_t lru;
-		SpriteID id;
-		uint32_t size;
-		uint8_t missing_zoom_levels;
-
-		bool operator<(const SpriteInfo &other) const
-		{
-			return this->lru < other.lru;
-		}
-	};
-	std::vector<SpriteInfo> candidates;
-	size_t candidate_bytes = 0;
-
-	auto push = [&](SpriteInfo info) {
-		candidates.push_back(info);
-		std::push_heap(candidates.begin(), candidates.end());
-		candidate_bytes += info.size;
-	};
-
-	auto pop = [&]() {
-		candidate_bytes -= candidates.front().size;
-		std::pop_heap(candidates.begin(), candidates.end());
-		candidates.pop_back();
-	};
-
-	size_t total_candidates = 0;
-	SpriteID i = 0;
-	for (; i != _spritecache.size() && candidate_bytes < target; i++) {
-		SpriteCache *sc = GetSpriteCache(i);
-		if (sc->GetType() != SpriteType::Recolour) {
-			Sprite *sp = (Sprite *)sc->GetPtr();
-			while (sp != nullptr) {
-				push({ sp->lru, i, sp->size, sp->missing_zoom_levels });
-				total_candidates++;
-				sp = sp->next;
-			}
-			if (candidate_bytes >= target) break;
-		}
-	}
-	for (; i != _spritecache.size(); i++) {
-		SpriteCache *sc = GetSpriteCache(i);
-		if (sc->GetType() != SpriteType::Recolour) {
-			Sprite *sp = (Sprite *)sc->GetPtr();
-			while (sp != nullptr) {
-				total_candidates++;
-
-				/* Only add to candidates if LRU <= current highest */
-				if (sp->lru <= candidates.front().lru) {
-					push({ sp->lru, i, sp->size, sp->missing_zoom_levels });
-					while (!candidates.empty() && candidate_bytes - candidates.front().size >= target) {
-						pop();
-					}
-				}
-				sp = sp->next;
-			}
-		}
+	size_t deleted = 0;
+	size_t deleted_bytes = 0;
+	size_t in_use = initial_in_use;
+	while (in_use > target && _sprite_lru.tail != nullptr) {
+		Sprite *sp = _sprite_lru.tail;
+		deleted++;
+		deleted_bytes += sp->size;
+		GetSpriteCache(sp->id)->Remove(sp);
+		in_use = GetSpriteCacheUsage();
 	}
 
-	for (auto &it : candidates) {
-		GetSpriteCache(it.id)->RemoveByMissingZoomLevels(it.missing_zoom_levels);
-	}
+	/* Release the slabs which became empty */
+	_sprite_arena.Trim();
+	in_use = GetSpriteCacheUsage();
 
-	DEBUG(sprite, 3, "DeleteEntriesFromSpriteCache, deleted: " PRINTF_SIZE " of " PRINTF_SIZE ", freed: " PRINTF_SIZE ", in use: " PRINTF_SIZE " --> " PRINTF_SIZE ", delta: " PRINTF_SIZE ", requested: " PRINTF_SIZE,
-			candidates.size(), total_candidates, candidate_bytes, initial_in_use, GetSpriteCacheUsage(), initial_in_use - GetSpriteCacheUsage(), target);
+	DEBUG(sprite, 3, "DeleteEntriesFromSpriteCache, deleted: " PRINTF_SIZE ", freed: " PRINTF_SIZE ", in use: " PRINTF_SIZE " --> " PRINTF_SIZE ", delta: " PRINTF_SIZE ", target: " PRINTF_SIZE,
+			deleted, deleted_bytes, initial_in_use, in_use, initial_in_use - in_use, target);
 
 	_spritecache_prune_events++;
-	_spritecache_prune_entries += candidates.size();
-	_spritecache_prune_total += (initial_in_use - GetSpriteCacheUsage());
+	_spritecache_prune_entries += deleted;
+	_spritecache_prune_total += (initial_in_use - in_use);
 }
 
 uint GetTargetSpriteSize()
@@ -868,32 +910,20 @@ uint GetTargetSpriteSize()
 	return (bpp > 0 ? _sprite_cache_size * bpp / 8 : 1) * 1024 * 1024;
 }
 
+/**
+ * Keep the memory used by the sprite cache within its budget, this must only be called when no render jobs are using cached sprite pointers.
+ */
 void IncreaseSpriteLRU()
 {
-	uint target_size = GetTargetSpriteSize();
-	if (_spritecache_bytes_used > target_size) {
-		DeleteEntriesFromSpriteCache(_spritecache_bytes_used - target_size + 512 * 1024);
+	ProcessPrefetchedSprites();
+	if (_prefetched_sprites_inserted) {
+		_prefetched_sprites_inserted = false;
+		MarkViewportsWithPendingSpritesDirty();
 	}
 
-	/* Adjust all LRU values */
-	if (_sprite_lru_counter >= 0xC0000000) {
-		DEBUG(sprite, 5, "Fixing lru %u, inuse=" PRINTF_SIZE, _sprite_lru_counter, GetSpriteCacheUsage());
-
-		for (SpriteID i = 0; i != _spritecache.size(); i++) {
-			SpriteCache *sc = GetSpriteCache(i);
-			if (sc->GetType() != SpriteType::Recolour) {
-				Sprite *sp = (Sprite *)sc->GetPtr();
-				while (sp != nullptr) {
-					if (sp->lru > 0x80000000) {
-						sp->lru -= 0x80000000;
-					} else {
-						sp->lru = 0;
-					}
-					sp = sp->next;
-				}
-			}
-		}
-		_sprite_lru_counter -= 0x80000000;
+	const size_t target_size = GetTargetSpriteSize();
+	if (GetSpriteCacheUsage() > target_size) {
+		DeleteEntriesFromSpriteCache(target_size - std::min<size_t>(512 * 1024, target_size / 8));
 	}
 }
 
@@ -981,6 +1011,11 @@ void *GetRawSprite(SpriteID sprite, SpriteType type, uint8_t zoom_levels, Alloca
 		if (type != SpriteType::Normal) zoom_levels = UINT8_MAX;
 
 		/* Load the sprite, if it is not loaded, yet */
+		if (sc->GetPtr() == nullptr || (type == SpriteType::Normal && (sc->total_missing_zoom_levels & zoom_levels) != 0)) {
+			_spritecache_misses++;
+		} else {
+			_spritecache_hits++;
+		}
 		if (sc->GetPtr() == nullptr) {
 			[[maybe_unused]] void *ptr = ReadSprite(sc, sprite, type, AllocSprite, nullptr, zoom_levels);
 			assert(ptr == _last_sprite_allocation.GetPtr());
@@ -998,7 +1033,7 @@ void *GetRawSprite(SpriteID sprite, SpriteType type, uint8_t zoom_levels, Alloca
 				uint8_t usable = ~sp->missing_zoom_levels;
 				if (usable & lvls) {
 					/* Update LRU */
-					sp->lru = ++_sprite_lru_counter;
+					_sprite_lru.Touch(sp);
 					lvls &= ~usable;
 				}
 				sp = sp->next;
@@ -1012,6 +1047,336 @@ void *GetRawSprite(SpriteID sprite, SpriteType type, uint8_t zoom_levels, Alloca
 	}
 }
 
+/** Request to decode a sprite on a worker thread. */
+struct SpriteDecodeRequest {
+	SpriteID id;            ///< The sprite.
+	const SpriteFile *file; ///< The file of the sprite, only its immutable properties are used on the worker thread.
+	size_t file_pos;        ///< Position of the sprite in the file.
+	uint count;             ///< Sprite count of the cache entry.
+	uint16_t flags;         ///< Control flags of the cache entry, see SpriteCacheCtrlFlags.
+	uint8_t zoom_levels;    ///< Zoom levels to decode.
+};
+
+/** Sprite decoded on a worker thread. */
+struct DecodedSprite {
+	SpriteDecodeRequest req; ///< The request which was decoded.
+	uint32_t generation;     ///< Sprite cache generation the sprite was decoded in.
+	SpriteDataBuffer data;   ///< Encoded sprite data, empty if decoding failed.
+};
+
+/** Batch of background sprite decode requests. */
+struct SpritePrefetchBatch {
+	std::vector<SpriteDecodeRequest> requests;
+	SpriteEncoder *encoder;
+	uint32_t generation;
+};
+
+static std::atomic<uint32_t> _sprite_cache_generation = 0;   ///< Incremented whenever the sprite cache is cleared, to drop stale decoded sprites.
+static std::mutex _sprite_prefetch_mutex;
+static std::condition_variable _sprite_prefetch_cv;
+static uint _sprite_prefetch_outstanding = 0;                 ///< Number of background batches not yet completed, guarded by _sprite_prefetch_mutex.
+static std::vector<DecodedSprite> _sprite_prefetch_results;   ///< Completed background decodes, guarded by _sprite_prefetch_mutex.
+static btree::btree_set<SpriteID> _sprites_being_prefetched; ///< Sprites with outstanding background decodes, main thread only.
+static btree::btree_set<SpriteID> _sprites_failed_prefetch;  ///< Sprites which failed to decode in the background, these are left to the main thread to report, main thread only.
+static const size_t MAX_SPRITES_BEING_PREFETCHED = 4096;
+static const size_t SPRITE_PREFETCH_BATCH_SIZE = 32;
+static const size_t MAX_THREAD_SPRITE_FILES = 4;              ///< Maximum number of sprite file handles kept open by each thread decoding sprites.
+
+static thread_local SpriteDataBuffer _decoded_sprite_allocation;
+
+static void *AllocDecodedSprite(size_t mem_req)
+{
+	assert(_decoded_sprite_allocation.GetPtr() == nullptr);
+	_decoded_sprite_allocation.Allocate((uint32_t)mem_req);
+	return _decoded_sprite_allocation.GetPtr();
+}
+
+/**
+ * Get this thread's own handle of a sprite file, as the file position of the sprite cache's handle is not thread-safe.
+ * Only the few most recently used handles are kept open.
+ * @param file The sprite cache's file.
+ * @param generation The current sprite cache generation.
+ * @return The file handle for this thread, or nullptr if the file could not be opened.
+ */
+static SpriteFile *GetThreadSpriteFile(const SpriteFile *file, uint32_t generation)
+{
+	/* Most recently used first */
+	thread_local std::vector<std::pair<const SpriteFile *, std::unique_ptr<SpriteFile>>> files;
+	thread_local uint32_t files_generation = 0;
+	if (files_generation != generation) {
+		files.clear();
+		files_generation = generation;
+	}
+	for (auto it = files.begin(); it != files.end(); ++it) {
+		if (it->first == file) {
+			std::rotate(files.begin(), it, it + 1);
+			return files.front().second.get();
+		}
+	}
+
+	/* Don't let the file constructor fail with usererror, this may not be the main thread */
+	FILE *handle = FioFOpenFile(file->GetFilename(), "rb", file->GetSubdirectory());
+	if (handle == nullptr) return nullptr;
+
+	if (files.size() >= MAX_THREAD_SPRITE_FILES) files.pop_back();
+	files.emplace(files.begin(), file, std::make_unique<SpriteFile>(file->GetFilename(), handle, file->GetSubdirectory(), file->NeedsPaletteRemap()));
+	files.front().second->flags = file->flags;
+	return files.front().second.get();
+}
+
+/**
+ * Decode and encode a normal sprite, this may be called on any thread.
+ * This is the equivalent of ReadSprite, except that failures are left to the main thread.
+ * @param req The sprite to decode.
+ * @param encoder Sprite encoder to use.
+ * @param generation The sprite cache generation.
+ * @param[out] result The encoded sprite.
+ */
+static void DecodeSprite(const SpriteDecodeRequest &req, SpriteEncoder *encoder, uint32_t generation, SpriteDataBuffer &result)
+{
+	SpriteFile *thread_file = GetThreadSpriteFile(req.file, generation);
+	if (thread_file == nullptr) return;
+	SpriteFile &file = *thread_file;
+
+	SpriteLoader::SpriteCollection sprite;
+	uint8_t sprite_avail = 0;
+	sprite[ZOOM_LVL_NORMAL].type = SpriteType::Normal;
+
+	SpriteLoaderGrf sprite_loader(file.GetContainerVersion());
+	if (GB(req.flags, SCC_32BPP_ZOOM_START, 6) != 0 && encoder->Is32BppSupported()) {
+		sprite_avail = sprite_loader.LoadSprite(sprite, file, req.file_pos, SpriteType::Normal, true, req.count, req.flags, req.zoom_levels);
+	}
+	if (sprite_avail == 0) {
+		sprite_avail = sprite_loader.LoadSprite(sprite, file, req.file_pos, SpriteType::Normal, false, req.count, req.flags, req.zoom_levels);
+	}
+	if (sprite_avail == 0) return;
+
+	if (!ResizeSprites(sprite, sprite_avail, encoder, req.zoom_levels)) return;
+
+	for (ZoomLevel zoom = ZOOM_LVL_BEGIN; zoom != ZOOM_LVL_SPR_END; zoom++) {
+		if (!HasBit(req.zoom_levels, zoom)) sprite[zoom].data = nullptr;
+	}
+
+	encoder->Encode(sprite, AllocDecodedSprite);
+	result = std::move(_decoded_sprite_allocation);
+}
+
+/**
+ * Get the zoom levels of a sprite which need to be loaded into the sprite cache, if it can be decoded on a worker thread.
+ * @param id The sprite.
+ * @param encoder The sprite encoder.
+ * @param zoom The zoom level which is needed.
+ * @return The zoom levels to decode, or 0 if none.
+ */
+static uint8_t GetSpriteZoomLevelsToDecode(SpriteID id, SpriteEncoder *encoder, ZoomLevel zoom)
+{
+	if (id == 0 || !SpriteExists(id)) return 0;
+	const SpriteCache *sc = GetSpriteCache(id);
+	if (sc->GetType() != SpriteType::Normal || sc->file == nullptr) return 0;
+
+	const uint8_t zoom_levels = encoder->SupportsMissingZoomLevels() ? ZoomMask(zoom) : UINT8_MAX;
+	if (sc->GetPtr() == nullptr) return zoom_levels;
+	return sc->total_missing_zoom_levels & zoom_levels;
+}
+
+static SpriteDecodeRequest MakeSpriteDecodeRequest(SpriteID id, uint8_t zoom_levels)
+{
+	const SpriteCache *sc = GetSpriteCache(id);
+	return { id, sc->file, sc->file_pos, sc->count, sc->flags, zoom_levels };
+}
+
+/**
+ * Insert a sprite decoded on a worker thread into the sprite cache, unless the cache entry has changed such that it is no longer useful.
+ * @param id The sprite.
+ * @param data The encoded sprite.
+ */
+static void InsertDecodedSprite(SpriteID id, SpriteDataBuffer &&data)
+{
+	if (data.GetPtr() == nullptr || id >= _spritecache.size()) return;
+	SpriteCache *sc = GetSpriteCache(id);
+	if (sc->GetType() != SpriteType::Normal) return;
+
+	const Sprite *sp = (const Sprite *)data.GetPtr();
+	if (sc->GetPtr() == nullptr) {
+		sc->Assign(std::move(data));
+		return;
+	}
+
+	const uint8_t all_levels = (1 << ZOOM_LVL_SPR_COUNT) - 1;
+	const uint8_t provided = ~sp->missing_zoom_levels & all_levels;
+	if (provided != 0 && (provided & ~sc->total_missing_zoom_levels) == 0) {
+		sc->Append(std::move(data));
+	}
+}
+
+/**
+ * Load the sprite of a decode request from the sprite disk cache, and insert it into the sprite cache.
+ * @param req The sprite.
+ * @return True if the sprite was in the sprite disk cache.
+ */
+static bool LoadDecodeRequestFromDiskCache(const SpriteDecodeRequest &req)
+{
+	SpriteDiskCache *disk_cache = GetSpriteDiskCache(req.file);
+	if (disk_cache == nullptr) return false;
+
+	SpriteDataBuffer buffer;
+	if (!disk_cache->Load(GetSpriteDiskCacheKey(req.file_pos, req.count, req.flags, req.zoom_levels), buffer)) return false;
+	InsertDecodedSprite(req.id, std::move(buffer));
+	return true;
+}
+
+/**
+ * Store a sprite decoded on a worker thread in the sprite disk cache.
+ * @param req The sprite.
+ * @param data The encoded sprite.
+ */
+static void StoreDecodedSpriteInDiskCache(const SpriteDecodeRequest &req, SpriteDataBuffer &data)
+{
+	if (data.GetPtr() == nullptr) return;
+	SpriteDiskCache *disk_cache = GetSpriteDiskCache(req.file);
+	if (disk_cache != nullptr) disk_cache->Store(GetSpriteDiskCacheKey(req.file_pos, req.count, req.flags, req.zoom_levels), data.GetPtr(), data.GetSize());
+}
+
+/**
+ * Insert sprites which were decoded in the background into the sprite cache.
+ */
+void ProcessPrefetchedSprites()
+{
+	std::vector<DecodedSprite> results;
+	{
+		std::lock_guard<std::mutex> lock(_sprite_prefetch_mutex);
+		if (_sprite_prefetch_results.empty()) return;
+		results.swap(_sprite_prefetch_results);
+	}
+
+	const uint32_t generation = _sprite_cache_generation.load(std::memory_order_relaxed);
+	for (DecodedSprite &result : results) {
+		if (result.generation != generation) continue;
+		_sprites_being_prefetched.erase(result.req.id);
+		if (result.data.GetPtr() == nullptr) _sprites_failed_prefetch.insert(result.req.id);
+		StoreDecodedSpriteInDiskCache(result.req, result.data);
+		InsertDecodedSprite(result.req.id, std::move(result.data));
+	}
+	_prefetched_sprites_inserted = true;
+}
+
+/**
+ * Wait for all background sprite decodes to complete, and discard their results.
+ * This must be called before sprite files are closed or sprite cache entries are cleared.
+ */
+static void CancelSpritePrefetch()
+{
+	{
+		std::unique_lock<std::mutex> lock(_sprite_prefetch_mutex);
+		_sprite_prefetch_cv.wait(lock, []() { return _sprite_prefetch_outstanding == 0; });
+		_sprite_prefetch_results.clear();
+	}
+	_sprites_being_prefetched.clear();
+	_sprites_failed_prefetch.clear();
+	_sprite_cache_generation++;
+
+	/* Viewports drawn without the cancelled sprites still need redrawing */
+	_prefetched_sprites_inserted = true;
+}
+
+/**
+ * Decode sprites needed at a zoom level which are not yet cached in the background on the worker threads, without waiting for them.
+ * The decoded sprites are inserted into the sprite cache by ProcessPrefetchedSprites.
+ * @param sprites The sprites, which may contain duplicates.
+ * @param zoom The zoom level.
+ * @param encoder Sprite encoder to use.
+ */
+static void QueueSpriteDecodes(const std::vector<SpriteID> &sprites, ZoomLevel zoom, SpriteEncoder *encoder)
+{
+	const uint32_t generation = _sprite_cache_generation.load(std::memory_order_relaxed);
+	std::unique_ptr<SpritePrefetchBatch> batch;
+	auto submit = [&]() {
+		{
+			std::lock_guard<std::mutex> lock(_sprite_prefetch_mutex);
+			_sprite_prefetch_outstanding++;
+		}
+		_general_worker_pool.EnqueueJob([](void *data1, void *, void *) {
+			std::unique_ptr<SpritePrefetchBatch> batch(static_cast<SpritePrefetchBatch *>(data1));
+			std::vector<DecodedSprite> results;
+			results.reserve(batch->requests.size());
+			for (const SpriteDecodeRequest &req : batch->requests) {
+				DecodedSprite &result = results.emplace_back();
+				result.req = req;
+				result.generation = batch->generation;
+				DecodeSprite(req, batch->encoder, batch->generation, result.data);
+			}
+
+			std::lock_guard<std::mutex> lock(_sprite_prefetch_mutex);
+			for (DecodedSprite &result : results) {
+				_sprite_prefetch_results.push_back(std::move(result));
+			}
+			_sprite_prefetch_outstanding--;
+			_sprite_prefetch_cv.notify_all();
+		}, batch.release());
+	};
+
+	for (SpriteID id : sprites) {
+		if (_sprites_being_prefetched.size() >= MAX_SPRITES_BEING_PREFETCHED) break;
+		uint8_t zoom_levels = GetSpriteZoomLevelsToDecode(id, encoder, zoom);
+		if (zoom_levels == 0 || _sprites_being_prefetched.count(id) != 0 || _sprites_failed_prefetch.count(id) != 0) continue;
+
+		const SpriteDecodeRequest req = MakeSpriteDecodeRequest(id, zoom_levels);
+		if (LoadDecodeRequestFromDiskCache(req)) continue;
+		_sprites_being_prefetched.insert(id);
+
+		if (batch == nullptr) batch.reset(new SpritePrefetchBatch{ {}, encoder, generation });
+		batch->requests.push_back(req);
+		if (batch->requests.size() == SPRITE_PREFETCH_BATCH_SIZE) submit();
+	}
+	if (batch != nullptr) submit();
+}
+
+/**
+ * Start loading sprites needed at a zoom level into the sprite cache, decoding those which are not yet cached in the background.
+ * This is used before drawing, so that the sprites are not loaded one at a time when they are first drawn.
+ * Drawing skips sprites for which IsSpriteLoadPending is true, and redraws the area when they have been decoded.
+ * @param sprites The sprites, which may contain duplicates.
+ * @param zoom The zoom level.
+ */
+void LoadSpritesInBackground(const std::vector<SpriteID> &sprites, ZoomLevel zoom)
+{
+	ProcessPrefetchedSprites();
+
+	if (_general_worker_pool.GetWorkerCount() == 0) return;
+
+	SpriteEncoder *encoder = BlitterFactory::GetCurrentBlitter();
+	if (encoder->NoSpriteDataRequired()) return;
+
+	QueueSpriteDecodes(sprites, zoom, encoder);
+}
+
+/**
+ * Decode sprites needed at a neighbouring zoom level in the background on the worker threads, without waiting for them.
+ * @param sprites The sprites, which may contain duplicates.
+ * @param zoom The zoom level.
+ */
+void PrefetchSprites(const std::vector<SpriteID> &sprites, ZoomLevel zoom)
+{
+	if (_general_worker_pool.GetWorkerCount() == 0) return;
+
+	SpriteEncoder *encoder = BlitterFactory::GetCurrentBlitter();
+	if (encoder->NoSpriteDataRequired() || !encoder->SupportsMissingZoomLevels()) return;
+
+	QueueSpriteDecodes(sprites, zoom, encoder);
+}
+
+/**
+ * Check whether a sprite needed at a zoom level is still being decoded in the background.
+ * @param id The sprite.
+ * @param zoom The zoom level.
+ * @return True if the sprite should not be drawn yet.
+ */
+bool IsSpriteLoadPending(SpriteID id, ZoomLevel zoom)
+{
+	if (_sprites_being_prefetched.empty() || _sprites_being_prefetched.count(id) == 0) return false;
+	return GetSpriteZoomLevelsToDecode(id, BlitterFactory::GetCurrentBlitter(), zoom) != 0;
+}
+
 /**
  * Reads a sprite and finds its most representative colour.
  * @param sprite Sprite to read.
@@ -1117,12 +1482,19 @@ uint32_t GetSpriteMainColour(SpriteID sprite_id, PaletteID palette_id)
 void GfxInitSpriteMem()
 {
 	/* Reset the spritecache 'pool' */
+	CancelSpritePrefetch();
+	_sprite_disk_caches.clear();
 	_spritecache.clear();
 	_sprite_files.clear();
 	assert(_spritecache_bytes_used == 0);
 	_spritecache_prune_events = 0;
 	_spritecache_prune_entries = 0;
 	_spritecache_prune_total = 0;
+	_spritecache_hits = 0;
+	_spritecache_misses = 0;
+	_spritecache_stats_start = std::chrono::steady_clock::now();
+	_spritecache_stats_last_dump = _spritecache_stats_start;
+	_spritecache_stats_last_dump_entries = 0;
 }
 
 /**
@@ -1131,6 +1503,9 @@ void GfxInitSpriteMem()
  */
 void GfxClearSpriteCache()
 {
+	CancelSpritePrefetch();
+	_sprite_disk_caches.clear();
+
 	/* Clear sprite ptr for all cached items */
 	for (uint i = 0; i != _spritecache.size(); i++) {
 		SpriteCache *sc = GetSpriteCache(i);
@@ -1155,9 +1530,32 @@ void GfxClearFontSpriteCache()
 
 void DumpSpriteCacheStats(char *buffer, const char *last)
 {
-	uint target_size = GetTargetSpriteSize();
-	buffer += seprintf(buffer, last, "Sprite cache: entries: %u, size: %u, target: %u, percent used: %.1f%%\n",
-			(uint)_spritecache.size(), (uint)_spritecache_bytes_used, target_size, (100.0f * _spritecache_bytes_used) / target_size);
+	const uint target_size = GetTargetSpriteSize();
+	const SpriteArena::Stats arena = _sprite_arena.GetStats();
+	buffer += seprintf(buffer, last, "Sprite cache: entries: %u, size: " PRINTF_SIZE ", live: " PRINTF_SIZE ", data: " PRINTF_SIZE ", target: %u, percent used: %.1f%%\n",
+			(uint)_spritecache.size(), arena.committed_bytes, arena.live_bytes, _spritecache_bytes_used, target_size, (100.0f * arena.live_bytes) / target_size);
+
+	auto percent = [](size_t part, size_t total) -> double {
+		return total != 0 ? (100.0 * part) / total : 0.0;
+	};
+	buffer += seprintf(buffer, last, "  Arena: allocations: " PRINTF_SIZE ", requested: " PRINTF_SIZE ", slabs: " PRINTF_SIZE " (" PRINTF_SIZE " bytes, %.1f%% of slots in use), direct: " PRINTF_SIZE "\n",
+			arena.live_allocations, arena.requested_bytes, arena.slabs, arena.slab_bytes, percent(arena.slab_used_bytes, arena.slab_bytes), arena.direct_bytes);
+	buffer += seprintf(buffer, last, "  Fragmentation: %.1f%% of committed memory is not requested data\n",
+			percent(arena.committed_bytes - std::min(arena.committed_bytes, arena.requested_bytes), arena.committed_bytes));
+
+	const uint64_t lookups = _spritecache_hits + _spritecache_misses;
+	buffer += seprintf(buffer, last, "  Lookups: " OTTD_PRINTF64U ", hits: " OTTD_PRINTF64U " (%.1f%%), misses: " OTTD_PRINTF64U "\n",
+			lookups, _spritecache_hits, lookups != 0 ? (100.0 * _spritecache_hits) / lookups : 0.0, _spritecache_misses);
+
+	const auto now = std::chrono::steady_clock::now();
+	auto per_second = [&](size_t count, std::chrono::steady_clock::time_point since) -> double {
+		const double seconds = std::chrono::duration<double>(now - since).count();
+		return seconds > 0 ? count / seconds : 0.0;
+	};
+	buffer += seprintf(buffer, last, "  Evictions per second: %.1f, since last report: %.1f\n",
+			per_second(_spritecache_prune_entries, _spritecache_stats_start), per_second(_spritecache_prune_entries - _spritecache_stats_last_dump_entries, _spritecache_stats_last_dump));
+	_spritecache_stats_last_dump = now;
+	_spritecache_stats_last_dump_entries = _spritecache_prune_entries;
 
 	uint types[(uint)SpriteType::Invalid] = {};
 	uint have_data = 0;
@@ -1191,6 +1589,18 @@ void DumpSpriteCacheStats(char *buffer, const char *last)
 			have_data, have_warned, have_8bpp, have_32bpp);
 	buffer += seprintf(buffer, last, "  Cache prune events: %u, pruned entry total: " PRINTF_SIZE ", pruned data total: " PRINTF_SIZE "\n",
 			_spritecache_prune_events, _spritecache_prune_entries, _spritecache_prune_total);
+	const SpriteDiskCache::Stats &disk_stats = SpriteDiskCache::stats;
+	uint disk_cache_files = 0;
+	size_t disk_cache_records = 0;
+	for (const auto &it : _sprite_disk_caches) {
+		if (it.second == nullptr) continue;
+		disk_cache_files++;
+		disk_cache_records += it.second->GetRecordCount();
+	}
+	buffer += seprintf(buffer, last, "  Disk cache: %s, files: %u, records: " PRINTF_SIZE ", hits: " OTTD_PRINTF64U ", misses: " OTTD_PRINTF64U ", invalid: " OTTD_PRINTF64U ", stored: " OTTD_PRINTF64U "\n",
+			_sprite_disk_cache_enabled ? "enabled" : "disabled", disk_cache_files, disk_cache_records, disk_stats.hits, disk_stats.misses, disk_stats.invalid, disk_stats.stores);
+	buffer += seprintf(buffer, last, "    Loaded: " OTTD_PRINTF64U " bytes, stored: " OTTD_PRINTF64U " bytes, rebuilt files: " OTTD_PRINTF64U "\n",
+			disk_stats.bytes_loaded, disk_stats.bytes_stored, disk_stats.files_rebuilt);
 	buffer += seprintf(buffer, last, "  Normal:\n");
 	buffer += seprintf(buffer, last, "    Partial zoom: %u\n", have_partial_zoom);
 	for (uint i = 0; i < lengthof(depths); i++) {
@@ -1198,4 +1608,4 @@ void DumpSpriteCacheStats(char *buffer, const char *last)
 	}
 }
 
-/* static */ ReusableBuffer<SpriteLoader::CommonPixel> SpriteLoader::Sprite::buffer[ZOOM_LVL_SPR_COUNT];
+/* static */ thread_local ReusableBuffer<SpriteLoader::CommonPixel> SpriteLoader::Sprite::buffer[ZOOM_LVL_SPR_COUNT];
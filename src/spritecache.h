@@ -22,9 +22,11 @@ struct Sprite {
 	uint16_t width;              ///< Width of the sprite.
 	int16_t x_offs;              ///< Number of pixels to shift the sprite to the right.
 	int16_t y_offs;              ///< Number of pixels to shift the sprite downwards.
-	uint32_t lru;                ///< Sprite cache LRU of this sprite structure.
+	SpriteID id;                 ///< Sprite cache entry of this sprite structure.
 	uint8_t missing_zoom_levels; ///< Bitmask of zoom levels missing in data
-	Sprite *next = nullptr;      ///< Next sprite structure, this is the only member which may be changed after the sprite has been inserted in the sprite cache
+	Sprite *next = nullptr;      ///< Next sprite structure, this and the LRU links are the only members which may be changed after the sprite has been inserted in the sprite cache
+	Sprite *lru_prev = nullptr;  ///< More recently used sprite structure in the sprite cache.
+	Sprite *lru_next = nullptr;  ///< Less recently used sprite structure in the sprite cache.
 	uint8_t data[];              ///< Sprite data.
 };
 
@@ -39,6 +41,7 @@ enum SpriteCacheCtrlFlags {
 };
 
 extern uint _sprite_cache_size;
+extern bool _sprite_disk_cache_enabled;
 
 typedef void *AllocatorProc(size_t size);
 
@@ -68,6 +71,10 @@ void GfxInitSpriteMem();
 void GfxClearSpriteCache();
 void GfxClearFontSpriteCache();
 void IncreaseSpriteLRU();
+void LoadSpritesInBackground(const std::vector<SpriteID> &sprites, ZoomLevel zoom);
+void PrefetchSprites(const std::vector<SpriteID> &sprites, ZoomLevel zoom);
+void ProcessPrefetchedSprites();
+bool IsSpriteLoadPending(SpriteID id, ZoomLevel zoom);
 
 SpriteFile &OpenCachedSpriteFile(const std::string &filename, Subdirectory subdir, bool palette_remap);
 
@@ -108,6 +115,12 @@ public:
 	{
 		this->cache[sprite | (static_cast<uint32_t>(SpriteType::Recolour) << 29)] = GetRawSprite(sprite, SpriteType::Recolour, 0);
 	}
+
+	/** Don't draw a sprite which has not been loaded yet, GetSprite returns nullptr for it. */
+	inline void SkipSprite(SpriteID sprite, SpriteType type)
+	{
+		this->cache[sprite | (static_cast<uint32_t>(type) << 29)] = nullptr;
+	}
 };
 
 #endif /* SPRITECACHE_H */
@@ -0,0 +1,224 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file spritecache_arena.cpp Size class arena allocator for sprite cache data. */
+
+#include "stdafx.h"
+#include "spritecache_arena.h"
+#include "core/math_func.hpp"
+
+#include <new>
+
+#include "safeguards.h"
+
+SpriteArena::SpriteArena()
+{
+	/* Size classes in steps of ALIGNMENT up to 128 bytes, then 4 size classes per power of two */
+	for (uint32_t size = ALIGNMENT; size <= 128; size += ALIGNMENT) {
+		this->classes.emplace_back().size = size;
+	}
+	for (uint32_t base = 128; base < MAX_SLAB_ALLOCATION; base *= 2) {
+		for (uint32_t step = 1; step <= 4; step++) {
+			this->classes.emplace_back().size = base + step * (base / 4);
+		}
+	}
+	assert(this->classes.back().size == MAX_SLAB_ALLOCATION);
+	assert(this->classes.size() <= UINT8_MAX);
+
+	uint8_t size_class = 0;
+	for (size_t i = 0; i < this->class_lookup.size(); i++) {
+		while (this->classes[size_class].size < i * ALIGNMENT) size_class++;
+		this->class_lookup[i] = size_class;
+	}
+}
+
+/**
+ * Get the amount of memory used by an allocation, including size class rounding and the estimated heap overhead of large allocations.
+ * @param size The size of the allocation.
+ * @return The memory used.
+ */
+size_t SpriteArena::GetAllocationSize(size_t size) const
+{
+	if (size <= MAX_SLAB_ALLOCATION) return this->classes[this->class_lookup[CeilDivT<size_t>(size, ALIGNMENT)]].size;
+	return Align(size, ALIGNMENT) + HEAP_OVERHEAD;
+}
+
+void SpriteArena::LinkPartial(SizeClass &sc, Slab *slab)
+{
+	assert(!slab->in_partial_list);
+	slab->prev = nullptr;
+	slab->next = sc.partial;
+	if (sc.partial != nullptr) sc.partial->prev = slab;
+	sc.partial = slab;
+	slab->in_partial_list = true;
+}
+
+void SpriteArena::UnlinkPartial(SizeClass &sc, Slab *slab)
+{
+	assert(slab->in_partial_list);
+	if (slab->prev != nullptr) {
+		slab->prev->next = slab->next;
+	} else {
+		sc.partial = slab->next;
+	}
+	if (slab->next != nullptr) slab->next->prev = slab->prev;
+	slab->prev = nullptr;
+	slab->next = nullptr;
+	slab->in_partial_list = false;
+}
+
+SpriteArena::Slab *SpriteArena::NewSlab(uint8_t size_class)
+{
+	SizeClass &sc = this->classes[size_class];
+	if (sc.empty != nullptr) {
+		Slab *slab = sc.empty;
+		sc.empty = nullptr;
+		return slab;
+	}
+
+	Slab *slab = static_cast<Slab *>(::operator new(SLAB_SIZE, std::align_val_t(SLAB_SIZE)));
+	slab->prev = nullptr;
+	slab->next = nullptr;
+	slab->free_list = nullptr;
+	slab->bump = SLAB_HEADER_SIZE;
+	slab->used = 0;
+	slab->capacity = static_cast<uint32_t>((SLAB_SIZE - SLAB_HEADER_SIZE) / sc.size);
+	slab->size_class = size_class;
+	slab->in_partial_list = false;
+
+	sc.slabs++;
+	this->stats.slabs++;
+	this->stats.slab_bytes += SLAB_SIZE;
+	this->stats.committed_bytes += SLAB_SIZE + HEAP_OVERHEAD;
+	return slab;
+}
+
+void SpriteArena::ReleaseSlab(Slab *slab)
+{
+	SizeClass &sc = this->classes[slab->size_class];
+	sc.slabs--;
+	this->stats.slabs--;
+	this->stats.slab_bytes -= SLAB_SIZE;
+	this->stats.committed_bytes -= SLAB_SIZE + HEAP_OVERHEAD;
+	::operator delete(slab, std::align_val_t(SLAB_SIZE));
+}
+
+/**
+ * Allocate memory.
+ * @param size The size of the allocation, which must be passed to Free.
+ * @return The allocation, aligned to #ALIGNMENT.
+ */
+void *SpriteArena::Allocate(size_t size)
+{
+	assert(size > 0);
+	std::lock_guard<std::mutex> lock(this->mutex);
+
+	this->stats.requested_bytes += size;
+	this->stats.live_allocations++;
+
+	if (size > MAX_SLAB_ALLOCATION) {
+		const size_t allocated = this->GetAllocationSize(size);
+		this->stats.direct_bytes += allocated;
+		this->stats.committed_bytes += allocated;
+		return ::operator new(size, std::align_val_t(ALIGNMENT));
+	}
+
+	const uint8_t size_class = this->class_lookup[CeilDivT<size_t>(size, ALIGNMENT)];
+	SizeClass &sc = this->classes[size_class];
+
+	Slab *slab = sc.partial;
+	if (slab == nullptr) {
+		slab = this->NewSlab(size_class);
+		this->LinkPartial(sc, slab);
+	}
+
+	void *ptr;
+	if (slab->free_list != nullptr) {
+		ptr = slab->free_list;
+		slab->free_list = slab->free_list->next;
+	} else {
+		ptr = reinterpret_cast<uint8_t *>(slab) + slab->bump;
+		slab->bump += sc.size;
+	}
+	slab->used++;
+	if (slab->used == slab->capacity) this->UnlinkPartial(sc, slab);
+
+	this->stats.slab_used_bytes += sc.size;
+	return ptr;
+}
+
+/**
+ * Free memory.
+ * @param ptr The allocation.
+ * @param size The size which was passed to Allocate.
+ */
+void SpriteArena::Free(void *ptr, size_t size)
+{
+	if (ptr == nullptr) return;
+	std::lock_guard<std::mutex> lock(this->mutex);
+
+	this->stats.requested_bytes -= size;
+	this->stats.live_allocations--;
+
+	if (size > MAX_SLAB_ALLOCATION) {
+		const size_t allocated = this->GetAllocationSize(size);
+		this->stats.direct_bytes -= allocated;
+		this->stats.committed_bytes -= allocated;
+		::operator delete(ptr, std::align_val_t(ALIGNMENT));
+		return;
+	}
+
+	Slab *slab = GetSlab(ptr);
+	SizeClass &sc = this->classes[slab->size_class];
+	assert(sc.size >= size);
+
+	FreeSlot *slot = static_cast<FreeSlot *>(ptr);
+	slot->next = slab->free_list;
+	slab->free_list = slot;
+	slab->used--;
+	this->stats.slab_used_bytes -= sc.size;
+
+	if (slab->used == 0) {
+		/* Release the slab, but keep one empty slab per size class */
+		if (slab->in_partial_list) this->UnlinkPartial(sc, slab);
+		if (sc.empty == nullptr) {
+			slab->free_list = nullptr;
+			slab->bump = SLAB_HEADER_SIZE;
+			sc.empty = slab;
+		} else {
+			this->ReleaseSlab(slab);
+		}
+	} else if (!slab->in_partial_list) {
+		this->LinkPartial(sc, slab);
+	}
+}
+
+/**
+ * Release the empty slabs which are kept for reuse.
+ */
+void SpriteArena::Trim()
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	for (SizeClass &sc : this->classes) {
+		if (sc.empty != nullptr) {
+			this->ReleaseSlab(sc.empty);
+			sc.empty = nullptr;
+		}
+	}
+}
+
+/**
+ * Get the memory statistics of the arena.
+ * @return The statistics.
+ */
+SpriteArena::Stats SpriteArena::GetStats()
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	Stats stats = this->stats;
+	stats.live_bytes = stats.slab_used_bytes + stats.slabs * (SLAB_HEADER_SIZE + HEAP_OVERHEAD) + stats.direct_bytes;
+	return stats;
+}
@@ -0,0 +1,104 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file spritecache_arena.h Size class arena allocator for sprite cache data. */
+
+#ifndef SPRITECACHE_ARENA_H
+#define SPRITECACHE_ARENA_H
+
+#include <array>
+#include <mutex>
+#include <vector>
+
+/**
+ * Size class arena allocator for sprite cache data.
+ *
+ * Small allocations are rounded up to one of a set of size classes, and placed in slabs of #SLAB_SIZE bytes which only hold allocations of one size class.
+ * Slabs are aligned to their size so that the slab of an allocation can be found from its address, and are released when they become empty.
+ * Large allocations are made directly from the heap.
+ *
+ * All memory obtained from the heap, including slab headers, unused slots and an estimate of the heap's own per-allocation overhead, is counted as committed.
+ * Free slots are reused before new slabs are allocated, so only the memory which is not in free slots is counted as live.
+ * This may be used from any thread.
+ */
+class SpriteArena {
+public:
+	static constexpr size_t SLAB_SIZE = 64 * 1024;       ///< Size and alignment of a slab.
+	static constexpr size_t MAX_SLAB_ALLOCATION = 8192;  ///< Largest allocation which is made from a slab.
+	static constexpr size_t ALIGNMENT = 16;              ///< Alignment of all allocations.
+	static constexpr size_t HEAP_OVERHEAD = 16;          ///< Estimated overhead of each allocation made directly from the heap.
+
+	/** Memory statistics of the arena. */
+	struct Stats {
+		size_t committed_bytes;     ///< Memory obtained from the heap, including all overheads.
+		size_t live_bytes;          ///< Committed memory which is not in free slots: slots in use, slab headers and large allocations, including all overheads.
+		size_t requested_bytes;     ///< Sum of the sizes of the live allocations.
+		size_t slab_bytes;          ///< Memory in slabs.
+		size_t slab_used_bytes;     ///< Memory in slab slots which are in use, including size class rounding.
+		size_t direct_bytes;        ///< Memory in large allocations made directly from the heap, including estimated heap overhead.
+		size_t slabs;               ///< Number of slabs.
+		size_t live_allocations;    ///< Number of live allocations.
+	};
+
+private:
+	struct FreeSlot {
+		FreeSlot *next;
+	};
+
+	struct Slab {
+		Slab *prev;                 ///< Previous slab with free slots of the same size class.
+		Slab *next;                 ///< Next slab with free slots of the same size class.
+		FreeSlot *free_list;        ///< Slots which were freed.
+		uint32_t bump;              ///< Offset of the first slot which was never used.
+		uint32_t used;              ///< Number of slots in use.
+		uint32_t capacity;          ///< Number of slots.
+		uint8_t size_class;         ///< Size class of the slots.
+		bool in_partial_list;       ///< Whether the slab is in its size class's list of slabs with free slots.
+	};
+
+	static constexpr size_t SLAB_HEADER_SIZE = (sizeof(Slab) + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+
+	struct SizeClass {
+		uint32_t size = 0;          ///< Size of each slot.
+		Slab *partial = nullptr;    ///< Slabs with free slots.
+		Slab *empty = nullptr;      ///< An empty slab kept to avoid repeatedly allocating and releasing a slab.
+		size_t slabs = 0;           ///< Number of slabs, including the empty slab.
+	};
+
+	std::mutex mutex;
+	std::vector<SizeClass> classes;
+	std::array<uint8_t, MAX_SLAB_ALLOCATION / ALIGNMENT + 1> class_lookup; ///< Size class of each allocation size in units of ALIGNMENT.
+	Stats stats{};
+
+	Slab *NewSlab(uint8_t size_class);
+	void ReleaseSlab(Slab *slab);
+	void LinkPartial(SizeClass &sc, Slab *slab);
+	void UnlinkPartial(SizeClass &sc, Slab *slab);
+
+	static Slab *GetSlab(void *ptr)
+	{
+		return reinterpret_cast<Slab *>(reinterpret_cast<uintptr_t>(ptr) & ~(uintptr_t)(SLAB_SIZE - 1));
+	}
+
+public:
+	SpriteArena();
+	~SpriteArena() { this->Trim(); }
+
+	SpriteArena(const SpriteArena &) = delete;
+	SpriteArena &operator=(const SpriteArena &) = delete;
+
+	void *Allocate(size_t size);
+	void Free(void *ptr, size_t size);
+	void Trim();
+	Stats GetStats();
+
+	size_t GetAllocationSize(size_t size) const;
+};
+
+extern SpriteArena _sprite_arena;
+
+#endif /* SPRITECACHE_ARENA_H */
@@ -0,0 +1,350 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file spritecache_disk.cpp Persistent on-disk cache of encoded sprites. */
+
+#include "stdafx.h"
+#include "spritecache_disk.h"
+#include "fileio_func.h"
+#include "debug.h"
+#include "string_func.h"
+#include "rev.h"
+#include "core/endian_func.hpp"
+#include "core/format.hpp"
+#include "core/math_func.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#	include <sys/mman.h>
+#	define WITH_SPRITE_DISK_CACHE_MMAP
+#elif defined(_WIN32)
+#	include <windows.h>
+#	include <io.h>
+#	define WITH_SPRITE_DISK_CACHE_FILE_MAPPING
+#endif
+
+#include "safeguards.h"
+
+SpriteDiskCache::Stats SpriteDiskCache::stats;
+
+static const char SPRITE_DISK_CACHE_MAGIC[8] = { 'O', 'T', 'T', 'D', 'S', 'P', 'R', 'C' };
+static const uint32_t SPRITE_DISK_CACHE_VERSION = 2;
+static const uint32_t SPRITE_DISK_CACHE_RECORD_MAGIC = 0x53505231; ///< 'SPR1'
+static const uint64_t MAX_SPRITE_DISK_CACHE_FILE_SIZE = 1024 * 1024 * 1024; ///< Stop appending records to a cache file beyond this size.
+static const uint32_t MAX_SPRITE_DISK_CACHE_RECORD_SIZE = 64 * 1024 * 1024;
+static const uint SPRITE_DISK_CACHE_ALIGNMENT = 16; ///< Alignment of records and their data in the cache file.
+
+/** Header of a sprite disk cache file. */
+struct SpriteDiskCacheHeader {
+	char magic[8];          ///< SPRITE_DISK_CACHE_MAGIC
+	uint32_t version;       ///< SPRITE_DISK_CACHE_VERSION
+	uint32_t layout;        ///< Hash of the build's revision and the layout of the sprite structures.
+	uint8_t md5[16];        ///< MD5 of the sprite file.
+	uint64_t source_size;   ///< Size of the sprite file.
+	int64_t source_mtime;   ///< Last modification time of the sprite file.
+	char blitter[32];       ///< Name of the blitter which encoded the sprites.
+	uint32_t config_hash;   ///< Hash of the palette and other settings which affect encoding.
+	uint32_t checksum;      ///< Checksum of the preceding fields.
+	uint32_t reserved[2];
+};
+static_assert(sizeof(SpriteDiskCacheHeader) % SPRITE_DISK_CACHE_ALIGNMENT == 0);
+
+/** Header of a sprite record in a sprite disk cache file, followed by the sprite data. */
+struct SpriteDiskCacheRecord {
+	uint32_t magic;         ///< SPRITE_DISK_CACHE_RECORD_MAGIC
+	uint32_t size;          ///< Size of the sprite data.
+	uint64_t file_pos;      ///< Position of the sprite in the sprite file.
+	uint32_t count;         ///< Sprite count of the sprite cache entry.
+	uint16_t flags;         ///< Control flags of the sprite cache entry.
+	uint8_t zoom_levels;    ///< Zoom levels which were encoded.
+	uint8_t pad;
+	uint32_t checksum;      ///< Checksum of the sprite data.
+	uint32_t header_checksum; ///< Checksum of the preceding fields.
+};
+static_assert(sizeof(SpriteDiskCacheRecord) % SPRITE_DISK_CACHE_ALIGNMENT == 0);
+
+/**
+ * Checksum used to validate sprite disk cache data.
+ * @param data The data.
+ * @param size The size of the data.
+ * @param seed Initial value, to combine several checksums.
+ * @return The checksum.
+ */
+uint32_t SpriteDiskCacheChecksum(const void *data, size_t size, uint32_t seed)
+{
+	const uint8_t *bytes = static_cast<const uint8_t *>(data);
+	uint64_t hash = 0xCBF29CE484222325ULL ^ seed;
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8) {
+		uint64_t word;
+		memcpy(&word, bytes + i, sizeof(word));
+		hash = (hash ^ word) * 0x100000001B3ULL;
+		hash ^= hash >> 29;
+	}
+	for (; i < size; i++) {
+		hash = (hash ^ bytes[i]) * 0x100000001B3ULL;
+	}
+	return static_cast<uint32_t>(hash ^ (hash >> 32));
+}
+
+static uint32_t GetSpriteDiskCacheLayout()
+{
+	const uint32_t layout[] = { (uint32_t)sizeof(Sprite), (uint32_t)sizeof(void *), TTD_ENDIAN, (uint32_t)ZOOM_LVL_SPR_COUNT };
+	return SpriteDiskCacheChecksum(_openttd_revision, strlen(_openttd_revision), SpriteDiskCacheChecksum(layout, sizeof(layout)));
+}
+
+static uint64_t AlignSpriteDiskCacheOffset(uint64_t offset)
+{
+	return Align(offset, SPRITE_DISK_CACHE_ALIGNMENT);
+}
+
+SpriteDiskCache::~SpriteDiskCache()
+{
+	this->Unmap();
+	if (this->file != nullptr) fclose(this->file);
+}
+
+/**
+ * Map the cache file into memory, on platforms which support it.
+ * Otherwise records are read from the file when they are needed.
+ */
+void SpriteDiskCache::Map()
+{
+	if (this->file_size == 0) return;
+#if defined(WITH_SPRITE_DISK_CACHE_MMAP)
+	void *ptr = mmap(nullptr, this->file_size, PROT_READ, MAP_SHARED, fileno(this->file), 0);
+	if (ptr == MAP_FAILED) return;
+	this->mapping = static_cast<const uint8_t *>(ptr);
+	this->mapping_size = this->file_size;
+#elif defined(WITH_SPRITE_DISK_CACHE_FILE_MAPPING)
+	HANDLE file_mapping = CreateFileMapping(reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(this->file))), nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (file_mapping == nullptr) return;
+	/* The view keeps the file mapping object alive */
+	void *ptr = MapViewOfFile(file_mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(file_mapping);
+	if (ptr == nullptr) return;
+	this->mapping = static_cast<const uint8_t *>(ptr);
+	this->mapping_size = this->file_size;
+#endif
+}
+
+void SpriteDiskCache::Unmap()
+{
+#if defined(WITH_SPRITE_DISK_CACHE_MMAP)
+	if (this->mapping != nullptr) munmap(const_cast<uint8_t *>(this->mapping), this->mapping_size);
+#elif defined(WITH_SPRITE_DISK_CACHE_FILE_MAPPING)
+	if (this->mapping != nullptr) UnmapViewOfFile(this->mapping);
+#endif
+	this->mapping = nullptr;
+	this->mapping_size = 0;
+}
+
+/**
+ * Read data from the cache file, from the mapping if it is mapped.
+ * @param offset Offset in the cache file.
+ * @param buffer Buffer to read into.
+ * @param size Number of bytes to read.
+ * @return True if the data was read.
+ */
+bool SpriteDiskCache::ReadAt(uint64_t offset, void *buffer, size_t size) const
+{
+	if (offset + size <= this->mapping_size) {
+		memcpy(buffer, this->mapping + offset, size);
+		return true;
+	}
+	if (this->file == nullptr) return false;
+	return fseek(this->file, (long)offset, SEEK_SET) == 0 && fread(buffer, size, 1, this->file) == 1;
+}
+
+/**
+ * Build the index of the records in the cache file.
+ * Scanning stops at the first record which is truncated or has an invalid header, new records are written from there.
+ */
+void SpriteDiskCache::ReadIndex()
+{
+	uint64_t offset = sizeof(SpriteDiskCacheHeader);
+	while (offset + sizeof(SpriteDiskCacheRecord) <= this->file_size) {
+		SpriteDiskCacheRecord record;
+		if (!this->ReadAt(offset, &record, sizeof(record))) break;
+		if (record.magic != SPRITE_DISK_CACHE_RECORD_MAGIC) break;
+		if (record.header_checksum != SpriteDiskCacheChecksum(&record, offsetof(SpriteDiskCacheRecord, header_checksum))) break;
+		if (record.size < sizeof(Sprite) || record.size > MAX_SPRITE_DISK_CACHE_RECORD_SIZE) break;
+
+		const uint64_t data_offset = offset + sizeof(SpriteDiskCacheRecord);
+		if (data_offset + record.size > this->file_size) break;
+
+		Key key{ static_cast<size_t>(record.file_pos), record.count, record.flags, record.zoom_levels };
+		this->index[GetIndexKey(key)] = { data_offset, record.size, record.checksum, record.count, record.flags };
+		offset = AlignSpriteDiskCacheOffset(data_offset + record.size);
+	}
+	this->file_end = std::min<uint64_t>(offset, AlignSpriteDiskCacheOffset(this->file_size));
+}
+
+/**
+ * Open or create the cache file for a sprite file and encoding configuration.
+ * @param md5 MD5 of the sprite file.
+ * @param source_size Size of the sprite file.
+ * @param source_mtime Last modification time of the sprite file, together with its size this detects a file changed since its MD5 was determined.
+ * @param blitter_name Name of the blitter which encodes the sprites.
+ * @param config_hash Hash of the palette and other settings which affect encoding.
+ * @return The cache, or nullptr if no cache file can be used.
+ */
+/* static */ std::unique_ptr<SpriteDiskCache> SpriteDiskCache::Open(const MD5Hash &md5, uint64_t source_size, int64_t source_mtime, const char *blitter_name, uint32_t config_hash)
+{
+	extern std::string _personal_dir;
+	if (_personal_dir.empty()) return nullptr;
+
+	SpriteDiskCacheHeader header{};
+	memcpy(header.magic, SPRITE_DISK_CACHE_MAGIC, sizeof(header.magic));
+	header.version = SPRITE_DISK_CACHE_VERSION;
+	header.layout = GetSpriteDiskCacheLayout();
+	std::copy(md5.begin(), md5.end(), header.md5);
+	header.source_size = source_size;
+	header.source_mtime = source_mtime;
+	strecpy(header.blitter, blitter_name, lastof(header.blitter));
+	header.config_hash = config_hash;
+	header.checksum = SpriteDiskCacheChecksum(&header, offsetof(SpriteDiskCacheHeader, checksum));
+
+	const std::string dir = _personal_dir + "cache" PATHSEP "sprites" PATHSEP;
+	FioCreateDirectory(dir);
+
+	std::unique_ptr<SpriteDiskCache> cache(new SpriteDiskCache());
+	cache->filename = fmt::format("{}{}-{}-{:08x}.bin", dir, FormatArrayAsHex(md5), blitter_name, config_hash);
+
+	size_t file_size = 0;
+	cache->file = FioFOpenFile(cache->filename, "r+b", NO_DIRECTORY, &file_size);
+	if (cache->file != nullptr) {
+		cache->file_size = file_size;
+		cache->Map();
+		SpriteDiskCacheHeader existing;
+		if (cache->ReadAt(0, &existing, sizeof(existing))) {
+			if (memcmp(&existing, &header, sizeof(header)) == 0) {
+				cache->ReadIndex();
+				DEBUG(sprite, 3, "Opened sprite disk cache %s, %u records", cache->filename.c_str(), (uint)cache->index.size());
+				return cache;
+			}
+		}
+		SpriteDiskCache::stats.files_rebuilt++;
+		DEBUG(sprite, 1, "Discarding invalid sprite disk cache %s", cache->filename.c_str());
+	}
+	cache->Unmap();
+	if (cache->file != nullptr) fclose(cache->file);
+	cache->index.clear();
+
+	/* Write a new file, and rename it over the old one so that other processes which have the old file mapped are not affected. */
+	const std::string tmp_filename = cache->filename + ".tmp";
+	cache->file = FioFOpenFile(tmp_filename, "w+b", NO_DIRECTORY);
+	if (cache->file == nullptr) return nullptr;
+	if (fwrite(&header, sizeof(header), 1, cache->file) != 1 || fflush(cache->file) != 0 || !FioRenameFile(tmp_filename, cache->filename)) {
+		fclose(cache->file);
+		cache->file = nullptr;
+		return nullptr;
+	}
+	cache->file_size = sizeof(header);
+	cache->file_end = sizeof(header);
+	DEBUG(sprite, 3, "Created sprite disk cache %s", cache->filename.c_str());
+	return cache;
+}
+
+/**
+ * Read the data of a record into a buffer, and validate it.
+ * @param entry The record.
+ * @param buffer The buffer, of at least the size of the record.
+ * @return True if the data is valid.
+ */
+bool SpriteDiskCache::ReadRecord(const Entry &entry, uint8_t *buffer) const
+{
+	if (!this->ReadAt(entry.offset, buffer, entry.size)) return false;
+
+	/* Validate the copy, as the file may be changed by another process */
+	return SpriteDiskCacheChecksum(buffer, entry.size) == entry.checksum;
+}
+
+/**
+ * Load an encoded sprite from the cache file.
+ * @param key The sprite.
+ * @param[out] buffer Buffer to allocate and fill with the sprite data.
+ * @return True if the sprite was loaded, false if it is not in the cache file or failed validation.
+ */
+bool SpriteDiskCache::Load(const Key &key, SpriteDataBuffer &buffer)
+{
+	auto it = this->index.find(GetIndexKey(key));
+	if (it == this->index.end() || it->second.count != key.count || it->second.flags != key.flags) {
+		SpriteDiskCache::stats.misses++;
+		return false;
+	}
+
+	buffer.Allocate(it->second.size);
+	if (!this->ReadRecord(it->second, static_cast<uint8_t *>(buffer.GetPtr()))) {
+		/* The sprite will be encoded and stored again */
+		DEBUG(sprite, 1, "Invalid record in sprite disk cache %s at offset " OTTD_PRINTF64U, this->filename.c_str(), it->second.offset);
+		buffer.Clear();
+		this->index.erase(it);
+		SpriteDiskCache::stats.invalid++;
+		SpriteDiskCache::stats.misses++;
+		return false;
+	}
+
+	SpriteDiskCache::stats.hits++;
+	SpriteDiskCache::stats.bytes_loaded += it->second.size;
+	return true;
+}
+
+/**
+ * Append an encoded sprite to the cache file, if it is not already there.
+ * @param key The sprite.
+ * @param data The encoded sprite.
+ * @param size The size of the encoded sprite.
+ */
+void SpriteDiskCache::Store(const Key &key, const void *data, size_t size)
+{
+	if (this->file == nullptr || size < sizeof(Sprite) || size > MAX_SPRITE_DISK_CACHE_RECORD_SIZE) return;
+	if (this->file_end + sizeof(SpriteDiskCacheRecord) + size > MAX_SPRITE_DISK_CACHE_FILE_SIZE) return;
+
+	auto it = this->index.find(GetIndexKey(key));
+	if (it != this->index.end() && it->second.count == key.count && it->second.flags == key.flags) return;
+
+	/* Clear the fields of the sprite structure which are specific to the sprite cache entry */
+	std::unique_ptr<uint8_t[]> copy(new uint8_t[size]);
+	memcpy(copy.get(), data, size);
+	Sprite *sprite = reinterpret_cast<Sprite *>(copy.get());
+	sprite->size = 0;
+	sprite->id = 0;
+	sprite->next = nullptr;
+	sprite->lru_prev = nullptr;
+	sprite->lru_next = nullptr;
+	const uint32_t checksum = SpriteDiskCacheChecksum(copy.get(), size);
+
+	SpriteDiskCacheRecord record{};
+	record.magic = SPRITE_DISK_CACHE_RECORD_MAGIC;
+	record.size = static_cast<uint32_t>(size);
+	record.file_pos = key.file_pos;
+	record.count = key.count;
+	record.flags = key.flags;
+	record.zoom_levels = key.zoom_levels;
+	record.checksum = checksum;
+	record.header_checksum = SpriteDiskCacheChecksum(&record, offsetof(SpriteDiskCacheRecord, header_checksum));
+
+	static const uint8_t padding[SPRITE_DISK_CACHE_ALIGNMENT] = {};
+	const uint64_t data_offset = this->file_end + sizeof(record);
+	const uint64_t end = AlignSpriteDiskCacheOffset(data_offset + size);
+	bool ok = fseek(this->file, (long)this->file_end, SEEK_SET) == 0 &&
+			fwrite(&record, sizeof(record), 1, this->file) == 1 &&
+			fwrite(copy.get(), size, 1, this->file) == 1 &&
+			(end == data_offset + size || fwrite(padding, end - data_offset - size, 1, this->file) == 1) &&
+			fflush(this->file) == 0;
+	if (!ok) {
+		DEBUG(sprite, 1, "Failed to write to sprite disk cache %s, disabling it", this->filename.c_str());
+		fclose(this->file);
+		this->file = nullptr;
+		return;
+	}
+
+	this->index[GetIndexKey(key)] = { data_offset, record.size, checksum, key.count, key.flags };
+	this->file_end = end;
+	SpriteDiskCache::stats.stores++;
+	SpriteDiskCache::stats.bytes_stored += size;
+}
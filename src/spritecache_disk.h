@@ -0,0 +1,100 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file spritecache_disk.h Persistent on-disk cache of encoded sprites. */
+
+#ifndef SPRITECACHE_DISK_H
+#define SPRITECACHE_DISK_H
+
+#include "spritecache.h"
+#include "spritecache_internal.h"
+#include "3rdparty/md5/md5.h"
+#include "3rdparty/robin_hood/robin_hood.h"
+
+#include <memory>
+#include <string>
+
+/**
+ * Persistent cache of the sprites of one sprite file, encoded by one blitter with one palette and sprite zoom configuration.
+ *
+ * The cache file starts with a header containing the MD5, size and modification time of the sprite file and a hash of the encoding configuration,
+ * followed by records of encoded sprite data, each with a checksum.
+ * Where supported, the file is mapped into memory when opened, and the records are copied into the sprite cache from the mapping.
+ * Otherwise the records are read from the file when they are loaded.
+ * Sprites which are not in the cache file, or whose record fails validation, are appended to the file when they are encoded.
+ */
+class SpriteDiskCache {
+public:
+	/** Identification of an encoded sprite within a sprite file. */
+	struct Key {
+		size_t file_pos;     ///< Position of the sprite in the sprite file.
+		uint count;          ///< Sprite count of the sprite cache entry.
+		uint16_t flags;      ///< Control flags of the sprite cache entry, see SpriteCacheCtrlFlags.
+		uint8_t zoom_levels; ///< Zoom levels which were encoded.
+	};
+
+	/** Statistics of all sprite disk caches. */
+	struct Stats {
+		uint64_t hits = 0;             ///< Sprites loaded from a cache file.
+		uint64_t misses = 0;           ///< Sprites not found in a cache file.
+		uint64_t invalid = 0;          ///< Records which failed validation.
+		uint64_t stores = 0;           ///< Sprites appended to a cache file.
+		uint64_t bytes_loaded = 0;     ///< Bytes of sprite data loaded from cache files.
+		uint64_t bytes_stored = 0;     ///< Bytes of sprite data appended to cache files.
+		uint64_t files_rebuilt = 0;    ///< Cache files which were discarded because their header was invalid.
+	};
+
+	static Stats stats;
+
+private:
+	struct Entry {
+		uint64_t offset; ///< Offset of the sprite data in the cache file.
+		uint32_t size;   ///< Size of the sprite data.
+		uint32_t checksum; ///< Checksum of the sprite data.
+		uint32_t count;  ///< Sprite count of the sprite cache entry.
+		uint16_t flags;  ///< Control flags of the sprite cache entry.
+	};
+
+	std::string filename;
+	FILE *file = nullptr;          ///< Cache file, opened for appending records.
+	uint64_t file_size = 0;        ///< Size of the cache file when opened.
+	uint64_t file_end = 0;         ///< End of the last valid record, new records are written here.
+	const uint8_t *mapping = nullptr; ///< Mapping of the cache file, as it was when opened, or nullptr if it is not mapped.
+	size_t mapping_size = 0;
+	robin_hood::unordered_flat_map<uint64_t, Entry> index; ///< Records by sprite file position and zoom levels.
+
+	SpriteDiskCache() = default;
+
+	static uint64_t GetIndexKey(const Key &key) { return (static_cast<uint64_t>(key.file_pos) << 8) | key.zoom_levels; }
+
+	void Map();
+	void Unmap();
+	bool ReadAt(uint64_t offset, void *buffer, size_t size) const;
+	void ReadIndex();
+	bool ReadRecord(const Entry &entry, uint8_t *buffer) const;
+
+public:
+	~SpriteDiskCache();
+
+	SpriteDiskCache(const SpriteDiskCache &) = delete;
+	SpriteDiskCache &operator=(const SpriteDiskCache &) = delete;
+
+	static std::unique_ptr<SpriteDiskCache> Open(const MD5Hash &md5, uint64_t source_size, int64_t source_mtime, const char *blitter_name, uint32_t config_hash);
+
+	bool Load(const Key &key, SpriteDataBuffer &buffer);
+	void Store(const Key &key, const void *data, size_t size);
+
+	/**
+	 * Get the number of sprite records in the cache file.
+	 * @return The number of records.
+	 */
+	size_t GetRecordCount() const { return this->index.size(); }
+};
+
+uint32_t SpriteDiskCacheChecksum(const void *data, size_t size, uint32_t seed = 0);
+
+#endif /* SPRITECACHE_DISK_H */
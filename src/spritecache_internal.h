@@ -15,6 +15,10 @@
 #include "core/math_func.hpp"
 #include "gfx_type.h"
 #include "spriteloader/spriteloader.hpp"
+#include "spritecache.h"
+#include "spritecache_arena.h"
+
+#include <utility>
 
 #include "table/sprites.h"
 
@@ -29,26 +33,104 @@ struct SpriteCache;
 class SpriteDataBuffer {
 	friend SpriteCache;
 
-	std::unique_ptr<void, FreeDeleter> ptr;
+	void *ptr = nullptr;
 	uint32_t size = 0;
 
+	void *Release()
+	{
+		this->size = 0;
+		return std::exchange(this->ptr, nullptr);
+	}
+
 public:
-	void *GetPtr() { return this->ptr.get(); }
+	SpriteDataBuffer() = default;
+	SpriteDataBuffer(const SpriteDataBuffer &other) = delete;
+	SpriteDataBuffer(SpriteDataBuffer &&other) noexcept : ptr(std::exchange(other.ptr, nullptr)), size(std::exchange(other.size, 0)) {}
+	SpriteDataBuffer &operator=(const SpriteDataBuffer &other) = delete;
+
+	SpriteDataBuffer &operator=(SpriteDataBuffer &&other) noexcept
+	{
+		this->Clear();
+		this->ptr = std::exchange(other.ptr, nullptr);
+		this->size = std::exchange(other.size, 0);
+		return *this;
+	}
+
+	~SpriteDataBuffer()
+	{
+		this->Clear();
+	}
+
+	void *GetPtr() { return this->ptr; }
 	uint32_t GetSize() { return this->size; }
 
 	void Allocate(uint32_t size)
 	{
-		this->ptr.reset(MallocT<uint8_t>(size));
+		this->Clear();
+		this->ptr = _sprite_arena.Allocate(size);
 		this->size = size;
 	}
 
 	void Clear()
 	{
-		this->ptr.reset();
+		_sprite_arena.Free(this->ptr, this->size);
+		this->ptr = nullptr;
 		this->size = 0;
 	}
 };
 
+/**
+ * Intrusive list of the sprite structures in the sprite cache, from the most to the least recently used.
+ * This is only used on the main thread.
+ */
+struct SpriteLRUList {
+	Sprite *head = nullptr; ///< Most recently used sprite structure.
+	Sprite *tail = nullptr; ///< Least recently used sprite structure.
+
+	void Link(Sprite *sp)
+	{
+		sp->lru_prev = nullptr;
+		sp->lru_next = this->head;
+		if (this->head != nullptr) {
+			this->head->lru_prev = sp;
+		} else {
+			this->tail = sp;
+		}
+		this->head = sp;
+	}
+
+	void Unlink(Sprite *sp)
+	{
+		if (sp->lru_prev != nullptr) {
+			sp->lru_prev->lru_next = sp->lru_next;
+		} else {
+			this->head = sp->lru_next;
+		}
+		if (sp->lru_next != nullptr) {
+			sp->lru_next->lru_prev = sp->lru_prev;
+		} else {
+			this->tail = sp->lru_prev;
+		}
+		sp->lru_prev = nullptr;
+		sp->lru_next = nullptr;
+	}
+
+	/** Mark a sprite structure as the most recently used. */
+	inline void Touch(Sprite *sp)
+	{
+		if (this->head == sp) return;
+		this->Unlink(sp);
+		this->Link(sp);
+	}
+};
+
+extern SpriteLRUList _sprite_lru;
+
+size_t GetSpriteCacheUsage();
+void DeleteEntriesFromSpriteCache(size_t target);
+
+SpriteID GetSpriteCacheIndex(const SpriteCache *sc);
+
 struct SpriteCache {
 	SpriteFile *file;    ///< The file the sprite in this entry can be found in.
 	size_t file_pos;
@@ -75,27 +157,45 @@ public:
 	bool GetHasNonPalette() const { return GB(this->flags, SCC_32BPP_ZOOM_START, 6) != 0; }
 
 private:
+	static void FreeSprite(Sprite *sp)
+	{
+		_sprite_lru.Unlink(sp);
+		_spritecache_bytes_used -= sp->size;
+		_sprite_arena.Free(sp, sp->size);
+	}
+
 	void Deallocate()
 	{
 		if (!this->ptr) return;
 
 		if (this->GetType() == SpriteType::Recolour) {
 			_spritecache_bytes_used -= RECOLOUR_SPRITE_SIZE;
-			free(this->ptr.release());
+			_sprite_arena.Free(this->ptr.release(), RECOLOUR_SPRITE_SIZE);
 			return;
 		}
 
 		Sprite *p = (Sprite *)this->ptr.release();
 		while (p != nullptr) {
 			Sprite *next = p->next;
-			_spritecache_bytes_used -= p->size;
-			free(p);
+			FreeSprite(p);
 			p = next;
 		}
 	}
 
 	Sprite *GetSpritePtr() { return (Sprite *)this->ptr.get(); }
 
+	Sprite *InsertSprite(SpriteDataBuffer &other)
+	{
+		const uint32_t size = other.size;
+		Sprite *sp = (Sprite *)other.Release();
+		sp->size = size;
+		sp->id = GetSpriteCacheIndex(this);
+		sp->next = nullptr;
+		_sprite_lru.Link(sp);
+		_spritecache_bytes_used += size;
+		return sp;
+	}
+
 public:
 	void Clear()
 	{
@@ -103,56 +203,47 @@ public:
 		this->total_missing_zoom_levels = 0;
 	}
 
-	void RemoveByMissingZoomLevels(uint8_t lvls)
+	/**
+	 * Remove a sprite structure of this entry from the sprite cache.
+	 * @param sp The sprite structure.
+	 */
+	void Remove(Sprite *sp)
 	{
 		Sprite *base = this->GetSpritePtr();
-		if (base == nullptr) {
-			return;
-		}
-		if (base->missing_zoom_levels == lvls) {
-			/* erase top level entry */
-			this->ptr.reset(base->next);
-			_spritecache_bytes_used -= base->size;
-			free(base);
-			base = this->GetSpritePtr();
-		}
-		if (base == nullptr) {
-			this->total_missing_zoom_levels = 0;
-			return;
+		if (base == sp) {
+			this->ptr.reset(sp->next);
+		} else {
+			Sprite *prev = base;
+			while (prev->next != sp) prev = prev->next;
+			prev->next = sp->next;
 		}
-		this->total_missing_zoom_levels = base->missing_zoom_levels;
-		Sprite *sp = base;
-		while (sp != nullptr) {
-			this->total_missing_zoom_levels &= sp->missing_zoom_levels;
-
-			if (sp->next != nullptr && sp->next->missing_zoom_levels == lvls) {
-				/* found entry to erase */
-				_spritecache_bytes_used -= sp->next->size;
-				Sprite *new_next = sp->next->next;
-				free(sp->next);
-				sp->next = new_next;
-			}
+		FreeSprite(sp);
 
-			sp = sp->next;
+		this->total_missing_zoom_levels = 0;
+		base = this->GetSpritePtr();
+		if (base != nullptr) {
+			this->total_missing_zoom_levels = base->missing_zoom_levels;
+			for (const Sprite *p = base->next; p != nullptr; p = p->next) {
+				this->total_missing_zoom_levels &= p->missing_zoom_levels;
+			}
 		}
 	}
 
 	void Assign(SpriteDataBuffer &&other)
 	{
 		this->Clear();
-		if (!other.ptr) return;
+		if (other.ptr == nullptr) return;
 
-		this->ptr.reset(other.ptr.release());
 		if (this->GetType() == SpriteType::Recolour) {
+			this->ptr.reset(other.Release());
 			_spritecache_bytes_used += RECOLOUR_SPRITE_SIZE;
 		} else {
-			this->GetSpritePtr()->size = other.size;
-			_spritecache_bytes_used += other.size;
+			Sprite *sp = this->InsertSprite(other);
+			this->ptr.reset(sp);
 			if (this->GetType() == SpriteType::Normal) {
-				this->total_missing_zoom_levels = this->GetSpritePtr()->missing_zoom_levels;
+				this->total_missing_zoom_levels = sp->missing_zoom_levels;
 			}
 		}
-		other.size = 0;
 	}
 
 	void Append(SpriteDataBuffer &&other)
@@ -165,10 +256,8 @@ public:
 			return;
 		}
 
-		Sprite *sp = (Sprite *)other.ptr.release();
-		if (sp == nullptr) return;
-
-		sp->size = other.size;
+		if (other.ptr == nullptr) return;
+		Sprite *sp = this->InsertSprite(other);
 
 		Sprite *p = this->GetSpritePtr();
 		while (p->next != nullptr) {
@@ -176,8 +265,6 @@ public:
 		}
 		p->next = sp;
 		this->total_missing_zoom_levels &= sp->missing_zoom_levels;
-		_spritecache_bytes_used += other.size;
-		other.size = 0;
 	}
 
 	~SpriteCache()
@@ -18,6 +18,7 @@
 #include "../core/alloc_type.hpp"
 #include "../core/bitmath_func.hpp"
 #include "../spritecache.h"
+#include "../thread.h"
 #include "grf.hpp"
 
 #include "../safeguards.h"
@@ -35,6 +36,10 @@ extern const uint8_t _palmap_w2d[];
 static bool WarnCorruptSprite(const SpriteFile &file, size_t file_pos, int line)
 {
 	static uint8_t warning_level = 0;
+	if (IsNonMainThread()) {
+		/* Sprites decoded on worker threads are loaded again on the main thread when decoding fails, leave the warning to that */
+		return false;
+	}
 	if (warning_level == 0) {
 		SetDParamStr(0, file.GetSimplifiedFilename());
 		ShowErrorMessage(STR_NEWGRF_ERROR_CORRUPT_SPRITE, INVALID_STRING_ID, WL_ERROR);
@@ -182,7 +187,7 @@ bool DecodeSingleSprite(SpriteLoader::Sprite *sprite, SpriteFile &file, size_t f
 			return WarnCorruptSprite(file, file_pos, __LINE__);
 		}
 
-		if (dest_size > sprite_size) {
+		if (dest_size > sprite_size && !IsNonMainThread()) {
 			static uint8_t warning_level = 0;
 			DEBUG(sprite, warning_level, "Ignoring " OTTD_PRINTF64 " unused extra bytes from the sprite from %s at position %i", dest_size - sprite_size, file.GetSimplifiedFilename().c_str(), (int)file_pos);
 			warning_level = 6;
@@ -9,6 +9,7 @@
 
 #include "../stdafx.h"
 #include "sprite_file_type.hpp"
+#include "../fileio_func.h"
 
 /** Signature of a container version 2 GRF. */
 extern const uint8_t _grf_cont_v2_sig[8] = {'G', 'R', 'F', 0x82, 0x0D, 0x0A, 0x1A, 0x0A};
@@ -43,7 +44,17 @@ static uint8_t GetGRFContainerVersion(SpriteFile &file)
  * @param palette_remap Whether a palette remap needs to be performed for this file.
  */
 SpriteFile::SpriteFile(const std::string &filename, Subdirectory subdir, bool palette_remap)
-	: RandomAccessFile(filename, subdir), palette_remap(palette_remap)
+	: SpriteFile(filename, FioFOpenFile(filename, "rb", subdir), subdir, palette_remap) {}
+
+/**
+ * Create the SpriteFile from an already opened file.
+ * @param filename      Name of the file at the disk.
+ * @param file_handle   File handle of the opened file, this takes ownership of it.
+ * @param subdir        The sub directory this file was found in.
+ * @param palette_remap Whether a palette remap needs to be performed for this file.
+ */
+SpriteFile::SpriteFile(const std::string &filename, FILE *file_handle, Subdirectory subdir, bool palette_remap)
+	: RandomAccessFile(filename, file_handle), subdir(subdir), palette_remap(palette_remap)
 {
 	this->container_version = GetGRFContainerVersion(*this);
 	this->content_begin = this->GetPos();
@@ -11,6 +11,9 @@
 #define SPRITE_FILE_TYPE_HPP
 
 #include "../random_access_file_type.h"
+#include "../3rdparty/md5/md5.h"
+
+#include <optional>
 
 enum SpriteFileFlags : uint8_t {
 	SFF_NONE                  = 0,
@@ -26,13 +29,16 @@ DECLARE_ENUM_AS_BIT_SET(SpriteFileFlags)
  */
 class SpriteFile : public RandomAccessFile {
 	size_t content_begin;   ///< The begin of the content of the sprite file, i.e. after the container metadata.
+	Subdirectory subdir;    ///< The sub directory the file was opened from.
 	bool palette_remap;     ///< Whether or not a remap of the palette is required for this file.
 	uint8_t container_version; ///< Container format of the sprite file.
+	std::optional<MD5Hash> content_md5; ///< MD5 of the sprite file, if known.
 
 public:
 	SpriteFileFlags flags = SFF_NONE;
 
 	SpriteFile(const std::string &filename, Subdirectory subdir, bool palette_remap);
+	SpriteFile(const std::string &filename, FILE *file_handle, Subdirectory subdir, bool palette_remap);
 	SpriteFile(const SpriteFile&) = delete;
 	void operator=(const SpriteFile&) = delete;
 
@@ -42,12 +48,30 @@ public:
 	 */
 	bool NeedsPaletteRemap() const { return this->palette_remap; }
 
+	/**
+	 * Get the sub directory the file was opened from.
+	 * @return The sub directory.
+	 */
+	Subdirectory GetSubdirectory() const { return this->subdir; }
+
 	/**
 	 * Get the version number of container type used by the file.
 	 * @return The version.
 	 */
 	uint8_t GetContainerVersion() const { return this->container_version; }
 
+	/**
+	 * Set the MD5 of the sprite file, this is used to identify the file in the sprite disk cache.
+	 * @param md5 The MD5 of the file.
+	 */
+	void SetContentMD5(const MD5Hash &md5) { this->content_md5 = md5; }
+
+	/**
+	 * Get the MD5 of the sprite file.
+	 * @return The MD5, if known.
+	 */
+	const std::optional<MD5Hash> &GetContentMD5() const { return this->content_md5; }
+
 	/**
 	 * Seek to the begin of the content, i.e. the position just after the container version has been determined.
 	 */
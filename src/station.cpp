@@ -21,6 +21,8 @@
 #include "core/pool_func.hpp"
 #include "station_base.h"
 #include "station_kdtree.h"
+#include "station_catchment_index.h"
+#include "station_func.h"
 #include "roadstop_base.h"
 #include "industry.h"
 #include "town.h"
@@ -57,6 +59,12 @@ void RebuildStationKdtree()
 	_station_kdtree.Build(stids.begin(), stids.end());
 }
 
+/** Resize the station catchment index for the current map size, this must only be done when there are no stations. */
+void InitializeStationCatchmentIndex()
+{
+	_station_catchment_index.Reset(MapLogX(), MapLogY());
+}
+
 
 BaseStation::~BaseStation()
 {
@@ -142,6 +150,7 @@ Station::~Station()
 
 	/* Remove station from industries and towns that reference it. */
 	this->RemoveFromAllNearbyLists();
+	_station_catchment_index.Remove(this->index, this->catchment_tiles);
 
 	/* Clear the persistent storage. */
 	delete this->airport.psa;
@@ -498,6 +507,7 @@ void Station::RecomputeCatchment(bool no_clear_nearby_lists)
 {
 	this->industries_near.clear();
 	if (!no_clear_nearby_lists) this->RemoveFromAllNearbyLists();
+	_station_catchment_index.Remove(this->index, this->catchment_tiles);
 
 	if (this->rect.IsEmpty()) {
 		this->catchment_tiles.Reset();
@@ -519,6 +529,7 @@ void Station::RecomputeCatchment(bool no_clear_nearby_lists)
 		this->industry->stations_near.clear();
 		this->industry->stations_near.insert(this);
 		this->industries_near.insert(IndustryListEntry{0, this->industry});
+		_station_catchment_index.Add(this->index, this->catchment_tiles);
 
 		/* Loop finding all station tiles */
 		TileArea ta(TileXY(this->rect.left, this->rect.top), TileXY(this->rect.right, this->rect.bottom));
@@ -547,6 +558,7 @@ void Station::RecomputeCatchment(bool no_clear_nearby_lists)
 		TileArea ta2 = TileArea(tile, 1, 1).Expand(r);
 		for (TileIndex tile2 : ta2) this->catchment_tiles.SetTile(tile2);
 	}
+	_station_catchment_index.Add(this->index, this->catchment_tiles);
 
 	/* Search catchment tiles for towns and industries */
 	BitmapTileIterator it(this->catchment_tiles);
@@ -575,6 +587,7 @@ void Station::RecomputeCatchment(bool no_clear_nearby_lists)
  */
 /* static */ void Station::RecomputeCatchmentForAll()
 {
+	_station_catchment_index.Reset(MapLogX(), MapLogY());
 	for (Town *t : Town::Iterate()) { t->stations_near.clear(); }
 	for (Industry *i : Industry::Iterate()) { i->stations_near.clear(); }
 	for (Station *st : Station::Iterate()) { st->RecomputeCatchment(true); }
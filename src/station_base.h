@@ -20,6 +20,7 @@
 #include "3rdparty/cpp-btree/btree_map.h"
 #include "3rdparty/cpp-btree/btree_set.h"
 #include "bitmap_type.h"
+#include "station_catchment_index.h"
 #include "core/alloc_type.hpp"
 #include "core/endian_type.hpp"
 #include "strings_type.h"
@@ -1017,21 +1018,12 @@ void ForAllStationsAroundTiles(const TileArea &ta, Func func)
 	/* There are no stations, so we will never find anything. */
 	if (Station::GetNumItems() == 0) return;
 
-	/* Not using, or don't have a nearby stations list, so we need to scan. */
-	btree::btree_set<StationID> seen_stations;
-
-	/* Scan an area around the building covering the maximum possible station
-	 * to find the possible nearby stations. */
-	uint max_c = _settings_game.station.modified_catchment ? MAX_CATCHMENT : CA_UNMODIFIED;
-	max_c += _settings_game.station.catchment_increase;
-	TileArea ta_ext = TileArea(ta).Expand(max_c);
-	for (TileIndex tile : ta_ext) {
-		if (IsTileType(tile, MP_STATION)) seen_stations.insert(GetStationIndex(tile));
-	}
+	/* Find the stations whose catchment covers any part of the area. */
+	std::vector<StationID> seen_stations;
+	_station_catchment_index.FindStations(ta, seen_stations);
 
 	for (StationID stationid : seen_stations) {
-		Station *st = Station::GetIfValid(stationid);
-		if (st == nullptr) continue; /* Waypoint */
+		Station *st = Station::Get(stationid);
 
 		/* Check if station is attached to an industry */
 		if (!_settings_game.station.serve_neutral_industries && st->industry != nullptr) continue;
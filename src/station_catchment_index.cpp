@@ -0,0 +1,143 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file station_catchment_index.cpp Spatial index of the tiles covered by station catchments. */
+
+#include "stdafx.h"
+#include "station_catchment_index.h"
+#include "core/geometry_type.hpp"
+#include "bitmap_type.h"
+
+#include "safeguards.h"
+
+StationCatchmentIndex _station_catchment_index;
+
+/**
+ * Remove all stations and resize the index for a map.
+ * @param map_log_x Log2 of the map size in the X direction, at least #BLOCK_EDGE_LOG.
+ * @param map_log_y Log2 of the map size in the Y direction, at least #BLOCK_EDGE_LOG.
+ */
+void StationCatchmentIndex::Reset(uint map_log_x, uint map_log_y)
+{
+	this->blocks_x_log = map_log_x - BLOCK_EDGE_LOG;
+	this->blocks_y = 1U << (map_log_y - BLOCK_EDGE_LOG);
+	this->blocks.clear();
+	this->blocks.resize(this->blocks_y << this->blocks_x_log);
+}
+
+/**
+ * Add the catchment of a station, replacing any catchment of the station which is already in the index within the same area.
+ * @param station The station.
+ * @param catchment The catchment tiles of the station.
+ */
+void StationCatchmentIndex::Add(StationID station, const BitmapTileArea &catchment)
+{
+	if (catchment.tile == INVALID_TILE || catchment.w == 0 || catchment.h == 0) return;
+
+	const uint x0 = TileX(catchment.tile);
+	const uint y0 = TileY(catchment.tile);
+	const uint x1 = x0 + catchment.w - 1;
+	const uint y1 = y0 + catchment.h - 1;
+
+	for (uint by = y0 >> BLOCK_EDGE_LOG; by <= y1 >> BLOCK_EDGE_LOG; by++) {
+		const uint ty0 = std::max(y0, by << BLOCK_EDGE_LOG);
+		const uint ty1 = std::min(y1, (by << BLOCK_EDGE_LOG) | BLOCK_EDGE_MASK);
+		for (uint bx = x0 >> BLOCK_EDGE_LOG; bx <= x1 >> BLOCK_EDGE_LOG; bx++) {
+			const uint tx0 = std::max(x0, bx << BLOCK_EDGE_LOG);
+			const uint tx1 = std::min(x1, (bx << BLOCK_EDGE_LOG) | BLOCK_EDGE_MASK);
+
+			Entry entry{ station, {} };
+			bool covered = false;
+			for (uint y = ty0; y <= ty1; y++) {
+				for (uint x = tx0; x <= tx1; x++) {
+					if (catchment.HasTile(TileXY(x, y))) {
+						SetBit(entry.rows[y & BLOCK_EDGE_MASK], x & BLOCK_EDGE_MASK);
+						covered = true;
+					}
+				}
+			}
+
+			Block &block = this->GetBlock(bx, by);
+			auto it = FindEntry(block, station);
+			const bool present = (it != block.end() && it->station == station);
+			if (covered) {
+				if (present) {
+					*it = entry;
+				} else {
+					block.insert(it, entry);
+				}
+			} else if (present) {
+				block.erase(it);
+			}
+		}
+	}
+}
+
+/**
+ * Remove the catchment of a station.
+ * @param station The station.
+ * @param catchment The catchment tiles of the station which were added to the index.
+ */
+void StationCatchmentIndex::Remove(StationID station, const BitmapTileArea &catchment)
+{
+	if (catchment.tile == INVALID_TILE || catchment.w == 0 || catchment.h == 0) return;
+
+	const uint bx0 = TileX(catchment.tile) >> BLOCK_EDGE_LOG;
+	const uint by0 = TileY(catchment.tile) >> BLOCK_EDGE_LOG;
+	const uint bx1 = (TileX(catchment.tile) + catchment.w - 1) >> BLOCK_EDGE_LOG;
+	const uint by1 = (TileY(catchment.tile) + catchment.h - 1) >> BLOCK_EDGE_LOG;
+
+	for (uint by = by0; by <= by1; by++) {
+		for (uint bx = bx0; bx <= bx1; bx++) {
+			Block &block = this->GetBlock(bx, by);
+			auto it = FindEntry(block, station);
+			if (it != block.end() && it->station == station) block.erase(it);
+		}
+	}
+}
+
+/**
+ * Find all stations whose catchment covers at least one tile of an area.
+ * @param ta The area.
+ * @param[out] stations The stations, in order of station ID.
+ */
+void StationCatchmentIndex::FindStations(const TileArea &ta, std::vector<StationID> &stations) const
+{
+	stations.clear();
+	if (ta.tile == INVALID_TILE || ta.w == 0 || ta.h == 0) return;
+
+	const uint x0 = TileX(ta.tile);
+	const uint y0 = TileY(ta.tile);
+	const uint x1 = x0 + ta.w - 1;
+	const uint y1 = y0 + ta.h - 1;
+
+	uint blocks = 0;
+	for (uint by = y0 >> BLOCK_EDGE_LOG; by <= y1 >> BLOCK_EDGE_LOG; by++) {
+		const uint row0 = std::max(y0, by << BLOCK_EDGE_LOG) & BLOCK_EDGE_MASK;
+		const uint row1 = std::min(y1, (by << BLOCK_EDGE_LOG) | BLOCK_EDGE_MASK) & BLOCK_EDGE_MASK;
+		for (uint bx = x0 >> BLOCK_EDGE_LOG; bx <= x1 >> BLOCK_EDGE_LOG; bx++) {
+			const uint col0 = std::max(x0, bx << BLOCK_EDGE_LOG) & BLOCK_EDGE_MASK;
+			const uint col1 = std::min(x1, (bx << BLOCK_EDGE_LOG) | BLOCK_EDGE_MASK) & BLOCK_EDGE_MASK;
+			const uint16_t col_mask = GetBitMaskFL<uint16_t>(col0, col1);
+
+			for (const Entry &entry : this->GetBlock(bx, by)) {
+				for (uint row = row0; row <= row1; row++) {
+					if ((entry.rows[row] & col_mask) != 0) {
+						stations.push_back(entry.station);
+						break;
+					}
+				}
+			}
+			blocks++;
+		}
+	}
+
+	if (blocks > 1) {
+		std::sort(stations.begin(), stations.end());
+		stations.erase(std::unique(stations.begin(), stations.end()), stations.end());
+	}
+}
@@ -0,0 +1,96 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file station_catchment_index.h Spatial index of the tiles covered by station catchments. */
+
+#ifndef STATION_CATCHMENT_INDEX_H
+#define STATION_CATCHMENT_INDEX_H
+
+#include "station_type.h"
+#include "tilearea_type.h"
+#include "map_func.h"
+#include "core/bitmath_func.hpp"
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+class BitmapTileArea;
+
+/**
+ * Spatial index of the tiles covered by station catchments, used to find the stations covering a tile without scanning around it.
+ *
+ * The map is divided into blocks of 16x16 tiles. Each block has a list, sorted by station, of the stations whose catchment covers
+ * at least one tile of the block, with a bitmap of the covered tiles of the block.
+ * The index mirrors Station::catchment_tiles, and is updated whenever that is recomputed.
+ */
+class StationCatchmentIndex {
+public:
+	static constexpr uint BLOCK_EDGE_LOG = 4;
+	static constexpr uint BLOCK_EDGE = 1 << BLOCK_EDGE_LOG;
+	static constexpr uint BLOCK_EDGE_MASK = BLOCK_EDGE - 1;
+
+private:
+	/** Catchment of one station within a block. */
+	struct Entry {
+		StationID station;                      ///< The station.
+		std::array<uint16_t, BLOCK_EDGE> rows;  ///< One bit per covered tile, one word per row.
+
+		bool operator==(const Entry &other) const = default;
+	};
+
+	using Block = std::vector<Entry>;
+
+	std::vector<Block> blocks; ///< Blocks, row by row.
+	uint blocks_x_log = 0;     ///< Log2 of the number of blocks in the X direction.
+	uint blocks_y = 0;         ///< Number of blocks in the Y direction.
+
+	inline const Block &GetBlock(uint bx, uint by) const
+	{
+		return this->blocks[(by << this->blocks_x_log) | bx];
+	}
+
+	inline Block &GetBlock(uint bx, uint by)
+	{
+		return this->blocks[(by << this->blocks_x_log) | bx];
+	}
+
+	static inline Block::iterator FindEntry(Block &block, StationID station)
+	{
+		return std::lower_bound(block.begin(), block.end(), station, [](const Entry &entry, StationID id) { return entry.station < id; });
+	}
+
+public:
+	void Reset(uint map_log_x, uint map_log_y);
+	void Add(StationID station, const BitmapTileArea &catchment);
+	void Remove(StationID station, const BitmapTileArea &catchment);
+	void FindStations(const TileArea &ta, std::vector<StationID> &stations) const;
+
+	/**
+	 * Call a function on all stations whose catchment covers a tile, in order of station ID.
+	 * @param tile The tile.
+	 * @param func The function to call, must take a single parameter which is StationID.
+	 */
+	template <typename Func>
+	void ForEachStationOnTile(TileIndex tile, Func func) const
+	{
+		const uint x = TileX(tile);
+		const uint y = TileY(tile);
+		const Block &block = this->GetBlock(x >> BLOCK_EDGE_LOG, y >> BLOCK_EDGE_LOG);
+		const uint row = y & BLOCK_EDGE_MASK;
+		const uint col = x & BLOCK_EDGE_MASK;
+		for (const Entry &entry : block) {
+			if (HasBit(entry.rows[row], col)) func(entry.station);
+		}
+	}
+
+	bool operator==(const StationCatchmentIndex &other) const = default;
+};
+
+extern StationCatchmentIndex _station_catchment_index;
+
+#endif /* STATION_CATCHMENT_INDEX_H */
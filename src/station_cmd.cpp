@@ -61,6 +61,7 @@
 #include "cheat_type.h"
 #include "newgrf_roadstop.h"
 #include "core/math_func.hpp"
+#include "framerate_type.h"
 
 #include "table/strings.h"
 
@@ -1672,10 +1673,11 @@ CommandCost CmdBuildRailStation(TileIndex tile_org, DoCommandFlag flags, uint32_
 				if (!blocked) c->infrastructure.rail[rt]++;
 				c->infrastructure.station++;
 
+				YapfNotifyTrackLayoutChange(tile, track);
+
 				tile += tile_delta;
 			} while (--w);
 			AddTrackToSignalBuffer(tile_track, track, _current_company);
-			YapfNotifyTrackLayoutChange(tile_track, track);
 			tile_track += tile_delta ^ TileDiffXY(1, 1); // perpendicular to tile_delta
 		} while (--numtracks);
 
@@ -4277,6 +4279,8 @@ int GetTargetRating(const Station *st, const CargoSpec *cs, const GoodsEntry *ge
 
 static void UpdateStationRating(Station *st)
 {
+	PerformanceZoneMeasurer framerate(PFZ_STATION_RATINGS);
+
 	bool waiting_changed = false;
 
 	byte_inc_sat(&st->time_since_load);
@@ -4882,13 +4886,6 @@ CommandCost CmdSetStationCargoAllowedSupply(TileIndex tile, DoCommandFlag flags,
 	return CommandCost();
 }
 
-static void AddNearbyStationsByCatchment(TileIndex tile, StationList *stations, StationList &nearby)
-{
-	for (Station *st : nearby) {
-		if (st->TileIsInCatchment(tile)) stations->insert(st);
-	}
-}
-
 /**
  * Run a tile loop to find stations around a tile, on demand. Cache the result for further requests
  * @return pointer to a StationList containing all stations found
@@ -4897,9 +4894,11 @@ const StationList *StationFinder::GetStations()
 {
 	if (this->tile != INVALID_TILE) {
 		if (IsTileType(this->tile, MP_HOUSE)) {
-			/* Town nearby stations need to be filtered per tile. */
+			/* Houses are single tiles, so only the stations covering this tile need to be looked up. */
 			assert(this->w == 1 && this->h == 1);
-			AddNearbyStationsByCatchment(this->tile, &this->stations, Town::GetByTile(this->tile)->stations_near);
+			_station_catchment_index.ForEachStationOnTile(this->tile, [this](StationID id) {
+				this->stations.insert(Station::Get(id));
+			});
 		} else {
 			ForAllStationsAroundTiles(*this, [this](Station *st, TileIndex) {
 				this->stations.insert(st);
@@ -5751,4 +5750,5 @@ extern const TileTypeProcs _tile_type_station_procs = {
 	VehicleEnter_Station,       // vehicle_enter_tile_proc
 	GetFoundation_Station,      // get_foundation_proc
 	TerraformTile_Station,      // terraform_tile_proc
+	nullptr,                    // tile_loop_quiescent_proc
 };
@@ -53,6 +53,8 @@ void RerouteCargoFromSource(Station *st, CargoID c, StationID source, StationID
 
 void FreeTrainStationPlatformReservation(const Train *v);
 
+void InitializeStationCatchmentIndex();
+
 /**
  * Calculates the maintenance cost of a number of station tiles.
  * @param num Number of station tiles.
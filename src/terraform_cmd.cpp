@@ -17,6 +17,7 @@
 #include "company_base.h"
 #include "company_func.h"
 #include "core/backup_type.hpp"
+#include "pathfinder/yapf/yapf_cache.h"
 
 #include "table/strings.h"
 
@@ -330,6 +331,11 @@ CommandCost CmdTerraformLand(TileIndex tile, DoCommandFlag flags, uint32_t p1, u
 			SetTileHeight(t, (uint)height);
 		}
 
+		/* Track and road costs depend on the slope */
+		for (const auto &t : ts.dirty_tiles) {
+			YapfNotifyTrackLayoutChange(t, INVALID_TRACK);
+		}
+
 		if (c != nullptr) c->terraform_limit -= (uint32_t)ts.tile_to_new_height.size() << 16;
 	}
 	return total_cost;
@@ -0,0 +1,61 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file mock_map.h Scoped mock map size, for tests of code which depends on the map size but not on the map contents. */
+
+#ifndef MOCK_MAP_H
+#define MOCK_MAP_H
+
+#include "../map_func.h"
+
+extern uint _map_log_x;
+extern uint _map_log_y;
+extern uint _map_size_x;
+extern uint _map_size_y;
+extern uint _map_size;
+extern uint _map_tile_mask;
+
+/** Set the map size globals without allocating the map, and restore them when going out of scope. */
+class MockMapSize {
+	uint log_x;
+	uint log_y;
+	uint size_x;
+	uint size_y;
+	uint size;
+	uint tile_mask;
+
+public:
+	/**
+	 * Set the map size.
+	 * @param log_x Base 2 logarithm of the size of the map along the X.
+	 * @param log_y Base 2 logarithm of the size of the map along the Y.
+	 */
+	MockMapSize(uint log_x, uint log_y) : log_x(_map_log_x), log_y(_map_log_y), size_x(_map_size_x), size_y(_map_size_y), size(_map_size), tile_mask(_map_tile_mask)
+	{
+		_map_log_x = log_x;
+		_map_log_y = log_y;
+		_map_size_x = 1U << log_x;
+		_map_size_y = 1U << log_y;
+		_map_size = _map_size_x * _map_size_y;
+		_map_tile_mask = _map_size - 1;
+	}
+
+	~MockMapSize()
+	{
+		_map_log_x = this->log_x;
+		_map_log_y = this->log_y;
+		_map_size_x = this->size_x;
+		_map_size_y = this->size_y;
+		_map_size = this->size;
+		_map_tile_mask = this->tile_mask;
+	}
+
+	MockMapSize(const MockMapSize &) = delete;
+	MockMapSize &operator=(const MockMapSize &) = delete;
+};
+
+#endif /* MOCK_MAP_H */
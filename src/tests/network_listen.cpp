@@ -0,0 +1,236 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file network_listen.cpp Test accepting, receiving from and sending to connections of a TCP listener over loopback. */
+
+#include "../stdafx.h"
+
+#include "../3rdparty/catch2/catch.hpp"
+
+#include "../network/network_admin.h"
+#include "../network/network_func.h"
+#include "../settings_type.h"
+
+#include <chrono>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+
+/** Admin server listening on a loopback port, closed when going out of scope. */
+struct TestAdminServer {
+	std::string old_admin_password = _settings_client.network.admin_password;
+	StringList old_bind_list = _network_bind_list;
+	uint16_t port = 0;
+
+	TestAdminServer()
+	{
+		_settings_client.network.admin_password = "test";
+		_network_bind_list = { "127.0.0.1" };
+
+		/* Find a free port */
+		SOCKET s = socket(AF_INET, SOCK_STREAM, 0);
+		REQUIRE(s != INVALID_SOCKET);
+		struct sockaddr_in sin{};
+		sin.sin_family = AF_INET;
+		sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		REQUIRE(bind(s, reinterpret_cast<struct sockaddr *>(&sin), sizeof(sin)) == 0);
+		socklen_t sin_len = sizeof(sin);
+		REQUIRE(getsockname(s, reinterpret_cast<struct sockaddr *>(&sin), &sin_len) == 0);
+		closesocket(s);
+		this->port = ntohs(sin.sin_port);
+	}
+
+	~TestAdminServer()
+	{
+		for (ServerNetworkAdminSocketHandler *as : ServerNetworkAdminSocketHandler::Iterate()) {
+			as->CloseConnection(true);
+		}
+		ServerNetworkAdminSocketHandler::CloseListeners();
+		_settings_client.network.admin_password = this->old_admin_password;
+		_network_bind_list = this->old_bind_list;
+	}
+
+	/** Handle the network of the server once. */
+	void Tick()
+	{
+		ServerNetworkAdminSocketHandler::Receive();
+		ServerNetworkAdminSocketHandler::Send();
+	}
+};
+
+/**
+ * Connect to the server.
+ * @param port The port of the server.
+ * @return The client socket.
+ */
+static SOCKET ConnectClient(uint16_t port)
+{
+	SOCKET s = socket(AF_INET, SOCK_STREAM, 0);
+	REQUIRE(s != INVALID_SOCKET);
+	struct sockaddr_in sin{};
+	sin.sin_family = AF_INET;
+	sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	sin.sin_port = htons(port);
+	REQUIRE(connect(s, reinterpret_cast<struct sockaddr *>(&sin), sizeof(sin)) == 0);
+	return s;
+}
+
+/**
+ * Receive the data which is available on a client socket.
+ * @param s The client socket.
+ * @param[out] buffer The buffer to append the data to.
+ * @return The number of bytes received.
+ */
+static size_t ReceiveAvailable(SOCKET s, std::vector<uint8_t> &buffer)
+{
+	size_t total = 0;
+	uint8_t chunk[65536];
+	ssize_t received;
+	while ((received = recv(s, chunk, sizeof(chunk), MSG_DONTWAIT)) > 0) {
+		buffer.insert(buffer.end(), chunk, chunk + received);
+		total += received;
+	}
+	return total;
+}
+
+/**
+ * Get the types of the complete packets in the received data.
+ * @param buffer The received data.
+ * @return The packet types.
+ */
+static std::vector<uint8_t> GetPacketTypes(const std::vector<uint8_t> &buffer)
+{
+	std::vector<uint8_t> types;
+	size_t pos = 0;
+	while (pos + 3 <= buffer.size()) {
+		const size_t size = buffer[pos] | (buffer[pos + 1] << 8);
+		if (pos + size > buffer.size()) break;
+		types.push_back(buffer[pos + 2]);
+		pos += size;
+	}
+	return types;
+}
+
+/**
+ * Connect an admin to the server and exchange packets with it, including when the send buffer of the server is full.
+ * @param server The server.
+ */
+static void TestAdminConnection(TestAdminServer &server)
+{
+	const bool polling = ServerNetworkAdminSocketHandler::IsPolling();
+
+	SOCKET client = ConnectClient(server.port);
+
+	/* Accept the connection */
+	for (int i = 0; i < 1000 && ServerNetworkAdminSocketHandler::GetNumItems() == 0; i++) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		server.Tick();
+	}
+	REQUIRE(ServerNetworkAdminSocketHandler::GetNumItems() == 1);
+	ServerNetworkAdminSocketHandler *as = *ServerNetworkAdminSocketHandler::Iterate().begin();
+	CHECK(ServerNetworkAdminSocketHandler::IsPolling() == polling);
+
+	/* Receive the join, to which the server replies with its protocol and welcome */
+	Packet join(ADMIN_PACKET_ADMIN_JOIN);
+	join.Send_string("test");
+	join.Send_string("test admin");
+	join.Send_string("1.0");
+	join.PrepareToSend();
+	REQUIRE(join.TransferOut<int>(send, client, 0) > 0);
+
+	std::vector<uint8_t> buffer;
+	for (int i = 0; i < 1000 && GetPacketTypes(buffer).size() < 2; i++) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		server.Tick();
+		ReceiveAvailable(client, buffer);
+	}
+	CHECK(GetPacketTypes(buffer) == std::vector<uint8_t>{ ADMIN_PACKET_SERVER_PROTOCOL, ADMIN_PACKET_SERVER_WELCOME });
+	CHECK_FALSE(as->HasSendQueue());
+
+	/* Queue packets without the client reading them, until sending would block */
+	size_t queued = 0;
+	auto queue_packets = [&]() {
+		for (int j = 0; j < 64; j++) {
+			auto p = std::make_unique<Packet>(ADMIN_PACKET_SERVER_PONG, TCP_MTU);
+			for (uint32_t k = 0; k < 1000; k++) p->Send_uint32(k);
+			queued += p->Size();
+			as->SendPacket(std::move(p));
+		}
+	};
+	for (int i = 0; i < 10000 && as->writable; i++) {
+		queue_packets();
+		ServerNetworkAdminSocketHandler::Send();
+	}
+	REQUIRE_FALSE(as->writable);
+	REQUIRE(as->HasSendQueue());
+
+	/* Packets queued whilst the socket would block wait until it becomes writable */
+	queue_packets();
+	server.Tick();
+	CHECK_FALSE(as->writable);
+
+	/* Once the client reads, the socket becomes writable again and the rest is sent */
+	buffer.clear();
+	size_t received = 0;
+	for (int i = 0; i < 100000 && received < queued; i++) {
+		received += ReceiveAvailable(client, buffer);
+		buffer.clear();
+		server.Tick();
+		if (i % 100 == 99) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	CHECK(received == queued);
+	CHECK_FALSE(as->HasSendQueue());
+
+	/* Further packets are sent without waiting for the socket to be reported as writable again */
+	queued = 0;
+	queue_packets();
+	received = 0;
+	for (int i = 0; i < 1000 && received < queued; i++) {
+		received += ReceiveAvailable(client, buffer);
+		buffer.clear();
+		server.Tick();
+	}
+	CHECK(received == queued);
+	CHECK_FALSE(as->HasSendQueue());
+
+	closesocket(client);
+}
+
+#ifdef HAVE_EPOLL
+TEST_CASE("Network listen - epoll")
+{
+	TestAdminServer server;
+	REQUIRE(ServerNetworkAdminSocketHandler::Listen(server.port));
+	REQUIRE(ServerNetworkAdminSocketHandler::IsPolling());
+
+	TestAdminConnection(server);
+}
+#endif /* HAVE_EPOLL */
+
+TEST_CASE("Network listen - select")
+{
+	TestAdminServer server;
+
+	/* Only allow the listener socket to be opened, so that polling can't be set up */
+	struct rlimit old_limit;
+	REQUIRE(getrlimit(RLIMIT_NOFILE, &old_limit) == 0);
+	const int lowest_free_fd = open("/dev/null", O_RDONLY);
+	REQUIRE(lowest_free_fd >= 0);
+	close(lowest_free_fd);
+	struct rlimit limit = old_limit;
+	limit.rlim_cur = lowest_free_fd + 1;
+	REQUIRE(setrlimit(RLIMIT_NOFILE, &limit) == 0);
+	const bool listening = ServerNetworkAdminSocketHandler::Listen(server.port);
+	REQUIRE(setrlimit(RLIMIT_NOFILE, &old_limit) == 0);
+
+	REQUIRE(listening);
+	REQUIRE_FALSE(ServerNetworkAdminSocketHandler::IsPolling());
+
+	TestAdminConnection(server);
+}
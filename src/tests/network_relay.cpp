@@ -0,0 +1,223 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file network_relay.cpp Test that the spectators of a relay receive the frames, syncs and commands of the relayed server. */
+
+#include "../stdafx.h"
+
+#include "../3rdparty/catch2/catch.hpp"
+
+#include "../network/network.h"
+#include "../network/network_internal.h"
+#include "../network/network_server.h"
+#include "../core/checksum_func.hpp"
+#include "../core/random_func.hpp"
+#include "../settings_type.h"
+
+#include <sys/socket.h>
+
+/** A spectator of the relay, connected by a socket pair. */
+struct TestSpectator {
+	ServerNetworkGameSocketHandler *cs; ///< The relay's side of the connection.
+	SOCKET remote;                      ///< The spectator's side of the connection.
+};
+
+/**
+ * Connect an active spectator to the relay.
+ * @return The spectator.
+ */
+static TestSpectator ConnectSpectator()
+{
+	int fds[2];
+	REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+
+	ServerNetworkGameSocketHandler *cs = new ServerNetworkGameSocketHandler(fds[0]);
+	cs->status = NetworkClientSocket::STATUS_ACTIVE;
+	cs->writable = true;
+	cs->last_frame = _frame_counter;
+	cs->last_frame_server = _frame_counter;
+	cs->last_token_frame = _frame_counter;
+	/* The token is only sent in the first frame after joining, after that the frame packets are shared. */
+	cs->last_token = 1;
+	return { cs, fds[1] };
+}
+
+/**
+ * Send the queued packets of the relay to a spectator, and receive them.
+ * @param spectator The spectator.
+ * @return The packets received, without their size.
+ */
+static std::vector<std::vector<uint8_t>> ReceivePackets(TestSpectator &spectator)
+{
+	REQUIRE(spectator.cs->SendPackets() == SPS_ALL_SENT);
+
+	std::vector<uint8_t> buffer;
+	uint8_t chunk[4096];
+	ssize_t received;
+	while ((received = recv(spectator.remote, chunk, sizeof(chunk), MSG_DONTWAIT)) > 0) {
+		buffer.insert(buffer.end(), chunk, chunk + received);
+	}
+
+	std::vector<std::vector<uint8_t>> packets;
+	size_t pos = 0;
+	while (pos < buffer.size()) {
+		REQUIRE(pos + 3 <= buffer.size());
+		const size_t size = buffer[pos] | (buffer[pos + 1] << 8);
+		REQUIRE(pos + size <= buffer.size());
+		packets.emplace_back(buffer.begin() + pos + 2, buffer.begin() + pos + size);
+		pos += size;
+	}
+	return packets;
+}
+
+/** Reader of the fields of a received packet. */
+struct TestPacketReader {
+	const std::vector<uint8_t> &data;
+	size_t pos = 1; ///< Skip the packet type.
+
+	uint64_t Read(size_t bytes)
+	{
+		REQUIRE(this->pos + bytes <= this->data.size());
+		uint64_t value = 0;
+		for (size_t i = 0; i < bytes; i++) value |= static_cast<uint64_t>(this->data[this->pos++]) << (i * 8);
+		return value;
+	}
+
+	void SkipString()
+	{
+		while (this->Read(1) != 0) {}
+	}
+
+	bool AtEnd() const { return this->pos == this->data.size(); }
+};
+
+/**
+ * Check a frame packet.
+ * @param data The packet.
+ * @param frame The frame the relay is at.
+ * @param frame_max The frame the relayed server allows to run to.
+ */
+static void CheckFramePacket(const std::vector<uint8_t> &data, uint32_t frame, uint32_t frame_max)
+{
+	REQUIRE(data[0] == PACKET_SERVER_FRAME);
+	TestPacketReader reader{ data };
+	CHECK(reader.Read(4) == frame);
+	CHECK(reader.Read(4) == frame_max);
+#ifdef ENABLE_NETWORK_SYNC_EVERY_FRAME
+	CHECK(reader.Read(4) == _random.state[0]);
+	CHECK(reader.Read(8) == _state_checksum.state);
+#endif
+	CHECK(reader.AtEnd());
+}
+
+TEST_CASE("Network relay - spectators follow the relayed server")
+{
+	const bool old_relay = _network_relay;
+	const uint32_t old_frame_counter = _frame_counter;
+	const uint32_t old_frame_counter_max = _frame_counter_max;
+	const uint32_t old_last_sync_frame = _last_sync_frame;
+	const uint32_t old_random_state = _random.state[0];
+	const uint64_t old_state_checksum = _state_checksum.state;
+	const NetworkSettings old_network_settings = _settings_client.network;
+
+	_network_relay = true;
+	_settings_client.network.sync_freq = 5;
+	_settings_client.network.frame_freq = 1;
+	_settings_client.network.max_lag_time = 500;
+	_settings_client.network.bytes_per_frame = 8;
+	_settings_client.network.bytes_per_frame_burst = 256;
+
+	/* The relay has loaded the game of the relayed server at frame 100 */
+	_frame_counter = 100;
+	_frame_counter_max = 100;
+	_last_sync_frame = 100;
+
+	std::vector<TestSpectator> spectators;
+	for (int i = 0; i < 3; i++) spectators.push_back(ConnectSpectator());
+	for (const TestSpectator &spectator : spectators) {
+		CHECK(spectator.cs->client_id >= CLIENT_ID_RELAY_FIRST);
+	}
+
+	/* The relayed server allows running up to frame 105 */
+	_frame_counter_max = 105;
+	NetworkRelay_Tick();
+
+	/* The relayed server sends a command for frame 103, before the relay has run it */
+	CommandPacket cp;
+	cp.tile = 0;
+	cp.p1 = 1;
+	cp.p2 = 2;
+	cp.p3 = 3;
+	cp.cmd = CMD_PAUSE;
+	cp.company = COMPANY_SPECTATOR;
+	cp.frame = 103;
+	cp.my_cmd = true;
+	NetworkRelayDistributeCommand(cp);
+
+	/* No frame is sent when the relayed server did not send a new one */
+	NetworkRelay_Tick();
+
+	/* The relay has run up to frame 105 where the relayed server checks the sync, with the same state as the server */
+	_frame_counter = 105;
+	_random.state[0] = 0x12345678;
+	_state_checksum.state = 0x0123456789ABCDEFULL;
+	_frame_counter_max = 110;
+	NetworkRelay_Tick();
+
+	const std::vector<std::vector<uint8_t>> expected = ReceivePackets(spectators[0]);
+#ifdef ENABLE_NETWORK_SYNC_EVERY_FRAME
+	REQUIRE(expected.size() == 3);
+#else
+	REQUIRE(expected.size() == 4);
+#endif
+
+	CheckFramePacket(expected[0], 100, 105);
+
+	REQUIRE(expected[1][0] == PACKET_SERVER_COMMAND);
+	TestPacketReader command{ expected[1] };
+	CHECK(command.Read(1) == COMPANY_SPECTATOR);
+	CHECK(command.Read(4) == CMD_PAUSE);
+	CHECK(command.Read(4) == 1);
+	CHECK(command.Read(4) == 2);
+	CHECK(command.Read(8) == 3);
+	CHECK(command.Read(4) == 0);
+	command.SkipString();
+	command.Read(1); // callback
+	command.pos += command.Read(2); // auxiliary data
+	CHECK(command.Read(4) == 103); // the frame of the relayed server
+	CHECK(command.Read(1) == 0); // not from the spectator
+	CHECK(command.AtEnd());
+
+	CheckFramePacket(expected[2], 105, 110);
+
+#ifndef ENABLE_NETWORK_SYNC_EVERY_FRAME
+	REQUIRE(expected[3][0] == PACKET_SERVER_SYNC);
+	TestPacketReader sync{ expected[3] };
+	CHECK(sync.Read(4) == 105);
+	CHECK(sync.Read(4) == 0x12345678);
+	CHECK(sync.Read(8) == 0x0123456789ABCDEFULL);
+	CHECK(sync.AtEnd());
+#endif
+
+	/* All spectators receive exactly the same */
+	for (size_t i = 1; i < spectators.size(); i++) {
+		CHECK(ReceivePackets(spectators[i]) == expected);
+	}
+
+	for (TestSpectator &spectator : spectators) {
+		delete spectator.cs;
+		closesocket(spectator.remote);
+	}
+
+	_network_relay = old_relay;
+	_frame_counter = old_frame_counter;
+	_frame_counter_max = old_frame_counter_max;
+	_last_sync_frame = old_last_sync_frame;
+	_random.state[0] = old_random_state;
+	_state_checksum.state = old_state_checksum;
+	_settings_client.network = old_network_settings;
+}
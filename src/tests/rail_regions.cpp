@@ -0,0 +1,44 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file rail_regions.cpp Test that track layout changes keep the rail regions up to date. */
+
+#include "../stdafx.h"
+
+#include "../3rdparty/catch2/catch.hpp"
+
+#include "../pathfinder/rail_regions.h"
+#include "../pathfinder/yapf/yapf_cache.h"
+#include "../rail_map.h"
+
+TEST_CASE("RailRegions - Platform across regions")
+{
+	AllocateMap(256, 128);
+
+	/* Both regions are calculated before there is any track */
+	CHECK(GetRailRegionPatchInfo(TileXY(10, 5)).label == INVALID_RAIL_REGION_PATCH);
+	CHECK(GetRailRegionPatchInfo(TileXY(20, 5)).label == INVALID_RAIL_REGION_PATCH);
+
+	/* A platform from region (0, 0) into region (1, 0) is notified tile by tile, as when building a rail station */
+	for (uint x = 10; x <= 20; x++) {
+		MakeRailNormal(TileXY(x, 5), OWNER_NONE, TRACK_BIT_X, RAILTYPE_RAIL);
+		YapfNotifyTrackLayoutChange(TileXY(x, 5), TRACK_X);
+	}
+
+	const RailRegionPatchDesc first = GetRailRegionPatchInfo(TileXY(10, 5));
+	const RailRegionPatchDesc last = GetRailRegionPatchInfo(TileXY(20, 5));
+	CHECK(first.label != INVALID_RAIL_REGION_PATCH);
+	CHECK(last.label != INVALID_RAIL_REGION_PATCH);
+	CHECK(GetRailRegionPatchInfo(TileXY(15, 5)) == first);
+	CHECK(GetRailRegionPatchInfo(TileXY(16, 5)) == RailRegionPatchDesc{ 1, 0, last.label });
+
+	/* Both regions see the track which connects them */
+	std::vector<RailRegionPatchDesc> neighbours;
+	TVisitRailRegionPatchCallBack callback = [&](const RailRegionPatchDesc &patch) { neighbours.push_back(patch); };
+	VisitRailRegionPatchNeighbors(first, callback);
+	CHECK(neighbours == std::vector<RailRegionPatchDesc>{ last });
+}
@@ -0,0 +1,160 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file saveload_parallel.cpp Test saving chunks in parallel on the worker threads. */
+
+#include "../stdafx.h"
+
+#include "../3rdparty/catch2/catch.hpp"
+
+#include "../sl/saveload_internal.h"
+#include "../sl/saveload_filter.h"
+#include "../gamelog.h"
+#include "../gamelog_internal.h"
+#include "../worker_thread.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+/** Save filter which keeps the saved data in memory. */
+struct TestSaveFilter : SaveFilter {
+	std::vector<uint8_t> data; ///< The saved data.
+
+	TestSaveFilter() : SaveFilter(nullptr) {}
+
+	void Write(uint8_t *buf, size_t len) override
+	{
+		this->data.insert(this->data.end(), buf, buf + len);
+	}
+};
+
+static std::atomic<bool> _failing_chunk_unwound;  ///< Has the failing chunk thrown its error?
+static std::thread::id _failing_chunk_thread;      ///< The thread which saved the failing chunk.
+static size_t _gamelog_actions_after_error;        ///< Number of gamelog actions when the game thread logged a change after the error.
+
+/**
+ * Wait until a flag is set, or a time out.
+ * @param flag The flag.
+ * @return Whether the flag is set.
+ */
+static bool WaitForFlag(const std::atomic<bool> &flag)
+{
+	const auto end = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+	while (!flag.load()) {
+		if (std::chrono::steady_clock::now() > end) return false;
+		std::this_thread::yield();
+	}
+	return true;
+}
+
+static void Save_TSER()
+{
+	SlSetLength(4);
+	SlWriteUint32(1);
+}
+
+static void Save_TSER_WaitForError()
+{
+	/* The failing chunk is saved on a worker whilst the game thread is saving this chunk */
+	if (WaitForFlag(_failing_chunk_unwound)) {
+		/* The failed chunk must not have stopped the gamelog action of the game thread */
+		GamelogSetting("parallel_save_test", 0, 1);
+		_gamelog_actions_after_error = _gamelog_actions.size();
+	}
+	Save_TSER();
+}
+
+static void Save_TPAR()
+{
+	SlSetLength(8);
+	SlWriteUint32(2);
+	SlWriteUint32(3);
+}
+
+static void Save_TFAI()
+{
+	_failing_chunk_thread = std::this_thread::get_id();
+
+	/* Signal that the error has been thrown, after SlError did everything it does before throwing. */
+	struct Unwound {
+		~Unwound() { _failing_chunk_unwound = true; }
+	} unwound;
+
+	SlErrorCorrupt("parallel test chunk failed");
+}
+
+TEST_CASE("Saveload - parallel chunks")
+{
+	_general_worker_pool.Start("ottd:test", 2);
+
+	TestSaveFilter writer;
+	std::string error_msg;
+	const std::vector<ChunkHandler> handlers = {
+		{ 'TSER', Save_TSER, nullptr, nullptr, nullptr, CH_RIFF },
+		{ 'TPAR', Save_TPAR, nullptr, nullptr, nullptr, CH_RIFF, nullptr, true },
+		{ 'TSE2', Save_TSER, nullptr, nullptr, nullptr, CH_RIFF },
+	};
+	CHECK(SaveChunksWithFilter(handlers, writer, error_msg) == SL_OK);
+
+	/* The parallel chunk is saved in chunk order */
+	const std::vector<uint8_t> expected = {
+		'T', 'S', 'E', 'R', 0, 0, 0, 4, 0, 0, 0, 1,
+		'T', 'P', 'A', 'R', 0, 0, 0, 8, 0, 0, 0, 2, 0, 0, 0, 3,
+		'T', 'S', 'E', '2', 0, 0, 0, 4, 0, 0, 0, 1,
+		0, 0, 0, 0, // Terminator
+	};
+	CHECK(writer.data == expected);
+
+	_general_worker_pool.Stop();
+}
+
+TEST_CASE("Saveload - failing parallel chunk")
+{
+	_general_worker_pool.Start("ottd:test", 2);
+
+	_failing_chunk_unwound = false;
+	_failing_chunk_thread = {};
+	_gamelog_actions_after_error = 0;
+
+	GamelogStartAction(GLAT_SETTING);
+	const size_t gamelog_actions = _gamelog_actions.size();
+
+	TestSaveFilter writer;
+	std::string error_msg;
+	const std::vector<ChunkHandler> handlers = {
+		{ 'TSER', Save_TSER_WaitForError, nullptr, nullptr, nullptr, CH_RIFF },
+		{ 'TFAI', Save_TFAI, nullptr, nullptr, nullptr, CH_RIFF, nullptr, true },
+		{ 'TPAR', Save_TPAR, nullptr, nullptr, nullptr, CH_RIFF, nullptr, true },
+	};
+	CHECK(SaveChunksWithFilter(handlers, writer, error_msg) == SL_ERROR);
+	CHECK(error_msg == "parallel test chunk failed");
+	CHECK(writer.data.empty());
+
+	/* The chunk failed on a worker, or on the game thread when there are no workers, and the game thread could still log to its gamelog action afterwards */
+	CHECK(_failing_chunk_unwound);
+	if (_general_worker_pool.GetWorkerCount() > 0) CHECK(_failing_chunk_thread != std::this_thread::get_id());
+	CHECK(_gamelog_actions_after_error == gamelog_actions + 1);
+	CHECK(_gamelog_actions.back().at == GLAT_SETTING);
+
+	/* The error stopped the gamelog action of the game thread, so a new one can be started */
+	GamelogStartAction(GLAT_SETTING);
+	GamelogStopAction();
+	GamelogReset();
+
+	/* The failed save doesn't affect the next one */
+	error_msg.clear();
+	TestSaveFilter next_writer;
+	const std::vector<ChunkHandler> next_handlers = {
+		{ 'TPAR', Save_TPAR, nullptr, nullptr, nullptr, CH_RIFF, nullptr, true },
+	};
+	CHECK(SaveChunksWithFilter(next_handlers, next_writer, error_msg) == SL_OK);
+	CHECK(error_msg.empty());
+	CHECK(next_writer.data.size() == 16 + 4);
+
+	_general_worker_pool.Stop();
+}
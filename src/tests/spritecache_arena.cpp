@@ -0,0 +1,158 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file spritecache_arena.cpp Test functionality from spritecache_arena.h */
+
+#include "../stdafx.h"
+
+#include "../3rdparty/catch2/catch.hpp"
+
+#include "../spritecache_arena.h"
+#include "../spritecache_internal.h"
+
+#include <algorithm>
+#include <random>
+#include <utility>
+
+TEST_CASE("SpriteArena - Size classes")
+{
+	SpriteArena arena;
+
+	CHECK(arena.GetAllocationSize(1) == 16);
+	CHECK(arena.GetAllocationSize(16) == 16);
+	CHECK(arena.GetAllocationSize(17) == 32);
+	CHECK(arena.GetAllocationSize(128) == 128);
+	CHECK(arena.GetAllocationSize(129) == 160);
+	CHECK(arena.GetAllocationSize(SpriteArena::MAX_SLAB_ALLOCATION) == SpriteArena::MAX_SLAB_ALLOCATION);
+	CHECK(arena.GetAllocationSize(SpriteArena::MAX_SLAB_ALLOCATION + 1) == SpriteArena::MAX_SLAB_ALLOCATION + 16 + SpriteArena::HEAP_OVERHEAD);
+
+	for (size_t size = 1; size <= SpriteArena::MAX_SLAB_ALLOCATION; size++) {
+		size_t allocation = arena.GetAllocationSize(size);
+		CHECK(allocation >= size);
+		CHECK(allocation % SpriteArena::ALIGNMENT == 0);
+		/* Rounding wastes at most a quarter of the allocation */
+		CHECK((allocation - size) * 4 <= std::max<size_t>(allocation, 64));
+	}
+}
+
+TEST_CASE("SpriteArena - Accounting")
+{
+	SpriteArena arena;
+
+	std::mt19937 rng(42);
+	std::uniform_int_distribution<size_t> small(1, 2000);
+	std::uniform_int_distribution<size_t> large(SpriteArena::MAX_SLAB_ALLOCATION + 1, 100000);
+
+	std::vector<std::pair<uint8_t *, size_t>> allocations;
+	size_t requested = 0;
+	for (int i = 0; i < 2000; i++) {
+		size_t size = (i % 10 == 0) ? large(rng) : small(rng);
+		uint8_t *ptr = static_cast<uint8_t *>(arena.Allocate(size));
+		CHECK(reinterpret_cast<uintptr_t>(ptr) % SpriteArena::ALIGNMENT == 0);
+		memset(ptr, i & 0xFF, size);
+		allocations.emplace_back(ptr, size);
+		requested += size;
+	}
+
+	SpriteArena::Stats stats = arena.GetStats();
+	CHECK(stats.live_allocations == allocations.size());
+	CHECK(stats.requested_bytes == requested);
+	CHECK(stats.committed_bytes >= requested);
+	CHECK(stats.committed_bytes == stats.slab_bytes + stats.slabs * SpriteArena::HEAP_OVERHEAD + stats.direct_bytes);
+
+	/* Allocations do not overlap */
+	for (size_t i = 0; i < allocations.size(); i++) {
+		const auto &[ptr, size] = allocations[i];
+		CHECK(ptr[0] == (i & 0xFF));
+		CHECK(ptr[size - 1] == (i & 0xFF));
+	}
+
+	std::shuffle(allocations.begin(), allocations.end(), rng);
+	for (const auto &[ptr, size] : allocations) {
+		arena.Free(ptr, size);
+	}
+
+	stats = arena.GetStats();
+	CHECK(stats.live_allocations == 0);
+	CHECK(stats.requested_bytes == 0);
+	CHECK(stats.direct_bytes == 0);
+	CHECK(stats.slab_used_bytes == 0);
+
+	/* Only the empty slabs kept for reuse remain, until trimmed */
+	arena.Trim();
+	stats = arena.GetStats();
+	CHECK(stats.slabs == 0);
+	CHECK(stats.committed_bytes == 0);
+}
+
+TEST_CASE("SpriteArena - Eviction from a fragmented arena")
+{
+	/* Use a separate LRU list, so that only the sprites of this test are evicted */
+	const SpriteLRUList saved_lru = std::exchange(_sprite_lru, {});
+	_sprite_arena.Trim();
+
+	/* Fill four slabs with sprites of one size class, after any other sprite cache entries */
+	constexpr uint32_t SPRITE_SIZE = 1024;
+	REQUIRE(_sprite_arena.GetAllocationSize(SPRITE_SIZE) == SPRITE_SIZE);
+	constexpr uint COUNT = 4 * 63;
+	const uint first = GetMaxSpriteID();
+	AllocateSpriteCache(first + COUNT - 1);
+	for (uint i = 0; i < COUNT; i++) {
+		SpriteDataBuffer buffer;
+		buffer.Allocate(SPRITE_SIZE);
+		memset(buffer.GetPtr(), 0, SPRITE_SIZE);
+		SpriteCache *sc = AllocateSpriteCache(first + i);
+		sc->SetType(SpriteType::Normal);
+		sc->Assign(std::move(buffer));
+	}
+
+	/* Every other sprite is the least recently used, so evicting them leaves every slab partially used */
+	for (uint i = 0; i < COUNT; i += 2) {
+		_sprite_lru.Touch(static_cast<Sprite *>(AllocateSpriteCache(first + i)->GetPtr()));
+	}
+
+	auto count_cached = [&]() {
+		uint cached = 0;
+		for (uint i = 0; i < COUNT; i++) {
+			if (AllocateSpriteCache(first + i)->GetPtr() != nullptr) cached++;
+		}
+		return cached;
+	};
+
+	const SpriteArena::Stats before = _sprite_arena.GetStats();
+	CHECK(GetSpriteCacheUsage() == before.live_bytes);
+
+	/* Evicting 20 sprites is not quite enough */
+	const size_t target = before.live_bytes - 20 * SPRITE_SIZE - SPRITE_SIZE / 2;
+	DeleteEntriesFromSpriteCache(target);
+
+	/* Eviction stops as soon as the live memory fits, even though no slab became empty */
+	const SpriteArena::Stats after = _sprite_arena.GetStats();
+	CHECK(count_cached() == COUNT - 21);
+	CHECK(after.live_bytes == before.live_bytes - 21 * SPRITE_SIZE);
+	CHECK(after.live_bytes <= target);
+	CHECK(after.committed_bytes == before.committed_bytes);
+	for (uint i = 0; i < 21; i++) {
+		CHECK(AllocateSpriteCache(first + 2 * i + 1)->GetPtr() == nullptr);
+	}
+
+	/* The free slots are not counted, so the sprite cache is now within its budget */
+	DeleteEntriesFromSpriteCache(target);
+	CHECK(count_cached() == COUNT - 21);
+
+	/* New sprites reuse the free slots */
+	SpriteDataBuffer buffer;
+	buffer.Allocate(SPRITE_SIZE);
+	CHECK(_sprite_arena.GetStats().committed_bytes == before.committed_bytes);
+	buffer.Clear();
+
+	for (uint i = 0; i < COUNT; i++) {
+		AllocateSpriteCache(first + i)->Clear();
+	}
+	_sprite_arena.Trim();
+	_sprite_lru = saved_lru;
+}
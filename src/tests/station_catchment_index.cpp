@@ -0,0 +1,136 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file station_catchment_index.cpp Test functionality from station_catchment_index.h */
+
+#include "../stdafx.h"
+
+#include "../3rdparty/catch2/catch.hpp"
+
+#include "../core/geometry_type.hpp"
+#include "../bitmap_type.h"
+#include "../station_catchment_index.h"
+#include "mock_map.h"
+
+#include <map>
+#include <random>
+
+static BitmapTileArea MakeTestCatchment(std::mt19937 &rng)
+{
+	std::uniform_int_distribution<uint> pos_x(0, MapMaxX());
+	std::uniform_int_distribution<uint> pos_y(0, MapMaxY());
+	std::uniform_int_distribution<uint> size(1, 24);
+
+	const uint x = pos_x(rng);
+	const uint y = pos_y(rng);
+	Rect r{ (int)x, (int)y, (int)std::min(x + size(rng), MapMaxX()), (int)std::min(y + size(rng), MapMaxY()) };
+
+	BitmapTileArea catchment;
+	catchment.Initialize(r);
+	for (TileIndex tile : TileArea(catchment)) {
+		if (rng() % 3 != 0) catchment.SetTile(tile);
+	}
+	return catchment;
+}
+
+TEST_CASE("StationCatchmentIndex - Tiles")
+{
+	MockMapSize map_size(7, 6);
+
+	StationCatchmentIndex index;
+	index.Reset(MapLogX(), MapLogY());
+
+	BitmapTileArea catchment;
+	catchment.Initialize(Rect{ 14, 14, 17, 17 });
+	catchment.SetTile(TileXY(15, 15));
+	catchment.SetTile(TileXY(16, 16));
+	index.Add(3, catchment);
+
+	auto find = [&](uint x, uint y) {
+		std::vector<StationID> found;
+		index.ForEachStationOnTile(TileXY(x, y), [&](StationID id) { found.push_back(id); });
+		return found;
+	};
+
+	CHECK(find(15, 15) == std::vector<StationID>{ 3 });
+	CHECK(find(16, 16) == std::vector<StationID>{ 3 });
+	CHECK(find(15, 16).empty());
+	CHECK(find(14, 14).empty());
+	CHECK(find(0, 0).empty());
+
+	BitmapTileArea other;
+	other.Initialize(Rect{ 16, 16, 16, 16 });
+	other.SetTile(TileXY(16, 16));
+	index.Add(1, other);
+	CHECK(find(16, 16) == std::vector<StationID>{ 1, 3 });
+
+	std::vector<StationID> stations;
+	index.FindStations(TileArea(TileXY(10, 10), 6, 6), stations);
+	CHECK(stations == std::vector<StationID>{ 3 });
+	index.FindStations(TileArea(TileXY(15, 16), 2, 2), stations);
+	CHECK(stations == std::vector<StationID>{ 1, 3 });
+	index.FindStations(TileArea(TileXY(14, 16), 1, 2), stations);
+	CHECK(stations.empty());
+
+	index.Remove(3, catchment);
+	CHECK(find(15, 15).empty());
+	CHECK(find(16, 16) == std::vector<StationID>{ 1 });
+}
+
+TEST_CASE("StationCatchmentIndex - Random")
+{
+	MockMapSize map_size(7, 6);
+
+	StationCatchmentIndex index;
+	index.Reset(MapLogX(), MapLogY());
+
+	std::mt19937 rng(42);
+	std::map<StationID, BitmapTileArea> catchments;
+
+	for (uint i = 0; i < 2000; i++) {
+		const StationID id = rng() % 64;
+		auto it = catchments.find(id);
+		if (it != catchments.end()) {
+			index.Remove(id, it->second);
+			catchments.erase(it);
+		}
+		if (rng() % 4 != 0) {
+			BitmapTileArea catchment = MakeTestCatchment(rng);
+			index.Add(id, catchment);
+			catchments[id] = std::move(catchment);
+		}
+	}
+
+	for (uint y = 0; y < MapSizeY(); y++) {
+		for (uint x = 0; x < MapSizeX(); x++) {
+			const TileIndex tile = TileXY(x, y);
+			std::vector<StationID> expected;
+			for (const auto &[id, catchment] : catchments) {
+				if (catchment.HasTile(tile)) expected.push_back(id);
+			}
+			std::vector<StationID> found;
+			index.ForEachStationOnTile(tile, [&](StationID id) { found.push_back(id); });
+			CHECK(found == expected);
+		}
+	}
+
+	for (uint i = 0; i < 500; i++) {
+		BitmapTileArea area = MakeTestCatchment(rng);
+		std::vector<StationID> expected;
+		for (const auto &[id, catchment] : catchments) {
+			for (TileIndex tile : TileArea(area)) {
+				if (catchment.HasTile(tile)) {
+					expected.push_back(id);
+					break;
+				}
+			}
+		}
+		std::vector<StationID> found;
+		index.FindStations(area, found);
+		CHECK(found == expected);
+	}
+}
@@ -0,0 +1,301 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file tracerestrict.cpp Test functionality from tracerestrict.h */
+
+#include "../stdafx.h"
+
+#include "../3rdparty/catch2/catch.hpp"
+
+#include "../tracerestrict.h"
+#include "../track_func.h"
+
+#include <random>
+
+/*
+ * The programs in these tests only use entry direction conditions and pathfinder penalty actions,
+ * which depend only on the program input, so no train is required to execute them.
+ * Each penalty action of a program adds a different power of two, so the result penalty identifies the set of actions which were executed.
+ */
+
+/** Trackdirs entering a signal tile from each of the four tile edges, in DiagDirection order */
+static const Trackdir _entry_trackdirs[] = { TRACKDIR_X_SW, TRACKDIR_Y_NW, TRACKDIR_X_NE, TRACKDIR_Y_SE };
+
+static TraceRestrictItem MakeCondition(TraceRestrictCondFlags flags, DiagDirection dir, bool negate = false)
+{
+	TraceRestrictItem item = 0;
+	SetTraceRestrictType(item, TRIT_COND_ENTRY_DIRECTION);
+	SetTraceRestrictCondFlags(item, flags);
+	SetTraceRestrictCondOp(item, negate ? TRCO_ISNOT : TRCO_IS);
+	SetTraceRestrictValue(item, dir);
+	return item;
+}
+
+static TraceRestrictItem MakeEndif(bool is_else)
+{
+	TraceRestrictItem item = 0;
+	SetTraceRestrictType(item, TRIT_COND_ENDIF);
+	SetTraceRestrictCondFlags(item, is_else ? TRCF_ELSE : TRCF_DEFAULT);
+	return item;
+}
+
+static TraceRestrictItem MakePenalty(uint bit)
+{
+	TraceRestrictItem item = 0;
+	SetTraceRestrictType(item, TRIT_PF_PENALTY);
+	SetTraceRestrictAuxField(item, TRPPAF_VALUE);
+	SetTraceRestrictValue(item, 1 << bit);
+	return item;
+}
+
+static uint32_t ExecuteCompiled(const std::vector<TraceRestrictItem> &items, DiagDirection entry)
+{
+	TraceRestrictProgram prog;
+	prog.items = items;
+	REQUIRE(prog.Validate().Succeeded());
+
+	TraceRestrictProgramInput input(INVALID_TILE, _entry_trackdirs[entry], nullptr, nullptr);
+	TraceRestrictProgramResult out;
+	prog.Execute(nullptr, input, out);
+	return out.penalty;
+}
+
+/**
+ * Reference implementation of program execution, using a condition stack.
+ * This is how execution worked before programs were compiled, and evaluates every condition.
+ */
+static uint32_t ExecuteReference(const std::vector<TraceRestrictItem> &items, DiagDirection entry)
+{
+	enum StackFlags : uint8_t {
+		DONE_IF         = 1 << 0,
+		ACTIVE          = 1 << 1,
+		PARENT_INACTIVE = 1 << 2,
+	};
+	std::vector<uint8_t> condstack;
+
+	auto handle_condition = [&](TraceRestrictCondFlags condflags, bool value) {
+		if ((condflags & TRCF_OR) && (condstack.back() & ACTIVE)) return;
+
+		if (condflags & (TRCF_OR | TRCF_ELSE)) {
+			if (condstack.back() & (DONE_IF | PARENT_INACTIVE)) {
+				condstack.back() &= ~ACTIVE;
+				return;
+			}
+		} else {
+			if (!condstack.empty() && !(condstack.back() & ACTIVE)) {
+				condstack.push_back(PARENT_INACTIVE);
+				return;
+			}
+			condstack.push_back(0);
+		}
+
+		if (value) {
+			condstack.back() |= DONE_IF | ACTIVE;
+		} else {
+			condstack.back() &= ~ACTIVE;
+		}
+	};
+
+	uint32_t penalty = 0;
+	for (TraceRestrictItem item : items) {
+		if (IsTraceRestrictConditional(item)) {
+			const TraceRestrictCondFlags condflags = GetTraceRestrictCondFlags(item);
+			if (GetTraceRestrictType(item) == TRIT_COND_ENDIF) {
+				if (condflags & TRCF_ELSE) {
+					handle_condition(condflags, true);
+				} else {
+					condstack.pop_back();
+				}
+			} else {
+				const bool match = (GetTraceRestrictValue(item) == entry);
+				handle_condition(condflags, (GetTraceRestrictCondOp(item) == TRCO_IS) == match);
+			}
+		} else if (condstack.empty() || (condstack.back() & ACTIVE)) {
+			penalty += GetTraceRestrictValue(item);
+		}
+	}
+	return penalty;
+}
+
+static void CheckProgram(const std::vector<TraceRestrictItem> &items)
+{
+	for (DiagDirection dir = DIAGDIR_BEGIN; dir < DIAGDIR_END; dir++) {
+		CHECK(ExecuteCompiled(items, dir) == ExecuteReference(items, dir));
+	}
+}
+
+/** Generate a random valid program with up to 16 actions */
+class RandomProgramGenerator {
+	std::mt19937 &rng;
+	std::vector<TraceRestrictItem> items;
+	uint actions = 0;
+
+	bool Chance(uint n) { return this->rng() % n == 0; }
+
+	DiagDirection RandomDir() { return static_cast<DiagDirection>(this->rng() % DIAGDIR_END); }
+
+	void Body(uint depth)
+	{
+		while (!this->Chance(3)) {
+			if (depth < 4 && this->Chance(3)) {
+				this->Block(depth + 1);
+			} else if (this->actions < 16) {
+				this->items.push_back(MakePenalty(this->actions++));
+			}
+		}
+	}
+
+	void Block(uint depth)
+	{
+		this->items.push_back(MakeCondition(TRCF_DEFAULT, this->RandomDir(), this->Chance(2)));
+		this->Body(depth);
+		while (this->Chance(2)) {
+			this->items.push_back(MakeCondition(this->Chance(2) ? TRCF_OR : TRCF_ELSE, this->RandomDir(), this->Chance(2)));
+			this->Body(depth);
+		}
+		if (this->Chance(2)) {
+			this->items.push_back(MakeEndif(true));
+			this->Body(depth);
+		}
+		this->items.push_back(MakeEndif(false));
+	}
+
+public:
+	RandomProgramGenerator(std::mt19937 &rng) : rng(rng) {}
+
+	std::vector<TraceRestrictItem> Generate()
+	{
+		this->items.clear();
+		this->actions = 0;
+		this->Body(0);
+		return std::move(this->items);
+	}
+};
+
+TEST_CASE("TraceRestrictProgram - Conditional blocks")
+{
+	const auto NE = DIAGDIR_NE;
+	const auto SE = DIAGDIR_SE;
+	const auto SW = DIAGDIR_SW;
+
+	/* if/elif/else/endif */
+	const std::vector<TraceRestrictItem> if_elif_else = {
+		MakeCondition(TRCF_DEFAULT, NE), MakePenalty(0),
+		MakeCondition(TRCF_ELSE, SE), MakePenalty(1),
+		MakeEndif(true), MakePenalty(2),
+		MakeEndif(false), MakePenalty(3),
+	};
+	CHECK(ExecuteCompiled(if_elif_else, NE) == 0b1001);
+	CHECK(ExecuteCompiled(if_elif_else, SE) == 0b1010);
+	CHECK(ExecuteCompiled(if_elif_else, SW) == 0b1100);
+	CheckProgram(if_elif_else);
+
+	/* Or-if chain, with an action between the if and the or-if */
+	const std::vector<TraceRestrictItem> or_chain = {
+		MakeCondition(TRCF_DEFAULT, NE), MakePenalty(0),
+		MakeCondition(TRCF_OR, SE), MakePenalty(1),
+		MakeCondition(TRCF_OR, SW, true), MakePenalty(2),
+		MakeEndif(false),
+	};
+	CHECK(ExecuteCompiled(or_chain, NE) == 0b111);
+	CHECK(ExecuteCompiled(or_chain, SE) == 0b110);
+	CHECK(ExecuteCompiled(or_chain, SW) == 0);
+	CHECK(ExecuteCompiled(or_chain, DIAGDIR_NW) == 0b100);
+	CheckProgram(or_chain);
+
+	/* And chain, as nested ifs */
+	const std::vector<TraceRestrictItem> and_chain = {
+		MakeCondition(TRCF_DEFAULT, SW, true),
+		MakeCondition(TRCF_DEFAULT, NE, true), MakePenalty(0),
+		MakeCondition(TRCF_DEFAULT, SE, true), MakePenalty(1), MakeEndif(false),
+		MakeEndif(false),
+		MakeEndif(false),
+	};
+	CHECK(ExecuteCompiled(and_chain, NE) == 0);
+	CHECK(ExecuteCompiled(and_chain, SE) == 0b01);
+	CHECK(ExecuteCompiled(and_chain, SW) == 0);
+	CHECK(ExecuteCompiled(and_chain, DIAGDIR_NW) == 0b11);
+	CheckProgram(and_chain);
+
+	/* Nested block in an inactive branch, whose or-if and else must not become active */
+	const std::vector<TraceRestrictItem> nested = {
+		MakeCondition(TRCF_DEFAULT, NE),
+		MakeCondition(TRCF_DEFAULT, SE), MakePenalty(0),
+		MakeCondition(TRCF_OR, SW), MakePenalty(1),
+		MakeEndif(true), MakePenalty(2),
+		MakeEndif(false),
+		MakeCondition(TRCF_ELSE, SE), MakePenalty(3),
+		MakeEndif(false), MakePenalty(4),
+	};
+	CHECK(ExecuteCompiled(nested, NE) == 0b10100);
+	CHECK(ExecuteCompiled(nested, SE) == 0b11000);
+	CHECK(ExecuteCompiled(nested, SW) == 0b10000);
+	CheckProgram(nested);
+
+	/* Else-if after a taken branch, and an or-if after a not taken else-if */
+	const std::vector<TraceRestrictItem> elif_or = {
+		MakeCondition(TRCF_DEFAULT, NE, true), MakePenalty(0),
+		MakeCondition(TRCF_ELSE, NE), MakePenalty(1),
+		MakeCondition(TRCF_OR, SE), MakePenalty(2),
+		MakeEndif(false),
+	};
+	CHECK(ExecuteCompiled(elif_or, NE) == 0b110);
+	CHECK(ExecuteCompiled(elif_or, SE) == 0b001);
+	CheckProgram(elif_or);
+}
+
+TEST_CASE("TraceRestrictProgram - Compiled execution matches reference")
+{
+	std::mt19937 rng(4);
+	RandomProgramGenerator generator(rng);
+	for (uint i = 0; i < 2000; i++) {
+		CheckProgram(generator.Generate());
+	}
+}
+
+TEST_CASE("TraceRestrictProgram - Malformed programs")
+{
+	TraceRestrictProgramActionsUsedFlags actions_used_flags;
+	auto is_valid = [&](const std::vector<TraceRestrictItem> &items) -> bool {
+		return TraceRestrictProgram::Validate(items, actions_used_flags).Succeeded();
+	};
+
+	CHECK(is_valid({}));
+	CHECK(is_valid({ MakePenalty(0) }));
+	CHECK(is_valid({ MakeCondition(TRCF_DEFAULT, DIAGDIR_NE), MakeEndif(false) }));
+
+	/* Missing endif */
+	CHECK_FALSE(is_valid({ MakeCondition(TRCF_DEFAULT, DIAGDIR_NE), MakePenalty(0) }));
+	CHECK_FALSE(is_valid({ MakeCondition(TRCF_DEFAULT, DIAGDIR_NE), MakeCondition(TRCF_DEFAULT, DIAGDIR_SE), MakeEndif(false) }));
+	CHECK_FALSE(is_valid({ MakeCondition(TRCF_DEFAULT, DIAGDIR_NE), MakeEndif(true) }));
+
+	/* Endif/else/elif/orif without an if */
+	CHECK_FALSE(is_valid({ MakeEndif(false) }));
+	CHECK_FALSE(is_valid({ MakeEndif(true), MakeEndif(false) }));
+	CHECK_FALSE(is_valid({ MakeCondition(TRCF_ELSE, DIAGDIR_NE), MakeEndif(false) }));
+	CHECK_FALSE(is_valid({ MakeCondition(TRCF_OR, DIAGDIR_NE), MakeEndif(false) }));
+	CHECK_FALSE(is_valid({ MakeCondition(TRCF_DEFAULT, DIAGDIR_NE), MakeEndif(false), MakeEndif(false) }));
+
+	/* Duplicate else, and elif/orif after else */
+	CHECK_FALSE(is_valid({ MakeCondition(TRCF_DEFAULT, DIAGDIR_NE), MakeEndif(true), MakeEndif(true), MakeEndif(false) }));
+	CHECK_FALSE(is_valid({ MakeCondition(TRCF_DEFAULT, DIAGDIR_NE), MakeEndif(true), MakeCondition(TRCF_ELSE, DIAGDIR_SE), MakeEndif(false) }));
+	CHECK_FALSE(is_valid({ MakeCondition(TRCF_DEFAULT, DIAGDIR_NE), MakeEndif(true), MakeCondition(TRCF_OR, DIAGDIR_SE), MakeEndif(false) }));
+
+	/* Invalid condition operator */
+	TraceRestrictItem bad_op = MakeCondition(TRCF_DEFAULT, DIAGDIR_NE);
+	SetTraceRestrictCondOp(bad_op, TRCO_LT);
+	CHECK_FALSE(is_valid({ bad_op, MakeEndif(false) }));
+
+	/* A program which fails validation is not compiled, and so executes no actions */
+	TraceRestrictProgram prog;
+	prog.items = { MakePenalty(0), MakeCondition(TRCF_DEFAULT, DIAGDIR_NE) };
+	CHECK(prog.Validate().Failed());
+	TraceRestrictProgramInput input(INVALID_TILE, TRACKDIR_X_SW, nullptr, nullptr);
+	TraceRestrictProgramResult out;
+	prog.Execute(nullptr, input, out);
+	CHECK(out.penalty == 0);
+}
@@ -0,0 +1,90 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file vehicle_tile_grid.cpp Test functionality from vehicle_tile_grid.h */
+
+#include "../stdafx.h"
+
+#include "../3rdparty/catch2/catch.hpp"
+
+#include "../vehicle_tile_grid.h"
+
+#include <map>
+#include <random>
+
+TEST_CASE("VehicleTileGrid - Empty")
+{
+	VehicleTileGrid grid;
+	grid.Reset(7, 6);
+
+	CHECK(grid.Find(0, 0) == INVALID_VEHICLE);
+	CHECK(grid.Find(127, 63) == INVALID_VEHICLE);
+	CHECK(grid.Find(128, 0) == INVALID_VEHICLE);
+	CHECK(grid.Find(0, 64) == INVALID_VEHICLE);
+
+	/* Out of range changes are ignored */
+	grid.Set(128, 0, 1);
+	grid.Erase(0, 64);
+	CHECK(grid.Find(128, 0) == INVALID_VEHICLE);
+}
+
+TEST_CASE("VehicleTileGrid - Set, overwrite and erase")
+{
+	VehicleTileGrid grid;
+	grid.Reset(7, 7);
+
+	grid.Set(5, 3, 10);
+	grid.Set(4, 3, 11);
+	grid.Set(0, 4, 12);
+	grid.Set(70, 3, 13);
+	CHECK(grid.Find(5, 3) == 10);
+	CHECK(grid.Find(4, 3) == 11);
+	CHECK(grid.Find(0, 4) == 12);
+	CHECK(grid.Find(70, 3) == 13);
+	CHECK(grid.Find(6, 3) == INVALID_VEHICLE);
+
+	grid.Set(5, 3, 20);
+	CHECK(grid.Find(5, 3) == 20);
+	CHECK(grid.Find(4, 3) == 11);
+	CHECK(grid.Find(0, 4) == 12);
+
+	grid.Erase(4, 3);
+	CHECK(grid.Find(4, 3) == INVALID_VEHICLE);
+	CHECK(grid.Find(5, 3) == 20);
+	CHECK(grid.Find(0, 4) == 12);
+
+	grid.Reset(7, 7);
+	CHECK(grid.Find(5, 3) == INVALID_VEHICLE);
+}
+
+TEST_CASE("VehicleTileGrid - Random operations")
+{
+	VehicleTileGrid grid;
+	grid.Reset(8, 7);
+	std::map<std::pair<uint, uint>, VehicleID> reference;
+
+	std::mt19937 rng(1234);
+	for (uint i = 0; i < 20000; i++) {
+		uint x = rng() % 256;
+		uint y = rng() % 128;
+		if (rng() % 3 == 0) {
+			grid.Erase(x, y);
+			reference.erase({ x, y });
+		} else {
+			VehicleID id = rng() % 1000;
+			grid.Set(x, y, id);
+			reference[{ x, y }] = id;
+		}
+	}
+
+	for (uint y = 0; y < 128; y++) {
+		for (uint x = 0; x < 256; x++) {
+			auto iter = reference.find({ x, y });
+			CHECK(grid.Find(x, y) == (iter != reference.end() ? iter->second : INVALID_VEHICLE));
+		}
+	}
+}
@@ -0,0 +1,144 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file worker_thread.cpp Test functionality from worker_thread.h */
+
+#include "../stdafx.h"
+
+#include "../3rdparty/catch2/catch.hpp"
+
+#include "../worker_thread.h"
+
+#include <chrono>
+#include <numeric>
+#include <thread>
+
+static void TestParallelFor(WorkerThreadPool &pool)
+{
+	std::vector<uint> values(10000, 0);
+	ParallelFor(0, values.size(), 64, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) values[i] += (uint)i;
+	}, pool);
+	for (size_t i = 0; i < values.size(); i++) {
+		CHECK(values[i] == i);
+	}
+
+	uint calls = 0;
+	ParallelFor(5, 5, 64, [&](size_t, size_t) { calls++; }, pool);
+	CHECK(calls == 0);
+}
+
+static void TestNestedGroups(WorkerThreadPool &pool)
+{
+	std::atomic<uint> total = 0;
+	WorkerTaskGroup outer(pool);
+	for (uint i = 0; i < 16; i++) {
+		outer.Run([&pool, &total]() {
+			WorkerTaskGroup inner(pool);
+			for (uint j = 0; j < 16; j++) {
+				inner.Run([&total, j]() { total += j; });
+			}
+			inner.Wait();
+		});
+	}
+	outer.Wait();
+	CHECK(outer.IsDone());
+	CHECK(total == 16 * (15 * 16 / 2));
+}
+
+static void TestWaitForOutstanding(WorkerThreadPool &pool)
+{
+	std::atomic<uint> done = 0;
+	WorkerTaskGroup group(pool);
+	for (uint i = 0; i < 100; i++) {
+		group.WaitForOutstanding(3);
+		group.Run([&done]() { done++; });
+	}
+	group.Wait();
+	CHECK(done == 100);
+}
+
+static void TestLongRunning(WorkerThreadPool &pool)
+{
+	/* Long running jobs are run by the workers, or in the enqueuing thread if the pool can't run them */
+	std::atomic<uint> done = 0;
+	WorkerTaskGroup group(pool);
+	for (uint i = 0; i < 8; i++) {
+		group.Run([&done]() { done++; }, WJF_LONG_RUNNING);
+	}
+	group.Wait();
+	CHECK(done == 8);
+}
+
+TEST_CASE("WorkerThreadPool - no workers")
+{
+	WorkerThreadPool pool;
+	TestParallelFor(pool);
+	TestNestedGroups(pool);
+	TestWaitForOutstanding(pool);
+	TestLongRunning(pool);
+}
+
+TEST_CASE("WorkerThreadPool - workers")
+{
+	WorkerThreadPool pool;
+	pool.Start("ottd:test", 4);
+	TestParallelFor(pool);
+	TestNestedGroups(pool);
+	TestWaitForOutstanding(pool);
+	TestLongRunning(pool);
+	pool.Stop();
+}
+
+static void SetFlagJob(void *data1, void *, void *)
+{
+	static_cast<std::atomic<bool> *>(data1)->store(true);
+}
+
+TEST_CASE("WorkerThreadPool - long running jobs leave a worker free")
+{
+	WorkerThreadPool pool;
+	pool.Start("ottd:test", 2);
+	if (pool.GetWorkerCount() < 2) return;
+	CHECK(pool.CanRunLongRunningJobs());
+
+	std::atomic<bool> release = false;
+	WorkerTaskGroup group(pool);
+	for (uint i = 0; i < 2; i++) {
+		group.Run([&release]() {
+			while (!release.load()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}, WJF_LONG_RUNNING);
+	}
+
+	/* A job enqueued directly must still be run whilst the long running jobs are blocked */
+	std::atomic<bool> done = false;
+	pool.EnqueueJob(&SetFlagJob, &done);
+	for (uint i = 0; i < 10000 && !done.load(); i++) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	CHECK(done.load());
+
+	release = true;
+	group.Wait();
+	pool.Stop();
+}
+
+TEST_CASE("WorkerThreadPool - single worker")
+{
+	WorkerThreadPool pool;
+	pool.Start("ottd:test", 1);
+	if (pool.GetWorkerCount() != 1) return;
+	CHECK_FALSE(pool.CanRunLongRunningJobs());
+
+	/* Long running jobs can't take the only worker, they are run in the enqueuing thread */
+	std::thread::id ran_on;
+	WorkerTaskGroup group(pool);
+	group.Run([&ran_on]() { ran_on = std::this_thread::get_id(); }, WJF_LONG_RUNNING);
+	CHECK(ran_on == std::this_thread::get_id());
+	group.Wait();
+	pool.Stop();
+}
@@ -0,0 +1,178 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file yapf_costcache.cpp Test the region invalidation of the YAPF segment cost caches. */
+
+#include "../stdafx.h"
+
+#include "../3rdparty/catch2/catch.hpp"
+
+#include "../pathfinder/yapf/yapf.hpp"
+#include "../pathfinder/yapf/yapf_node_road.hpp"
+#include "../pathfinder/yapf/yapf_cache.h"
+#include "../map_func.h"
+#include "../rail_map.h"
+#include "mock_map.h"
+
+typedef CSegmentCostCacheT<CYapfRoadSegment> TestRoadSegmentCostCache;
+
+/**
+ * Add a cached road segment to the cache, as the road pathfinder does.
+ * @param cache Cache.
+ * @param from First tile of the segment.
+ * @param to Last tile of the segment, this is in a straight line from the first tile.
+ * @return Key of the segment.
+ */
+static CYapfRoadSegmentKey AddSegment(TestRoadSegmentCostCache &cache, TileIndex from, TileIndex to)
+{
+	CYapfRoadSegmentKey key(from, TRACKDIR_X_NE, RTT_ROAD, ROADTYPES_ROAD);
+	bool found;
+	CYapfRoadSegment &segment = cache.Get(key, &found);
+	REQUIRE_FALSE(found);
+	segment.m_cost = 100;
+	segment.m_last_tile = to;
+
+	std::vector<uint32_t> regions;
+	CSegmentCostCacheBase::AddRegions(regions, from, to);
+	cache.SetRegions(segment, regions);
+	return key;
+}
+
+static bool IsCached(TestRoadSegmentCostCache &cache, const CYapfRoadSegmentKey &key)
+{
+	return cache.m_map.Find(key) != nullptr;
+}
+
+TEST_CASE("SegmentCostCache - Regions")
+{
+	MockMapSize map_size(8, 7);
+
+	std::vector<uint32_t> regions;
+	CSegmentCostCacheBase::AddRegions(regions, TileXY(5, 5), TileXY(20, 5));
+	CHECK(regions == std::vector<uint32_t>{ CSegmentCostCacheBase::GetRegion(TileXY(0, 0)), CSegmentCostCacheBase::GetRegion(TileXY(16, 0)) });
+
+	/* Regions which are already present are not added again */
+	CSegmentCostCacheBase::AddRegions(regions, TileXY(18, 30), TileXY(18, 2));
+	CHECK(regions.size() == 3);
+	CHECK(regions[2] == CSegmentCostCacheBase::GetRegion(TileXY(16, 16)));
+
+	/* Each region is a distinct 16x16 tile square */
+	CHECK(CSegmentCostCacheBase::GetRegion(TileXY(15, 15)) == CSegmentCostCacheBase::GetRegion(TileXY(0, 0)));
+	CHECK(CSegmentCostCacheBase::GetRegion(TileXY(255, 0)) != CSegmentCostCacheBase::GetRegion(TileXY(0, 16)));
+	CHECK(CSegmentCostCacheBase::GetRegion(TileXY(255, 127)) == (256 / 16) * (128 / 16) - 1);
+}
+
+TEST_CASE("SegmentCostCache - Region invalidation")
+{
+	MockMapSize map_size(8, 7);
+
+	TestRoadSegmentCostCache cache;
+	cache.FlushIfChanged();
+
+	const CYapfRoadSegmentKey a = AddSegment(cache, TileXY(2, 3), TileXY(14, 3));   // region (0, 0)
+	const CYapfRoadSegmentKey b = AddSegment(cache, TileXY(20, 3), TileXY(40, 3));  // regions (1, 0) and (2, 0)
+	const CYapfRoadSegmentKey c = AddSegment(cache, TileXY(100, 100), TileXY(100, 90)); // regions (6, 5) and (6, 6)
+	CHECK(cache.GetCachedSegments() == 3);
+
+	/* A change far from all segments doesn't invalidate any */
+	YapfNotifyRoadLayoutChange(TileXY(200, 50));
+	CHECK(IsCached(cache, a));
+	CHECK(IsCached(cache, b));
+	CHECK(IsCached(cache, c));
+
+	/* A change within a segment's region, e.g. road built or removed */
+	YapfNotifyRoadLayoutChange(TileXY(36, 10));
+	CHECK(IsCached(cache, a));
+	CHECK_FALSE(IsCached(cache, b));
+	CHECK(IsCached(cache, c));
+
+	/* A change next to a region also invalidates the segments of that region, as the tile after a segment's end is examined too */
+	YapfNotifyRoadLayoutChange(TileXY(16, 8));
+	CHECK_FALSE(IsCached(cache, a));
+	CHECK(IsCached(cache, c));
+
+	/* A terraform notifies via the track layout change, which also applies to road segments */
+	CSegmentCostCacheBase::NotifyTrackLayoutChange(TileXY(99, 80), INVALID_TRACK);
+	CHECK_FALSE(IsCached(cache, c));
+	CHECK(cache.GetCachedSegments() == 0);
+}
+
+TEST_CASE("SegmentCostCache - Replaced segment")
+{
+	MockMapSize map_size(8, 7);
+
+	TestRoadSegmentCostCache cache;
+	cache.FlushIfChanged();
+
+	/* A segment in regions (0, 0) and (1, 0), invalidated via region (0, 0) */
+	CYapfRoadSegmentKey key = AddSegment(cache, TileXY(8, 8), TileXY(24, 8));
+	YapfNotifyRoadLayoutChange(TileXY(4, 4));
+	CHECK_FALSE(IsCached(cache, key));
+
+	/* Recalculated with the same key, but only in region (0, 0), so the stale entry of region (1, 0) must not remove it */
+	bool found;
+	CYapfRoadSegment &segment = cache.Get(key, &found);
+	CHECK_FALSE(found);
+	segment.m_cost = 50;
+	std::vector<uint32_t> regions;
+	CSegmentCostCacheBase::AddRegions(regions, TileXY(8, 8), TileXY(12, 8));
+	cache.SetRegions(segment, regions);
+
+	YapfNotifyRoadLayoutChange(TileXY(28, 4));
+	CHECK(IsCached(cache, key));
+
+	YapfNotifyRoadLayoutChange(TileXY(10, 10));
+	CHECK_FALSE(IsCached(cache, key));
+}
+
+TEST_CASE("SegmentCostCache - Flush")
+{
+	MockMapSize map_size(8, 7);
+
+	TestRoadSegmentCostCache cache;
+	cache.FlushIfChanged();
+
+	const CYapfRoadSegmentKey key = AddSegment(cache, TileXY(8, 8), TileXY(24, 8));
+
+	/* A change of the whole map flushes all caches when they are next used */
+	YapfNotifyRoadLayoutChange(INVALID_TILE);
+	CHECK(IsCached(cache, key));
+	cache.FlushIfChanged();
+	CHECK_FALSE(IsCached(cache, key));
+	CHECK(cache.GetCachedSegments() == 0);
+
+	/* A destroyed cache doesn't receive further notifications */
+	{
+		TestRoadSegmentCostCache temp_cache;
+		temp_cache.FlushIfChanged();
+		AddSegment(temp_cache, TileXY(40, 40), TileXY(40, 50));
+	}
+	YapfNotifyRoadLayoutChange(TileXY(40, 45));
+}
+
+TEST_CASE("SegmentCostCache - Platform across regions")
+{
+	/* Track layout changes also update the map dependent rail regions, so this needs a real map */
+	AllocateMap(256, 128);
+
+	TestRoadSegmentCostCache cache;
+	cache.FlushIfChanged();
+
+	/* Segments in regions (0, 0) and (1, 0), away from the tiles next to the platform */
+	const CYapfRoadSegmentKey a = AddSegment(cache, TileXY(2, 3), TileXY(6, 3));
+	const CYapfRoadSegmentKey b = AddSegment(cache, TileXY(26, 3), TileXY(30, 3));
+	const CYapfRoadSegmentKey c = AddSegment(cache, TileXY(40, 3), TileXY(44, 3));
+
+	/* A platform from region (0, 0) into region (1, 0) is notified tile by tile, as when building a rail station */
+	for (uint x = 10; x <= 20; x++) {
+		MakeRailNormal(TileXY(x, 5), OWNER_NONE, TRACK_BIT_X, RAILTYPE_RAIL);
+		YapfNotifyTrackLayoutChange(TileXY(x, 5), TRACK_X);
+	}
+	CHECK_FALSE(IsCached(cache, a));
+	CHECK_FALSE(IsCached(cache, b));
+	CHECK(IsCached(cache, c));
+}
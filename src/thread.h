@@ -31,6 +31,13 @@ inline void CSleep(int milliseconds)
  */
 void SetCurrentThreadName(const char *name);
 
+/**
+ * Restrict the thread this function is called on to run on the given CPU core.
+ * This does nothing on platforms which don't support it.
+ * @param cpu Index of the core, this wraps around if there are fewer cores.
+ */
+void SetCurrentThreadAffinity(uint cpu);
+
 /**
  * Get the name of the current thread, if any.
  * @param str The start of the buffer.
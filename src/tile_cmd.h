@@ -159,6 +159,16 @@ typedef Foundation GetFoundationProc(TileIndex tile, Slope tileh);
  */
 typedef CommandCost TerraformTileProc(TileIndex tile, DoCommandFlag flags, int z_new, Slope tileh_new);
 
+/**
+ * Tile callback function signature for checking whether calling the tile loop proc of a tile would currently have no effect,
+ * other than ambient sound effects, so that the call can be skipped.
+ * This is called on worker threads, so it must only read the map and pools.
+ * The result must only depend on the map data of the tile itself, and on state which is not changed by tile loop procs.
+ * @param tile The tile to check.
+ * @return Whether the tile loop proc would have no effect.
+ */
+typedef bool TileLoopQuiescentProc(TileIndex tile);
+
 /**
  * Set of callback functions for performing tile operations of a given tile type.
  * @see TileType
@@ -178,6 +188,7 @@ struct TileTypeProcs {
 	VehicleEnterTileProc *vehicle_enter_tile_proc; ///< Called when a vehicle enters a tile
 	GetFoundationProc *get_foundation_proc;
 	TerraformTileProc *terraform_tile_proc;        ///< Called when a terraforming operation is about to take place
+	TileLoopQuiescentProc *tile_loop_quiescent_proc; ///< Optional, checks whether calling tile_loop_proc would currently have no effect
 };
 
 extern const TileTypeProcs * const _tile_type_procs[16];
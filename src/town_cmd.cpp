@@ -55,6 +55,7 @@
 #include "zoom_func.h"
 #include "zoning.h"
 #include "scope.h"
+#include "framerate_type.h"
 #include "3rdparty/cpp-btree/btree_map.h"
 
 #include "table/strings.h"
@@ -1023,6 +1024,8 @@ void OnTick_Town()
 {
 	if (_game_mode == GM_EDITOR) return;
 
+	PerformanceZoneMeasurer framerate(PFZ_TOWNS);
+
 	for (Town *t : Town::Iterate()) {
 		TownTickHandler(t);
 	}
@@ -4577,6 +4580,7 @@ extern const TileTypeProcs _tile_type_town_procs = {
 	nullptr,                    // vehicle_enter_tile_proc
 	GetFoundation_Town,      // get_foundation_proc
 	TerraformTile_Town,      // terraform_tile_proc
+	nullptr,                 // tile_loop_quiescent_proc
 };
 
 
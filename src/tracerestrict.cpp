@@ -103,7 +103,7 @@ void ClearTraceRestrictMapping() {
 }
 
 /**
- * Flags used for the program execution condition stack
+ * Flags used for the program validation condition stack
  * Each 'if' pushes onto the stack
  * Each 'end if' pops from the stack
  * Elif/orif/else may modify the stack top
@@ -235,679 +235,770 @@ static bool TestStationCondition(StationID station, TraceRestrictItem item)
 
 }
 
+/** Temporary slot state, only for use with TRPISP_PBS_RES_END_ACQ_DRY and TRPAUF_PBS_RES_END_SIMULATE */
+static TraceRestrictSlotTemporaryState _pbs_res_end_acq_dry_slot_temporary_state;
+
 /**
- * Execute program on train and store results in out
- * @p v may not be nullptr
- * @p out should be zero-initialised
+ * State of a single program execution which is shared between conditions.
+ * This lives on the stack of TraceRestrictProgram::Execute, so that execution does not allocate and is re-entrant.
  */
-void TraceRestrictProgram::Execute(const Train* v, const TraceRestrictProgramInput &input, TraceRestrictProgramResult& out) const
-{
-	/* static to avoid needing to re-alloc/resize on each execution */
-	static std::vector<TraceRestrictCondStackFlags> condstack;
-	condstack.clear();
-
-	/* Only for use with TRPISP_PBS_RES_END_ACQ_DRY and TRPAUF_PBS_RES_END_SIMULATE */
-	static TraceRestrictSlotTemporaryState pbs_res_end_acq_dry_slot_temporary_state;
-
+struct TraceRestrictExecuteState {
 	uint8_t have_previous_signal = 0;
 	TileIndex previous_signal_tile[3];
+};
 
-	size_t size = this->items.size();
-	for (size_t i = 0; i < size; i++) {
-		TraceRestrictItem item = this->items[i];
-		TraceRestrictItemType type = GetTraceRestrictType(item);
+/**
+ * Evaluate a conditional instruction
+ * @p data points to the instruction, the second item of double item instructions follows it
+ * @return whether the condition is true
+ */
+static bool EvaluateTraceRestrictCondition(const Train *v, const TraceRestrictProgramInput &input, const TraceRestrictItem *data, TraceRestrictExecuteState &state)
+{
+	const TraceRestrictItem item = data[0];
+	const TraceRestrictItemType type = GetTraceRestrictType(item);
+	const TraceRestrictCondOp condop = GetTraceRestrictCondOp(item);
+	const uint16_t condvalue = GetTraceRestrictValue(item);
+	bool result = false;
+	switch (type) {
+		case TRIT_COND_UNDEFINED:
+			result = false;
+			break;
 
-		if (IsTraceRestrictConditional(item)) {
-			TraceRestrictCondFlags condflags = GetTraceRestrictCondFlags(item);
-			TraceRestrictCondOp condop = GetTraceRestrictCondOp(item);
+		case TRIT_COND_TRAIN_LENGTH:
+			result = TestCondition(CeilDiv(v->gcache.cached_total_length, TILE_SIZE), condop, condvalue);
+			break;
 
-			if (type == TRIT_COND_ENDIF) {
-				assert(!condstack.empty());
-				if (condflags & TRCF_ELSE) {
-					// else
-					assert(!(condstack.back() & TRCSF_SEEN_ELSE));
-					HandleCondition(condstack, condflags, true);
-					condstack.back() |= TRCSF_SEEN_ELSE;
-				} else {
-					// end if
-					condstack.pop_back();
-				}
-			} else {
-				uint16_t condvalue = GetTraceRestrictValue(item);
-				bool result = false;
-				switch(type) {
-					case TRIT_COND_UNDEFINED:
-						result = false;
-						break;
+		case TRIT_COND_MAX_SPEED:
+			result = TestCondition(v->GetDisplayMaxSpeed(), condop, condvalue);
+			break;
 
-					case TRIT_COND_TRAIN_LENGTH:
-						result = TestCondition(CeilDiv(v->gcache.cached_total_length, TILE_SIZE), condop, condvalue);
-						break;
+		case TRIT_COND_CURRENT_ORDER:
+			result = TestOrderCondition(&(v->current_order), item);
+			break;
 
-					case TRIT_COND_MAX_SPEED:
-						result = TestCondition(v->GetDisplayMaxSpeed(), condop, condvalue);
-						break;
+		case TRIT_COND_NEXT_ORDER: {
+			if (v->orders == nullptr) break;
+			if (v->orders->GetNumOrders() == 0) break;
 
-					case TRIT_COND_CURRENT_ORDER:
-						result = TestOrderCondition(&(v->current_order), item);
-						break;
+			const Order *current_order = v->GetOrder(v->cur_real_order_index);
+			for (const Order *order = v->orders->GetNext(current_order); order != current_order; order = v->orders->GetNext(order)) {
+				if (order->IsGotoOrder()) {
+					result = TestOrderCondition(order, item);
+					break;
+				}
+			}
+			break;
+		}
 
-					case TRIT_COND_NEXT_ORDER: {
-						if (v->orders == nullptr) break;
-						if (v->orders->GetNumOrders() == 0) break;
+		case TRIT_COND_LAST_STATION:
+			result = TestStationCondition(v->last_station_visited, item);
+			break;
 
-						const Order *current_order = v->GetOrder(v->cur_real_order_index);
-						for (const Order *order = v->orders->GetNext(current_order); order != current_order; order = v->orders->GetNext(order)) {
-							if (order->IsGotoOrder()) {
-								result = TestOrderCondition(order, item);
-								break;
-							}
-						}
-						break;
-					}
+		case TRIT_COND_CARGO: {
+			bool have_cargo = false;
+			for (const Vehicle *v_iter = v; v_iter != nullptr; v_iter = v_iter->Next()) {
+				if (v_iter->cargo_type == GetTraceRestrictValue(item) && v_iter->cargo_cap > 0) {
+					have_cargo = true;
+					break;
+				}
+			}
+			result = TestBinaryConditionCommon(item, have_cargo);
+			break;
+		}
 
-					case TRIT_COND_LAST_STATION:
-						result = TestStationCondition(v->last_station_visited, item);
-						break;
+		case TRIT_COND_ENTRY_DIRECTION: {
+			bool direction_match;
+			switch (GetTraceRestrictValue(item)) {
+				case TRNTSV_NE:
+				case TRNTSV_SE:
+				case TRNTSV_SW:
+				case TRNTSV_NW:
+					direction_match = (static_cast<DiagDirection>(GetTraceRestrictValue(item)) == TrackdirToExitdir(ReverseTrackdir(input.trackdir)));
+					break;
 
-					case TRIT_COND_CARGO: {
-						bool have_cargo = false;
-						for (const Vehicle *v_iter = v; v_iter != nullptr; v_iter = v_iter->Next()) {
-							if (v_iter->cargo_type == GetTraceRestrictValue(item) && v_iter->cargo_cap > 0) {
-								have_cargo = true;
-								break;
-							}
-						}
-						result = TestBinaryConditionCommon(item, have_cargo);
-						break;
-					}
+				case TRDTSV_FRONT:
+					direction_match = (IsTileType(input.tile, MP_RAILWAY) && HasSignalOnTrackdir(input.tile, input.trackdir)) || IsTileType(input.tile, MP_TUNNELBRIDGE);
+					break;
 
-					case TRIT_COND_ENTRY_DIRECTION: {
-						bool direction_match;
-						switch (GetTraceRestrictValue(item)) {
-							case TRNTSV_NE:
-							case TRNTSV_SE:
-							case TRNTSV_SW:
-							case TRNTSV_NW:
-								direction_match = (static_cast<DiagDirection>(GetTraceRestrictValue(item)) == TrackdirToExitdir(ReverseTrackdir(input.trackdir)));
-								break;
+				case TRDTSV_BACK:
+					direction_match = IsTileType(input.tile, MP_RAILWAY) && !HasSignalOnTrackdir(input.tile, input.trackdir);
+					break;
 
-							case TRDTSV_FRONT:
-								direction_match = (IsTileType(input.tile, MP_RAILWAY) && HasSignalOnTrackdir(input.tile, input.trackdir)) || IsTileType(input.tile, MP_TUNNELBRIDGE);
-								break;
+				case TRDTSV_TUNBRIDGE_ENTER:
+					direction_match = IsTunnelBridgeSignalSimulationEntranceTile(input.tile) && TrackdirEntersTunnelBridge(input.tile, input.trackdir);
+					break;
 
-							case TRDTSV_BACK:
-								direction_match = IsTileType(input.tile, MP_RAILWAY) && !HasSignalOnTrackdir(input.tile, input.trackdir);
-								break;
+				case TRDTSV_TUNBRIDGE_EXIT:
+					direction_match = IsTunnelBridgeSignalSimulationExitTile(input.tile) && TrackdirExitsTunnelBridge(input.tile, input.trackdir);
+					break;
 
-							case TRDTSV_TUNBRIDGE_ENTER:
-								direction_match = IsTunnelBridgeSignalSimulationEntranceTile(input.tile) && TrackdirEntersTunnelBridge(input.tile, input.trackdir);
-								break;
+				default:
+					NOT_REACHED();
+					break;
+			}
+			result = TestBinaryConditionCommon(item, direction_match);
+			break;
+		}
 
-							case TRDTSV_TUNBRIDGE_EXIT:
-								direction_match = IsTunnelBridgeSignalSimulationExitTile(input.tile) && TrackdirExitsTunnelBridge(input.tile, input.trackdir);
-								break;
+		case TRIT_COND_PBS_ENTRY_SIGNAL: {
+			// TRIT_COND_PBS_ENTRY_SIGNAL value type uses the next slot
+			TraceRestrictPBSEntrySignalAuxField mode = static_cast<TraceRestrictPBSEntrySignalAuxField>(GetTraceRestrictAuxField(item));
+			assert(mode == TRPESAF_VEH_POS || mode == TRPESAF_RES_END || mode == TRPESAF_RES_END_TILE);
+			uint32_t signal_tile = data[1];
+			if (!HasBit(state.have_previous_signal, mode)) {
+				if (input.previous_signal_callback) {
+					state.previous_signal_tile[mode] = input.previous_signal_callback(v, input.previous_signal_ptr, mode);
+				} else {
+					state.previous_signal_tile[mode] = INVALID_TILE;
+				}
+				SetBit(state.have_previous_signal, mode);
+			}
+			bool match = (signal_tile != INVALID_TILE)
+					&& (state.previous_signal_tile[mode] == signal_tile);
+			result = TestBinaryConditionCommon(item, match);
+			break;
+		}
 
-							default:
-								NOT_REACHED();
-								break;
-						}
-						result = TestBinaryConditionCommon(item, direction_match);
-						break;
-					}
+		case TRIT_COND_TRAIN_GROUP: {
+			result = TestBinaryConditionCommon(item, GroupIsInGroup(v->group_id, GetTraceRestrictValue(item)));
+			break;
+		}
 
-					case TRIT_COND_PBS_ENTRY_SIGNAL: {
-						// TRIT_COND_PBS_ENTRY_SIGNAL value type uses the next slot
-						i++;
-						TraceRestrictPBSEntrySignalAuxField mode = static_cast<TraceRestrictPBSEntrySignalAuxField>(GetTraceRestrictAuxField(item));
-						assert(mode == TRPESAF_VEH_POS || mode == TRPESAF_RES_END || mode == TRPESAF_RES_END_TILE);
-						uint32_t signal_tile = this->items[i];
-						if (!HasBit(have_previous_signal, mode)) {
-							if (input.previous_signal_callback) {
-								previous_signal_tile[mode] = input.previous_signal_callback(v, input.previous_signal_ptr, mode);
-							} else {
-								previous_signal_tile[mode] = INVALID_TILE;
-							}
-							SetBit(have_previous_signal, mode);
-						}
-						bool match = (signal_tile != INVALID_TILE)
-								&& (previous_signal_tile[mode] == signal_tile);
-						result = TestBinaryConditionCommon(item, match);
-						break;
-					}
+		case TRIT_COND_TRAIN_IN_SLOT: {
+			const TraceRestrictSlot *slot = TraceRestrictSlot::GetIfValid(GetTraceRestrictValue(item));
+			result = TestBinaryConditionCommon(item, slot != nullptr && slot->IsOccupant(v->index));
+			break;
+		}
 
-					case TRIT_COND_TRAIN_GROUP: {
-						result = TestBinaryConditionCommon(item, GroupIsInGroup(v->group_id, GetTraceRestrictValue(item)));
-						break;
-					}
+		case TRIT_COND_SLOT_OCCUPANCY: {
+			// TRIT_COND_SLOT_OCCUPANCY value type uses the next slot
+			uint32_t value = data[1];
+			const TraceRestrictSlot *slot = TraceRestrictSlot::GetIfValid(GetTraceRestrictValue(item));
+			switch (static_cast<TraceRestrictSlotOccupancyCondAuxField>(GetTraceRestrictAuxField(item))) {
+				case TRSOCAF_OCCUPANTS:
+					result = TestCondition(slot != nullptr ? (uint)slot->occupants.size() : 0, condop, value);
+					break;
 
-					case TRIT_COND_TRAIN_IN_SLOT: {
-						const TraceRestrictSlot *slot = TraceRestrictSlot::GetIfValid(GetTraceRestrictValue(item));
-						result = TestBinaryConditionCommon(item, slot != nullptr && slot->IsOccupant(v->index));
-						break;
-					}
+				case TRSOCAF_REMAINING:
+					result = TestCondition(slot != nullptr ? slot->max_occupancy - (uint)slot->occupants.size() : 0, condop, value);
+					break;
 
-					case TRIT_COND_SLOT_OCCUPANCY: {
-						// TRIT_COND_SLOT_OCCUPANCY value type uses the next slot
-						i++;
-						uint32_t value = this->items[i];
-						const TraceRestrictSlot *slot = TraceRestrictSlot::GetIfValid(GetTraceRestrictValue(item));
-						switch (static_cast<TraceRestrictSlotOccupancyCondAuxField>(GetTraceRestrictAuxField(item))) {
-							case TRSOCAF_OCCUPANTS:
-								result = TestCondition(slot != nullptr ? (uint)slot->occupants.size() : 0, condop, value);
-								break;
+				default:
+					NOT_REACHED();
+					break;
+			}
+			break;
+		}
 
-							case TRSOCAF_REMAINING:
-								result = TestCondition(slot != nullptr ? slot->max_occupancy - (uint)slot->occupants.size() : 0, condop, value);
-								break;
+		case TRIT_COND_PHYS_PROP: {
+			switch (static_cast<TraceRestrictPhysPropCondAuxField>(GetTraceRestrictAuxField(item))) {
+				case TRPPCAF_WEIGHT:
+					result = TestCondition(v->gcache.cached_weight, condop, condvalue);
+					break;
 
-							default:
-								NOT_REACHED();
-								break;
-						}
-						break;
-					}
+				case TRPPCAF_POWER:
+					result = TestCondition(v->gcache.cached_power, condop, condvalue);
+					break;
 
-					case TRIT_COND_PHYS_PROP: {
-						switch (static_cast<TraceRestrictPhysPropCondAuxField>(GetTraceRestrictAuxField(item))) {
-							case TRPPCAF_WEIGHT:
-								result = TestCondition(v->gcache.cached_weight, condop, condvalue);
-								break;
+				case TRPPCAF_MAX_TE:
+					result = TestCondition(v->gcache.cached_max_te / 1000, condop, condvalue);
+					break;
 
-							case TRPPCAF_POWER:
-								result = TestCondition(v->gcache.cached_power, condop, condvalue);
-								break;
+				default:
+					NOT_REACHED();
+					break;
+			}
+			break;
+		}
 
-							case TRPPCAF_MAX_TE:
-								result = TestCondition(v->gcache.cached_max_te / 1000, condop, condvalue);
-								break;
+		case TRIT_COND_PHYS_RATIO: {
+			switch (static_cast<TraceRestrictPhysPropRatioCondAuxField>(GetTraceRestrictAuxField(item))) {
+				case TRPPRCAF_POWER_WEIGHT:
+					result = TestCondition(std::min<uint>(UINT16_MAX, (100 * v->gcache.cached_power) / std::max<uint>(1, v->gcache.cached_weight)), condop, condvalue);
+					break;
 
-							default:
-								NOT_REACHED();
-								break;
-						}
-						break;
-					}
+				case TRPPRCAF_MAX_TE_WEIGHT:
+					result = TestCondition(std::min<uint>(UINT16_MAX, (v->gcache.cached_max_te / 10) / std::max<uint>(1, v->gcache.cached_weight)), condop, condvalue);
+					break;
 
-					case TRIT_COND_PHYS_RATIO: {
-						switch (static_cast<TraceRestrictPhysPropRatioCondAuxField>(GetTraceRestrictAuxField(item))) {
-							case TRPPRCAF_POWER_WEIGHT:
-								result = TestCondition(std::min<uint>(UINT16_MAX, (100 * v->gcache.cached_power) / std::max<uint>(1, v->gcache.cached_weight)), condop, condvalue);
-								break;
+				default:
+					NOT_REACHED();
+					break;
+			}
+			break;
+		}
 
-							case TRPPRCAF_MAX_TE_WEIGHT:
-								result = TestCondition(std::min<uint>(UINT16_MAX, (v->gcache.cached_max_te / 10) / std::max<uint>(1, v->gcache.cached_weight)), condop, condvalue);
-								break;
+		case TRIT_COND_TRAIN_OWNER: {
+			result = TestBinaryConditionCommon(item, v->owner == condvalue);
+			break;
+		}
 
-							default:
-								NOT_REACHED();
-								break;
+		case TRIT_COND_TRAIN_STATUS: {
+			bool has_status = false;
+			switch (static_cast<TraceRestrictTrainStatusValueField>(GetTraceRestrictValue(item))) {
+				case TRTSVF_EMPTY:
+					has_status = true;
+					for (const Vehicle *v_iter = v; v_iter != nullptr; v_iter = v_iter->Next()) {
+						if (v_iter->cargo.StoredCount() > 0) {
+							has_status = false;
+							break;
 						}
-						break;
 					}
+					break;
 
-					case TRIT_COND_TRAIN_OWNER: {
-						result = TestBinaryConditionCommon(item, v->owner == condvalue);
-						break;
+				case TRTSVF_FULL:
+					has_status = true;
+					for (const Vehicle *v_iter = v; v_iter != nullptr; v_iter = v_iter->Next()) {
+						if (v_iter->cargo.StoredCount() < v_iter->cargo_cap) {
+							has_status = false;
+							break;
+						}
 					}
+					break;
 
-					case TRIT_COND_TRAIN_STATUS: {
-						bool has_status = false;
-						switch (static_cast<TraceRestrictTrainStatusValueField>(GetTraceRestrictValue(item))) {
-							case TRTSVF_EMPTY:
-								has_status = true;
-								for (const Vehicle *v_iter = v; v_iter != nullptr; v_iter = v_iter->Next()) {
-									if (v_iter->cargo.StoredCount() > 0) {
-										has_status = false;
-										break;
-									}
-								}
-								break;
-
-							case TRTSVF_FULL:
-								has_status = true;
-								for (const Vehicle *v_iter = v; v_iter != nullptr; v_iter = v_iter->Next()) {
-									if (v_iter->cargo.StoredCount() < v_iter->cargo_cap) {
-										has_status = false;
-										break;
-									}
-								}
-								break;
+				case TRTSVF_BROKEN_DOWN:
+					has_status = v->flags & VRF_IS_BROKEN;
+					break;
 
-							case TRTSVF_BROKEN_DOWN:
-								has_status = v->flags & VRF_IS_BROKEN;
-								break;
+				case TRTSVF_NEEDS_REPAIR:
+					has_status = v->critical_breakdown_count > 0;
+					break;
 
-							case TRTSVF_NEEDS_REPAIR:
-								has_status = v->critical_breakdown_count > 0;
-								break;
+				case TRTSVF_REVERSING:
+					has_status = v->reverse_distance > 0 || HasBit(v->flags, VRF_REVERSING);
+					break;
 
-							case TRTSVF_REVERSING:
-								has_status = v->reverse_distance > 0 || HasBit(v->flags, VRF_REVERSING);
-								break;
+				case TRTSVF_HEADING_TO_STATION_WAYPOINT:
+					has_status = v->current_order.IsType(OT_GOTO_STATION) || v->current_order.IsType(OT_GOTO_WAYPOINT);
+					break;
 
-							case TRTSVF_HEADING_TO_STATION_WAYPOINT:
-								has_status = v->current_order.IsType(OT_GOTO_STATION) || v->current_order.IsType(OT_GOTO_WAYPOINT);
-								break;
+				case TRTSVF_HEADING_TO_DEPOT:
+					has_status = v->current_order.IsType(OT_GOTO_DEPOT);
+					break;
 
-							case TRTSVF_HEADING_TO_DEPOT:
-								has_status = v->current_order.IsType(OT_GOTO_DEPOT);
-								break;
+				case TRTSVF_LOADING: {
+					extern const Order *_choose_train_track_saved_current_order;
+					const Order *o = (_choose_train_track_saved_current_order != nullptr) ? _choose_train_track_saved_current_order : &(v->current_order);
+					has_status = o->IsType(OT_LOADING) || o->IsType(OT_LOADING_ADVANCE);
+					break;
+				}
 
-							case TRTSVF_LOADING: {
-								extern const Order *_choose_train_track_saved_current_order;
-								const Order *o = (_choose_train_track_saved_current_order != nullptr) ? _choose_train_track_saved_current_order : &(v->current_order);
-								has_status = o->IsType(OT_LOADING) || o->IsType(OT_LOADING_ADVANCE);
-								break;
-							}
+				case TRTSVF_WAITING:
+					has_status = v->current_order.IsType(OT_WAITING);
+					break;
 
-							case TRTSVF_WAITING:
-								has_status = v->current_order.IsType(OT_WAITING);
-								break;
+				case TRTSVF_LOST:
+					has_status = HasBit(v->vehicle_flags, VF_PATHFINDER_LOST);
+					break;
 
-							case TRTSVF_LOST:
-								has_status = HasBit(v->vehicle_flags, VF_PATHFINDER_LOST);
-								break;
+				case TRTSVF_REQUIRES_SERVICE:
+					has_status = v->NeedsServicing();
+					break;
 
-							case TRTSVF_REQUIRES_SERVICE:
-								has_status = v->NeedsServicing();
-								break;
+				case TRTSVF_STOPPING_AT_STATION_WAYPOINT:
+					switch (v->current_order.GetType()) {
+						case OT_GOTO_STATION:
+						case OT_GOTO_WAYPOINT:
+						case OT_LOADING_ADVANCE:
+							has_status = v->current_order.ShouldStopAtStation(v, v->current_order.GetDestination(), v->current_order.IsType(OT_GOTO_WAYPOINT));
+							break;
 
-							case TRTSVF_STOPPING_AT_STATION_WAYPOINT:
-								switch (v->current_order.GetType()) {
-									case OT_GOTO_STATION:
-									case OT_GOTO_WAYPOINT:
-									case OT_LOADING_ADVANCE:
-										has_status = v->current_order.ShouldStopAtStation(v, v->current_order.GetDestination(), v->current_order.IsType(OT_GOTO_WAYPOINT));
-										break;
-
-									default:
-										has_status = false;
-										break;
-								}
-								break;
-						}
-						result = TestBinaryConditionCommon(item, has_status);
-						break;
+						default:
+							has_status = false;
+							break;
 					}
+					break;
+			}
+			result = TestBinaryConditionCommon(item, has_status);
+			break;
+		}
 
-					case TRIT_COND_LOAD_PERCENT: {
-						result = TestCondition(CalcPercentVehicleFilled(v, nullptr), condop, condvalue);
-						break;
-					}
+		case TRIT_COND_LOAD_PERCENT: {
+			result = TestCondition(CalcPercentVehicleFilled(v, nullptr), condop, condvalue);
+			break;
+		}
 
-					case TRIT_COND_COUNTER_VALUE: {
-						// TRVT_COUNTER_INDEX_INT value type uses the next slot
-						i++;
-						uint32_t value = this->items[i];
-						const TraceRestrictCounter *ctr = TraceRestrictCounter::GetIfValid(GetTraceRestrictValue(item));
-						result = TestCondition(ctr != nullptr ? ctr->value : 0, condop, value);
-						break;
-					}
+		case TRIT_COND_COUNTER_VALUE: {
+			// TRVT_COUNTER_INDEX_INT value type uses the next slot
+			uint32_t value = data[1];
+			const TraceRestrictCounter *ctr = TraceRestrictCounter::GetIfValid(GetTraceRestrictValue(item));
+			result = TestCondition(ctr != nullptr ? ctr->value : 0, condop, value);
+			break;
+		}
 
-					case TRIT_COND_TIME_DATE_VALUE: {
-						// TRVT_TIME_DATE_INT value type uses the next slot
-						i++;
-						uint32_t value = this->items[i];
-						result = TestCondition(GetTraceRestrictTimeDateValue(static_cast<TraceRestrictTimeDateValueField>(GetTraceRestrictValue(item))), condop, value);
-						break;
-					}
+		case TRIT_COND_TIME_DATE_VALUE: {
+			// TRVT_TIME_DATE_INT value type uses the next slot
+			uint32_t value = data[1];
+			result = TestCondition(GetTraceRestrictTimeDateValue(static_cast<TraceRestrictTimeDateValueField>(GetTraceRestrictValue(item))), condop, value);
+			break;
+		}
 
-					case TRIT_COND_RESERVED_TILES: {
-						uint tiles_ahead = 0;
-						if (v->lookahead != nullptr) {
-							tiles_ahead = std::max<int>(0, v->lookahead->reservation_end_position - v->lookahead->current_position) / TILE_SIZE;
+		case TRIT_COND_RESERVED_TILES: {
+			uint tiles_ahead = 0;
+			if (v->lookahead != nullptr) {
+				tiles_ahead = std::max<int>(0, v->lookahead->reservation_end_position - v->lookahead->current_position) / TILE_SIZE;
+			}
+			result = TestCondition(tiles_ahead, condop, condvalue);
+			break;
+		}
+
+		case TRIT_COND_CATEGORY: {
+			switch (static_cast<TraceRestrictCatgeoryCondAuxField>(GetTraceRestrictAuxField(item))) {
+				case TRCCAF_ENGINE_CLASS: {
+					EngineClass ec = (EngineClass)condvalue;
+					result = (GetTraceRestrictCondOp(item) != TRCO_IS);
+					for (const Train *u = v; u != nullptr; u = u->Next()) {
+						/* Check if engine class present */
+						if (u->IsEngine() && RailVehInfo(u->engine_type)->engclass == ec) {
+							result = !result;
+							break;
 						}
-						result = TestCondition(tiles_ahead, condop, condvalue);
-						break;
 					}
+					break;
+				}
 
-					case TRIT_COND_CATEGORY: {
-						switch (static_cast<TraceRestrictCatgeoryCondAuxField>(GetTraceRestrictAuxField(item))) {
-							case TRCCAF_ENGINE_CLASS: {
-								EngineClass ec = (EngineClass)condvalue;
-								result = (GetTraceRestrictCondOp(item) != TRCO_IS);
-								for (const Train *u = v; u != nullptr; u = u->Next()) {
-									/* Check if engine class present */
-									if (u->IsEngine() && RailVehInfo(u->engine_type)->engclass == ec) {
-										result = !result;
-										break;
-									}
-								}
-								break;
-							}
+				default:
+					NOT_REACHED();
+					break;
+			}
+			break;
+		}
 
-							default:
-								NOT_REACHED();
-								break;
+		case TRIT_COND_TARGET_DIRECTION: {
+			const Order *o = nullptr;
+			switch (static_cast<TraceRestrictTargetDirectionCondAuxField>(GetTraceRestrictAuxField(item))) {
+				case TRTDCAF_CURRENT_ORDER:
+					o = &(v->current_order);
+					break;
+
+				case TRTDCAF_NEXT_ORDER:
+					if (v->orders == nullptr) break;
+					if (v->orders->GetNumOrders() == 0) break;
+
+					const Order *current_order = v->GetOrder(v->cur_real_order_index);
+					for (const Order *order = v->orders->GetNext(current_order); order != current_order; order = v->orders->GetNext(order)) {
+						if (order->IsGotoOrder()) {
+							o = order;
+							break;
 						}
-						break;
 					}
+					break;
+			}
 
-					case TRIT_COND_TARGET_DIRECTION: {
-						const Order *o = nullptr;
-						switch (static_cast<TraceRestrictTargetDirectionCondAuxField>(GetTraceRestrictAuxField(item))) {
-							case TRTDCAF_CURRENT_ORDER:
-								o = &(v->current_order);
-								break;
+			if (o == nullptr) break;
 
-							case TRTDCAF_NEXT_ORDER:
-								if (v->orders == nullptr) break;
-								if (v->orders->GetNumOrders() == 0) break;
+			TileIndex target = o->GetLocation(v, true);
+			if (target == INVALID_TILE) break;
 
-								const Order *current_order = v->GetOrder(v->cur_real_order_index);
-								for (const Order *order = v->orders->GetNext(current_order); order != current_order; order = v->orders->GetNext(order)) {
-									if (order->IsGotoOrder()) {
-										o = order;
-										break;
-									}
-								}
-								break;
-						}
+			switch (condvalue) {
+				case DIAGDIR_NE:
+					result = TestBinaryConditionCommon(item, TileX(target) < TileX(input.tile));
+					break;
+				case DIAGDIR_SE:
+					result = TestBinaryConditionCommon(item, TileY(target) > TileY(input.tile));
+					break;
+				case DIAGDIR_SW:
+					result = TestBinaryConditionCommon(item, TileX(target) > TileX(input.tile));
+					break;
+				case DIAGDIR_NW:
+					result = TestBinaryConditionCommon(item, TileY(target) < TileY(input.tile));
+					break;
+			}
+			break;
+		}
 
-						if (o == nullptr) break;
+		case TRIT_COND_RESERVATION_THROUGH: {
+			// TRIT_COND_RESERVATION_THROUGH value type uses the next slot
+			uint32_t test_tile = data[1];
+			result = TestBinaryConditionCommon(item, TrainReservationPassesThroughTile(v, test_tile));
+			break;
+		}
 
-						TileIndex target = o->GetLocation(v, true);
-						if (target == INVALID_TILE) break;
+		default:
+			NOT_REACHED();
+	}
+	return result;
+}
 
-						switch (condvalue) {
-							case DIAGDIR_NE:
-								result = TestBinaryConditionCommon(item, TileX(target) < TileX(input.tile));
-								break;
-							case DIAGDIR_SE:
-								result = TestBinaryConditionCommon(item, TileY(target) > TileY(input.tile));
-								break;
-							case DIAGDIR_SW:
-								result = TestBinaryConditionCommon(item, TileX(target) > TileX(input.tile));
-								break;
-							case DIAGDIR_NW:
-								result = TestBinaryConditionCommon(item, TileY(target) < TileY(input.tile));
-								break;
-						}
-						break;
-					}
+/**
+ * Apply an action instruction to the result
+ * @p data points to the instruction, the second item of double item instructions follows it
+ * @p actions_used_flags are the actions used flags of the program
+ */
+static void ApplyTraceRestrictAction(const Train *v, const TraceRestrictProgramInput &input, const TraceRestrictItem *data, TraceRestrictProgramActionsUsedFlags actions_used_flags, TraceRestrictProgramResult &out)
+{
+	const TraceRestrictItem item = data[0];
+	switch (GetTraceRestrictType(item)) {
+		case TRIT_PF_DENY:
+			if (GetTraceRestrictValue(item)) {
+				out.flags &= ~TRPRF_DENY;
+			} else {
+				out.flags |= TRPRF_DENY;
+			}
+			break;
 
-					case TRIT_COND_RESERVATION_THROUGH: {
-						// TRIT_COND_RESERVATION_THROUGH value type uses the next slot
-						i++;
-						uint32_t test_tile = this->items[i];
-						result = TestBinaryConditionCommon(item, TrainReservationPassesThroughTile(v, test_tile));
-						break;
-					}
+		case TRIT_PF_PENALTY:
+			switch (static_cast<TraceRestrictPathfinderPenaltyAuxField>(GetTraceRestrictAuxField(item))) {
+				case TRPPAF_VALUE:
+					out.penalty += GetTraceRestrictValue(item);
+					break;
 
-					default:
-						NOT_REACHED();
+				case TRPPAF_PRESET: {
+					uint16_t index = GetTraceRestrictValue(item);
+					assert(index < TRPPPI_END);
+					out.penalty += _tracerestrict_pathfinder_penalty_preset_values[index];
+					break;
 				}
-				HandleCondition(condstack, condflags, result);
+
+				default:
+					NOT_REACHED();
 			}
-		} else {
-			if (condstack.empty() || condstack.back() & TRCSF_ACTIVE) {
-				switch(type) {
-					case TRIT_PF_DENY:
-						if (GetTraceRestrictValue(item)) {
-							out.flags &= ~TRPRF_DENY;
-						} else {
-							out.flags |= TRPRF_DENY;
-						}
-						break;
+			break;
 
-					case TRIT_PF_PENALTY:
-						switch (static_cast<TraceRestrictPathfinderPenaltyAuxField>(GetTraceRestrictAuxField(item))) {
-							case TRPPAF_VALUE:
-								out.penalty += GetTraceRestrictValue(item);
-								break;
+		case TRIT_RESERVE_THROUGH:
+			if (GetTraceRestrictValue(item)) {
+				out.flags &= ~TRPRF_RESERVE_THROUGH;
+			} else {
+				out.flags |= TRPRF_RESERVE_THROUGH;
+			}
+			break;
 
-							case TRPPAF_PRESET: {
-								uint16_t index = GetTraceRestrictValue(item);
-								assert(index < TRPPPI_END);
-								out.penalty += _tracerestrict_pathfinder_penalty_preset_values[index];
-								break;
-							}
+		case TRIT_LONG_RESERVE:
+			switch (static_cast<TraceRestrictLongReserveValueField>(GetTraceRestrictValue(item))) {
+				case TRLRVF_LONG_RESERVE:
+					out.flags |= TRPRF_LONG_RESERVE;
+					break;
 
-							default:
-								NOT_REACHED();
-						}
-						break;
+				case TRLRVF_CANCEL_LONG_RESERVE:
+					out.flags &= ~TRPRF_LONG_RESERVE;
+					break;
 
-					case TRIT_RESERVE_THROUGH:
-						if (GetTraceRestrictValue(item)) {
-							out.flags &= ~TRPRF_RESERVE_THROUGH;
-						} else {
-							out.flags |= TRPRF_RESERVE_THROUGH;
-						}
-						break;
+				case TRLRVF_LONG_RESERVE_UNLESS_STOPPING:
+					if (!(input.input_flags & TRPIF_PASSED_STOP)) {
+						out.flags |= TRPRF_LONG_RESERVE;
+					}
+					break;
 
-					case TRIT_LONG_RESERVE:
-						switch (static_cast<TraceRestrictLongReserveValueField>(GetTraceRestrictValue(item))) {
-							case TRLRVF_LONG_RESERVE:
-								out.flags |= TRPRF_LONG_RESERVE;
-								break;
+				default:
+					NOT_REACHED();
+					break;
+			}
+			break;
 
-							case TRLRVF_CANCEL_LONG_RESERVE:
-								out.flags &= ~TRPRF_LONG_RESERVE;
-								break;
+		case TRIT_WAIT_AT_PBS:
+			switch (static_cast<TraceRestrictWaitAtPbsValueField>(GetTraceRestrictValue(item))) {
+				case TRWAPVF_WAIT_AT_PBS:
+					out.flags |= TRPRF_WAIT_AT_PBS;
+					break;
 
-							case TRLRVF_LONG_RESERVE_UNLESS_STOPPING:
-								if (!(input.input_flags & TRPIF_PASSED_STOP)) {
-									out.flags |= TRPRF_LONG_RESERVE;
-								}
-								break;
+				case TRWAPVF_CANCEL_WAIT_AT_PBS:
+					out.flags &= ~TRPRF_WAIT_AT_PBS;
+					break;
 
-							default:
-								NOT_REACHED();
-								break;
-						}
-						break;
+				case TRWAPVF_PBS_RES_END_WAIT:
+					out.flags |= TRPRF_PBS_RES_END_WAIT;
+					break;
 
-					case TRIT_WAIT_AT_PBS:
-						switch (static_cast<TraceRestrictWaitAtPbsValueField>(GetTraceRestrictValue(item))) {
-							case TRWAPVF_WAIT_AT_PBS:
-								out.flags |= TRPRF_WAIT_AT_PBS;
-								break;
+				case TRWAPVF_CANCEL_PBS_RES_END_WAIT:
+					out.flags &= ~TRPRF_PBS_RES_END_WAIT;
+					break;
 
-							case TRWAPVF_CANCEL_WAIT_AT_PBS:
-								out.flags &= ~TRPRF_WAIT_AT_PBS;
-								break;
+				default:
+					NOT_REACHED();
+					break;
+			}
+			break;
 
-							case TRWAPVF_PBS_RES_END_WAIT:
-								out.flags |= TRPRF_PBS_RES_END_WAIT;
-								break;
+		case TRIT_SLOT: {
+			if (!input.permitted_slot_operations) break;
+			TraceRestrictSlot *slot = TraceRestrictSlot::GetIfValid(GetTraceRestrictValue(item));
+			if (slot == nullptr || slot->vehicle_type != v->type) break;
+			switch (static_cast<TraceRestrictSlotSubtypeField>(GetTraceRestrictCombinedAuxCondOpField(item))) {
+				case TRSCOF_ACQUIRE_WAIT:
+					if (input.permitted_slot_operations & TRPISP_ACQUIRE) {
+						if (!slot->Occupy(v)) out.flags |= TRPRF_WAIT_AT_PBS;
+					} else if (input.permitted_slot_operations & TRPISP_ACQUIRE_TEMP_STATE) {
+						if (!slot->OccupyUsingTemporaryState(v->index, TraceRestrictSlotTemporaryState::GetCurrent())) out.flags |= TRPRF_WAIT_AT_PBS;
+					}
+					break;
 
-							case TRWAPVF_CANCEL_PBS_RES_END_WAIT:
-								out.flags &= ~TRPRF_PBS_RES_END_WAIT;
-								break;
+				case TRSCOF_ACQUIRE_TRY:
+					if (input.permitted_slot_operations & TRPISP_ACQUIRE) {
+						slot->Occupy(v);
+					} else if (input.permitted_slot_operations & TRPISP_ACQUIRE_TEMP_STATE) {
+						slot->OccupyUsingTemporaryState(v->index, TraceRestrictSlotTemporaryState::GetCurrent());
+					}
+					break;
 
-							default:
-								NOT_REACHED();
-								break;
-						}
-						break;
+				case TRSCOF_RELEASE_ON_RESERVE:
+					if (input.permitted_slot_operations & TRPISP_ACQUIRE) {
+						slot->Vacate(v);
+					} else if (input.permitted_slot_operations & TRPISP_ACQUIRE_TEMP_STATE) {
+						slot->VacateUsingTemporaryState(v->index, TraceRestrictSlotTemporaryState::GetCurrent());
+					}
+					break;
 
-					case TRIT_SLOT: {
-						if (!input.permitted_slot_operations) break;
-						TraceRestrictSlot *slot = TraceRestrictSlot::GetIfValid(GetTraceRestrictValue(item));
-						if (slot == nullptr || slot->vehicle_type != v->type) break;
-						switch (static_cast<TraceRestrictSlotSubtypeField>(GetTraceRestrictCombinedAuxCondOpField(item))) {
-							case TRSCOF_ACQUIRE_WAIT:
-								if (input.permitted_slot_operations & TRPISP_ACQUIRE) {
-									if (!slot->Occupy(v)) out.flags |= TRPRF_WAIT_AT_PBS;
-								} else if (input.permitted_slot_operations & TRPISP_ACQUIRE_TEMP_STATE) {
-									if (!slot->OccupyUsingTemporaryState(v->index, TraceRestrictSlotTemporaryState::GetCurrent())) out.flags |= TRPRF_WAIT_AT_PBS;
-								}
-								break;
+				case TRSCOF_RELEASE_BACK:
+					if (input.permitted_slot_operations & TRPISP_RELEASE_BACK) slot->Vacate(v);
+					break;
 
-							case TRSCOF_ACQUIRE_TRY:
-								if (input.permitted_slot_operations & TRPISP_ACQUIRE) {
-									slot->Occupy(v);
-								} else if (input.permitted_slot_operations & TRPISP_ACQUIRE_TEMP_STATE) {
-									slot->OccupyUsingTemporaryState(v->index, TraceRestrictSlotTemporaryState::GetCurrent());
-								}
-								break;
+				case TRSCOF_RELEASE_FRONT:
+					if (input.permitted_slot_operations & TRPISP_RELEASE_FRONT) slot->Vacate(v);
+					break;
 
-							case TRSCOF_RELEASE_ON_RESERVE:
-								if (input.permitted_slot_operations & TRPISP_ACQUIRE) {
-									slot->Vacate(v);
-								} else if (input.permitted_slot_operations & TRPISP_ACQUIRE_TEMP_STATE) {
-									slot->VacateUsingTemporaryState(v->index, TraceRestrictSlotTemporaryState::GetCurrent());
-								}
-								break;
+				case TRSCOF_PBS_RES_END_ACQ_WAIT:
+					if (input.permitted_slot_operations & TRPISP_PBS_RES_END_ACQUIRE) {
+						if (!slot->Occupy(v)) out.flags |= TRPRF_PBS_RES_END_WAIT;
+					} else if (input.permitted_slot_operations & TRPISP_PBS_RES_END_ACQ_DRY) {
+						if (actions_used_flags & TRPAUF_PBS_RES_END_SIMULATE) {
+							if (!slot->OccupyUsingTemporaryState(v->index, &_pbs_res_end_acq_dry_slot_temporary_state)) out.flags |= TRPRF_PBS_RES_END_WAIT;
+						} else {
+							if (!slot->OccupyDryRun(v->index)) out.flags |= TRPRF_PBS_RES_END_WAIT;
+						}
+					}
+					break;
 
-							case TRSCOF_RELEASE_BACK:
-								if (input.permitted_slot_operations & TRPISP_RELEASE_BACK) slot->Vacate(v);
-								break;
+				case TRSCOF_PBS_RES_END_ACQ_TRY:
+					if (input.permitted_slot_operations & TRPISP_PBS_RES_END_ACQUIRE) {
+						slot->Occupy(v);
+					} else if ((input.permitted_slot_operations & TRPISP_PBS_RES_END_ACQ_DRY) && (actions_used_flags & TRPAUF_PBS_RES_END_SIMULATE)) {
+						slot->OccupyUsingTemporaryState(v->index, &_pbs_res_end_acq_dry_slot_temporary_state);
+					}
+					break;
 
-							case TRSCOF_RELEASE_FRONT:
-								if (input.permitted_slot_operations & TRPISP_RELEASE_FRONT) slot->Vacate(v);
-								break;
+				case TRSCOF_PBS_RES_END_RELEASE:
+					if (input.permitted_slot_operations & TRPISP_PBS_RES_END_ACQUIRE) {
+						slot->Vacate(v);
+					} else if ((input.permitted_slot_operations & TRPISP_PBS_RES_END_ACQ_DRY) && (actions_used_flags & TRPAUF_PBS_RES_END_SIMULATE)) {
+						slot->VacateUsingTemporaryState(v->index, &_pbs_res_end_acq_dry_slot_temporary_state);
+					}
+					break;
 
-							case TRSCOF_PBS_RES_END_ACQ_WAIT:
-								if (input.permitted_slot_operations & TRPISP_PBS_RES_END_ACQUIRE) {
-									if (!slot->Occupy(v)) out.flags |= TRPRF_PBS_RES_END_WAIT;
-								} else if (input.permitted_slot_operations & TRPISP_PBS_RES_END_ACQ_DRY) {
-									if (this->actions_used_flags & TRPAUF_PBS_RES_END_SIMULATE) {
-										if (!slot->OccupyUsingTemporaryState(v->index, &pbs_res_end_acq_dry_slot_temporary_state)) out.flags |= TRPRF_PBS_RES_END_WAIT;
-									} else {
-										if (!slot->OccupyDryRun(v->index)) out.flags |= TRPRF_PBS_RES_END_WAIT;
-									}
-								}
-								break;
+				default:
+					NOT_REACHED();
+					break;
+			}
+			break;
+		}
 
-							case TRSCOF_PBS_RES_END_ACQ_TRY:
-								if (input.permitted_slot_operations & TRPISP_PBS_RES_END_ACQUIRE) {
-									slot->Occupy(v);
-								} else if ((input.permitted_slot_operations & TRPISP_PBS_RES_END_ACQ_DRY) && (this->actions_used_flags & TRPAUF_PBS_RES_END_SIMULATE)) {
-									slot->OccupyUsingTemporaryState(v->index, &pbs_res_end_acq_dry_slot_temporary_state);
-								}
-								break;
+		case TRIT_REVERSE:
+			switch (static_cast<TraceRestrictReverseValueField>(GetTraceRestrictValue(item))) {
+				case TRRVF_REVERSE:
+					out.flags |= TRPRF_REVERSE;
+					break;
 
-							case TRSCOF_PBS_RES_END_RELEASE:
-								if (input.permitted_slot_operations & TRPISP_PBS_RES_END_ACQUIRE) {
-									slot->Vacate(v);
-								} else if ((input.permitted_slot_operations & TRPISP_PBS_RES_END_ACQ_DRY) && (this->actions_used_flags & TRPAUF_PBS_RES_END_SIMULATE)) {
-									slot->VacateUsingTemporaryState(v->index, &pbs_res_end_acq_dry_slot_temporary_state);
-								}
-								break;
+				case TRRVF_CANCEL_REVERSE:
+					out.flags &= ~TRPRF_REVERSE;
+					break;
 
-							default:
-								NOT_REACHED();
-								break;
-						}
-						break;
-					}
+				default:
+					NOT_REACHED();
+					break;
+			}
+			break;
 
-					case TRIT_REVERSE:
-						switch (static_cast<TraceRestrictReverseValueField>(GetTraceRestrictValue(item))) {
-							case TRRVF_REVERSE:
-								out.flags |= TRPRF_REVERSE;
-								break;
+		case TRIT_SPEED_RESTRICTION: {
+			out.speed_restriction = GetTraceRestrictValue(item);
+			out.flags |= TRPRF_SPEED_RESTRICTION_SET;
+			break;
+		}
 
-							case TRRVF_CANCEL_REVERSE:
-								out.flags &= ~TRPRF_REVERSE;
-								break;
+		case TRIT_NEWS_CONTROL:
+			switch (static_cast<TraceRestrictNewsControlField>(GetTraceRestrictValue(item))) {
+				case TRNCF_TRAIN_NOT_STUCK:
+					out.flags |= TRPRF_TRAIN_NOT_STUCK;
+					break;
 
-							default:
-								NOT_REACHED();
-								break;
-						}
-						break;
+				case TRNCF_CANCEL_TRAIN_NOT_STUCK:
+					out.flags &= ~TRPRF_TRAIN_NOT_STUCK;
+					break;
 
-					case TRIT_SPEED_RESTRICTION: {
-						out.speed_restriction = GetTraceRestrictValue(item);
-						out.flags |= TRPRF_SPEED_RESTRICTION_SET;
-						break;
-					}
+				default:
+					NOT_REACHED();
+					break;
+			}
+			break;
 
-					case TRIT_NEWS_CONTROL:
-						switch (static_cast<TraceRestrictNewsControlField>(GetTraceRestrictValue(item))) {
-							case TRNCF_TRAIN_NOT_STUCK:
-								out.flags |= TRPRF_TRAIN_NOT_STUCK;
-								break;
+		case TRIT_COUNTER: {
+			// TRVT_COUNTER_INDEX_INT value type uses the next slot
+			uint32_t value = data[1];
+			if (!(input.permitted_slot_operations & TRPISP_CHANGE_COUNTER)) break;
+			TraceRestrictCounter *ctr = TraceRestrictCounter::GetIfValid(GetTraceRestrictValue(item));
+			if (ctr == nullptr) break;
+			ctr->ApplyUpdate(static_cast<TraceRestrictCounterCondOpField>(GetTraceRestrictCondOp(item)), value);
+			break;
+		}
 
-							case TRNCF_CANCEL_TRAIN_NOT_STUCK:
-								out.flags &= ~TRPRF_TRAIN_NOT_STUCK;
-								break;
+		case TRIT_PF_PENALTY_CONTROL:
+			switch (static_cast<TraceRestrictPfPenaltyControlField>(GetTraceRestrictValue(item))) {
+				case TRPPCF_NO_PBS_BACK_PENALTY:
+					out.flags |= TRPRF_NO_PBS_BACK_PENALTY;
+					break;
 
-							default:
-								NOT_REACHED();
-								break;
-						}
-						break;
+				case TRPPCF_CANCEL_NO_PBS_BACK_PENALTY:
+					out.flags &= ~TRPRF_NO_PBS_BACK_PENALTY;
+					break;
 
-					case TRIT_COUNTER: {
-						// TRVT_COUNTER_INDEX_INT value type uses the next slot
-						i++;
-						uint32_t value = this->items[i];
-						if (!(input.permitted_slot_operations & TRPISP_CHANGE_COUNTER)) break;
-						TraceRestrictCounter *ctr = TraceRestrictCounter::GetIfValid(GetTraceRestrictValue(item));
-						if (ctr == nullptr) break;
-						ctr->ApplyUpdate(static_cast<TraceRestrictCounterCondOpField>(GetTraceRestrictCondOp(item)), value);
-						break;
-					}
+				default:
+					NOT_REACHED();
+					break;
+			}
+			break;
 
-					case TRIT_PF_PENALTY_CONTROL:
-						switch (static_cast<TraceRestrictPfPenaltyControlField>(GetTraceRestrictValue(item))) {
-							case TRPPCF_NO_PBS_BACK_PENALTY:
-								out.flags |= TRPRF_NO_PBS_BACK_PENALTY;
-								break;
+		case TRIT_SPEED_ADAPTATION_CONTROL:
+			switch (static_cast<TraceRestrictSpeedAdaptationControlField>(GetTraceRestrictValue(item))) {
+				case TRSACF_SPEED_ADAPT_EXEMPT:
+					out.flags |= TRPRF_SPEED_ADAPT_EXEMPT;
+					out.flags &= ~TRPRF_RM_SPEED_ADAPT_EXEMPT;
+					break;
 
-							case TRPPCF_CANCEL_NO_PBS_BACK_PENALTY:
-								out.flags &= ~TRPRF_NO_PBS_BACK_PENALTY;
-								break;
+				case TRSACF_REMOVE_SPEED_ADAPT_EXEMPT:
+					out.flags &= ~TRPRF_SPEED_ADAPT_EXEMPT;
+					out.flags |= TRPRF_RM_SPEED_ADAPT_EXEMPT;
+					break;
 
-							default:
-								NOT_REACHED();
-								break;
-						}
-						break;
+				default:
+					NOT_REACHED();
+					break;
+			}
+			break;
 
-					case TRIT_SPEED_ADAPTATION_CONTROL:
-						switch (static_cast<TraceRestrictSpeedAdaptationControlField>(GetTraceRestrictValue(item))) {
-							case TRSACF_SPEED_ADAPT_EXEMPT:
-								out.flags |= TRPRF_SPEED_ADAPT_EXEMPT;
-								out.flags &= ~TRPRF_RM_SPEED_ADAPT_EXEMPT;
-								break;
+		case TRIT_SIGNAL_MODE_CONTROL:
+			switch (static_cast<TraceRestrictSignalModeControlField>(GetTraceRestrictValue(item))) {
+				case TRSMCF_NORMAL_ASPECT:
+					out.flags |= TRPRF_SIGNAL_MODE_NORMAL;
+					out.flags &= ~TRPRF_SIGNAL_MODE_SHUNT;
+					break;
 
-							case TRSACF_REMOVE_SPEED_ADAPT_EXEMPT:
-								out.flags &= ~TRPRF_SPEED_ADAPT_EXEMPT;
-								out.flags |= TRPRF_RM_SPEED_ADAPT_EXEMPT;
-								break;
+				case TRSMCF_SHUNT_ASPECT:
+					out.flags &= ~TRPRF_SIGNAL_MODE_NORMAL;
+					out.flags |= TRPRF_SIGNAL_MODE_SHUNT;
+					break;
 
-							default:
-								NOT_REACHED();
-								break;
-						}
-						break;
+				default:
+					NOT_REACHED();
+					break;
+			}
+			break;
 
-					case TRIT_SIGNAL_MODE_CONTROL:
-						switch (static_cast<TraceRestrictSignalModeControlField>(GetTraceRestrictValue(item))) {
-							case TRSMCF_NORMAL_ASPECT:
-								out.flags |= TRPRF_SIGNAL_MODE_NORMAL;
-								out.flags &= ~TRPRF_SIGNAL_MODE_SHUNT;
-								break;
+		default:
+			NOT_REACHED();
+	}
+}
 
-							case TRSMCF_SHUNT_ASPECT:
-								out.flags &= ~TRPRF_SIGNAL_MODE_NORMAL;
-								out.flags |= TRPRF_SIGNAL_MODE_SHUNT;
-								break;
+/**
+ * Execute program on train and store results in out
+ * This uses the compiled form of the program, see TraceRestrictProgram::Compile, and does not allocate.
+ * Execution is thread safe as long as @p input does not permit any slot or counter operations.
+ * @p v may not be nullptr
+ * @p out should be zero-initialised
+ */
+void TraceRestrictProgram::Execute(const Train* v, const TraceRestrictProgramInput &input, TraceRestrictProgramResult& out) const
+{
+	TraceRestrictExecuteState state;
+	const TraceRestrictItem *items = this->items.data();
+	const TraceRestrictCompiledInstruction *compiled = this->compiled.data();
+
+	/* Find where to continue after the condition of a branch of a conditional block was false,
+	 * @p pc is the next elif/orif/else/endif of the block */
+	auto find_active_branch = [&](uint32_t pc) -> uint32_t {
+		while (true) {
+			const TraceRestrictCompiledInstruction &insn = compiled[pc];
+			if (insn.kind != TRIK_ELIF && insn.kind != TRIK_ORIF) return pc + 1;
+			if (EvaluateTraceRestrictCondition(v, input, items + insn.offset, state)) return pc + 1;
+			pc = insn.next;
+		}
+	};
+
+	const uint32_t count = (uint32_t)this->compiled.size();
+	uint32_t pc = 0;
+	while (pc < count) {
+		const TraceRestrictCompiledInstruction &insn = compiled[pc];
+		switch (insn.kind) {
+			case TRIK_ACTION:
+				ApplyTraceRestrictAction(v, input, items + insn.offset, this->actions_used_flags, out);
+				pc++;
+				break;
 
-							default:
-								NOT_REACHED();
-								break;
-						}
-						break;
+			case TRIK_IF:
+				pc = EvaluateTraceRestrictCondition(v, input, items + insn.offset, state) ? pc + 1 : find_active_branch(insn.next);
+				break;
 
-					default:
-						NOT_REACHED();
-				}
-			} else {
-				if (IsTraceRestrictDoubleItem(type)) i++;
-			}
+			case TRIK_ORIF:
+			case TRIK_ENDIF:
+				/* Reached from an active branch, which remains active */
+				pc++;
+				break;
+
+			case TRIK_ELIF:
+			case TRIK_ELSE:
+				/* Reached from an active branch, no later branch of the block is active */
+				pc = insn.end + 1;
+				break;
+
+			default:
+				NOT_REACHED();
 		}
 	}
 	if ((input.permitted_slot_operations & TRPISP_PBS_RES_END_ACQ_DRY) && (this->actions_used_flags & TRPAUF_PBS_RES_END_SIMULATE)) {
-		pbs_res_end_acq_dry_slot_temporary_state.RevertTemporaryChanges(v->index);
+		_pbs_res_end_acq_dry_slot_temporary_state.RevertTemporaryChanges(v->index);
+	}
+}
+
+/**
+ * Compile the instruction list into the form used by Execute.
+ * This resolves the jumps between the if/elif/orif/else/endif instructions of each conditional block,
+ * so that execution does not need a condition stack, and does not need to visit inactive branches.
+ * The compiled instructions refer to the instruction list, so in-place changes to instruction values do not require re-compilation.
+ * The instruction list must be valid.
+ */
+void TraceRestrictProgram::Compile()
+{
+	this->compiled.clear();
+
+	/* Index of the if, and of the most recent if/elif/orif/else, of each open conditional block */
+	std::vector<std::pair<uint32_t, uint32_t>> blocks;
+
+	const size_t size = this->items.size();
+	for (size_t i = 0; i < size; i++) {
+		const TraceRestrictItem item = this->items[i];
+		const uint32_t index = (uint32_t)this->compiled.size();
+		TraceRestrictCompiledInstruction &insn = this->compiled.emplace_back();
+		insn.offset = (uint32_t)i;
+		insn.next = 0;
+		insn.end = 0;
+		if (IsTraceRestrictDoubleItem(item)) i++;
+
+		if (!IsTraceRestrictConditional(item)) {
+			insn.kind = TRIK_ACTION;
+			continue;
+		}
+
+		const TraceRestrictCondFlags condflags = GetTraceRestrictCondFlags(item);
+		if (GetTraceRestrictType(item) == TRIT_COND_ENDIF) {
+			insn.kind = (condflags & TRCF_ELSE) ? TRIK_ELSE : TRIK_ENDIF;
+		} else if (condflags & TRCF_OR) {
+			insn.kind = TRIK_ORIF;
+		} else if (condflags & TRCF_ELSE) {
+			insn.kind = TRIK_ELIF;
+		} else {
+			insn.kind = TRIK_IF;
+			blocks.emplace_back(index, index);
+			continue;
+		}
+
+		assert(!blocks.empty());
+		this->compiled[blocks.back().second].next = index;
+		blocks.back().second = index;
+		if (insn.kind == TRIK_ENDIF) {
+			for (uint32_t j = blocks.back().first; j != index; j = this->compiled[j].next) {
+				this->compiled[j].end = index;
+			}
+			insn.end = index;
+			blocks.pop_back();
+		}
 	}
-	assert(condstack.empty());
+	assert(blocks.empty());
 }
 
 void TraceRestrictProgram::ClearRefIds()
@@ -2219,6 +2310,7 @@ CommandCost CmdProgramSignalTraceRestrict(TileIndex tile, DoCommandFlag flags, u
 		// move in modified program
 		prog->items.swap(items);
 		prog->actions_used_flags = actions_used_flags;
+		prog->Compile();
 
 		if (prog->items.size() == 0 && prog->refcount == 1) {
 			// program is empty, and this tile is the only reference to it
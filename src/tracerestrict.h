@@ -582,6 +582,27 @@ struct TraceRestrictProgramResult {
 			: penalty(0), flags(static_cast<TraceRestrictProgramResultFlags>(0)) { }
 };
 
+/** Kind of a compiled instruction, see TraceRestrictProgram::Compile */
+enum TraceRestrictInstructionKind : uint8_t {
+	TRIK_ACTION,                  ///< Non-conditional instruction
+	TRIK_IF,                      ///< If, starts a conditional block
+	TRIK_ELIF,                    ///< Else if
+	TRIK_ORIF,                    ///< Or if
+	TRIK_ELSE,                    ///< Else
+	TRIK_ENDIF,                   ///< End if, ends a conditional block
+};
+
+/**
+ * Compiled instruction, see TraceRestrictProgram::Compile
+ * This refers to the instruction in the instruction list, and stores the resolved jumps of conditional instructions.
+ */
+struct TraceRestrictCompiledInstruction {
+	uint32_t offset;                     ///< Array offset of the instruction in the instruction list
+	uint32_t next;                       ///< Conditionals only: index of the next elif/orif/else/endif of the same block
+	uint32_t end;                        ///< Conditionals only: index of the endif of the block
+	TraceRestrictInstructionKind kind;   ///< Kind of instruction
+};
+
 /**
  * Program type, this stores the instruction list
  * This is refcounted, see info at top of tracerestrict.cpp
@@ -592,6 +613,7 @@ struct TraceRestrictProgram : TraceRestrictProgramPool::PoolItem<&_tracerestrict
 	TraceRestrictProgramActionsUsedFlags actions_used_flags;
 
 private:
+	std::vector<TraceRestrictCompiledInstruction> compiled;
 
 	struct ptr_buffer {
 		TraceRestrictRefId *buffer;
@@ -623,6 +645,8 @@ public:
 
 	void Execute(const Train *v, const TraceRestrictProgramInput &input, TraceRestrictProgramResult &out) const;
 
+	void Compile();
+
 	inline const TraceRestrictRefId *GetRefIdsPtr() const { return const_cast<TraceRestrictProgram *>(this)->GetRefIdsPtr(); }
 
 	void IncrementRefCount(TraceRestrictRefId ref_id);
@@ -671,10 +695,12 @@ public:
 		return items.begin() + TraceRestrictProgram::InstructionOffsetToArrayOffset(items, instruction_offset);
 	}
 
-	/** Call validation function on current program instruction list and set actions_used_flags */
+	/** Call validation function on current program instruction list and set actions_used_flags, and compile it if it is valid */
 	CommandCost Validate()
 	{
-		return TraceRestrictProgram::Validate(items, actions_used_flags);
+		CommandCost result = TraceRestrictProgram::Validate(this->items, this->actions_used_flags);
+		if (result.Succeeded()) this->Compile();
+		return result;
 	}
 };
 
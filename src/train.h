@@ -90,6 +90,8 @@ void GetTrainSpriteSize(EngineID engine, uint &width, uint &height, int &xoffs,
 
 bool TrainOnCrossing(TileIndex tile);
 void NormalizeTrainVehInDepot(const Train *u);
+void PlanTrainTicks(const std::vector<Train *> &fronts);
+void SetCurrentTrainTickPlan(size_t index);
 
 inline int GetTrainRealisticBrakingTargetDecelerationLimit(int acceleration_type)
 {
@@ -46,6 +46,7 @@
 #include "debug_settings.h"
 #include "train_speed_adaptation.h"
 #include "event_logs.h"
+#include "worker_thread.h"
 #include "3rdparty/cpp-btree/btree_map.h"
 
 #include "table/strings.h"
@@ -3269,6 +3270,7 @@ static FindDepotData FindClosestTrainDepot(Train *v, int max_distance)
 	PBSTileInfo origin = FollowTrainReservation(v, nullptr, FTRF_OKAY_UNUSED);
 	if (IsRailDepotTile(origin.tile)) return FindDepotData(origin.tile, 0);
 
+	PerformanceZoneMeasurer framerate(PFZ_TRAIN_PATHFINDER);
 	switch (_settings_game.pf.pathfinder_for_trains) {
 		case VPF_NPF: return NPFTrainFindNearestDepot(v, max_distance);
 		case VPF_YAPF: return YapfTrainFindNearestDepot(v, max_distance);
@@ -3820,6 +3822,7 @@ static Track DoTrainPathfind(const Train *v, TileIndex tile, DiagDirection enter
 {
 	if (final_dest != nullptr) *final_dest = INVALID_TILE;
 
+	PerformanceZoneMeasurer framerate(PFZ_TRAIN_PATHFINDER);
 	switch (_settings_game.pf.pathfinder_for_trains) {
 		case VPF_NPF: return NPFTrainChooseTrack(v, path_found, do_track_reservation, dest);
 		case VPF_YAPF: return YapfTrainChooseTrack(v, tile, enterdir, tracks, path_found, do_track_reservation, dest, final_dest);
@@ -3964,6 +3967,7 @@ static PBSTileInfo ExtendTrainReservation(const Train *v, const PBSTileInfo &ori
  */
 static bool TryReserveSafeTrack(const Train *v, TileIndex tile, Trackdir td, bool override_railtype)
 {
+	PerformanceZoneMeasurer framerate(PFZ_TRAIN_PATHFINDER);
 	switch (_settings_game.pf.pathfinder_for_trains) {
 		case VPF_NPF: return NPFTrainFindNearestSafeTile(v, tile, td, override_railtype);
 		case VPF_YAPF: return YapfTrainFindNearestSafeTile(v, tile, td, override_railtype);
@@ -4773,6 +4777,7 @@ static bool CheckReverseTrain(const Train *v)
 
 	dbg_assert(v->track != TRACK_BIT_NONE);
 
+	PerformanceZoneMeasurer framerate(PFZ_TRAIN_PATHFINDER);
 	switch (_settings_game.pf.pathfinder_for_trains) {
 		case VPF_NPF: return NPFTrainCheckReverse(v);
 		case VPF_YAPF: return YapfTrainCheckReverse(v);
@@ -6600,6 +6605,212 @@ Money Train::CalculateCurrentOverallValue() const
 	return ovr_value;
 }
 
+/**
+ * Speed limits of a train which were calculated in the parallel plan phase before the serial train tick loop.
+ * The key and the copy of the look ahead items hold all of the train state which the calculation depends on,
+ * the planned result is only used if both still match when the train's tick reaches the speed calculation.
+ */
+struct TrainTickPlan {
+	struct Key {
+		const TrainReservationLookAhead *lookahead;
+		int32_t current_position;
+		int32_t reservation_end_position;
+		int32_t lookahead_end_position;
+		int32_t cached_zpos;
+		int16_t reservation_end_z;
+		int16_t tunnel_bridge_reserved_tiles;
+		uint16_t lookahead_flags;
+		uint16_t lookahead_speed_restriction;
+		uint8_t zpos_refresh_remaining;
+		uint64_t current_order;
+		uint16_t current_order_max_speed;
+		VehicleOrderID cur_real_order_index;
+		StationID last_station_visited;
+		uint32_t flags;
+		uint8_t vehstatus;
+		uint16_t cached_max_track_speed;
+		uint16_t cached_max_curve_speed;
+		uint16_t cached_uncapped_decel;
+		uint8_t cached_deceleration;
+		uint16_t cached_total_length;
+		uint16_t speed_restriction;
+		uint16_t signal_speed_restriction;
+		uint16_t reverse_distance;
+
+		bool operator==(const Key &) const = default;
+	};
+
+	const Train *train;
+	Key key;
+	std::vector<TrainReservationLookAheadItem> lookahead_items;
+	Train::MaxSpeedInfo max_speed_info;
+	bool valid;
+
+	bool Matches(const Train *v) const;
+};
+
+static std::vector<TrainTickPlan> _train_tick_plans;
+static const TrainTickPlan *_current_train_tick_plan = nullptr;
+
+static TrainTickPlan::Key GetTrainTickPlanKey(const Train *v)
+{
+	const TrainReservationLookAhead *lookahead = v->lookahead.get();
+	return {
+		lookahead,
+		lookahead->current_position,
+		lookahead->reservation_end_position,
+		lookahead->lookahead_end_position,
+		lookahead->cached_zpos,
+		lookahead->reservation_end_z,
+		lookahead->tunnel_bridge_reserved_tiles,
+		lookahead->flags,
+		lookahead->speed_restriction,
+		lookahead->zpos_refresh_remaining,
+		v->current_order.Pack(),
+		v->current_order.GetMaxSpeed(),
+		v->cur_real_order_index,
+		v->last_station_visited,
+		v->flags,
+		v->vehstatus,
+		v->gcache.cached_max_track_speed,
+		v->tcache.cached_max_curve_speed,
+		v->tcache.cached_uncapped_decel,
+		v->tcache.cached_deceleration,
+		v->gcache.cached_total_length,
+		v->speed_restriction,
+		v->signal_speed_restriction,
+		v->reverse_distance,
+	};
+}
+
+/**
+ * Check whether the train state which the plan was calculated from is unchanged.
+ * @param v The front engine.
+ * @return True if the planned result can be used.
+ */
+bool TrainTickPlan::Matches(const Train *v) const
+{
+	if (!this->valid || !(this->key == GetTrainTickPlanKey(v))) return false;
+	const ring_buffer<TrainReservationLookAheadItem> &items = v->lookahead->items;
+	return std::equal(items.begin(), items.end(), this->lookahead_items.begin(), this->lookahead_items.end());
+}
+
+/**
+ * Check whether the speed limits of a train can be calculated in the plan phase.
+ * This excludes trains for which GetCurrentMaxSpeedInfoAndUpdate() would modify state, or for which the calculation
+ * depends on state outside of the train itself which may be changed by other trains ticking first.
+ * @param v The front engine.
+ * @return True if the speed limits can be planned.
+ */
+static bool CanPlanTrainTick(const Train *v)
+{
+	if (v->vehstatus & (VS_CRASHED | VS_STOPPED)) return false;
+	if (!v->UsingRealisticBraking() || v->lookahead == nullptr) return false;
+	if (v->lookahead->zpos_refresh_remaining == 0) return false;
+	if (v->flags & ((1 << VRF_CONSIST_SPEED_REDUCTION) | (1 << VRF_CONSIST_BREAKDOWN) | (1 << VRF_BREAKDOWN_SPEED) | (1 << VRF_REVERSING))) return false;
+	if (v->reverse_distance >= 1) return false;
+
+	/* Advancing the order index over a station in the look ahead evaluates conditional orders and depot servicing, both of which read global state */
+	bool has_station_item = false;
+	for (const TrainReservationLookAheadItem &item : v->lookahead->items) {
+		if (item.type == TRLIT_STATION) {
+			has_station_item = true;
+			break;
+		}
+	}
+	if (has_station_item) {
+		for (VehicleOrderID i = 0; i < v->GetNumOrders(); i++) {
+			const Order *order = v->GetOrder(i);
+			if (order->IsType(OT_CONDITIONAL)) return false;
+			if (order->IsType(OT_GOTO_DEPOT) && (order->GetDepotOrderType() & ODTFB_SERVICE)) return false;
+		}
+	}
+
+	return true;
+}
+
+static void PlanTrainTickRange(TrainTickPlan *begin, TrainTickPlan *end)
+{
+	for (TrainTickPlan *plan = begin; plan != end; ++plan) {
+		const Train *v = plan->train;
+		plan->valid = CanPlanTrainTick(v);
+		if (!plan->valid) continue;
+		plan->key = GetTrainTickPlanKey(v);
+		plan->lookahead_items.assign(v->lookahead->items.begin(), v->lookahead->items.end());
+		plan->max_speed_info = v->GetCurrentMaxSpeedInfo();
+	}
+}
+
+/**
+ * Plan phase of the train tick loop.
+ * Calculate the look ahead speed limits of the trains which are about to be ticked, in parallel on the worker thread pool.
+ * This only reads state, the train tick loop which follows applies the results in the usual order, for any trains whose state still matches.
+ * @param fronts Front engines in tick order.
+ */
+void PlanTrainTicks(const std::vector<Train *> &fronts)
+{
+	static const size_t PLAN_CHUNK_SIZE = 128;
+
+	_current_train_tick_plan = nullptr;
+	_train_tick_plans.clear();
+	if (HasChickenBit(DCBF_NO_TRAIN_TICK_PLAN) || _settings_game.vehicle.train_braking_model != TBM_REALISTIC) return;
+
+	uint workers = _general_worker_pool.GetWorkerCount();
+	if (workers == 0 || fronts.size() < PLAN_CHUNK_SIZE * 2) return;
+
+	_train_tick_plans.resize(fronts.size());
+	for (size_t i = 0; i < fronts.size(); i++) {
+		_train_tick_plans[i].train = fronts[i];
+	}
+
+	size_t chunks = std::min<size_t>(workers + 1, CeilDivT<size_t>(fronts.size(), PLAN_CHUNK_SIZE));
+	size_t chunk_size = CeilDivT<size_t>(fronts.size(), chunks);
+
+	TrainTickPlan *plans = _train_tick_plans.data();
+	ParallelFor(0, fronts.size(), chunk_size, [plans](size_t begin, size_t end) {
+		PlanTrainTickRange(plans + begin, plans + end);
+	});
+}
+
+/**
+ * Set the plan to use for the train which is about to be ticked.
+ * @param index Index of the train in the vector passed to PlanTrainTicks, or SIZE_MAX to clear.
+ */
+void SetCurrentTrainTickPlan(size_t index)
+{
+	_current_train_tick_plan = (index < _train_tick_plans.size()) ? &_train_tick_plans[index] : nullptr;
+}
+
+/**
+ * Commit phase counterpart of GetCurrentMaxSpeedInfoAndUpdate, using the planned result if it is still valid.
+ * @param v The front engine.
+ * @return The speed limits.
+ */
+static Train::MaxSpeedInfo GetTrainTickMaxSpeedInfo(Train *v)
+{
+	const TrainTickPlan *plan = _current_train_tick_plan;
+	if (plan == nullptr || plan->train != v) return v->GetCurrentMaxSpeedInfoAndUpdate();
+
+	/* Only the first speed calculation in the tick can use the plan */
+	_current_train_tick_plan = nullptr;
+	if (!plan->Matches(v)) return v->GetCurrentMaxSpeedInfoAndUpdate();
+
+	if (HasChickenBit(DCBF_TRAIN_TICK_PLAN_CHECK)) {
+		Train::MaxSpeedInfo info = v->GetCurrentMaxSpeedInfoAndUpdate();
+		if (info.strict_max_speed != plan->max_speed_info.strict_max_speed || info.advisory_max_speed != plan->max_speed_info.advisory_max_speed) {
+			char buffer[256];
+			seprintf(buffer, lastof(buffer), "CACHE ERROR: Train tick plan mismatch: %s, veh: %u, planned: %d, %d, actual: %d, %d", debug_date_dumper().HexDate(), v->index,
+					plan->max_speed_info.strict_max_speed, plan->max_speed_info.advisory_max_speed, info.strict_max_speed, info.advisory_max_speed);
+			DEBUG(desync, 0, "%s", buffer);
+			LogDesyncMsg(buffer);
+			dbg_assert_msg(false, "%s", buffer);
+		}
+		return info;
+	}
+
+	return plan->max_speed_info;
+}
+
 static bool TrainLocoHandler(Train *v, bool mode)
 {
 	/* train has crashed? */
@@ -6733,7 +6944,7 @@ static bool TrainLocoHandler(Train *v, bool mode)
 
 	int j;
 	{
-		Train::MaxSpeedInfo max_speed_info = v->GetCurrentMaxSpeedInfoAndUpdate();
+		Train::MaxSpeedInfo max_speed_info = GetTrainTickMaxSpeedInfo(v);
 
 		if (!mode) v->ShowVisualEffect(std::min(max_speed_info.strict_max_speed, max_speed_info.advisory_max_speed));
 		j = v->UpdateSpeed(max_speed_info);
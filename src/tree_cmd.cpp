@@ -893,6 +893,40 @@ static bool IsTemperateTreeOnSnow(TileIndex tile)
 	return false;
 }
 
+/** @see TileLoopQuiescentProc */
+static bool IsTileLoopQuiescent_Trees(TileIndex tile)
+{
+	const TreeGround ground = GetTreeGround(tile);
+	if (ground == TREE_GROUND_SHORE) return false;
+
+	switch (_settings_game.game_creation.landscape) {
+		case LT_TROPIC:
+			switch (GetTropicZone(tile)) {
+				case TROPICZONE_DESERT:
+					if (ground != TREE_GROUND_SNOW_DESERT) return false;
+					break;
+
+				case TROPICZONE_RAINFOREST:
+					/* Rainforest sounds use the game random */
+					return false;
+
+				default:
+					break;
+			}
+			break;
+
+		case LT_ARCTIC:
+			if ((int)TileHeight(tile) >= GetSnowLine() - 1 || ground == TREE_GROUND_SNOW_DESERT || ground == TREE_GROUND_ROUGH_SNOW) return false;
+			break;
+	}
+
+	/* See TileLoop_Trees */
+	const uint32_t cycle = (uint32_t)((tile % 31) + (_tick_counter >> 8));
+	if ((cycle & 7) == 7 && ground == TREE_GROUND_GRASS && GetTreeDensity(tile) < 3) return false;
+	if ((cycle & 15) < 15) return true;
+	return _settings_game.construction.extra_tree_placement == ETP_NO_GROWTH_NO_SPREAD || _settings_game.construction.tree_growth_rate == 4;
+}
+
 static void TileLoop_Trees(TileIndex tile)
 {
 	if (GetTreeGround(tile) == TREE_GROUND_SHORE) {
@@ -1135,4 +1169,5 @@ extern const TileTypeProcs _tile_type_trees_procs = {
 	nullptr,                     // vehicle_enter_tile_proc
 	GetFoundation_Trees,      // get_foundation_proc
 	TerraformTile_Trees,      // terraform_tile_proc
+	IsTileLoopQuiescent_Trees, // tile_loop_quiescent_proc
 };
@@ -63,6 +63,7 @@
 #include "network/network_sync.h"
 #include "pathfinder/water_regions.h"
 #include "event_logs.h"
+#include "vehicle_tile_grid.h"
 #include "3rdparty/cpp-btree/btree_set.h"
 #include "3rdparty/cpp-btree/btree_map.h"
 #include "3rdparty/robin_hood/robin_hood.h"
@@ -500,24 +501,28 @@ Vehicle::Vehicle(VehicleType type)
 	this->vcache.cached_veh_flags = 0;
 }
 
-using VehicleTypeTileHash = robin_hood::unordered_map<TileIndex, VehicleID>;
-static std::array<VehicleTypeTileHash, 4> _vehicle_tile_hashes;
+static std::array<VehicleTileGrid, 4> _vehicle_tile_grids;
 
-static Vehicle *VehicleFromTileHash(int xl, int yl, int xu, int yu, VehicleType type, void *data, VehicleFromPosProc *proc, bool find_first)
+/**
+ * Get the first vehicle of a type on a tile in the vehicle tile hash.
+ * @param tile The tile, tiles outside the map are empty.
+ * @param type The vehicle type.
+ * @return The first vehicle, or nullptr if there are none.
+ */
+static inline Vehicle *GetFirstVehicleInTileHash(TileIndex tile, VehicleType type)
 {
-	VehicleTypeTileHash &vhash = _vehicle_tile_hashes[type];
+	if (tile >= MapSize()) return nullptr;
+	VehicleID id = _vehicle_tile_grids[type].Find(TileX(tile), TileY(tile));
+	return id != INVALID_VEHICLE ? Vehicle::Get(id) : nullptr;
+}
 
+static Vehicle *VehicleFromTileHash(int xl, int yl, int xu, int yu, VehicleType type, void *data, VehicleFromPosProc *proc, bool find_first)
+{
 	for (int y = yl; ; y++) {
 		for (int x = xl; ; x++) {
-			auto iter = vhash.find(TileXY(x, y));
-			if (iter != vhash.end()) {
-				Vehicle *v = Vehicle::Get(iter->second);
-				do {
-					Vehicle *a = proc(v, data);
-					if (find_first && a != nullptr) return a;
-
-					v = v->hash_tile_next;
-				} while (v != nullptr);
+			for (Vehicle *v = GetFirstVehicleInTileHash(TileXY(x, y), type); v != nullptr; v = v->hash_tile_next) {
+				Vehicle *a = proc(v, data);
+				if (find_first && a != nullptr) return a;
 			}
 			if (x == xu) break;
 		}
@@ -527,7 +532,6 @@ static Vehicle *VehicleFromTileHash(int xl, int yl, int xu, int yu, VehicleType
 	return nullptr;
 }
 
-
 /**
  * Helper function for FindVehicleOnPos/HasVehicleOnPos.
  * @note Do not call this function directly!
@@ -564,17 +568,9 @@ Vehicle *VehicleFromPosXY(int x, int y, VehicleType type, void *data, VehicleFro
  */
 Vehicle *VehicleFromPos(TileIndex tile, VehicleType type, void *data, VehicleFromPosProc *proc, bool find_first)
 {
-	VehicleTypeTileHash &vhash = _vehicle_tile_hashes[type];
-
-	auto iter = vhash.find(tile);
-	if (iter != vhash.end()) {
-		Vehicle *v = Vehicle::Get(iter->second);
-		do {
-			Vehicle *a = proc(v, data);
-			if (find_first && a != nullptr) return a;
-
-			v = v->hash_tile_next;
-		} while (v != nullptr);
+	for (Vehicle *v = GetFirstVehicleInTileHash(tile, type); v != nullptr; v = v->hash_tile_next) {
+		Vehicle *a = proc(v, data);
+		if (find_first && a != nullptr) return a;
 	}
 
 	return nullptr;
@@ -878,7 +874,7 @@ void UpdateVehicleTileHash(Vehicle *v, bool remove)
 
 	if (old_hash_tile == new_hash_tile) return;
 
-	VehicleTypeTileHash &vhash = _vehicle_tile_hashes[v->type];
+	VehicleTileGrid &grid = _vehicle_tile_grids[v->type];
 
 	/* Remove from the old position in the hash table */
 	if (old_hash_tile != INVALID_TILE) {
@@ -888,28 +884,20 @@ void UpdateVehicleTileHash(Vehicle *v, bool remove)
 		} else {
 			/* This was the first vehicle in the chain */
 			if (v->hash_tile_next != nullptr) {
-				vhash[old_hash_tile] = v->hash_tile_next->index;
+				grid.Set(TileX(old_hash_tile), TileY(old_hash_tile), v->hash_tile_next->index);
 			} else {
-				vhash.erase(old_hash_tile);
+				grid.Erase(TileX(old_hash_tile), TileY(old_hash_tile));
 			}
 		}
 	}
 
 	/* Insert vehicle at beginning of the new position in the hash table */
 	if (new_hash_tile != INVALID_TILE) {
-		auto res = vhash.insert({ new_hash_tile, v->index });
-		if (res.second) {
-			/* Insert took place */
-			v->hash_tile_next = nullptr;
-			v->hash_tile_prev = nullptr;
-		} else {
-			/* Key already existed */
-			Vehicle *next = Vehicle::Get(res.first->second);
-			next->hash_tile_prev = v;
-			v->hash_tile_next = next;
-			v->hash_tile_prev = nullptr;
-			res.first->second = v->index;
-		}
+		Vehicle *next = GetFirstVehicleInTileHash(new_hash_tile, v->type);
+		if (next != nullptr) next->hash_tile_prev = v;
+		v->hash_tile_next = next;
+		v->hash_tile_prev = nullptr;
+		grid.Set(TileX(new_hash_tile), TileY(new_hash_tile), v->index);
 	}
 
 	/* Remember current hash tile */
@@ -927,10 +915,7 @@ bool ValidateVehicleTileHash(const Vehicle *v)
 
 	if (v->hash_tile_current != v->tile) return false;
 
-	auto iter = _vehicle_tile_hashes[v->type].find(v->hash_tile_current);
-	if (iter == _vehicle_tile_hashes[v->type].end()) return false;
-
-	for (const Vehicle *u = Vehicle::GetIfValid(iter->second); u != nullptr; u = u->hash_tile_next) {
+	for (const Vehicle *u = GetFirstVehicleInTileHash(v->hash_tile_current, v->type); u != nullptr; u = u->hash_tile_next) {
 		if (u == v) return true;
 	}
 
@@ -1016,11 +1001,66 @@ void ResetVehicleHash()
 		v->hash_tile_current = INVALID_TILE;
 	}
 	memset(_vehicle_viewport_hash, 0, sizeof(_vehicle_viewport_hash));
-	for (VehicleTypeTileHash &vhash : _vehicle_tile_hashes) {
-		vhash.clear();
+	for (VehicleTileGrid &grid : _vehicle_tile_grids) {
+		grid.Reset(MapLogX(), MapLogY());
+	}
+}
+
+/** Resize the vehicle tile hash for the current map size, this must only be done when there are no vehicles. */
+void InitializeVehicleTileHash()
+{
+	for (VehicleTileGrid &grid : _vehicle_tile_grids) {
+		grid.Reset(MapLogX(), MapLogY());
 	}
 }
 
+/**
+ * Benchmark lookups of every tile of the map in the vehicle tile hash, against the same lookups in a hash map with the same contents.
+ * @param iterations Number of passes over the map.
+ * @return The benchmark result.
+ */
+VehicleTileHashBenchmarkResult BenchmarkVehicleTileHash(uint iterations)
+{
+	VehicleTileHashBenchmarkResult result;
+
+	std::array<robin_hood::unordered_map<TileIndex, VehicleID>, 4> hashes;
+	for (const Vehicle *v : Vehicle::Iterate()) {
+		if (v->type >= VEH_COMPANY_END || v->hash_tile_current == INVALID_TILE || v->hash_tile_prev != nullptr) continue;
+		hashes[v->type][v->hash_tile_current] = v->index;
+		result.occupied_tiles++;
+	}
+
+	const uint map_size = MapSize();
+	uint64_t grid_sum = 0;
+	uint64_t hash_sum = 0;
+
+	auto start = std::chrono::steady_clock::now();
+	for (uint i = 0; i < iterations; i++) {
+		for (const VehicleTileGrid &grid : _vehicle_tile_grids) {
+			for (TileIndex tile = 0; tile < map_size; tile++) {
+				VehicleID id = grid.Find(TileX(tile), TileY(tile));
+				if (id != INVALID_VEHICLE) grid_sum += id + tile;
+			}
+		}
+	}
+	result.grid_time = std::chrono::steady_clock::now() - start;
+
+	start = std::chrono::steady_clock::now();
+	for (uint i = 0; i < iterations; i++) {
+		for (const auto &hash : hashes) {
+			for (TileIndex tile = 0; tile < map_size; tile++) {
+				auto iter = hash.find(tile);
+				if (iter != hash.end()) hash_sum += iter->second + tile;
+			}
+		}
+	}
+	result.hash_time = std::chrono::steady_clock::now() - start;
+
+	result.lookups = (uint64_t)iterations * map_size * hashes.size();
+	result.mismatch = (grid_sum != hash_sum);
+	return result;
+}
+
 void ResetVehicleColourMap()
 {
 	for (Vehicle *v : Vehicle::Iterate()) { v->colourmap = PAL_NONE; }
@@ -1672,8 +1712,11 @@ void CallVehicleTicks()
 	if (!_tick_effect_veh_cache.empty()) RecordSyncEvent(NSRE_VEH_EFFECT);
 	{
 		PerformanceMeasurer framerate(PFE_GL_TRAINS);
-		for (Train *front : _tick_train_front_cache) {
+		PlanTrainTicks(_tick_train_front_cache);
+		for (size_t i = 0; i < _tick_train_front_cache.size(); i++) {
+			Train *front = _tick_train_front_cache[i];
 			v = front;
+			SetCurrentTrainTickPlan(i);
 			if (!front->Train::Tick()) continue;
 			for (Train *u = front; u != nullptr; u = u->Next()) {
 				u->tick_counter++;
@@ -1681,6 +1724,7 @@ void CallVehicleTicks()
 				if (u->IsEngine() && !((front->vehstatus & VS_STOPPED) && front->cur_speed == 0)) VehicleTickMotion(u, front);
 			}
 		}
+		SetCurrentTrainTickPlan(SIZE_MAX);
 	}
 	RecordSyncEvent(NSRE_VEH_TRAIN);
 	{
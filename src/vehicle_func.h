@@ -20,6 +20,7 @@
 #include "track_type.h"
 #include "livery.h"
 #include "cargo_type.h"
+#include <chrono>
 #include <vector>
 
 #define is_custom_sprite(x) (x >= 0xFD)
@@ -124,6 +125,17 @@ uint8_t CalcPercentVehicleFilledOfCargo(const Vehicle *v, CargoID cargo);
 void VehicleLengthChanged(const Vehicle *u);
 
 void ResetVehicleHash();
+void InitializeVehicleTileHash();
+
+/** Result of BenchmarkVehicleTileHash. */
+struct VehicleTileHashBenchmarkResult {
+	uint64_t lookups = 0;         ///< Number of lookups made in each structure.
+	uint64_t occupied_tiles = 0;  ///< Number of occupied tiles, summed over all vehicle types.
+	std::chrono::steady_clock::duration grid_time{}; ///< Time taken by the vehicle tile grid.
+	std::chrono::steady_clock::duration hash_time{}; ///< Time taken by the equivalent hash map.
+	bool mismatch = false;        ///< Whether the grid and hash map returned different vehicles.
+};
+VehicleTileHashBenchmarkResult BenchmarkVehicleTileHash(uint iterations);
 void ResetVehicleColourMap();
 
 uint8_t GetBestFittingSubType(const Vehicle *v_from, Vehicle *v_for, CargoID dest_cargo_type);
@@ -0,0 +1,131 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file vehicle_tile_grid.h Flat spatial grid of the first vehicle on each tile. */
+
+#ifndef VEHICLE_TILE_GRID_H
+#define VEHICLE_TILE_GRID_H
+
+#include "vehicle_type.h"
+#include "core/bitmath_func.hpp"
+
+#include <array>
+#include <memory>
+#include <vector>
+
+/**
+ * Flat spatial grid of the first vehicle on each tile, used for the vehicle tile hash.
+ *
+ * The map is divided into blocks of 64x64 tiles, which are allocated when a vehicle first enters them.
+ * Each block has an occupancy bitmap with one bit per tile, so that empty tiles are rejected with a single bit test,
+ * and a dense list of the first vehicle on each occupied tile in tile order, indexed by the rank of the tile's bit in the bitmap.
+ */
+class VehicleTileGrid {
+public:
+	static constexpr uint BLOCK_EDGE_LOG = 6;
+	static constexpr uint BLOCK_EDGE = 1 << BLOCK_EDGE_LOG;
+	static constexpr uint BLOCK_EDGE_MASK = BLOCK_EDGE - 1;
+
+private:
+	struct Block {
+		std::array<uint64_t, BLOCK_EDGE> occupancy{}; ///< One bit per tile, one word per row.
+		std::array<uint16_t, BLOCK_EDGE> row_base{};  ///< Index in #heads of the first occupied tile of each row.
+		std::vector<VehicleID> heads;                 ///< First vehicle of each occupied tile, in tile order.
+
+		inline uint GetRank(uint row, uint col) const
+		{
+			return this->row_base[row] + CountBits(this->occupancy[row] & ((uint64_t(1) << col) - 1));
+		}
+	};
+
+	std::vector<std::unique_ptr<Block>> blocks; ///< Blocks, row by row, nullptr for blocks which were never occupied.
+	uint blocks_x_log = 0;                      ///< Log2 of the number of blocks in the X direction.
+	uint blocks_y = 0;                          ///< Number of blocks in the Y direction.
+
+	inline Block *GetBlock(uint x, uint y) const
+	{
+		uint bx = x >> BLOCK_EDGE_LOG;
+		uint by = y >> BLOCK_EDGE_LOG;
+		if (bx >= (1U << this->blocks_x_log) || by >= this->blocks_y) return nullptr;
+		return this->blocks[(by << this->blocks_x_log) | bx].get();
+	}
+
+public:
+	/**
+	 * Remove all vehicles and resize the grid for a map.
+	 * @param map_log_x Log2 of the map size in the X direction, at least #BLOCK_EDGE_LOG.
+	 * @param map_log_y Log2 of the map size in the Y direction, at least #BLOCK_EDGE_LOG.
+	 */
+	void Reset(uint map_log_x, uint map_log_y)
+	{
+		this->blocks_x_log = map_log_x - BLOCK_EDGE_LOG;
+		this->blocks_y = 1U << (map_log_y - BLOCK_EDGE_LOG);
+		this->blocks.clear();
+		this->blocks.resize(this->blocks_y << this->blocks_x_log);
+	}
+
+	/**
+	 * Get the first vehicle on a tile.
+	 * @param x X coordinate of the tile.
+	 * @param y Y coordinate of the tile.
+	 * @return The vehicle, or INVALID_VEHICLE if the tile is empty.
+	 */
+	inline VehicleID Find(uint x, uint y) const
+	{
+		const Block *block = this->GetBlock(x, y);
+		if (block == nullptr) return INVALID_VEHICLE;
+		uint row = y & BLOCK_EDGE_MASK;
+		uint col = x & BLOCK_EDGE_MASK;
+		if (!HasBit(block->occupancy[row], col)) return INVALID_VEHICLE;
+		return block->heads[block->GetRank(row, col)];
+	}
+
+	/**
+	 * Set the first vehicle on a tile.
+	 * @param x X coordinate of the tile.
+	 * @param y Y coordinate of the tile.
+	 * @param id The vehicle.
+	 */
+	void Set(uint x, uint y, VehicleID id)
+	{
+		uint bx = x >> BLOCK_EDGE_LOG;
+		uint by = y >> BLOCK_EDGE_LOG;
+		if (bx >= (1U << this->blocks_x_log) || by >= this->blocks_y) return;
+		std::unique_ptr<Block> &block = this->blocks[(by << this->blocks_x_log) | bx];
+		if (block == nullptr) block = std::make_unique<Block>();
+
+		uint row = y & BLOCK_EDGE_MASK;
+		uint col = x & BLOCK_EDGE_MASK;
+		uint rank = block->GetRank(row, col);
+		if (HasBit(block->occupancy[row], col)) {
+			block->heads[rank] = id;
+			return;
+		}
+		SetBit(block->occupancy[row], col);
+		block->heads.insert(block->heads.begin() + rank, id);
+		for (uint r = row + 1; r < BLOCK_EDGE; r++) block->row_base[r]++;
+	}
+
+	/**
+	 * Mark a tile as empty.
+	 * @param x X coordinate of the tile.
+	 * @param y Y coordinate of the tile.
+	 */
+	void Erase(uint x, uint y)
+	{
+		Block *block = this->GetBlock(x, y);
+		if (block == nullptr) return;
+		uint row = y & BLOCK_EDGE_MASK;
+		uint col = x & BLOCK_EDGE_MASK;
+		if (!HasBit(block->occupancy[row], col)) return;
+		block->heads.erase(block->heads.begin() + block->GetRank(row, col));
+		ClrBit(block->occupancy[row], col);
+		for (uint r = row + 1; r < BLOCK_EDGE; r++) block->row_base[r]--;
+	}
+};
+
+#endif /* VEHICLE_TILE_GRID_H */
@@ -203,13 +203,13 @@ void VideoDriver_Dedicated::MainLoop()
 
 	SetSelfAsGameThread();
 
-	/* Load the dedicated server stuff */
-	_is_network_server = true;
+	/* Load the dedicated server stuff, a relay joins its server instead of starting a game */
+	_is_network_server = !_network_relay;
 	_network_dedicated = true;
 	_current_company = _local_company = COMPANY_SPECTATOR;
 
 	/* If SwitchMode is SM_LOAD_GAME / SM_START_HEIGHTMAP, it means that the user used the '-g' options */
-	if (_switch_mode != SM_LOAD_GAME && _switch_mode != SM_START_HEIGHTMAP) {
+	if (!_network_relay && _switch_mode != SM_LOAD_GAME && _switch_mode != SM_START_HEIGHTMAP) {
 		StartNewGameWithoutGUI(GENERATE_NEW_SEED);
 	}
 
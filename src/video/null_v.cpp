@@ -13,6 +13,7 @@
 #include "../sl/saveload.h"
 #include "../window_func.h"
 #include "../thread.h"
+#include "../benchmark.h"
 #include "null_v.h"
 
 #include <atomic>
@@ -37,6 +38,10 @@ const char *VideoDriver_Null::Start(const StringList &parm)
 
 	this->ticks = GetDriverParamInt(parm, "ticks", 1000);
 	this->until_exit = GetDriverParamBool(parm, "until_exit");
+	const char *benchmark = GetDriverParam(parm, "benchmark");
+	if (benchmark != nullptr) this->benchmark = benchmark;
+	const char *command_log = GetDriverParam(parm, "commands");
+	if (command_log != nullptr) this->command_log = command_log;
 	_screen.width  = _screen.pitch = _cur_resolution.width;
 	_screen.height = _cur_resolution.height;
 	_screen.dst_ptr = nullptr;
@@ -55,7 +60,9 @@ void VideoDriver_Null::MakeDirty(int, int, int, int) {}
 void VideoDriver_Null::MainLoop()
 {
 	SetSelfAsGameThread();
-	if (this->until_exit) {
+	if (!this->benchmark.empty()) {
+		RunBenchmark(this->ticks, this->benchmark, this->command_log);
+	} else if (this->until_exit) {
 		while (!_exit_game) {
 			::GameLoop();
 			::InputLoop();
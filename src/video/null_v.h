@@ -17,6 +17,8 @@ class VideoDriver_Null : public VideoDriver {
 private:
 	int ticks; ///< Amount of ticks to run.
 	bool until_exit;
+	std::string benchmark;    ///< File to write the results of a benchmark of the ticks to, or empty.
+	std::string command_log;  ///< Desync log of which to replay the commands during the benchmark, or empty.
 
 public:
 	const char *Start(const StringList &param) override;
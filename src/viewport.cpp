@@ -68,6 +68,7 @@
 #include "smallmap_colours.h"
 #include "table/tree_land.h"
 #include "blitter/32bpp_base.hpp"
+#include "spritecache.h"
 #include "blitter/8bpp_simple.hpp"
 #include "blitter/null.hpp"
 #include "core/math_func.hpp"
@@ -3932,6 +3933,23 @@ static void ViewportDoDrawPhase2(Viewport *vp, ViewportDrawerDynamic *vdd);
 static void ViewportDoDrawPhase3(Viewport *vp);
 static void ViewportDoDrawRenderJob(Viewport *vp, ViewportDrawerDynamic *vdd);
 
+static std::vector<Rect> _viewport_areas_pending_sprites; ///< Areas drawn without sprites still being decoded in the background, in viewport coordinates.
+
+/**
+ * Mark the areas of viewports which were drawn without sprites still being decoded in the background dirty.
+ * This is called after decoded sprites have been inserted into the sprite cache.
+ */
+void MarkViewportsWithPendingSpritesDirty()
+{
+	if (_viewport_areas_pending_sprites.empty()) return;
+
+	std::vector<Rect> areas;
+	areas.swap(_viewport_areas_pending_sprites);
+	for (const Rect &r : areas) {
+		MarkAllViewportsDirty(r.left, r.top, r.right, r.bottom, VMDF_NOT_MAP_MODE);
+	}
+}
+
 /* This is run in the main thread */
 void ViewportDoDraw(Viewport *vp, int left, int top, int right, int bottom, uint8_t display_flags)
 {
@@ -4041,15 +4059,42 @@ void ViewportDoDraw(Viewport *vp, int left, int top, int right, int bottom, uint
 		ViewportAddLandscape();
 		ViewportAddVehicles(&_vdd->dpi, vp->update_vehicles);
 
+		/* Decode the sprites which are not yet in the sprite cache in the background, and prefetch those for the neighbouring zoom levels. */
+		static std::vector<SpriteID> viewport_sprites;
+		viewport_sprites.clear();
+		for (const TileSpriteToDraw &ts : _vdd->tile_sprites_to_draw) {
+			viewport_sprites.push_back(GB(ts.image, 0, SPRITE_WIDTH));
+		}
+		for (const ParentSpriteToDraw &ps : _vdd->parent_sprites_to_draw) {
+			if (ps.image != SPR_EMPTY_BOUNDING_BOX) viewport_sprites.push_back(GB(ps.image, 0, SPRITE_WIDTH));
+		}
+		for (const ChildScreenSpriteToDraw &cs : _vdd->child_screen_sprites_to_draw) {
+			viewport_sprites.push_back(GB(cs.image, 0, SPRITE_WIDTH));
+		}
+		LoadSpritesInBackground(viewport_sprites, _vdd->dpi.zoom);
+		if (_vdd->dpi.zoom > ZOOM_LVL_BEGIN) PrefetchSprites(viewport_sprites, (ZoomLevel)(_vdd->dpi.zoom - 1));
+		if (_vdd->dpi.zoom + 1 < ZOOM_LVL_SPR_END) PrefetchSprites(viewport_sprites, (ZoomLevel)(_vdd->dpi.zoom + 1));
+
+		/* Sprites which are still being decoded are not drawn this time, the area is redrawn when they are available. */
+		bool sprites_pending = false;
+		auto prepare_sprite = [&](SpriteID image, PaletteID pal) {
+			if (IsSpriteLoadPending(GB(image, 0, SPRITE_WIDTH), _vdd->dpi.zoom)) {
+				_vdd->sprite_data.SkipSprite(GB(image, 0, SPRITE_WIDTH), SpriteType::Normal);
+				sprites_pending = true;
+			} else {
+				PrepareDrawSpriteViewportSpriteStore(_vdd->sprite_data, &_vdd->dpi, image, pal);
+			}
+		};
 		for (const TileSpriteToDraw &ts : _vdd->tile_sprites_to_draw) {
-			PrepareDrawSpriteViewportSpriteStore(_vdd->sprite_data, &_vdd->dpi, ts.image, ts.pal);
+			prepare_sprite(ts.image, ts.pal);
 		}
 		for (const ParentSpriteToDraw &ps : _vdd->parent_sprites_to_draw) {
-			if (ps.image != SPR_EMPTY_BOUNDING_BOX) PrepareDrawSpriteViewportSpriteStore(_vdd->sprite_data, &_vdd->dpi, ps.image, ps.pal);
+			if (ps.image != SPR_EMPTY_BOUNDING_BOX) prepare_sprite(ps.image, ps.pal);
 		}
 		for (const ChildScreenSpriteToDraw &cs : _vdd->child_screen_sprites_to_draw) {
-			PrepareDrawSpriteViewportSpriteStore(_vdd->sprite_data, &_vdd->dpi, cs.image, cs.pal);
+			prepare_sprite(cs.image, cs.pal);
 		}
+		if (sprites_pending) _viewport_areas_pending_sprites.push_back({ left, top, right, bottom });
 
 		_viewport_drawer_jobs++;
 		extern bool _draw_widget_outlines;
@@ -39,6 +39,7 @@ void UpdateViewportSizeZoom(Viewport *vp);
 
 void MarkViewportDirty(Viewport * const vp, int left, int top, int right, int bottom, ViewportMarkDirtyFlags flags);
 void MarkAllViewportsDirty(int left, int top, int right, int bottom, ViewportMarkDirtyFlags flags = VMDF_NONE);
+void MarkViewportsWithPendingSpritesDirty();
 void MarkAllViewportMapsDirty(int left, int top, int right, int bottom);
 void MarkAllViewportMapLandscapesDirty();
 void MarkWholeNonMapViewportsDirty();
@@ -28,6 +28,7 @@ void ClearNeighbourNonFloodingStates(TileIndex tile);
 
 void TileLoop_Water(TileIndex tile);
 void TileLoopWaterFlooding(FloodingBehaviour flooding_behaviour, TileIndex tile);
+bool IsTileLoopWaterQuiescent(TileIndex tile);
 bool FloodHalftile(TileIndex t);
 void DoFloodTile(TileIndex target);
 
@@ -1354,6 +1354,19 @@ void TileLoop_Water(TileIndex tile)
 	TileLoopWaterFlooding(GetFloodingBehaviour(tile), tile);
 }
 
+/**
+ * Check whether TileLoop_Water would currently have no effect on a tile, other than ambient sound effects.
+ * @param tile Tile to check.
+ * @return Whether the tile would not flood or dry up.
+ * @see TileLoopQuiescentProc
+ */
+bool IsTileLoopWaterQuiescent(TileIndex tile)
+{
+	if (DayLengthFactor() > 4 && _game_mode != GM_EDITOR) return true;
+	if (IsNonFloodingWaterTile(tile)) return true;
+	return GetFloodingBehaviour(tile) == FLOOD_NONE;
+}
+
 void TileLoopWaterFlooding(FloodingBehaviour flooding_behaviour, TileIndex tile)
 {
 	switch (flooding_behaviour) {
@@ -1535,4 +1548,5 @@ extern const TileTypeProcs _tile_type_water_procs = {
 	VehicleEnter_Water,       // vehicle_enter_tile_proc
 	GetFoundation_Water,      // get_foundation_proc
 	TerraformTile_Water,      // terraform_tile_proc
+	IsTileLoopWaterQuiescent, // tile_loop_quiescent_proc
 };
@@ -14,28 +14,44 @@
 #include "safeguards.h"
 
 WorkerThreadPool _general_worker_pool;
+uint _worker_thread_count = 0;       ///< Number of threads in the general worker pool, 0 to use one less than the number of cores.
+bool _worker_thread_affinity = false; ///< Whether to pin each thread of the general worker pool to its own core.
 
-void WorkerThreadPool::Start(const char *thread_name, uint max_workers)
+static thread_local WorkerThreadPool *_current_worker_pool = nullptr; ///< Pool of the current thread, if it is a worker thread.
+static thread_local uint _current_worker_index = 0;                   ///< Index of the current thread in _current_worker_pool.
+
+void WorkerThreadPool::Start(const char *thread_name, uint max_workers, bool set_affinity)
 {
 	uint cpus = std::thread::hardware_concurrency();
 	if (cpus <= 1) return;
 
 	std::lock_guard<std::mutex> lk(this->lock);
 
+	/* The queues can't be resized whilst there are workers using them */
+	if (this->workers > 0) return;
+
 	this->exit = false;
 
 	uint worker_target = std::min<uint>(max_workers, cpus);
-	if (this->workers >= worker_target) return;
+	if (worker_target == 0) return;
 
-	uint new_workers = worker_target - this->workers;
+	this->queues.clear();
+	for (uint i = 0; i <= worker_target; i++) {
+		this->queues.push_back(std::make_unique<WorkerQueue>());
+	}
 
-	for (uint i = 0; i < new_workers; i++) {
+	for (uint i = 0; i < worker_target; i++) {
 		this->workers++;
-		if (!StartNewThread(nullptr, thread_name, &WorkerThreadPool::Run, this)) {
+		if (!StartNewThread(nullptr, thread_name, &WorkerThreadPool::Run, this, static_cast<uint>(i), static_cast<bool>(set_affinity))) {
 			this->workers--;
-			return;
+			break;
 		}
 	}
+
+	/* Jobs left in the queue of a worker which failed to start are stolen by the other workers.
+	 * Always keep at least one worker free of long running jobs, so that short jobs aren't held up.
+	 * With a single worker, long running jobs can't be run on the pool at all. */
+	this->max_long_running = this->workers > 1 ? this->workers - 1 : 0;
 }
 
 void WorkerThreadPool::Stop()
@@ -46,39 +62,217 @@ void WorkerThreadPool::Stop()
 	this->done_cv.wait(lk, [this]() { return this->workers == 0; });
 }
 
-void WorkerThreadPool::EnqueueJob(WorkerJobFunc *func, void *data1, void *data2, void *data3)
+void WorkerThreadPool::Enqueue(WorkerJob job, WorkerJobFlags flags)
 {
 	std::unique_lock<std::mutex> lk(this->lock);
-	if (this->workers == 0) {
+	if (this->workers == 0 || ((flags & WJF_LONG_RUNNING) && this->max_long_running == 0)) {
 		/* Just execute it here and now */
 		lk.unlock();
-		func(data1, data2, data3);
+		if (job.claimed == nullptr || !job.claimed->exchange(true)) job.func(job.data1, job.data2, job.data3);
 		return;
 	}
-	bool notify = this->jobs.size() < (size_t)this->workers_waiting;
-	this->jobs.push({ func, data1, data2, data3 });
+
+	if (flags & WJF_LONG_RUNNING) {
+		this->long_jobs.push_back(std::move(job));
+	} else {
+		/* Workers push to the back of their own queue, everyone else uses the shared queue */
+		WorkerQueue &queue = (_current_worker_pool == this) ? *this->queues[_current_worker_index] : *this->queues.back();
+		std::lock_guard<std::mutex> queue_lk(queue.lock);
+		queue.jobs.push_back(std::move(job));
+		this->pending++;
+	}
+	bool notify = this->workers_waiting > 0;
 	lk.unlock();
 	if (notify) this->worker_wait_cv.notify_one();
 }
 
-void WorkerThreadPool::Run(WorkerThreadPool *pool)
+void WorkerThreadPool::EnqueueJob(WorkerJobFunc *func, void *data1, void *data2, void *data3, WorkerJobFlags flags)
+{
+	this->Enqueue({ func, data1, data2, data3, nullptr }, flags);
+}
+
+/**
+ * Take a job from the queues, this is the newest job of the worker's own queue, or else the oldest job of any other queue.
+ * Jobs which have already been claimed by a thread waiting for their task group are skipped.
+ * @param index Index of the worker.
+ * @param job Output for the job.
+ * @return Whether a job was found.
+ */
+bool WorkerThreadPool::TryGetJob(uint index, WorkerJob &job)
 {
+	const uint count = (uint)this->queues.size();
+	for (uint i = 0; i < count; i++) {
+		const uint queue_index = (index + i) % count;
+		WorkerQueue &queue = *this->queues[queue_index];
+		std::lock_guard<std::mutex> lk(queue.lock);
+		while (!queue.jobs.empty()) {
+			if (queue_index == index) {
+				job = std::move(queue.jobs.back());
+				queue.jobs.pop_back();
+			} else {
+				job = std::move(queue.jobs.front());
+				queue.jobs.pop_front();
+			}
+			this->pending--;
+			if (job.claimed == nullptr || !job.claimed->exchange(true)) return true;
+		}
+	}
+	return false;
+}
+
+void WorkerThreadPool::Run(WorkerThreadPool *pool, uint index, bool set_affinity)
+{
+	_current_worker_pool = pool;
+	_current_worker_index = index;
+
+	/* Leave the first core for the main/game thread */
+	if (set_affinity) SetCurrentThreadAffinity(index + 1);
+
 	std::unique_lock<std::mutex> lk(pool->lock);
-	while (!pool->exit || !pool->jobs.empty()) {
-		if (pool->jobs.empty()) {
-			pool->workers_waiting++;
-			pool->worker_wait_cv.wait(lk);
-			pool->workers_waiting--;
-		} else {
-			WorkerJob job = pool->jobs.front();
-			pool->jobs.pop();
-			lk.unlock();
+	while (true) {
+		lk.unlock();
+		WorkerJob job;
+		if (pool->TryGetJob(index, job)) {
 			job.func(job.data1, job.data2, job.data3);
 			lk.lock();
+			continue;
+		}
+		lk.lock();
+
+		if (!pool->long_jobs.empty() && pool->long_running < pool->max_long_running) {
+			job = std::move(pool->long_jobs.front());
+			pool->long_jobs.pop_front();
+			pool->long_running++;
+			lk.unlock();
+			if (job.claimed == nullptr || !job.claimed->exchange(true)) job.func(job.data1, job.data2, job.data3);
+			lk.lock();
+			pool->long_running--;
+			if (!pool->long_jobs.empty()) pool->worker_wait_cv.notify_one();
+			continue;
 		}
+
+		if (pool->exit && pool->long_jobs.empty() && pool->pending.load() == 0) break;
+
+		/* Jobs are only added to the queues whilst holding the pool lock, so none can be missed between checking and waiting */
+		pool->workers_waiting++;
+		pool->worker_wait_cv.wait(lk, [pool]() {
+			return pool->pending.load() != 0 || (pool->exit && pool->long_jobs.empty()) ||
+					(!pool->long_jobs.empty() && pool->long_running < pool->max_long_running);
+		});
+		pool->workers_waiting--;
 	}
 	pool->workers--;
 	if (pool->workers == 0) {
 		pool->done_cv.notify_all();
 	}
 }
+
+/**
+ * Check whether long running jobs are run by the workers of the pool.
+ * If not, jobs enqueued with #WJF_LONG_RUNNING are run immediately in the enqueuing thread.
+ * @return True if long running jobs are run by the workers.
+ */
+bool WorkerThreadPool::CanRunLongRunningJobs()
+{
+	std::lock_guard<std::mutex> lk(this->lock);
+	return this->max_long_running > 0;
+}
+
+/**
+ * Start the general worker pool.
+ * This is sized by the worker_threads setting, or else to leave one core for the game thread.
+ */
+void StartGeneralWorkerPool()
+{
+	uint count = _worker_thread_count;
+	if (count == 0) count = std::max<uint>(std::thread::hardware_concurrency(), 2) - 1;
+	_general_worker_pool.Start("ottd:worker", count, _worker_thread_affinity);
+}
+
+/* static */ void WorkerTaskGroup::RunJob(void *data1, void *data2, void *)
+{
+	static_cast<WorkerTaskGroup *>(data1)->RunTask(*static_cast<Task *>(data2));
+}
+
+void WorkerTaskGroup::RunTask(Task &task)
+{
+	task.func();
+	task.func = nullptr;
+
+	/* Notify whilst holding the lock, the group may be destroyed as soon as the waiting thread sees that all tasks are done */
+	std::lock_guard<std::mutex> lk(this->lock);
+	this->outstanding--;
+	this->done_cv.notify_all();
+}
+
+/**
+ * Add a task to the group, and enqueue it on the pool.
+ * @param func Function to run.
+ * @param flags Job flags, see WorkerJobFlags.
+ */
+void WorkerTaskGroup::Run(std::function<void()> func, WorkerJobFlags flags)
+{
+	Task &task = this->tasks.emplace_back();
+	task.func = std::move(func);
+	task.long_running = (flags & WJF_LONG_RUNNING) != 0;
+	task.claimed = std::make_shared<std::atomic<bool>>(false);
+	{
+		std::lock_guard<std::mutex> lk(this->lock);
+		this->outstanding++;
+	}
+	this->pool.Enqueue({ &WorkerTaskGroup::RunJob, this, &task, nullptr, task.claimed }, flags);
+}
+
+/**
+ * Wait for all tasks of the group to complete.
+ * Tasks which have not yet been started by a worker are run in the current thread, except for long running tasks,
+ * which are left for the workers so that the waiting thread isn't stalled for a long time.
+ */
+void WorkerTaskGroup::Wait()
+{
+	/* Newest first, the workers take the oldest tasks first */
+	for (auto it = this->tasks.rbegin(); it != this->tasks.rend(); ++it) {
+		if (!it->long_running && !it->claimed->exchange(true)) this->RunTask(*it);
+	}
+
+	std::unique_lock<std::mutex> lk(this->lock);
+	this->done_cv.wait(lk, [this]() { return this->outstanding == 0; });
+	lk.unlock();
+
+	this->tasks.clear();
+	this->next_unclaimed = 0;
+}
+
+/**
+ * Wait until no more than the given number of tasks of the group are outstanding.
+ * Tasks which have not yet been started by a worker are run in the current thread, oldest first, except for long running tasks.
+ * @param max_outstanding Maximum number of tasks which may still be outstanding.
+ */
+void WorkerTaskGroup::WaitForOutstanding(uint max_outstanding)
+{
+	std::unique_lock<std::mutex> lk(this->lock);
+	while (this->outstanding > max_outstanding) {
+		lk.unlock();
+		bool ran = false;
+		for (; this->next_unclaimed < this->tasks.size(); this->next_unclaimed++) {
+			Task &task = this->tasks[this->next_unclaimed];
+			if (!task.long_running && !task.claimed->exchange(true)) {
+				this->RunTask(task);
+				ran = true;
+				break;
+			}
+		}
+		lk.lock();
+		if (!ran) this->done_cv.wait(lk, [&]() { return this->outstanding <= max_outstanding; });
+	}
+}
+
+/**
+ * Check whether all tasks of the group have completed, without waiting.
+ * @return True if there are no outstanding tasks.
+ */
+bool WorkerTaskGroup::IsDone()
+{
+	std::lock_guard<std::mutex> lk(this->lock);
+	return this->outstanding == 0;
+}
@@ -10,12 +10,31 @@
 #ifndef WORKER_THREAD_H
 #define WORKER_THREAD_H
 
-#include "core/ring_buffer_queue.hpp"
+#include "core/enum_type.hpp"
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
 #include <mutex>
 #include <condition_variable>
+#include <vector>
 
 typedef void WorkerJobFunc(void *, void *, void *);
 
+/** Flags for jobs enqueued on a WorkerThreadPool. */
+enum WorkerJobFlags : uint8_t {
+	WJF_NONE             = 0,
+	WJF_LONG_RUNNING     = 1 << 0, ///< Job may run for a long time (e.g. over many game ticks), these are limited to a subset of the workers, which never includes all of them.
+};
+DECLARE_ENUM_AS_BIT_SET(WorkerJobFlags);
+
+/**
+ * Work-stealing worker thread pool.
+ * Each worker has its own job queue, jobs enqueued from a worker thread go to the back of its own queue and are run in LIFO order.
+ * Jobs enqueued from other threads go to a shared queue. Idle workers steal from the front of the other queues.
+ * Long running jobs are kept in a separate queue, so that they can't occupy all of the workers at once.
+ * Idle workers sleep on a condition variable until there is a job which they can run.
+ */
 struct WorkerThreadPool {
 private:
 	struct WorkerJob {
@@ -23,23 +42,44 @@ private:
 		void *data1;
 		void *data2;
 		void *data3;
+		std::shared_ptr<std::atomic<bool>> claimed; ///< Set for jobs of a WorkerTaskGroup, the job is skipped if it was already claimed by a thread waiting for the group.
+	};
+
+	struct WorkerQueue {
+		std::mutex lock;
+		std::deque<WorkerJob> jobs;
 	};
 
 	uint workers = 0;
 	uint workers_waiting = 0;
+	uint long_running = 0;                           ///< Number of long running jobs currently running.
+	uint max_long_running = 0;                       ///< Maximum number of long running jobs to run at once.
 	bool exit = false;
 	std::mutex lock;
-	ring_buffer_queue<WorkerJob> jobs;
+	std::vector<std::unique_ptr<WorkerQueue>> queues; ///< One queue per worker, and a last shared queue for jobs enqueued by non-worker threads.
+	std::deque<WorkerJob> long_jobs;                 ///< Long running jobs, guarded by lock.
+	std::atomic<uint> pending = 0;                   ///< Number of jobs in queues, only incremented whilst holding lock.
 	std::condition_variable worker_wait_cv;
 	std::condition_variable done_cv;
 
-	static void Run(WorkerThreadPool *pool);
+	static void Run(WorkerThreadPool *pool, uint index, bool set_affinity);
+	bool TryGetJob(uint index, WorkerJob &job);
+	void Enqueue(WorkerJob job, WorkerJobFlags flags);
+
+	friend class WorkerTaskGroup;
 
 public:
 
-	void Start(const char *thread_name, uint max_workers);
+	void Start(const char *thread_name, uint max_workers, bool set_affinity = false);
 	void Stop();
-	void EnqueueJob(WorkerJobFunc *func, void *data1 = nullptr, void *data2 = nullptr, void *data3 = nullptr);
+	void EnqueueJob(WorkerJobFunc *func, void *data1 = nullptr, void *data2 = nullptr, void *data3 = nullptr, WorkerJobFlags flags = WJF_NONE);
+	bool CanRunLongRunningJobs();
+
+	uint GetWorkerCount()
+	{
+		std::lock_guard<std::mutex> lk(this->lock);
+		return this->workers;
+	}
 
 	~WorkerThreadPool()
 	{
@@ -48,5 +88,72 @@ public:
 };
 
 extern WorkerThreadPool _general_worker_pool;
+extern uint _worker_thread_count;
+extern bool _worker_thread_affinity;
+
+void StartGeneralWorkerPool();
+
+/**
+ * Group of tasks run on a WorkerThreadPool, which can be waited for together.
+ * Tasks may only be added to the group by the thread which owns it.
+ * Waiting for the group runs any tasks of the group which have not yet been started in the waiting thread,
+ * so groups may be nested, and waiting never runs unrelated jobs. Long running tasks are always left to the workers.
+ */
+class WorkerTaskGroup {
+	struct Task {
+		std::function<void()> func;
+		std::shared_ptr<std::atomic<bool>> claimed;
+		bool long_running;                   ///< Task is a long running job, which is never run by a waiting thread.
+	};
+
+	WorkerThreadPool &pool;
+	std::deque<Task> tasks;              ///< Tasks of this group, the deque keeps their addresses stable.
+	std::mutex lock;
+	std::condition_variable done_cv;
+	uint outstanding = 0;                ///< Number of tasks which have not yet completed, guarded by lock.
+	size_t next_unclaimed = 0;           ///< Index of the oldest task which may not have been claimed yet.
+
+	static void RunJob(void *data1, void *data2, void *data3);
+	void RunTask(Task &task);
+
+public:
+	WorkerTaskGroup(WorkerThreadPool &pool = _general_worker_pool) : pool(pool) {}
+
+	~WorkerTaskGroup()
+	{
+		this->Wait();
+	}
+
+	void Run(std::function<void()> func, WorkerJobFlags flags = WJF_NONE);
+	void Wait();
+	void WaitForOutstanding(uint max_outstanding);
+	bool IsDone();
+};
+
+/**
+ * Call a function for each sub-range of [begin, end), the sub-ranges are processed in parallel on the worker pool.
+ * The function is called directly if the range is not larger than the grain size, or there are no workers.
+ * @param begin Start of the range.
+ * @param end End of the range (exclusive).
+ * @param grain Maximum size of each sub-range.
+ * @param func Function to call with the begin and end of each sub-range.
+ * @param pool Worker pool to use.
+ */
+template <typename F>
+void ParallelFor(size_t begin, size_t end, size_t grain, F func, WorkerThreadPool &pool = _general_worker_pool)
+{
+	if (begin >= end) return;
+	if (end - begin <= grain || pool.GetWorkerCount() == 0) {
+		func(begin, end);
+		return;
+	}
+
+	WorkerTaskGroup group(pool);
+	for (size_t i = begin; i < end; i += grain) {
+		const size_t sub_end = std::min(end, i + grain);
+		group.Run([&func, i, sub_end]() { func(i, sub_end); });
+	}
+	group.Wait();
+}
 
 #endif /* WORKER_THREAD_H */